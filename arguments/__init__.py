@@ -60,6 +60,12 @@ class ModelParams(ParamGroup):
         self.resample_gt_image = False
         self.load_allres = False
         self.sample_more_highres = False
+        # Decode images natively into a cached 1x/2x/4x/8x pyramid and stream
+        # them during training instead of holding all of them in memory
+        self.image_cache = False
+        # Directory of the pyramid cache, the model path if empty. Runs on
+        # the same images can share it.
+        self.image_cache_dir = ""
         super().__init__(parser, "Loading Parameters", sentinel)
 
     def extract(self, args):
@@ -72,6 +78,9 @@ class PipelineParams(ParamGroup):
         self.convert_SHs_python = False
         self.compute_cov3D_python = False
         self.debug = False
+        self.persistent_buffers = False
+        self.bvh_culling = False
+        self.coherent_sort = False
         super().__init__(parser, "Pipeline Parameters")
 
 class OptimizationParams(ParamGroup):
@@ -87,11 +96,22 @@ class OptimizationParams(ParamGroup):
         self.rotation_lr = 0.001
         self.percent_dense = 0.01
         self.lambda_dssim = 0.2
+        # L1 + SSIM loss and its gradient in one native pass (splat_train)
+        self.fused_loss = False
         self.densification_interval = 100
         self.opacity_reset_interval = 3000
+        self.incremental_3D_filter = False
+        # Adam step of only the Gaussians visible in the iteration, with
+        # lazily decayed moments for the others
+        self.sparse_adam = False
         self.densify_from_iter = 500
         self.densify_until_iter = 15_000
         self.densify_grad_threshold = 0.0002
+        # Sort the Gaussians into Morton order after every densification
+        self.morton_reorder = False
+        # Prune Gaussians whose largest blend weight over all training views
+        # stays below this at the end of densification, 0 disables
+        self.min_contribution = 0.0
         super().__init__(parser, "Optimization Parameters")
 
 def get_combined_args(parser : ArgumentParser):
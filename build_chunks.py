@@ -0,0 +1,39 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import os
+from utils.general_utils import safe_state
+from utils.system_utils import searchForMaxIteration
+from argparse import ArgumentParser
+from arguments import ModelParams, get_combined_args
+from scene.gaussian_streaming import build_chunked
+
+if __name__ == "__main__":
+    # Set up command line argument parser
+    parser = ArgumentParser(description="Partition a compressed model into spatial chunks for out-of-core rendering")
+    model = ModelParams(parser, sentinel=True)
+    parser.add_argument("--iteration", default=-1, type=int)
+    parser.add_argument("--chunk_size", default=1 << 16, type=int)
+    parser.add_argument("--quiet", action="store_true")
+    args = get_combined_args(parser)
+    print("Building chunks for " + args.model_path)
+
+    # Initialize system state (RNG)
+    safe_state(args.quiet)
+    dataset = model.extract(args)
+    iteration = args.iteration if args.iteration != -1 else searchForMaxIteration(os.path.join(dataset.model_path, "point_cloud"))
+    folder = os.path.join(dataset.model_path, "point_cloud", "iteration_{}".format(iteration))
+
+    compressed_path = os.path.join(folder, "compressed.splat")
+    if not os.path.exists(compressed_path):
+        raise FileNotFoundError(compressed_path + " not found, run compress.py first")
+    chunks = build_chunked(compressed_path, os.path.join(folder, "chunked.splat"), args.chunk_size)
+    print("{} chunks of at most {} Gaussians".format(chunks, args.chunk_size))
@@ -0,0 +1,87 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import os
+import json
+import torch
+from scene import Scene
+from tqdm import tqdm
+from utils.general_utils import safe_state
+from utils.image_utils import psnr
+from argparse import ArgumentParser
+from arguments import ModelParams, PipelineParams, get_combined_args
+from gaussian_renderer import render, render_compressed, GaussianModel
+from scene.gaussian_compressed import CompressedGaussianModel
+
+def report(views, gaussians, compressed, pipeline, background, kernel_size):
+    # Mean PSNR of both models against the ground truth, and of the
+    # compressed renderings against the uncompressed ones
+    scores = {"uncompressed": [], "compressed": [], "compressed_vs_uncompressed": []}
+    for view in tqdm(views, desc="PSNR report"):
+        gt = view.original_image[0:3, :, :].cuda()
+        full = torch.clamp(render(view, gaussians, pipeline, background, kernel_size)["render"], 0.0, 1.0)
+        small = torch.clamp(render_compressed(view, compressed, pipeline, background, kernel_size)["render"], 0.0, 1.0)
+        scores["uncompressed"].append(psnr(full, gt).mean().item())
+        scores["compressed"].append(psnr(small, gt).mean().item())
+        scores["compressed_vs_uncompressed"].append(psnr(small, full).mean().item())
+    return {name: sum(values) / len(values) for name, values in scores.items()}
+
+if __name__ == "__main__":
+    # Set up command line argument parser
+    parser = ArgumentParser(description="Compress a trained model for serving")
+    model = ModelParams(parser, sentinel=True)
+    pipeline = PipelineParams(parser)
+    parser.add_argument("--iteration", default=-1, type=int)
+    parser.add_argument("--codebook_size", default=4096, type=int)
+    parser.add_argument("--kmeans_iterations", default=10, type=int)
+    parser.add_argument("--skip_report", action="store_true")
+    parser.add_argument("--quiet", action="store_true")
+    args = get_combined_args(parser)
+    print("Compressing " + args.model_path)
+
+    # Initialize system state (RNG)
+    safe_state(args.quiet)
+    dataset = model.extract(args)
+    pipe = pipeline.extract(args)
+
+    with torch.no_grad():
+        gaussians = GaussianModel(dataset.sh_degree)
+        scene = Scene(dataset, gaussians, load_iteration=args.iteration, shuffle=False)
+        folder = os.path.join(dataset.model_path, "point_cloud", "iteration_{}".format(scene.loaded_iter))
+
+        compressed = CompressedGaussianModel.compress(gaussians, args.codebook_size, args.kmeans_iterations)
+        compressed.save(os.path.join(folder, "compressed.splat"))
+
+        # Bytes of the attributes the renderer reads
+        uncompressed_bytes = sum(t.numel() * t.element_size() for t in (gaussians._xyz, gaussians._features_dc, gaussians._features_rest,
+                                                                       gaussians._opacity, gaussians._scaling, gaussians._rotation, gaussians.filter_3D))
+        results = {
+            "iteration": scene.loaded_iter,
+            "gaussians": compressed.num_gaussians,
+            "codebook_size": compressed.attributes.sh_codebook.shape[0],
+            "uncompressed_bytes": uncompressed_bytes,
+            "compressed_bytes": compressed.num_bytes,
+            "ratio": uncompressed_bytes / compressed.num_bytes,
+        }
+        print("{} Gaussians: {:.1f} MB -> {:.1f} MB ({:.1f}x)".format(
+            results["gaussians"], uncompressed_bytes / 2**20, compressed.num_bytes / 2**20, results["ratio"]))
+
+        if not args.skip_report:
+            views = scene.getTestCameras() or scene.getTrainCameras()
+            bg_color = [1,1,1] if dataset.white_background else [0, 0, 0]
+            background = torch.tensor(bg_color, dtype=torch.float32, device="cuda")
+            results["views"] = "test" if scene.getTestCameras() else "train"
+            results["PSNR"] = report(views, gaussians, compressed, pipe, background, dataset.kernel_size)
+            for name, value in results["PSNR"].items():
+                print("  PSNR {:<26}: {:>8.3f}".format(name, value))
+
+        with open(os.path.join(dataset.model_path, "compression.json"), 'w') as fp:
+            json.dump(results, fp, indent=True)
@@ -20,6 +20,6 @@ if __name__ == "__main__":
     dataset = model.extract(args)
     gaussians = GaussianModel(dataset.sh_degree)
         
-    gaussians.load_ply(os.path.join(dataset.model_path, "point_cloud", "iteration_30000", "point_cloud.ply"))
+    gaussians.load(os.path.join(dataset.model_path, "point_cloud", "iteration_30000"))
     gaussians.save_fused_ply(args.output_ply)
     
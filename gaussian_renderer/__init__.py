@@ -11,11 +11,11 @@
 
 import torch
 import math
-from diff_gaussian_rasterization import GaussianRasterizationSettings, GaussianRasterizer
+from diff_gaussian_rasterization import GaussianRasterizationSettings, GaussianRasterizer, rasterize_gaussians_batched, rasterize_gaussians_compressed
 from scene.gaussian_model import GaussianModel
 from utils.sh_utils import eval_sh
 
-def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor, kernel_size: float, scaling_modifier = 1.0, override_color = None, subpixel_offset=None):
+def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor, kernel_size: float, scaling_modifier = 1.0, override_color = None, subpixel_offset=None, raster_context=None):
     """
     Render the scene. 
     
@@ -23,7 +23,7 @@ def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor,
     """
  
     # Create zero tensor. We will use it to make pytorch return gradients of the 2D (screen-space) means
-    screenspace_points = torch.zeros_like(pc.get_xyz, dtype=pc.get_xyz.dtype, requires_grad=True, device="cuda") + 0
+    screenspace_points = torch.zeros_like(pc.get_xyz, dtype=pc.get_xyz.dtype, requires_grad=True, device=pc.get_xyz.device) + 0
     try:
         screenspace_points.retain_grad()
     except:
@@ -34,7 +34,7 @@ def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor,
     tanfovy = math.tan(viewpoint_camera.FoVy * 0.5)
 
     if subpixel_offset is None:
-        subpixel_offset = torch.zeros((int(viewpoint_camera.image_height), int(viewpoint_camera.image_width), 2), dtype=torch.float32, device="cuda")
+        subpixel_offset = torch.zeros((int(viewpoint_camera.image_height), int(viewpoint_camera.image_width), 2), dtype=torch.float32, device=pc.get_xyz.device)
         
     raster_settings = GaussianRasterizationSettings(
         image_height=int(viewpoint_camera.image_height),
@@ -50,11 +50,18 @@ def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor,
         sh_degree=pc.active_sh_degree,
         campos=viewpoint_camera.camera_center,
         prefiltered=False,
-        debug=pipe.debug
+        debug=pipe.debug,
+        context=raster_context
     )
 
     rasterizer = GaussianRasterizer(raster_settings=raster_settings)
 
+    # With BVH culling only the Gaussians that may be visible are passed
+    # on (gradients flow back through the gathers), see visible_indices
+    visible = pc.visible_indices(viewpoint_camera, kernel_size, scaling_modifier) if pipe.bvh_culling else None
+    def gather(tensor):
+        return tensor if visible is None or tensor is None else tensor[visible]
+
     means3D = pc.get_xyz
     means2D = screenspace_points
     opacity = pc.get_opacity_with_3D_filter
@@ -88,14 +95,16 @@ def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor,
 
     # Rasterize visible Gaussians to image, obtain their radii (on screen). 
     rendered_image, radii = rasterizer(
-        means3D = means3D,
-        means2D = means2D,
-        shs = shs,
-        colors_precomp = colors_precomp,
-        opacities = opacity,
-        scales = scales,
-        rotations = rotations,
-        cov3D_precomp = cov3D_precomp)
+        means3D = gather(means3D),
+        means2D = gather(means2D),
+        shs = gather(shs),
+        colors_precomp = gather(colors_precomp),
+        opacities = gather(opacity),
+        scales = gather(scales),
+        rotations = gather(rotations),
+        cov3D_precomp = gather(cov3D_precomp))
+    if visible is not None:
+        radii = torch.zeros(pc.get_xyz.shape[0], dtype=radii.dtype, device=radii.device).index_copy_(0, visible, radii)
 
     # Those Gaussians that were frustum culled or had a radius of 0 were not visible.
     # They will be excluded from value updates used in the splitting criteria.
@@ -103,3 +112,140 @@ def render(viewpoint_camera, pc : GaussianModel, pipe, bg_color : torch.Tensor,
             "viewspace_points": screenspace_points,
             "visibility_filter" : radii > 0,
             "radii": radii}
+
+def render_batched(viewpoint_cameras, pc : GaussianModel, pipe, bg_color : torch.Tensor, kernel_size: float, scaling_modifier = 1.0, raster_context=None, contributions=None):
+    """
+    Render the scene from several cameras of equal resolution in one call.
+    Returns a (N, 3, H, W) tensor of images and the (N, P) radii. No gradients.
+    Contribution statistics are accumulated into contributions (3, P) if given.
+    """
+    height = int(viewpoint_cameras[0].image_height)
+    width = int(viewpoint_cameras[0].image_width)
+    for view in viewpoint_cameras:
+        assert int(view.image_height) == height and int(view.image_width) == width, "All views of a batch must have the same resolution"
+
+    scales = None
+    rotations = None
+    cov3D_precomp = None
+    if pipe.compute_cov3D_python:
+        cov3D_precomp = pc.get_covariance(scaling_modifier)
+    else:
+        scales = pc.get_scaling_with_3D_filter
+        rotations = pc.get_rotation
+
+    images, radii = rasterize_gaussians_batched(
+        means3D = pc.get_xyz,
+        opacities = pc.get_opacity_with_3D_filter,
+        viewmatrices = torch.stack([view.world_view_transform for view in viewpoint_cameras]),
+        projmatrices = torch.stack([view.full_proj_transform for view in viewpoint_cameras]),
+        tanfovx = [math.tan(view.FoVx * 0.5) for view in viewpoint_cameras],
+        tanfovy = [math.tan(view.FoVy * 0.5) for view in viewpoint_cameras],
+        campos = torch.stack([view.camera_center for view in viewpoint_cameras]),
+        image_height = height,
+        image_width = width,
+        kernel_size = kernel_size,
+        bg = bg_color,
+        sh_degree = pc.active_sh_degree,
+        shs = pc.get_features,
+        scales = scales,
+        rotations = rotations,
+        cov3D_precomp = cov3D_precomp,
+        scale_modifier = scaling_modifier,
+        debug = pipe.debug,
+        context = raster_context,
+        contributions = contributions)
+
+    return {"render": images,
+            "visibility_filter" : radii > 0,
+            "radii": radii}
+
+def gaussian_contributions(viewpoint_cameras, pc : GaussianModel, pipe, bg_color : torch.Tensor, kernel_size: float, batch_size = 8, raster_context=None):
+    """
+    Per-Gaussian contribution statistics over all given cameras, rendered in
+    batches of equal resolution. Returns a (3, P) tensor of the largest blend
+    weight, the summed blend weight and the number of blended pixels.
+    """
+    contributions = torch.zeros((3, pc.get_xyz.shape[0]), dtype=torch.float32, device=pc.get_xyz.device)
+    by_resolution = {}
+    for view in viewpoint_cameras:
+        by_resolution.setdefault((int(view.image_height), int(view.image_width)), []).append(view)
+    for views in by_resolution.values():
+        for start in range(0, len(views), batch_size):
+            render_batched(views[start:start + batch_size], pc, pipe, bg_color, kernel_size,
+                           raster_context=raster_context, contributions=contributions)
+    return contributions
+
+def render_lod(viewpoint_camera, lod, pipe, bg_color : torch.Tensor, kernel_size: float, target_size = 1.0, raster_context=None):
+    """
+    Render the cut of a GaussianLOD whose nodes project to at most
+    target_size pixels. No gradients.
+    """
+    nodes = lod.cut(viewpoint_camera, target_size)
+
+    raster_settings = GaussianRasterizationSettings(
+        image_height=int(viewpoint_camera.image_height),
+        image_width=int(viewpoint_camera.image_width),
+        tanfovx=math.tan(viewpoint_camera.FoVx * 0.5),
+        tanfovy=math.tan(viewpoint_camera.FoVy * 0.5),
+        kernel_size=kernel_size,
+        subpixel_offset=torch.zeros((int(viewpoint_camera.image_height), int(viewpoint_camera.image_width), 2), dtype=torch.float32, device=lod.xyz.device),
+        bg=bg_color,
+        scale_modifier=1.0,
+        viewmatrix=viewpoint_camera.world_view_transform,
+        projmatrix=viewpoint_camera.full_proj_transform,
+        sh_degree=lod.active_sh_degree,
+        campos=viewpoint_camera.camera_center,
+        prefiltered=False,
+        debug=pipe.debug,
+        context=raster_context
+    )
+
+    rasterizer = GaussianRasterizer(raster_settings=raster_settings)
+
+    # The 3D filter is already part of the node covariances and opacities
+    means3D = lod.xyz[nodes]
+    with torch.no_grad():
+        rendered_image, radii = rasterizer(
+            means3D = means3D,
+            means2D = torch.zeros_like(means3D),
+            shs = lod.features[nodes],
+            colors_precomp = None,
+            opacities = lod.opacity[nodes],
+            scales = None,
+            rotations = None,
+            cov3D_precomp = lod.cov3D[nodes])
+
+    return {"render": rendered_image,
+            "nodes": nodes,
+            "visibility_filter" : radii > 0,
+            "radii": radii}
+
+def render_compressed(viewpoint_camera, model, pipe, bg_color : torch.Tensor, kernel_size: float, scaling_modifier = 1.0, raster_context=None):
+    """
+    Render a CompressedGaussianModel. The rasterizer decodes its attributes
+    per Gaussian, they are never expanded to float tensors. No gradients.
+    """
+    raster_settings = GaussianRasterizationSettings(
+        image_height=int(viewpoint_camera.image_height),
+        image_width=int(viewpoint_camera.image_width),
+        tanfovx=math.tan(viewpoint_camera.FoVx * 0.5),
+        tanfovy=math.tan(viewpoint_camera.FoVy * 0.5),
+        kernel_size=kernel_size,
+        subpixel_offset=torch.zeros((int(viewpoint_camera.image_height), int(viewpoint_camera.image_width), 2), dtype=torch.float32, device=model.xyz.device),
+        bg=bg_color,
+        scale_modifier=scaling_modifier,
+        viewmatrix=viewpoint_camera.world_view_transform,
+        projmatrix=viewpoint_camera.full_proj_transform,
+        sh_degree=model.active_sh_degree,
+        campos=viewpoint_camera.camera_center,
+        prefiltered=False,
+        debug=pipe.debug,
+        context=raster_context
+    )
+
+    # The 3D filter is already part of the compressed opacities and scales
+    rendered_image, radii = rasterize_gaussians_compressed(model.xyz, model.attributes, raster_settings)
+
+    return {"render": rendered_image,
+            "visibility_filter" : radii > 0,
+            "radii": radii}
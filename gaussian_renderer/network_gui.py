@@ -3,7 +3,7 @@
 # GRAPHDECO research group, https://team.inria.fr/graphdeco
 # All rights reserved.
 #
-# This software is free for non-commercial, research and evaluation use 
+# This software is free for non-commercial, research and evaluation use
 # under the terms of the LICENSE.md file.
 #
 # For inquiries contact  george.drettakis@inria.fr
@@ -11,51 +11,24 @@
 
 import torch
 import traceback
-import socket
 import json
 from scene.cameras import MiniCam
+from splat_io import ViewerServer
 
-host = "127.0.0.1"
-port = 6009
+# Viewer connections are served by a native server (splat_io.ViewerServer)
+# that accepts several clients and encodes and sends frames on its own
+# threads. Training only polls for the newest camera request and renders
+# it; it no longer waits for the viewer unless a client pauses training.
 
-conn = None
-addr = None
-
-listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+server = None
+hold = False
 
 def init(wish_host, wish_port):
-    global host, port, listener
-    host = wish_host
-    port = wish_port
-    listener.bind((host, port))
-    listener.listen()
-    listener.settimeout(0)
-
-def try_connect():
-    global conn, addr, listener
-    try:
-        conn, addr = listener.accept()
-        print(f"\nConnected by {addr}")
-        conn.settimeout(None)
-    except Exception as inst:
-        pass
-            
-def read():
-    global conn
-    messageLength = conn.recv(4)
-    messageLength = int.from_bytes(messageLength, 'little')
-    message = conn.recv(messageLength)
-    return json.loads(message.decode("utf-8"))
+    global server
+    server = ViewerServer(wish_host, wish_port)
 
-def send(message_bytes, verify):
-    global conn
-    if message_bytes != None:
-        conn.sendall(message_bytes)
-    conn.sendall(len(verify).to_bytes(4, 'little'))
-    conn.sendall(bytes(verify, 'ascii'))
-
-def receive():
-    message = read()
+def parse(message):
+    message = json.loads(message)
 
     width = message["resolution_x"]
     height = message["resolution_y"]
@@ -83,4 +56,38 @@ def receive():
             raise e
         return custom_cam, do_training, do_shs_python, do_rot_scale_python, keep_alive, scaling_modifier
     else:
-        return None, None, None, None, None, None
\ No newline at end of file
+        return None, None, None, None, None, None
+
+def serve(render_frame, verify, finished):
+    # Answers the pending viewer requests. render_frame(custom_cam,
+    # do_shs_python, do_rot_scale_python, scaling_modifier) returns the
+    # (3, H, W) image of a request. Returns right away unless a client asked
+    # to pause training, or training is finished and a client asked to keep
+    # it alive; then requests are served until that changes or the clients
+    # are gone.
+    global hold
+    while server is not None:
+        request = server.poll(10 if hold else 0)
+        if request is None:
+            if hold and server.stats()["clients"] == 0:
+                hold = False
+            if not hold:
+                return
+            continue
+
+        client, message = request
+        encoding = "raw"
+        image = None
+        try:
+            if json.loads(message).get("encoding") == "jpeg":
+                encoding = "jpeg"
+            custom_cam, do_training, do_shs_python, do_rot_scale_python, keep_alive, scaling_modifier = parse(message)
+            if custom_cam != None:
+                image = render_frame(custom_cam, do_shs_python, do_rot_scale_python, scaling_modifier)
+                hold = not do_training or (finished and keep_alive)
+        except Exception:
+            # The client still gets its reply, without an image
+            traceback.print_exc()
+        server.reply(client, image, encoding, verify)
+        if not hold:
+            return
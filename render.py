@@ -14,27 +14,72 @@ from scene import Scene
 import os
 from tqdm import tqdm
 from os import makedirs
-from gaussian_renderer import render
+from gaussian_renderer import render, render_batched, render_lod, render_compressed
 import torchvision
 from utils.general_utils import safe_state
 from argparse import ArgumentParser
 from arguments import ModelParams, PipelineParams, get_combined_args
 from gaussian_renderer import GaussianModel
+from scene.gaussian_lod import GaussianLOD
+from scene.gaussian_compressed import CompressedGaussianModel
+from scene.gaussian_streaming import StreamingGaussianModel, build_chunked
+from diff_gaussian_rasterization import RasterizerContext
+from utils.render_pipeline import RenderPipeline
+import time
 
-def render_set(model_path, name, iteration, views, gaussians, pipeline, background, kernel_size, scale_factor):
+def save_views(renderings, indices, views, render_path, gts_path, pipeline_stages, method, start):
+    if pipeline_stages is not None:
+        torch.cuda.synchronize()
+        pipeline_stages.rendered(time.perf_counter() - start)
+    for rendering, idx in zip(renderings, indices):
+        gt = views[idx].original_image[0:3, :, :]
+        render_file = os.path.join(render_path, '{0:05d}'.format(idx) + ".png")
+        gt_file = os.path.join(gts_path, '{0:05d}'.format(idx) + ".png")
+        if pipeline_stages is not None:
+            pipeline_stages.add(rendering, gt, render_file, gt_file, method)
+        else:
+            torchvision.utils.save_image(rendering, render_file)
+            torchvision.utils.save_image(gt, gt_file)
+
+def render_set(model_path, name, iteration, views, gaussians, pipeline, background, kernel_size, scale_factor, batch_size=1, lod=None, lod_target_size=1.0, pipeline_stages=None, compressed=None, streamed=None):
+    # With pipeline_stages (a RenderPipeline), images are written and the
+    # test views scored behind the renderer
+    method = "ours_{}".format(iteration) if name == "test" else None
     render_path = os.path.join(model_path, name, "ours_{}".format(iteration), f"test_preds_{scale_factor}")
     gts_path = os.path.join(model_path, name, "ours_{}".format(iteration), f"gt_{scale_factor}")\
 
     makedirs(render_path, exist_ok=True)
     makedirs(gts_path, exist_ok=True)
 
+    raster_context = RasterizerContext() if pipeline.persistent_buffers else None
+    if batch_size > 1 and lod is None and compressed is None and streamed is None:
+        # Group consecutive views of equal resolution into batches
+        batches = []
+        for idx, view in enumerate(views):
+            if batches and len(batches[-1]) < batch_size and \
+               (views[batches[-1][0]].image_height, views[batches[-1][0]].image_width) == (view.image_height, view.image_width):
+                batches[-1].append(idx)
+            else:
+                batches.append([idx])
+        for batch in tqdm(batches, desc="Rendering progress"):
+            start = time.perf_counter()
+            renderings = render_batched([views[idx] for idx in batch], gaussians, pipeline, background, kernel_size=kernel_size, raster_context=raster_context)["render"]
+            save_views(renderings, batch, views, render_path, gts_path, pipeline_stages, method, start)
+        return
+
     for idx, view in enumerate(tqdm(views, desc="Rendering progress")):
-        rendering = render(view, gaussians, pipeline, background, kernel_size=kernel_size)["render"]
-        gt = view.original_image[0:3, :, :]
-        torchvision.utils.save_image(rendering, os.path.join(render_path, '{0:05d}'.format(idx) + ".png"))
-        torchvision.utils.save_image(gt, os.path.join(gts_path, '{0:05d}'.format(idx) + ".png"))
+        start = time.perf_counter()
+        if lod is not None:
+            rendering = render_lod(view, lod, pipeline, background, kernel_size=kernel_size, target_size=lod_target_size, raster_context=raster_context)["render"]
+        elif compressed is not None:
+            rendering = render_compressed(view, compressed, pipeline, background, kernel_size=kernel_size, raster_context=raster_context)["render"]
+        elif streamed is not None:
+            rendering = render_compressed(view, streamed.gather(view), pipeline, background, kernel_size=kernel_size, raster_context=raster_context)["render"]
+        else:
+            rendering = render(view, gaussians, pipeline, background, kernel_size=kernel_size, raster_context=raster_context)["render"]
+        save_views([rendering], [idx], views, render_path, gts_path, pipeline_stages, method, start)
 
-def render_sets(dataset : ModelParams, iteration : int, pipeline : PipelineParams, skip_train : bool, skip_test : bool):
+def render_sets(dataset : ModelParams, iteration : int, pipeline : PipelineParams, skip_train : bool, skip_test : bool, batch_size : int = 1, lod_target_size : float = 0.0, pipelined : bool = False, metrics : bool = False, compressed : bool = False, streamed : bool = False, host_budget_mb : int = 2048, device_budget_mb : int = 1024):
     with torch.no_grad():
         gaussians = GaussianModel(dataset.sh_degree)
         scene = Scene(dataset, gaussians, load_iteration=iteration, shuffle=False)
@@ -42,11 +87,41 @@ def render_sets(dataset : ModelParams, iteration : int, pipeline : PipelineParam
         bg_color = [1,1,1] if dataset.white_background else [0, 0, 0]
         background = torch.tensor(bg_color, dtype=torch.float32, device="cuda")
         kernel_size = dataset.kernel_size
+
+        # Render cuts of the LOD tree (built by build_lod.py, or here)
+        lod = None
+        if lod_target_size > 0:
+            lod_path = os.path.join(dataset.model_path, "point_cloud", "iteration_{}".format(scene.loaded_iter), "lod.splat")
+            lod = GaussianLOD.load(lod_path) if os.path.exists(lod_path) else GaussianLOD.build(gaussians)
+        # Render the compressed model (written by compress.py, or built here)
+        compressed_model = None
+        compressed_path = os.path.join(dataset.model_path, "point_cloud", "iteration_{}".format(scene.loaded_iter), "compressed.splat")
+        if compressed:
+            compressed_model = CompressedGaussianModel.load(compressed_path) if os.path.exists(compressed_path) else CompressedGaussianModel.compress(gaussians)
+        # Stream the chunks of the compressed model (built by build_chunks.py,
+        # or here) through host and device memory budgets
+        streamed_model = None
+        if streamed:
+            chunked_path = os.path.join(os.path.dirname(compressed_path), "chunked.splat")
+            if not os.path.exists(chunked_path):
+                if not os.path.exists(compressed_path):
+                    CompressedGaussianModel.compress(gaussians).save(compressed_path)
+                build_chunked(compressed_path, chunked_path)
+            streamed_model = StreamingGaussianModel(chunked_path, host_budget_mb << 20, device_budget_mb << 20)
+        pipeline_stages = RenderPipeline(metrics) if pipelined or metrics else None
         if not skip_train:
-             render_set(dataset.model_path, "train", scene.loaded_iter, scene.getTrainCameras(), gaussians, pipeline, background, kernel_size, scale_factor=scale_factor)
+             render_set(dataset.model_path, "train", scene.loaded_iter, scene.getTrainCameras(), gaussians, pipeline, background, kernel_size, scale_factor=scale_factor, batch_size=batch_size, lod=lod, lod_target_size=lod_target_size, pipeline_stages=pipeline_stages, compressed=compressed_model, streamed=streamed_model)
 
         if not skip_test:
-             render_set(dataset.model_path, "test", scene.loaded_iter, scene.getTestCameras(), gaussians, pipeline, background, kernel_size, scale_factor=scale_factor)
+             render_set(dataset.model_path, "test", scene.loaded_iter, scene.getTestCameras(), gaussians, pipeline, background, kernel_size, scale_factor=scale_factor, batch_size=batch_size, lod=lod, lod_target_size=lod_target_size, pipeline_stages=pipeline_stages, compressed=compressed_model, streamed=streamed_model)
+
+        if pipeline_stages is not None:
+            pipeline_stages.finish(dataset.model_path)
+        if streamed_model is not None:
+            stats = streamed_model.stats()
+            print("\nStreaming ({} chunks): hit rate {:.1%}, {} stalls ({:.2f} s), {} loads ({:.1f} MB), {} evictions, peak host {:.1f} MB".format(
+                streamed_model.num_chunks, stats["hit_rate"], stats["host_stalls"], stats["host_stall_ms"] / 1000, stats["host_loads"],
+                stats["host_bytes_loaded"] / 2**20, stats["host_evictions"] + stats["device_evictions"], stats["host_peak_bytes"] / 2**20))
 
 if __name__ == "__main__":
     # Set up command line argument parser
@@ -57,10 +132,21 @@ if __name__ == "__main__":
     parser.add_argument("--skip_train", action="store_true")
     parser.add_argument("--skip_test", action="store_true")
     parser.add_argument("--quiet", action="store_true")
+    parser.add_argument("--batch_size", default=1, type=int)
+    parser.add_argument("--lod_target_size", default=0.0, type=float)
+    # Write images on native encoder threads; --metrics also scores the test
+    # views in memory and writes the results of metrics.py
+    parser.add_argument("--pipelined", action="store_true")
+    parser.add_argument("--metrics", action="store_true")
+    parser.add_argument("--compressed", action="store_true")
+    # Render the compressed model out of core, in chunks loaded on demand
+    parser.add_argument("--streamed", action="store_true")
+    parser.add_argument("--host_budget_mb", default=2048, type=int)
+    parser.add_argument("--device_budget_mb", default=1024, type=int)
     args = get_combined_args(parser)
     print("Rendering " + args.model_path)
 
     # Initialize system state (RNG)
     safe_state(args.quiet)
 
-    render_sets(model.extract(args), args.iteration, pipeline.extract(args), args.skip_train, args.skip_test)
\ No newline at end of file
+    render_sets(model.extract(args), args.iteration, pipeline.extract(args), args.skip_train, args.skip_test, args.batch_size, args.lod_target_size, args.pipelined, args.metrics, args.compressed, args.streamed, args.host_budget_mb, args.device_budget_mb)
\ No newline at end of file
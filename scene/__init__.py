@@ -17,6 +17,7 @@ from scene.dataset_readers import sceneLoadTypeCallbacks
 from scene.gaussian_model import GaussianModel
 from arguments import ModelParams
 from utils.camera_utils import cameraList_from_camInfos, camera_to_JSON
+from splat_io import ImagePyramid
 
 class Scene:
 
@@ -39,15 +40,18 @@ class Scene:
 
         self.train_cameras = {}
         self.test_cameras = {}
+        self.image_pyramid = None
 
         if os.path.exists(os.path.join(args.source_path, "sparse")):
-            scene_info = sceneLoadTypeCallbacks["Colmap"](args.source_path, args.images, args.eval)
+            scene_info = sceneLoadTypeCallbacks["Colmap"](args.source_path, args.images, args.eval, load_images=not args.image_cache)
         elif os.path.exists(os.path.join(args.source_path, "transforms_train.json")):
             print("Found transforms_train.json file, assuming Blender data set!")
+            if args.image_cache:
+                print("The image cache does not support Blender data sets, loading images directly")
             scene_info = sceneLoadTypeCallbacks["Blender"](args.source_path, args.white_background, args.eval)
         elif os.path.exists(os.path.join(args.source_path, "metadata.json")):
             print("Found metadata.json file, assuming multi scale Blender data set!")
-            scene_info = sceneLoadTypeCallbacks["Multi-scale"](args.source_path, args.white_background, args.eval, args.load_allres)
+            scene_info = sceneLoadTypeCallbacks["Multi-scale"](args.source_path, args.white_background, args.eval, args.load_allres, load_images=not args.image_cache)
         else:
             assert False, "Could not recognize scene type!"
 
@@ -71,23 +75,35 @@ class Scene:
 
         self.cameras_extent = scene_info.nerf_normalization["radius"]
 
+        cam_infos = scene_info.train_cameras + scene_info.test_cameras
+        if cam_infos and cam_infos[0].image is None:
+            # Decode into the 1x/2x/4x/8x pyramid cached in image_cache_dir,
+            # only images that changed since the last run are decoded again.
+            # The dataset directory is left alone, it may be read-only.
+            composite = "sparse" not in os.listdir(args.source_path)
+            background = ([1, 1, 1] if args.white_background else [0, 0, 0]) if composite else None
+            cache_dir = args.image_cache_dir or self.model_path
+            os.makedirs(cache_dir, exist_ok=True)
+            cache_path = os.path.join(cache_dir, "image_cache_r{}.pyr".format(args.resolution))
+            self.image_pyramid = ImagePyramid([c.image_path for c in cam_infos], cache_path, args.resolution, background=background)
+            print("Decoded {} of {} images into {}".format(self.image_pyramid.prepare(), len(cam_infos), cache_path))
+
         for resolution_scale in resolution_scales:
             print("Loading Training Cameras")
-            self.train_cameras[resolution_scale] = cameraList_from_camInfos(scene_info.train_cameras, resolution_scale, args)
+            self.train_cameras[resolution_scale] = cameraList_from_camInfos(scene_info.train_cameras, resolution_scale, args, self.image_pyramid)
             print("Loading Test Cameras")
-            self.test_cameras[resolution_scale] = cameraList_from_camInfos(scene_info.test_cameras, resolution_scale, args)
+            self.test_cameras[resolution_scale] = cameraList_from_camInfos(scene_info.test_cameras, resolution_scale, args, self.image_pyramid)
 
         if self.loaded_iter:
-            self.gaussians.load_ply(os.path.join(self.model_path,
-                                                           "point_cloud",
-                                                           "iteration_" + str(self.loaded_iter),
-                                                           "point_cloud.ply"))
+            self.gaussians.load(os.path.join(self.model_path,
+                                                       "point_cloud",
+                                                       "iteration_" + str(self.loaded_iter)))
         else:
             self.gaussians.create_from_pcd(scene_info.point_cloud, self.cameras_extent)
 
     def save(self, iteration):
         point_cloud_path = os.path.join(self.model_path, "point_cloud/iteration_{}".format(iteration))
-        self.gaussians.save_ply(os.path.join(point_cloud_path, "point_cloud.ply"))
+        self.gaussians.save_splat(os.path.join(point_cloud_path, "point_cloud.splat"))
 
     def getTrainCameras(self, scale=1.0):
         return self.train_cameras[scale]
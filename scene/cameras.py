@@ -17,7 +17,8 @@ from utils.graphics_utils import getWorld2View2, getProjectionMatrix
 class Camera(nn.Module):
     def __init__(self, colmap_id, R, T, FoVx, FoVy, image, gt_alpha_mask,
                  image_name, uid,
-                 trans=np.array([0.0, 0.0, 0.0]), scale=1.0, data_device = "cuda"
+                 trans=np.array([0.0, 0.0, 0.0]), scale=1.0, data_device = "cuda",
+                 image_source=None
                  ):
         super(Camera, self).__init__()
 
@@ -36,14 +37,17 @@ class Camera(nn.Module):
             print(f"[Warning] Custom device {data_device} failed, fallback to default cuda device" )
             self.data_device = torch.device("cuda")
 
-        self.original_image = image.clamp(0.0, 1.0).to(self.data_device)
-        self.image_width = self.original_image.shape[2]
-        self.image_height = self.original_image.shape[1]
-
-        if gt_alpha_mask is not None:
-            self.original_image *= gt_alpha_mask.to(self.data_device)
+        # Without an image, it is taken from image_source, a (ImagePyramid,
+        # path, factor) triple, on every access instead of being held
+        self.image_source = image_source
+        if image is not None:
+            self._original_image = self.prepare_image(image, gt_alpha_mask)
+            self.image_width = self._original_image.shape[2]
+            self.image_height = self._original_image.shape[1]
         else:
-            self.original_image *= torch.ones((1, self.image_height, self.image_width), device=self.data_device)
+            self._original_image = None
+            pyramid, path, factor = image_source
+            self.image_width, self.image_height, _ = pyramid.size(path, factor)
 
         self.zfar = 100.0
         self.znear = 0.01
@@ -60,6 +64,34 @@ class Camera(nn.Module):
         tan_fovy = np.tan(self.FoVy / 2.0)
         self.focal_y = self.image_height / (2.0 * tan_fovy)
         self.focal_x = self.image_width / (2.0 * tan_fovx)
+
+    def prepare_image(self, image, gt_alpha_mask):
+        image = image.clamp(0.0, 1.0).to(self.data_device)
+        if gt_alpha_mask is not None:
+            image *= gt_alpha_mask.to(self.data_device)
+        else:
+            image *= torch.ones((1, image.shape[1], image.shape[2]), device=self.data_device)
+        return image
+
+    @property
+    def original_image(self):
+        if self._original_image is not None:
+            return self._original_image
+        pyramid, path, factor = self.image_source
+        image = pyramid.take(path, factor)
+        return self.prepare_image(image[:3, ...], image[3:4, ...] if image.shape[0] == 4 else None)
+
+    def prefetch(self):
+        # Starts loading the image of a camera without one ahead of its use
+        if self._original_image is None:
+            pyramid, path, factor = self.image_source
+            pyramid.submit(path, factor)
+
+    def cancel_prefetch(self):
+        # Releases the slot of a prefetch that will not be used
+        if self._original_image is None:
+            pyramid, path, factor = self.image_source
+            pyramid.cancel(path, factor)
          
 class MiniCam:
     def __init__(self, width, height, fovy, fovx, znear, zfar, world_view_transform, full_proj_transform):
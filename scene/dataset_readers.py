@@ -66,7 +66,7 @@ def getNerfppNorm(cam_info):
 
     return {"translate": translate, "radius": radius}
 
-def readColmapCameras(cam_extrinsics, cam_intrinsics, images_folder):
+def readColmapCameras(cam_extrinsics, cam_intrinsics, images_folder, load_images=True):
     cam_infos = []
     for idx, key in enumerate(cam_extrinsics):
         sys.stdout.write('\r')
@@ -97,9 +97,13 @@ def readColmapCameras(cam_extrinsics, cam_intrinsics, images_folder):
 
         image_path = os.path.join(images_folder, os.path.basename(extr.name))
         image_name = os.path.basename(image_path).split(".")[0]
-        image = Image.open(image_path)
-        # get rid of too many opened files
-        image = copy.deepcopy(image)
+        if load_images:
+            image = Image.open(image_path)
+            # get rid of too many opened files
+            image = copy.deepcopy(image)
+        else:
+            # Decoded later by the scene's image loader
+            image = None
         cam_info = CameraInfo(uid=uid, R=R, T=T, FovY=FovY, FovX=FovX, image=image,
                               image_path=image_path, image_name=image_name, width=width, height=height)
         cam_infos.append(cam_info)
@@ -120,22 +124,22 @@ def storePly(path, xyz, rgb):
             ('nx', 'f4'), ('ny', 'f4'), ('nz', 'f4'),
             ('red', 'u1'), ('green', 'u1'), ('blue', 'u1')]
     
-    normals = np.zeros_like(xyz)
-
-    elements = np.empty(xyz.shape[0], dtype=dtype)
-    attributes = np.concatenate((xyz, normals, rgb), axis=1)
-    elements[:] = list(map(tuple, attributes))
+    elements = np.zeros(xyz.shape[0], dtype=dtype)
+    for i, name in enumerate(['x', 'y', 'z']):
+        elements[name] = xyz[:, i]
+    for i, name in enumerate(['red', 'green', 'blue']):
+        elements[name] = rgb[:, i]
 
     # Create the PlyData object and write to file
     vertex_element = PlyElement.describe(elements, 'vertex')
     ply_data = PlyData([vertex_element])
     ply_data.write(path)
 
-def readColmapSceneInfo(path, images, eval, llffhold=8):
+def readColmapSceneInfo(path, images, eval, llffhold=8, load_images=True):
     try:
         cameras_extrinsic_file = os.path.join(path, "sparse/0", "images.bin")
         cameras_intrinsic_file = os.path.join(path, "sparse/0", "cameras.bin")
-        cam_extrinsics = read_extrinsics_binary(cameras_extrinsic_file)
+        cam_extrinsics = read_extrinsics_binary(cameras_extrinsic_file, read_points2D=False)
         cam_intrinsics = read_intrinsics_binary(cameras_intrinsic_file)
     except:
         cameras_extrinsic_file = os.path.join(path, "sparse/0", "images.txt")
@@ -144,7 +148,7 @@ def readColmapSceneInfo(path, images, eval, llffhold=8):
         cam_intrinsics = read_intrinsics_text(cameras_intrinsic_file)
 
     reading_dir = "images" if images == None else images
-    cam_infos_unsorted = readColmapCameras(cam_extrinsics=cam_extrinsics, cam_intrinsics=cam_intrinsics, images_folder=os.path.join(path, reading_dir))
+    cam_infos_unsorted = readColmapCameras(cam_extrinsics=cam_extrinsics, cam_intrinsics=cam_intrinsics, images_folder=os.path.join(path, reading_dir), load_images=load_images)
     cam_infos = sorted(cam_infos_unsorted.copy(), key = lambda x : x.image_name)
 
     if eval:
@@ -159,6 +163,7 @@ def readColmapSceneInfo(path, images, eval, llffhold=8):
     ply_path = os.path.join(path, "sparse/0/points3D.ply")
     bin_path = os.path.join(path, "sparse/0/points3D.bin")
     txt_path = os.path.join(path, "sparse/0/points3D.txt")
+    pcd = None
     if not os.path.exists(ply_path):
         print("Converting point3d.bin to .ply, will happen only the first time you open the scene.")
         try:
@@ -166,10 +171,14 @@ def readColmapSceneInfo(path, images, eval, llffhold=8):
         except:
             xyz, rgb, _ = read_points3D_text(txt_path)
         storePly(ply_path, xyz, rgb)
-    try:
-        pcd = fetchPly(ply_path)
-    except:
-        pcd = None
+        # Same values as reading the .ply back, without parsing it
+        pcd = BasicPointCloud(points=xyz.astype(np.float32), colors=rgb.astype(np.uint8) / 255.0,
+                              normals=np.zeros_like(xyz, dtype=np.float32))
+    if pcd is None:
+        try:
+            pcd = fetchPly(ply_path)
+        except:
+            pcd = None
 
     scene_info = SceneInfo(point_cloud=pcd,
                            train_cameras=train_cam_infos,
@@ -256,7 +265,7 @@ def readNerfSyntheticInfo(path, white_background, eval, extension=".png"):
                            ply_path=ply_path)
     return scene_info
 
-def readMultiScale(path, white_background,split, only_highres=False):
+def readMultiScale(path, white_background,split, only_highres=False, load_images=True):
     cam_infos = []
     
     print("read split:", split)
@@ -282,32 +291,38 @@ def readMultiScale(path, white_background,split, only_highres=False):
         R = np.transpose(w2c[:3,:3])  # R is stored transposed due to 'glm' in CUDA code
         T = w2c[:3, 3]
 
-        image = Image.open(image_path)
+        if load_images:
+            image = Image.open(image_path)
 
-        im_data = np.array(image.convert("RGBA"))
+            im_data = np.array(image.convert("RGBA"))
 
-        bg = np.array([1,1,1]) if white_background else np.array([0, 0, 0])
+            bg = np.array([1,1,1]) if white_background else np.array([0, 0, 0])
 
-        norm_data = im_data / 255.0
-        arr = norm_data[:,:,:3] * norm_data[:, :, 3:4] + bg * (1 - norm_data[:, :, 3:4])
-        image = Image.fromarray(np.array(arr*255.0, dtype=np.byte), "RGB")
+            norm_data = im_data / 255.0
+            arr = norm_data[:,:,:3] * norm_data[:, :, 3:4] + bg * (1 - norm_data[:, :, 3:4])
+            image = Image.fromarray(np.array(arr*255.0, dtype=np.byte), "RGB")
+            width, height = image.size
+        else:
+            # Decoded and composited later by the scene's image loader
+            image = None
+            width, height = int(meta["width"][idx]), int(meta["height"][idx])
 
-        fovx = focal2fov(meta["focal"][idx], image.size[0])
-        fovy = focal2fov(meta["focal"][idx], image.size[1])
+        fovx = focal2fov(meta["focal"][idx], width)
+        fovy = focal2fov(meta["focal"][idx], height)
         FovY = fovy 
         FovX = fovx
 
         cam_infos.append(CameraInfo(uid=idx, R=R, T=T, FovY=FovY, FovX=FovX, image=image,
-                        image_path=image_path, image_name=image_name, width=image.size[0], height=image.size[1]))
+                        image_path=image_path, image_name=image_name, width=width, height=height))
     return cam_infos
 
 
-def readMultiScaleNerfSyntheticInfo(path, white_background, eval, load_allres=False):
+def readMultiScaleNerfSyntheticInfo(path, white_background, eval, load_allres=False, load_images=True):
     print("Reading train from metadata.json")
-    train_cam_infos = readMultiScale(path, white_background, "train", only_highres=(not load_allres))
+    train_cam_infos = readMultiScale(path, white_background, "train", only_highres=(not load_allres), load_images=load_images)
     print("number of training images:", len(train_cam_infos))
     print("Reading test from metadata.json")
-    test_cam_infos = readMultiScale(path, white_background, "test", only_highres=False)
+    test_cam_infos = readMultiScale(path, white_background, "test", only_highres=False, load_images=load_images)
     print("number of testing images:", len(test_cam_infos))
     if not eval:
         print("adding test cameras to training")
@@ -0,0 +1,101 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import os
+import torch
+from utils.system_utils import mkdir_p
+from splat_io import load_splat, save_splat
+from diff_gaussian_rasterization import CompressedGaussians
+from scene.gaussian_model import GaussianModel
+
+def vector_quantize(vectors, codebook_size, iterations=10, chunk_size=1 << 14):
+    # k-means (Lloyd) over the rows of vectors (N, dim). Returns the codebook
+    # (K, dim) and the entry of every row (N,). Distances are evaluated
+    # chunk_size rows at a time to bound the memory of the (rows, K) matrix.
+    count, dim = vectors.shape
+    K = max(1, min(codebook_size, count))
+    if dim == 0 or count == 0:
+        return vectors.new_zeros((K, dim)), torch.zeros(count, dtype=torch.long, device=vectors.device)
+
+    codebook = vectors[torch.randperm(count, device=vectors.device)[:K]].clone()
+    index = torch.empty(count, dtype=torch.long, device=vectors.device)
+    for iteration in range(iterations + 1):
+        norms = codebook.square().sum(dim=1)
+        for start in range(0, count, chunk_size):
+            chunk = vectors[start:start + chunk_size]
+            index[start:start + chunk_size] = torch.addmm(norms[None, :], chunk, codebook.T, alpha=-2).argmin(dim=1)
+        if iteration == iterations:
+            break
+
+        sums = torch.zeros_like(codebook).index_add_(0, index, vectors)
+        counts = torch.bincount(index, minlength=K)
+        codebook = torch.where(counts[:, None] > 0, sums / counts.clamp_min(1)[:, None], codebook)
+        # Unused entries restart at random rows
+        unused = (counts == 0).nonzero().squeeze(1)
+        if unused.numel() > 0:
+            codebook[unused] = vectors[torch.randint(count, (unused.numel(),), device=vectors.device)]
+    return codebook, index
+
+class CompressedGaussianModel:
+    """
+    A trained model for serving: the higher SH bands vector-quantized into a
+    codebook with an index per Gaussian, the other attributes except the
+    means in half precision, and the 3D filter folded into opacities and
+    scales. The rasterizer decodes these per Gaussian, see
+    render_compressed. Inference only.
+    """
+
+    def __init__(self, xyz, attributes : CompressedGaussians, sh_degree : int):
+        self.xyz = xyz
+        self.attributes = attributes
+        self.max_sh_degree = sh_degree
+        self.active_sh_degree = sh_degree
+
+    @staticmethod
+    @torch.no_grad()
+    def compress(gaussians : GaussianModel, codebook_size=4096, iterations=10):
+        rest = gaussians._features_rest.detach()
+        codebook, index = vector_quantize(rest.flatten(start_dim=1), codebook_size, iterations)
+        attributes = CompressedGaussians(
+            features_dc=gaussians._features_dc.detach().half().contiguous(),
+            sh_codebook=codebook.view(codebook.shape[0], rest.shape[1], 3).contiguous(),
+            sh_index=index.int(),
+            opacities=gaussians.get_opacity_with_3D_filter.half().contiguous(),
+            scales=gaussians.get_scaling_with_3D_filter.half().contiguous(),
+            rotations=gaussians.get_rotation.half().contiguous())
+        return CompressedGaussianModel(gaussians.get_xyz.detach().contiguous(), attributes, gaussians.max_sh_degree)
+
+    @property
+    def num_gaussians(self):
+        return self.xyz.shape[0]
+
+    @property
+    def num_bytes(self):
+        return sum(t.numel() * t.element_size() for t in (self.xyz, *self.attributes))
+
+    @staticmethod
+    def codebook_path(path):
+        # The codebook has its own row count, so it is kept in a second file
+        return os.path.splitext(path)[0] + "_codebook.splat"
+
+    def save(self, path):
+        mkdir_p(os.path.dirname(path))
+        save_splat(path, self.max_sh_degree, [("xyz", self.xyz)] +
+                   [(name, getattr(self.attributes, name)) for name in CompressedGaussians._fields if name != "sh_codebook"])
+        save_splat(CompressedGaussianModel.codebook_path(path), self.max_sh_degree, [("sh_codebook", self.attributes.sh_codebook)])
+
+    @staticmethod
+    def load(path, device="cuda"):
+        sh_degree, tensors = load_splat(path)
+        _, codebook = load_splat(CompressedGaussianModel.codebook_path(path))
+        tensors["sh_codebook"] = codebook["sh_codebook"]
+        attributes = CompressedGaussians(*[tensors[name].to(device) for name in CompressedGaussians._fields])
+        return CompressedGaussianModel(tensors["xyz"].to(device), attributes, sh_degree)
@@ -0,0 +1,62 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import math
+import os
+import torch
+from utils.system_utils import mkdir_p
+from splat_io import load_splat, save_splat
+from diff_gaussian_rasterization import LODTree, build_lod_tree, select_lod_cut
+from scene.gaussian_model import GaussianModel
+
+class GaussianLOD:
+    """
+    Level-of-detail hierarchy over a trained model. Leaves are the model's
+    Gaussians with the 3D filter applied, inner nodes their moment-matched
+    merges. The tree structure stays on the host, where cuts are selected;
+    the node Gaussians are kept on the render device.
+    """
+
+    def __init__(self, tree : LODTree, sh_degree : int, device="cuda"):
+        self.tree = tree
+        self.max_sh_degree = sh_degree
+        self.active_sh_degree = sh_degree
+        self.xyz = tree.means3D.to(device)
+        self.cov3D = tree.cov3D.to(device)
+        self.opacity = tree.opacities.to(device)
+        self.features = tree.features.to(device)
+
+    @staticmethod
+    @torch.no_grad()
+    def build(gaussians : GaussianModel, device="cuda"):
+        cov3D = gaussians.covariance_activation(gaussians.get_scaling_with_3D_filter, 1.0, gaussians._rotation)
+        tree = build_lod_tree(gaussians.get_xyz, cov3D, gaussians.get_opacity_with_3D_filter, gaussians.get_features)
+        return GaussianLOD(tree, gaussians.max_sh_degree, device)
+
+    @property
+    def num_nodes(self):
+        return self.xyz.shape[0]
+
+    def save(self, path):
+        mkdir_p(os.path.dirname(path))
+        save_splat(path, self.max_sh_degree, [(name, getattr(self.tree, name)) for name in LODTree._fields])
+
+    @staticmethod
+    def load(path, device="cuda"):
+        sh_degree, tensors = load_splat(path)
+        return GaussianLOD(LODTree(*[tensors[name] for name in LODTree._fields]), sh_degree, device)
+
+    def cut(self, viewpoint_camera, target_size=1.0):
+        # Node ids on the render device of the cut for this camera
+        focal = max(viewpoint_camera.image_width / (2.0 * math.tan(viewpoint_camera.FoVx * 0.5)),
+                    viewpoint_camera.image_height / (2.0 * math.tan(viewpoint_camera.FoVy * 0.5)))
+        nodes = select_lod_cut(self.tree, viewpoint_camera.camera_center, focal, target_size)
+        return nodes.to(self.xyz.device)
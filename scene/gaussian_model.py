@@ -10,6 +10,7 @@
 #
 
 import torch
+import math
 import numpy as np
 from utils.general_utils import inverse_sigmoid, get_expon_lr_func, build_rotation
 from torch import nn
@@ -18,6 +19,9 @@ from utils.system_utils import mkdir_p
 from plyfile import PlyData, PlyElement
 from utils.sh_utils import RGB2SH
 from simple_knn._C import distCUDA2
+from splat_io import load_splat, save_splat
+from splat_train import GaussianStore, SparseAdam
+from diff_gaussian_rasterization import compute_filter_3D, filter_3D_cameras, GaussianBVH
 from utils.graphics_utils import BasicPointCloud
 from utils.general_utils import strip_symmetric, build_scaling_rotation
 
@@ -56,21 +60,37 @@ class GaussianModel:
         self.optimizer = None
         self.percent_dense = 0
         self.spatial_lr_scale = 0
+        # Per-point cache of compute_3D_filter, see its incremental mode
+        self.filter_3D_distance = None
+        self.filter_3D_valid = None
+        self.filter_3D_pending = None
+        # Culling hierarchy, see visible_indices. Dropped when points are
+        # added or removed, marked stale when they move or change size.
+        self.bvh = None
+        self.bvh_stale = False
+        self.bvh_scaling_modifier = None
+        # Capacity-based storage of everything per point while training, see
+        # training_setup. The attributes above are then views of its columns.
+        self.store = None
         self.setup_functions()
 
     def capture(self):
+        # Tensors are views of the store's buffers, which would be saved
+        # whole, so only copies of the used rows go into the checkpoint
+        opt_dict = self.optimizer.state_dict()
+        opt_dict["state"] = {key: {name: value.clone() for name, value in state.items()} for key, state in opt_dict["state"].items()}
         return (
             self.active_sh_degree,
-            self._xyz,
-            self._features_dc,
-            self._features_rest,
-            self._scaling,
-            self._rotation,
-            self._opacity,
-            self.max_radii2D,
-            self.xyz_gradient_accum,
-            self.denom,
-            self.optimizer.state_dict(),
+            self._xyz.detach().clone(),
+            self._features_dc.detach().clone(),
+            self._features_rest.detach().clone(),
+            self._scaling.detach().clone(),
+            self._rotation.detach().clone(),
+            self._opacity.detach().clone(),
+            self.max_radii2D.clone(),
+            self.xyz_gradient_accum.clone(),
+            self.denom.clone(),
+            opt_dict,
             self.spatial_lr_scale,
         )
     
@@ -82,15 +102,22 @@ class GaussianModel:
         self._scaling, 
         self._rotation, 
         self._opacity,
-        self.max_radii2D, 
+        max_radii2D, 
         xyz_gradient_accum, 
         denom,
         opt_dict, 
         self.spatial_lr_scale) = model_args
         self.training_setup(training_args)
-        self.xyz_gradient_accum = xyz_gradient_accum
-        self.denom = denom
+        self.max_radii2D.copy_(max_radii2D)
+        self.xyz_gradient_accum.copy_(xyz_gradient_accum)
+        self.denom.copy_(denom)
         self.optimizer.load_state_dict(opt_dict)
+        # Loading replaces the moments, take them back into the store
+        self.store.bind_optimizer(self.optimizer)
+        self._sync_from_store()
+        if "adam_last_step" in self.store:
+            # All moments of the checkpoint are up to date
+            self.store["adam_last_step"].fill_(int(self.optimizer.state[self._xyz]["step"]))
 
     @property
     def get_scaling(self):
@@ -140,55 +167,63 @@ class GaussianModel:
         return self.covariance_activation(self.get_scaling, scaling_modifier, self._rotation)
 
     @torch.no_grad()
-    def compute_3D_filter(self, cameras):
+    def compute_3D_filter(self, cameras, incremental=False):
         print("Computing 3D filter")
         #TODO consider focal length and image width
-        xyz = self.get_xyz
-        distance = torch.ones((xyz.shape[0]), device=xyz.device) * 100000.0
-        valid_points = torch.zeros((xyz.shape[0]), device=xyz.device, dtype=torch.bool)
-        
+        xyz = self.get_xyz.detach()
+        camera_data = filter_3D_cameras(cameras, xyz.device)
+
+        # Minimum depth over the cameras that see a point, in a single pass.
+        # In incremental mode only the points added since the last call are
+        # evaluated, all others keep their cached depth.
+        if incremental and self.filter_3D_pending is not None and self.filter_3D_pending.shape[0] == xyz.shape[0]:
+            pending = self.filter_3D_pending.nonzero().squeeze(1)
+            if pending.numel() > 0:
+                distance, valid = compute_filter_3D(xyz[pending].contiguous(), camera_data)
+                self.filter_3D_distance[pending] = distance
+                self.filter_3D_valid[pending] = valid
+        else:
+            self.filter_3D_distance, self.filter_3D_valid = compute_filter_3D(xyz.contiguous(), camera_data)
+        self.filter_3D_pending = torch.zeros_like(self.filter_3D_valid)
+
+        distance = self.filter_3D_distance.clone()
+        valid_points = self.filter_3D_valid
+        if valid_points.any():
+            distance[~valid_points] = distance[valid_points].max()
+
         # we should use the focal length of the highest resolution camera
-        focal_length = 0.
-        for camera in cameras:
-
-            # transform points to camera space
-            R = torch.tensor(camera.R, device=xyz.device, dtype=torch.float32)
-            T = torch.tensor(camera.T, device=xyz.device, dtype=torch.float32)
-             # R is stored transposed due to 'glm' in CUDA code so we don't neet transopse here
-            xyz_cam = xyz @ R + T[None, :]
-            
-            xyz_to_cam = torch.norm(xyz_cam, dim=1)
-            
-            # project to screen space
-            valid_depth = xyz_cam[:, 2] > 0.2
-            
-            
-            x, y, z = xyz_cam[:, 0], xyz_cam[:, 1], xyz_cam[:, 2]
-            z = torch.clamp(z, min=0.001)
-            
-            x = x / z * camera.focal_x + camera.image_width / 2.0
-            y = y / z * camera.focal_y + camera.image_height / 2.0
-            
-            # in_screen = torch.logical_and(torch.logical_and(x >= 0, x < camera.image_width), torch.logical_and(y >= 0, y < camera.image_height))
-            
-            # use similar tangent space filtering as in the paper
-            in_screen = torch.logical_and(torch.logical_and(x >= -0.15 * camera.image_width, x <= camera.image_width * 1.15), torch.logical_and(y >= -0.15 * camera.image_height, y <= 1.15 * camera.image_height))
-            
-        
-            valid = torch.logical_and(valid_depth, in_screen)
-            
-            # distance[valid] = torch.min(distance[valid], xyz_to_cam[valid])
-            distance[valid] = torch.min(distance[valid], z[valid])
-            valid_points = torch.logical_or(valid_points, valid)
-            if focal_length < camera.focal_x:
-                focal_length = camera.focal_x
-        
-        distance[~valid_points] = distance[valid_points].max()
-        
+        focal_length = max(camera.focal_x for camera in cameras)
+
         #TODO remove hard coded value
         #TODO box to gaussian transform
         filter_3D = distance / focal_length * (0.2 ** 0.5)
         self.filter_3D = filter_3D[..., None]
+        self.bvh_stale = True
+
+        # The cache follows the points through densification as columns
+        if self.store is not None:
+            for name in ("filter_3D_distance", "filter_3D_valid", "filter_3D_pending"):
+                self.store.set_column(name, getattr(self, name))
+            self._sync_from_store()
+
+    @torch.no_grad()
+    def visible_indices(self, viewpoint_camera, kernel_size, scaling_modifier = 1.0):
+        # Sorted ids of the Gaussians that may be visible to the camera,
+        # culled with a BVH over the means. Conservative: rendering only
+        # these gives the same image as rendering all Gaussians.
+        sigma = (self.get_scaling_with_3D_filter * scaling_modifier).amax(dim=1)
+        if self.bvh is None or self.bvh.size != self.get_xyz.shape[0]:
+            self.bvh = GaussianBVH()
+            self.bvh.build(self.get_xyz, sigma)
+        elif self.bvh_stale or self.bvh_scaling_modifier != scaling_modifier:
+            self.bvh.refit(self.get_xyz, sigma)
+        self.bvh_stale = False
+        self.bvh_scaling_modifier = scaling_modifier
+
+        ids = self.bvh.cull(viewpoint_camera.world_view_transform, viewpoint_camera.full_proj_transform,
+                            int(viewpoint_camera.image_height), int(viewpoint_camera.image_width),
+                            math.tan(viewpoint_camera.FoVx * 0.5), math.tan(viewpoint_camera.FoVy * 0.5), kernel_size)
+        return ids.to(self.get_xyz.device)
         
     def oneupSHdegree(self):
         if self.active_sh_degree < self.max_sh_degree:
@@ -221,10 +256,20 @@ class GaussianModel:
 
     def training_setup(self, training_args):
         self.percent_dense = training_args.percent_dense
-        self.xyz_gradient_accum = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.xyz_gradient_accum_abs = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.xyz_gradient_accum_abs_max = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.denom = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
+        n = self.get_xyz.shape[0]
+
+        # Parameters, their Adam moments and all per-point statistics live
+        # in one store, so densification appends and prunes in place
+        self.store = GaussianStore()
+        for name, tensor in (("xyz", self._xyz), ("f_dc", self._features_dc), ("f_rest", self._features_rest),
+                             ("opacity", self._opacity), ("scaling", self._scaling), ("rotation", self._rotation)):
+            self.store.set_column(name, tensor.detach())
+        for name in ("xyz_gradient_accum", "xyz_gradient_accum_abs", "xyz_gradient_accum_abs_max", "denom"):
+            self.store.set_column(name, torch.zeros((n, 1), device="cuda"))
+        self.store.set_column("max_radii2D", torch.zeros((n), device="cuda"))
+        if self.filter_3D_pending is not None:
+            for name in ("filter_3D_distance", "filter_3D_valid", "filter_3D_pending"):
+                self.store.set_column(name, getattr(self, name))
 
         l = [
             {'params': [self._xyz], 'lr': training_args.position_lr_init * self.spatial_lr_scale, "name": "xyz"},
@@ -235,12 +280,26 @@ class GaussianModel:
             {'params': [self._rotation], 'lr': training_args.rotation_lr, "name": "rotation"}
         ]
 
-        self.optimizer = torch.optim.Adam(l, lr=0.0, eps=1e-15)
+        if training_args.sparse_adam:
+            # Step of the last update of every Gaussian, new ones start at 0
+            self.store.set_column("adam_last_step", torch.zeros((n), dtype=torch.int32, device="cuda"))
+            self.optimizer = SparseAdam(l, lr=0.0, eps=1e-15)
+        else:
+            self.optimizer = torch.optim.Adam(l, lr=0.0, eps=1e-15)
+        self.store.bind_optimizer(self.optimizer)
+        self._sync_from_store()
         self.xyz_scheduler_args = get_expon_lr_func(lr_init=training_args.position_lr_init*self.spatial_lr_scale,
                                                     lr_final=training_args.position_lr_final*self.spatial_lr_scale,
                                                     lr_delay_mult=training_args.position_lr_delay_mult,
                                                     max_steps=training_args.position_lr_max_steps)
 
+    def optimizer_step(self, visibility_filter):
+        # The sparse step only updates the Gaussians seen in the iteration
+        if isinstance(self.optimizer, SparseAdam):
+            self.optimizer.step(visibility_filter, self.store["adam_last_step"])
+        else:
+            self.optimizer.step()
+
     def update_learning_rate(self, iteration):
         ''' Learning rate scheduling per step '''
         for param_group in self.optimizer.param_groups:
@@ -285,6 +344,19 @@ class GaussianModel:
         el = PlyElement.describe(elements, 'vertex')
         PlyData([el]).write(path)
 
+    def save_splat(self, path):
+        # Columns are stored in the layout of the parameters, so loading is
+        # a mapping of the file rather than parsing it
+        mkdir_p(os.path.dirname(path))
+        save_splat(path, self.max_sh_degree, [
+            ("xyz", self._xyz.detach()),
+            ("features_dc", self._features_dc.detach()),
+            ("features_rest", self._features_rest.detach()),
+            ("opacity", self._opacity.detach()),
+            ("scaling", self._scaling.detach()),
+            ("rotation", self._rotation.detach()),
+            ("filter_3D", self.filter_3D.detach())])
+
     def save_fused_ply(self, path):
         mkdir_p(os.path.dirname(path))
 
@@ -370,80 +442,71 @@ class GaussianModel:
         self._scaling = nn.Parameter(torch.tensor(scales, dtype=torch.float, device="cuda").requires_grad_(True))
         self._rotation = nn.Parameter(torch.tensor(rots, dtype=torch.float, device="cuda").requires_grad_(True))
         self.filter_3D = torch.tensor(filter_3D, dtype=torch.float, device="cuda")
+        self.filter_3D_pending = None
+        self.bvh = None
 
         self.active_sh_degree = self.max_sh_degree
 
-    def replace_tensor_to_optimizer(self, tensor, name):
-        optimizable_tensors = {}
-        for group in self.optimizer.param_groups:
-            if group["name"] == name:
-                stored_state = self.optimizer.state.get(group['params'][0], None)
-                stored_state["exp_avg"] = torch.zeros_like(tensor)
-                stored_state["exp_avg_sq"] = torch.zeros_like(tensor)
-
-                del self.optimizer.state[group['params'][0]]
-                group["params"][0] = nn.Parameter(tensor.requires_grad_(True))
-                self.optimizer.state[group['params'][0]] = stored_state
-
-                optimizable_tensors[group["name"]] = group["params"][0]
-        return optimizable_tensors
-
-    def _prune_optimizer(self, mask):
-        optimizable_tensors = {}
-        for group in self.optimizer.param_groups:
-            stored_state = self.optimizer.state.get(group['params'][0], None)
-            if stored_state is not None:
-                stored_state["exp_avg"] = stored_state["exp_avg"][mask]
-                stored_state["exp_avg_sq"] = stored_state["exp_avg_sq"][mask]
-
-                del self.optimizer.state[group['params'][0]]
-                group["params"][0] = nn.Parameter((group["params"][0][mask].requires_grad_(True)))
-                self.optimizer.state[group['params'][0]] = stored_state
-
-                optimizable_tensors[group["name"]] = group["params"][0]
-            else:
-                group["params"][0] = nn.Parameter(group["params"][0][mask].requires_grad_(True))
-                optimizable_tensors[group["name"]] = group["params"][0]
-        return optimizable_tensors
+    def load_splat(self, path, device="cuda"):
+        sh_degree, tensors = load_splat(path)
+        assert sh_degree == self.max_sh_degree, "Splat file has SH degree {}, expected {}".format(sh_degree, self.max_sh_degree)
 
-    def prune_points(self, mask):
-        valid_points_mask = ~mask
-        optimizable_tensors = self._prune_optimizer(valid_points_mask)
-
-        self._xyz = optimizable_tensors["xyz"]
-        self._features_dc = optimizable_tensors["f_dc"]
-        self._features_rest = optimizable_tensors["f_rest"]
-        self._opacity = optimizable_tensors["opacity"]
-        self._scaling = optimizable_tensors["scaling"]
-        self._rotation = optimizable_tensors["rotation"]
+        # Host tensors keep sharing the (copy-on-write) file pages
+        def param(name):
+            return nn.Parameter(tensors[name].to(device).requires_grad_(True))
 
-        self.xyz_gradient_accum = self.xyz_gradient_accum[valid_points_mask]
-        self.xyz_gradient_accum_abs = self.xyz_gradient_accum_abs[valid_points_mask]
-        self.xyz_gradient_accum_abs_max = self.xyz_gradient_accum_abs_max[valid_points_mask]
-        self.denom = self.denom[valid_points_mask]
-        self.max_radii2D = self.max_radii2D[valid_points_mask]
+        self._xyz = param("xyz")
+        self._features_dc = param("features_dc")
+        self._features_rest = param("features_rest")
+        self._opacity = param("opacity")
+        self._scaling = param("scaling")
+        self._rotation = param("rotation")
+        self.filter_3D = tensors["filter_3D"].to(device)
+        self.filter_3D_pending = None
+        self.bvh = None
 
-    def cat_tensors_to_optimizer(self, tensors_dict):
-        optimizable_tensors = {}
-        for group in self.optimizer.param_groups:
-            assert len(group["params"]) == 1
-            extension_tensor = tensors_dict[group["name"]]
-            stored_state = self.optimizer.state.get(group['params'][0], None)
-            if stored_state is not None:
-
-                stored_state["exp_avg"] = torch.cat((stored_state["exp_avg"], torch.zeros_like(extension_tensor)), dim=0)
-                stored_state["exp_avg_sq"] = torch.cat((stored_state["exp_avg_sq"], torch.zeros_like(extension_tensor)), dim=0)
+        self.active_sh_degree = self.max_sh_degree
 
-                del self.optimizer.state[group['params'][0]]
-                group["params"][0] = nn.Parameter(torch.cat((group["params"][0], extension_tensor), dim=0).requires_grad_(True))
-                self.optimizer.state[group['params'][0]] = stored_state
+    def load(self, folder):
+        # Prefer the binary splat file, fall back to PLY for older outputs
+        splat_path = os.path.join(folder, "point_cloud.splat")
+        if os.path.exists(splat_path):
+            self.load_splat(splat_path)
+        else:
+            self.load_ply(os.path.join(folder, "point_cloud.ply"))
+
+    def _sync_from_store(self):
+        # Views of the store change whenever its size does
+        self._xyz = self.store.parameters["xyz"]
+        self._features_dc = self.store.parameters["f_dc"]
+        self._features_rest = self.store.parameters["f_rest"]
+        self._opacity = self.store.parameters["opacity"]
+        self._scaling = self.store.parameters["scaling"]
+        self._rotation = self.store.parameters["rotation"]
+
+        self.xyz_gradient_accum = self.store["xyz_gradient_accum"]
+        self.xyz_gradient_accum_abs = self.store["xyz_gradient_accum_abs"]
+        self.xyz_gradient_accum_abs_max = self.store["xyz_gradient_accum_abs_max"]
+        self.denom = self.store["denom"]
+        self.max_radii2D = self.store["max_radii2D"]
+
+        if "filter_3D_pending" in self.store:
+            self.filter_3D_distance = self.store["filter_3D_distance"]
+            self.filter_3D_valid = self.store["filter_3D_valid"]
+            self.filter_3D_pending = self.store["filter_3D_pending"]
 
-                optimizable_tensors[group["name"]] = group["params"][0]
-            else:
-                group["params"][0] = nn.Parameter(torch.cat((group["params"][0], extension_tensor), dim=0).requires_grad_(True))
-                optimizable_tensors[group["name"]] = group["params"][0]
+    def replace_tensor_to_optimizer(self, tensor, name):
+        # Values are overwritten and the moments reset in place
+        self.store.set_column(name, tensor)
+        self.store[name + ".exp_avg"].zero_()
+        self.store[name + ".exp_avg_sq"].zero_()
+        return {name: self.store.parameters[name]}
 
-        return optimizable_tensors
+    def prune_points(self, mask):
+        # Swap-compaction: the last kept points move into the holes
+        self.store.remove(mask)
+        self._sync_from_store()
+        self.bvh = None
 
     def densification_postfix(self, new_xyz, new_features_dc, new_features_rest, new_opacities, new_scaling, new_rotation):
         d = {"xyz": new_xyz,
@@ -453,20 +516,20 @@ class GaussianModel:
         "scaling" : new_scaling,
         "rotation" : new_rotation}
 
-        optimizable_tensors = self.cat_tensors_to_optimizer(d)
-        self._xyz = optimizable_tensors["xyz"]
-        self._features_dc = optimizable_tensors["f_dc"]
-        self._features_rest = optimizable_tensors["f_rest"]
-        self._opacity = optimizable_tensors["opacity"]
-        self._scaling = optimizable_tensors["scaling"]
-        self._rotation = optimizable_tensors["rotation"]
+        # Moments and statistics of the new points start at zero, new
+        # points still have to be evaluated by the incremental 3D filter
+        if "filter_3D_pending" in self.store:
+            d["filter_3D_pending"] = torch.ones(new_xyz.shape[0], dtype=torch.bool, device=new_xyz.device)
+        self.store.append(d)
+        self._sync_from_store()
 
         #TODO Maybe we don't need to reset the value, it's better to use moving average instead of reset the value
-        self.xyz_gradient_accum = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.xyz_gradient_accum_abs = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.xyz_gradient_accum_abs_max = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.denom = torch.zeros((self.get_xyz.shape[0], 1), device="cuda")
-        self.max_radii2D = torch.zeros((self.get_xyz.shape[0]), device="cuda")
+        self.xyz_gradient_accum.zero_()
+        self.xyz_gradient_accum_abs.zero_()
+        self.xyz_gradient_accum_abs_max.zero_()
+        self.denom.zero_()
+        self.max_radii2D.zero_()
+        self.bvh = None
 
     def densify_and_split(self, grads, grad_threshold, grads_abs, grad_abs_threshold, scene_extent, N=2):
         n_init_points = self.get_xyz.shape[0]
@@ -539,6 +602,28 @@ class GaussianModel:
         # torch.cuda.empty_cache()
         return clone - before, split - clone, split - prune
 
+    @torch.no_grad()
+    def reorder_morton(self):
+        # Sorts all per-point data into Morton order of the positions, so
+        # the rasterizer's gathers of nearby Gaussians hit nearby memory.
+        # Returns the permutation (row i was row order[i] before) for
+        # remapping anything that refers to points by index.
+        order = self.store.morton_order("xyz")
+        self.store.reorder(order)
+        self._sync_from_store()
+        filter_3D = getattr(self, "filter_3D", None)
+        if filter_3D is not None and filter_3D.shape[0] == order.shape[0]:
+            self.filter_3D = filter_3D[order]
+        self.bvh = None
+        return order
+
+    def prune_by_contribution(self, contributions, min_weight):
+        # contributions (3, P) from gaussian_contributions: max weight, summed
+        # weight and pixels. Keeps the Gaussians that are visible somewhere.
+        prune_mask = contributions[0] < min_weight
+        self.prune_points(prune_mask)
+        return int(prune_mask.sum())
+
     def add_densification_stats(self, viewspace_point_tensor, update_filter):
         self.xyz_gradient_accum[update_filter] += torch.norm(viewspace_point_tensor.grad[update_filter,:2], dim=-1, keepdim=True)
         #TODO maybe use max instead of average
@@ -0,0 +1,166 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import os
+import torch
+from collections import OrderedDict
+from utils.system_utils import mkdir_p
+from splat_io import ChunkCache, SplatWriter, load_splat, save_splat
+from splat_train import _C as train_C
+from diff_gaussian_rasterization import CompressedGaussians
+from scene.gaussian_compressed import CompressedGaussianModel
+
+# Columns of a chunked model, the codebook is kept apart as for compressed models
+CHUNK_COLUMNS = ["xyz"] + [name for name in CompressedGaussians._fields if name != "sh_codebook"]
+
+def chunk_table_path(path):
+    return os.path.splitext(path)[0] + "_chunks.splat"
+
+def chunk_rows(codes, chunk_size):
+    # Row counts of the chunks of sorted 30 bit Morton codes: the cells of
+    # an octree, split until they hold at most chunk_size rows, with runs
+    # of small neighbouring cells merged up to chunk_size
+    cells = []
+    stack = [(0, codes.numel(), 0)]
+    while stack:
+        start, end, level = stack.pop()
+        if end - start <= chunk_size or level == 10:
+            cells.append(end - start)
+            continue
+        shift = 3 * (9 - level)
+        base = (codes[start].item() >> (shift + 3)) << (shift + 3)
+        edges = torch.searchsorted(codes[start:end], torch.tensor([base + (child << shift) for child in range(1, 8)])) + start
+        edges = [start] + edges.tolist() + [end]
+        # Children in reverse, so they are taken in Morton order
+        for child in reversed(range(8)):
+            if edges[child + 1] > edges[child]:
+                stack.append((edges[child], edges[child + 1], level + 1))
+
+    counts = []
+    for cell in cells:
+        if counts and counts[-1] + cell <= chunk_size:
+            counts[-1] += cell
+        else:
+            counts.append(cell)
+    return counts
+
+@torch.no_grad()
+def build_chunked(path, chunked_path, chunk_size=1 << 16):
+    # Partitions the compressed model at path (see compress.py) into spatial
+    # chunks and writes it as a chunked model for StreamingGaussianModel.
+    # The model is mapped, rows are gathered and written one chunk at a
+    # time. Returns the number of chunks.
+    sh_degree, tensors = load_splat(path)
+    _, codebook = load_splat(CompressedGaussianModel.codebook_path(path))
+    count = tensors["xyz"].shape[0]
+    codes, order = torch.sort(train_C.morton_codes(tensors["xyz"]).long(), stable=True)
+    counts = chunk_rows(codes, chunk_size)
+
+    mkdir_p(os.path.dirname(chunked_path))
+    writer = SplatWriter(chunked_path, count, sh_degree)
+    for name in CHUNK_COLUMNS:
+        writer.add_attribute(name, list(tensors[name].shape[1:]), str(tensors[name].dtype).replace("torch.", ""))
+    bounds = torch.empty((len(counts), 2, 3))
+    start = 0
+    for chunk, rows in enumerate(counts):
+        index = order[start:start + rows]
+        for name in CHUNK_COLUMNS:
+            writer.write(name, tensors[name][index])
+        # The bounds enclose the 3 sigma extent of every Gaussian
+        xyz = tensors["xyz"][index]
+        extent = 3.0 * tensors["scales"][index].float().amax(dim=1, keepdim=True)
+        bounds[chunk, 0] = (xyz - extent).amin(dim=0)
+        bounds[chunk, 1] = (xyz + extent).amax(dim=0)
+        start += rows
+    writer.close()
+
+    save_splat(chunk_table_path(chunked_path), sh_degree, [("bounds", bounds), ("rows", torch.tensor(counts, dtype=torch.int32))])
+    save_splat(CompressedGaussianModel.codebook_path(chunked_path), sh_degree, [("sh_codebook", codebook["sh_codebook"])])
+    return len(counts)
+
+class StreamingGaussianModel:
+    """
+    A chunked model (see build_chunked) rendered out of core. For every
+    camera, gather selects the chunks in its frustum and those within
+    margin of it, has the native ChunkCache load them into host memory in
+    the background under host_budget bytes, and returns the visible chunks
+    that are resident as a CompressedGaussianModel for render_compressed.
+    Uploaded chunks are kept on the device under device_budget bytes, least
+    recently used first out. Without wait, chunks still loading are left
+    out of the frame instead of stalling it. Inference only.
+    """
+
+    def __init__(self, path, host_budget=2 << 30, device_budget=1 << 30, threads=2, margin=None, wait=True, device="cuda"):
+        self.cache = ChunkCache(path, chunk_table_path(path), host_budget, threads)
+        self.max_sh_degree = self.cache.sh_degree()
+        self.active_sh_degree = self.max_sh_degree
+        _, codebook = load_splat(CompressedGaussianModel.codebook_path(path))
+        self.sh_codebook = codebook["sh_codebook"].to(device)
+        # Only the header of the data file is read for frames without chunks
+        _, tensors = load_splat(path)
+        self.empty = {name: tensors[name][:0].to(device) for name in CHUNK_COLUMNS}
+        bounds, _ = self.cache.table()
+        # By default chunks are prefetched once within one mean chunk size
+        self.margin = margin if margin is not None else (bounds[:, 1] - bounds[:, 0]).norm(dim=1).mean().item()
+        self.device_budget = device_budget
+        self.wait = wait
+        self.device = device
+        self.resident = OrderedDict()  # chunk -> {name: device tensor}, least recently used first
+        self.resident_bytes = 0
+        self.counters = {"frames": 0, "chunks": 0, "device_hits": 0, "uploads": 0, "device_evictions": 0, "skipped": 0}
+
+    @property
+    def num_chunks(self):
+        return self.cache.num_chunks()
+
+    @torch.no_grad()
+    def gather(self, viewpoint_camera):
+        visible, near = self.cache.select(viewpoint_camera.full_proj_transform, viewpoint_camera.camera_center, self.margin)
+        self.cache.prefetch(visible + near)
+
+        parts = []
+        for chunk in visible:
+            if chunk in self.resident:
+                self.resident.move_to_end(chunk)
+                self.counters["device_hits"] += 1
+            else:
+                host = self.cache.acquire(chunk, self.wait)
+                if host is None:
+                    self.counters["skipped"] += 1
+                    continue
+                self.resident[chunk] = {name: host[name].to(self.device) for name in CHUNK_COLUMNS}
+                self.resident_bytes += sum(t.numel() * t.element_size() for t in self.resident[chunk].values())
+                self.counters["uploads"] += 1
+            parts.append(self.resident[chunk])
+        self.counters["frames"] += 1
+        self.counters["chunks"] += len(visible)
+
+        # The chunks of this frame were used last and are never evicted
+        while self.resident_bytes > self.device_budget and len(self.resident) > len(parts):
+            _, tensors = self.resident.popitem(last=False)
+            self.resident_bytes -= sum(t.numel() * t.element_size() for t in tensors.values())
+            self.counters["device_evictions"] += 1
+
+        columns = {name: torch.cat([part[name] for part in parts]) if parts else self.empty[name] for name in CHUNK_COLUMNS}
+        attributes = CompressedGaussians(sh_codebook=self.sh_codebook, **{name: columns[name] for name in CHUNK_COLUMNS if name != "xyz"})
+        model = CompressedGaussianModel(columns["xyz"], attributes, self.max_sh_degree)
+        model.active_sh_degree = self.active_sh_degree
+        return model
+
+    def stats(self):
+        # Chunks of the frames served from memory (on the device or the
+        # host), and the loads the frames had to wait for
+        cache = self.cache.stats()
+        stats = dict(self.counters)
+        stats.update({"host_" + name: value for name, value in cache.items()})
+        stats["hit_rate"] = (stats["device_hits"] + cache["hits"]) / max(1, stats["chunks"])
+        stats["device_bytes"] = self.resident_bytes
+        return stats
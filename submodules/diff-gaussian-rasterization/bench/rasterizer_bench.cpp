@@ -0,0 +1,498 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+// Benchmark of the host rasterizer on synthetic scenes. Renders random
+// Gaussians in front of a pinhole camera for every combination of scene
+// size, resolution and anisotropy, and writes per-stage timings and
+// workload statistics (RasterizerStats) as JSON, e.g.
+//
+//   rasterizer_bench --sizes 1e4,1e6 --resolutions 800x800 --backward --output bench.json
+//
+// With --orbit R, the camera turns by R radians around the scene from one
+// run to the next and the forward passes keep the depth order across
+// runs (CoherentSort), as the frames of an interactive viewer do. With
+// --codebook K, the forward passes read compressed attributes (half
+// precision, the higher SH bands from a codebook of K entries, see
+// compressed.h) instead of the float arrays.
+
+#include "rasterizer.h"
+#include "../cuda_rasterizer/config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+struct Options
+{
+	std::vector<int> sizes = { 10000, 100000, 1000000, 10000000 };
+	std::vector<std::pair<int, int>> resolutions = { { 800, 800 }, { 1920, 1080 } };
+	std::vector<float> anisotropies = { 1.0f, 10.0f };
+	int sh_degree = 0;
+	int warmup = 1;
+	int repeats = 3;
+	bool backward = false;
+	float orbit = -1.0f;
+	int codebook = 0;
+	unsigned seed = 0;
+	std::string output;
+};
+
+struct Scene
+{
+	int P;
+	std::vector<float> means, scales, rotations, opacities, shs;
+};
+
+// The attributes of a scene as served models store them
+struct CompressedScene
+{
+	std::vector<uint16_t> features_dc, opacities, scales, rotations;
+	std::vector<float> sh_codebook;
+	std::vector<int32_t> sh_index;
+	CompressedGaussians attributes = {};
+};
+
+static std::vector<std::string> split(const std::string& list)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+static Options parseOptions(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		auto value = [&]() -> std::string {
+			if (i + 1 >= argc)
+				throw std::runtime_error("Missing value for " + arg);
+			return argv[++i];
+		};
+
+		if (arg == "--sizes")
+		{
+			options.sizes.clear();
+			for (const std::string& s : split(value()))
+				options.sizes.push_back((int)std::stod(s));
+		}
+		else if (arg == "--resolutions")
+		{
+			options.resolutions.clear();
+			for (const std::string& s : split(value()))
+			{
+				const size_t x = s.find('x');
+				if (x == std::string::npos)
+					throw std::runtime_error("Resolutions must be given as WIDTHxHEIGHT");
+				options.resolutions.push_back({ std::stoi(s.substr(0, x)), std::stoi(s.substr(x + 1)) });
+			}
+		}
+		else if (arg == "--anisotropy")
+		{
+			options.anisotropies.clear();
+			for (const std::string& s : split(value()))
+				options.anisotropies.push_back(std::stof(s));
+		}
+		else if (arg == "--sh_degree")
+			options.sh_degree = std::stoi(value());
+		else if (arg == "--warmup")
+			options.warmup = std::stoi(value());
+		else if (arg == "--repeats")
+			options.repeats = std::max(1, std::stoi(value()));
+		else if (arg == "--seed")
+			options.seed = (unsigned)std::stoul(value());
+		else if (arg == "--backward")
+			options.backward = true;
+		else if (arg == "--output")
+			options.output = value();
+		else if (arg == "--orbit")
+			options.orbit = std::stof(value());
+		else if (arg == "--codebook")
+			options.codebook = std::max(1, std::stoi(value()));
+		else
+			throw std::runtime_error("Unknown argument " + arg + "\n"
+				"Usage: rasterizer_bench [--sizes N,...] [--resolutions WxH,...] [--anisotropy R,...]\n"
+				"                        [--sh_degree D] [--warmup N] [--repeats N] [--seed S]\n"
+				"                        [--backward] [--orbit R] [--codebook K] [--output FILE]");
+	}
+	if (options.sh_degree < 0 || options.sh_degree > 3)
+		throw std::runtime_error("--sh_degree must be in [0, 3]");
+	if (options.codebook > 0 && options.backward)
+		throw std::runtime_error("--codebook renders compressed attributes, which have no backward pass");
+	return options;
+}
+
+// Gaussians uniformly distributed in a box in front of the camera. The
+// scales shrink with the number of Gaussians so that the screen coverage
+// stays comparable across sizes and anisotropies.
+static Scene makeScene(int P, float anisotropy, int M, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+
+	Scene scene;
+	scene.P = P;
+	scene.means.resize(3 * (size_t)P);
+	scene.scales.resize(3 * (size_t)P);
+	scene.rotations.resize(4 * (size_t)P);
+	scene.opacities.resize(P);
+	scene.shs.resize((size_t)P * M * 3);
+
+	const float extent = 4.0f;
+	const float base_scale = 0.5f * extent / std::cbrt((float)P);
+	for (size_t i = 0; i < (size_t)P; i++)
+	{
+		scene.means[3 * i] = (uniform(rng) - 0.5f) * extent;
+		scene.means[3 * i + 1] = (uniform(rng) - 0.5f) * extent;
+		scene.means[3 * i + 2] = 3.0f + uniform(rng) * extent;
+
+		// Volume preserving: the long axis is anisotropy times the others
+		const float s = base_scale * std::exp(0.5f * normal(rng));
+		const float minor = s / std::cbrt(anisotropy);
+		scene.scales[3 * i] = minor * anisotropy;
+		scene.scales[3 * i + 1] = minor;
+		scene.scales[3 * i + 2] = minor;
+
+		float q[4], norm = 0.0f;
+		for (int k = 0; k < 4; k++)
+		{
+			q[k] = normal(rng);
+			norm += q[k] * q[k];
+		}
+		norm = std::sqrt(std::max(norm, 1e-12f));
+		for (int k = 0; k < 4; k++)
+			scene.rotations[4 * i + k] = q[k] / norm;
+
+		scene.opacities[i] = 0.05f + 0.95f * uniform(rng);
+		for (int k = 0; k < M * 3; k++)
+			scene.shs[i * M * 3 + k] = (k < 3 ? 1.0f : 0.2f) * (uniform(rng) - 0.5f);
+	}
+	return scene;
+}
+
+// Codebook of the higher SH bands of the first K Gaussians, assigned
+// round robin; the benchmark measures decoding, not quantization quality
+static CompressedScene compressScene(const Scene& scene, int M, int K)
+{
+	const int P = scene.P;
+	K = std::min(K, P);
+	CompressedScene compressed;
+	auto halves = [](const std::vector<float>& values, std::vector<uint16_t>& out) {
+		out.resize(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+			out[i] = floatToHalf(values[i]);
+	};
+	halves(scene.opacities, compressed.opacities);
+	halves(scene.scales, compressed.scales);
+	halves(scene.rotations, compressed.rotations);
+	compressed.features_dc.resize(3 * (size_t)P);
+	compressed.sh_index.resize(P);
+	compressed.sh_codebook.resize((size_t)K * (M - 1) * 3);
+	for (size_t i = 0; i < (size_t)P; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			compressed.features_dc[3 * i + c] = floatToHalf(scene.shs[i * M * 3 + c]);
+		compressed.sh_index[i] = (int32_t)(i % K);
+	}
+	for (size_t k = 0; k < (size_t)K; k++)
+		std::copy(scene.shs.begin() + k * M * 3 + 3, scene.shs.begin() + (k + 1) * M * 3, compressed.sh_codebook.begin() + k * (M - 1) * 3);
+	compressed.attributes = { compressed.features_dc.data(), compressed.sh_codebook.data(), compressed.sh_index.data(),
+		compressed.opacities.data(), compressed.scales.data(), compressed.rotations.data() };
+	return compressed;
+}
+
+// Camera at the origin turned by angle around the vertical axis through
+// the center of the scene: view and full projection matrices (column
+// major, as the rasterizer takes them) and the camera position.
+static void orbitCamera(float angle, const float* projection, float* viewmatrix, float* projmatrix, float* campos)
+{
+	const float center[3] = { 0.0f, 0.0f, 5.0f };
+	const float c = std::cos(angle), s = std::sin(angle);
+	const float R[9] = { c, 0.0f, -s, 0.0f, 1.0f, 0.0f, s, 0.0f, c }; // column major
+	std::fill(viewmatrix, viewmatrix + 16, 0.0f);
+	for (int col = 0; col < 3; col++)
+		for (int row = 0; row < 3; row++)
+			viewmatrix[4 * col + row] = R[3 * col + row];
+	for (int row = 0; row < 3; row++)
+		viewmatrix[12 + row] = center[row] - (R[row] * center[0] + R[3 + row] * center[1] + R[6 + row] * center[2]);
+	viewmatrix[15] = 1.0f;
+	for (int row = 0; row < 3; row++)
+		campos[row] = -(R[3 * row] * viewmatrix[12] + R[3 * row + 1] * viewmatrix[13] + R[3 * row + 2] * viewmatrix[14]);
+	for (int col = 0; col < 4; col++)
+		for (int row = 0; row < 4; row++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++)
+				sum += projection[4 * k + row] * viewmatrix[4 * col + k];
+			projmatrix[4 * col + row] = sum;
+		}
+}
+
+static std::function<char*(size_t)> resizing(std::vector<char>& buffer)
+{
+	return [&buffer](size_t N) {
+		if (buffer.size() < N)
+			buffer.resize(N);
+		return buffer.data();
+	};
+}
+
+// Mean of the per-repeat timings and thread balance, workload of the
+// last repeat
+static RasterizerStats average(const std::vector<RasterizerStats>& runs)
+{
+	RasterizerStats mean = runs.back();
+	double RasterizerStats::* timings[] = {
+		&RasterizerStats::preprocess_ms, &RasterizerStats::scan_ms, &RasterizerStats::duplicate_ms, &RasterizerStats::sort_ms,
+		&RasterizerStats::ranges_ms, &RasterizerStats::render_ms, &RasterizerStats::forward_ms,
+		&RasterizerStats::backward_render_ms, &RasterizerStats::backward_reduce_ms, &RasterizerStats::backward_preprocess_ms,
+		&RasterizerStats::backward_ms, &RasterizerStats::worker_imbalance };
+	for (auto timing : timings)
+	{
+		double sum = 0.0;
+		for (const RasterizerStats& run : runs)
+			sum += run.*timing;
+		mean.*timing = sum / runs.size();
+	}
+	return mean;
+}
+
+static std::string toJson(int P, int width, int height, float anisotropy, const Options& options, const RasterizerStats& s, double best_forward_ms, int64_t full_sorts)
+{
+	std::ostringstream json;
+	json.precision(6);
+	json << "    {\n";
+	json << "      \"config\": { \"num_gaussians\": " << P << ", \"width\": " << width << ", \"height\": " << height
+		<< ", \"anisotropy\": " << anisotropy << ", \"sh_degree\": " << options.sh_degree << ", \"repeats\": " << options.repeats;
+	if (options.orbit >= 0.0f)
+		json << ", \"orbit\": " << options.orbit << ", \"full_sorts\": " << full_sorts;
+	if (options.codebook > 0)
+		json << ", \"codebook\": " << options.codebook;
+	json << " },\n";
+	json << "      \"forward_ms\": { \"preprocess\": " << s.preprocess_ms << ", \"scan\": " << s.scan_ms
+		<< ", \"duplicate\": " << s.duplicate_ms << ", \"sort\": " << s.sort_ms << ", \"ranges\": " << s.ranges_ms
+		<< ", \"render\": " << s.render_ms << ", \"total\": " << s.forward_ms << ", \"best_total\": " << best_forward_ms << " },\n";
+	if (options.backward)
+		json << "      \"backward_ms\": { \"render\": " << s.backward_render_ms << ", \"reduce\": " << s.backward_reduce_ms
+			<< ", \"preprocess\": " << s.backward_preprocess_ms << ", \"total\": " << s.backward_ms << " },\n";
+	json << "      \"workload\": { \"num_visible\": " << s.num_visible << ", \"num_rendered\": " << s.num_rendered
+		<< ", \"num_tiles\": " << s.num_tiles << ", \"mean_tile_range\": " << s.mean_tile_range << ", \"max_tile_range\": " << s.max_tile_range
+		<< ", \"tile_imbalance\": " << s.tile_imbalance
+		<< ", \"mean_contributors\": " << s.mean_contributors << ", \"max_contributors\": " << s.max_contributors << ",\n";
+	int bins = RasterizerStats::HISTOGRAM_BINS;
+	while (bins > 1 && s.tile_histogram[bins - 1] == 0)
+		bins--;
+	json << "        \"tile_histogram\": [";
+	for (int b = 0; b < bins; b++)
+		json << (b ? ", " : "") << s.tile_histogram[b];
+	json << "] },\n";
+	json << "      \"schedule\": { \"render_items\": " << s.render_items << ", \"split_tiles\": " << s.split_tiles
+		<< ", \"stolen_items\": " << s.stolen_items << ", \"worker_imbalance\": " << s.worker_imbalance << " },\n";
+	json << "      \"memory_bytes\": { \"geometry\": " << s.geometry_bytes << ", \"binning\": " << s.binning_bytes
+		<< ", \"image\": " << s.image_bytes << " }\n";
+	json << "    }";
+	return json.str();
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	try
+	{
+		options = parseOptions(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	const int D = options.sh_degree;
+	const int M = (D + 1) * (D + 1);
+	const float background[3] = { 0.0f, 0.0f, 0.0f };
+	const float znear = 0.01f, zfar = 100.0f;
+
+	std::vector<std::string> results;
+	std::vector<char> geom_buffer, binning_buffer, img_buffer, scratch_buffer, order_buffer;
+
+	for (int P : options.sizes)
+	{
+		for (float anisotropy : options.anisotropies)
+		{
+			const Scene scene = makeScene(P, anisotropy, M, options.seed);
+			const CompressedScene compressed = options.codebook > 0 ? compressScene(scene, M, options.codebook) : CompressedScene();
+			std::vector<int> radii(P);
+			std::vector<float> dL_dmean2D, dL_dconic, dL_dopacity, dL_dcolor, dL_dmean3D, dL_dcov3D, dL_dsh, dL_dscale, dL_drot;
+			if (options.backward)
+			{
+				dL_dmean2D.resize(3 * (size_t)P);
+				dL_dconic.resize(4 * (size_t)P);
+				dL_dopacity.resize(P);
+				dL_dcolor.resize(3 * (size_t)P);
+				dL_dmean3D.resize(3 * (size_t)P);
+				dL_dcov3D.resize(6 * (size_t)P);
+				dL_dsh.resize((size_t)P * M * 3);
+				dL_dscale.resize(3 * (size_t)P);
+				dL_drot.resize(4 * (size_t)P);
+			}
+
+			for (const auto& resolution : options.resolutions)
+			{
+				const int width = resolution.first, height = resolution.second;
+				const float tan_fovx = 0.5f;
+				const float tan_fovy = tan_fovx * height / width;
+				float projection[16] = { 0 };
+				projection[0] = 1.0f / tan_fovx;
+				projection[5] = 1.0f / tan_fovy;
+				projection[10] = zfar / (zfar - znear);
+				projection[11] = 1.0f;
+				projection[14] = -zfar * znear / (zfar - znear);
+				float viewmatrix[16], projmatrix[16], campos[3];
+				orbitCamera(0.0f, projection, viewmatrix, projmatrix, campos);
+
+				CoherentSort coherent;
+				coherent.orderBuffer = resizing(order_buffer);
+
+				std::vector<float> subpixel_offset(2 * (size_t)width * height, 0.0f);
+				std::vector<float> out_color(3 * (size_t)width * height);
+				std::vector<float> dL_dpix(3 * (size_t)width * height, 1.0f / (width * height));
+
+				std::vector<RasterizerStats> runs;
+				double best_forward_ms = 0.0;
+				for (int run = 0; run < options.warmup + options.repeats; run++)
+				{
+					if (options.orbit >= 0.0f)
+						orbitCamera(run * options.orbit, projection, viewmatrix, projmatrix, campos);
+					RasterizerStats stats;
+					const int num_rendered = CpuRasterizer::Rasterizer::forward(
+						resizing(geom_buffer), resizing(binning_buffer), resizing(img_buffer),
+						P, D, M,
+						NUM_CHANNELS,
+						background,
+						width, height,
+						scene.means.data(),
+						scene.shs.data(),
+						nullptr,
+						scene.opacities.data(),
+						scene.scales.data(),
+						1.0f,
+						scene.rotations.data(),
+						nullptr,
+						viewmatrix, projmatrix,
+						campos,
+						tan_fovx, tan_fovy,
+						0.1f,
+						subpixel_offset.data(),
+						false,
+						out_color.data(),
+						radii.data(),
+						false,
+						&stats,
+						nullptr,
+						options.orbit >= 0.0f ? &coherent : nullptr,
+						options.codebook > 0 ? &compressed.attributes : nullptr);
+
+					if (options.backward)
+					{
+						for (std::vector<float>* grad : { &dL_dmean2D, &dL_dconic, &dL_dopacity, &dL_dcolor, &dL_dmean3D, &dL_dcov3D, &dL_dsh, &dL_dscale, &dL_drot })
+							std::fill(grad->begin(), grad->end(), 0.0f);
+						CpuRasterizer::Rasterizer::backward(
+							P, D, M, num_rendered,
+							NUM_CHANNELS,
+							background,
+							width, height,
+							scene.means.data(),
+							scene.shs.data(),
+							nullptr,
+							scene.scales.data(),
+							1.0f,
+							scene.rotations.data(),
+							nullptr,
+							viewmatrix, projmatrix,
+							campos,
+							tan_fovx, tan_fovy,
+							0.1f,
+							subpixel_offset.data(),
+							radii.data(),
+							geom_buffer.data(),
+							binning_buffer.data(),
+							img_buffer.data(),
+							dL_dpix.data(),
+							dL_dmean2D.data(),
+							dL_dconic.data(),
+							dL_dopacity.data(),
+							dL_dcolor.data(),
+							dL_dmean3D.data(),
+							dL_dcov3D.data(),
+							dL_dsh.data(),
+							dL_dscale.data(),
+							dL_drot.data(),
+							false,
+							resizing(scratch_buffer),
+							&stats);
+					}
+
+					if (run < options.warmup)
+						continue;
+					runs.push_back(stats);
+					best_forward_ms = runs.size() == 1 ? stats.forward_ms : std::min(best_forward_ms, stats.forward_ms);
+				}
+
+				const RasterizerStats mean = average(runs);
+				std::fprintf(stderr, "P=%d %dx%d anisotropy=%g: forward %.2f ms", P, width, height, anisotropy, mean.forward_ms);
+				if (options.backward)
+					std::fprintf(stderr, ", backward %.2f ms", mean.backward_ms);
+				std::fprintf(stderr, "\n");
+				results.push_back(toJson(P, width, height, anisotropy, options, mean, best_forward_ms, coherent.full_sorts));
+			}
+		}
+	}
+
+	int threads = 1;
+#ifdef _OPENMP
+	threads = omp_get_max_threads();
+#endif
+	std::ostringstream json;
+	json << "{\n  \"benchmark\": \"rasterizer_bench\",\n  \"backend\": \"cpu\",\n  \"threads\": " << threads << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+		json << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+	json << "  ]\n}\n";
+
+	if (options.output.empty())
+		std::fputs(json.str().c_str(), stdout);
+	else
+	{
+		FILE* file = std::fopen(options.output.c_str(), "w");
+		if (!file)
+		{
+			std::fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+			return 1;
+		}
+		std::fputs(json.str().c_str(), file);
+		std::fclose(file);
+	}
+	return 0;
+}
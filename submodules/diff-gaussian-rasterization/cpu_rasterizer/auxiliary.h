@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_AUXILIARY_H_INCLUDED
+#define CPU_RASTERIZER_AUXILIARY_H_INCLUDED
+
+#include "../cuda_rasterizer/config.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define BLOCK_SIZE (BLOCK_X * BLOCK_Y)
+
+namespace CpuRasterizer
+{
+	// Thread queries that also work when built without OpenMP.
+	inline int maxThreads()
+	{
+#ifdef _OPENMP
+		return omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+
+	inline int threadIndex()
+	{
+#ifdef _OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	// Host replacement for the CUDA launch grid, only used to describe
+	// the number of tiles in x and y.
+	struct TileGrid
+	{
+		uint32_t x;
+		uint32_t y;
+	};
+
+	// Spherical harmonics coefficients
+	const float SH_C0 = 0.28209479177387814f;
+	const float SH_C1 = 0.4886025119029199f;
+	const float SH_C2[] = {
+		1.0925484305920792f,
+		-1.0925484305920792f,
+		0.31539156525252005f,
+		-1.0925484305920792f,
+		0.5462742152960396f
+	};
+	const float SH_C3[] = {
+		-0.5900435899266435f,
+		2.890611442640554f,
+		-0.4570457994644658f,
+		0.3731763325901154f,
+		-0.4570457994644658f,
+		1.445305721320277f,
+		-0.5900435899266435f
+	};
+
+	inline float ndc2Pix(float v, int S)
+	{
+		return ((v + 1.0) * S - 1.0) * 0.5;
+	}
+
+	inline void getRect(const glm::vec2 p, int max_radius, glm::uvec2& rect_min, glm::uvec2& rect_max, const TileGrid grid)
+	{
+		rect_min = {
+			std::min(grid.x, (uint32_t)std::max((int)0, (int)((p.x - max_radius) / BLOCK_X))),
+			std::min(grid.y, (uint32_t)std::max((int)0, (int)((p.y - max_radius) / BLOCK_Y)))
+		};
+		rect_max = {
+			std::min(grid.x, (uint32_t)std::max((int)0, (int)((p.x + max_radius + BLOCK_X - 1) / BLOCK_X))),
+			std::min(grid.y, (uint32_t)std::max((int)0, (int)((p.y + max_radius + BLOCK_Y - 1) / BLOCK_Y)))
+		};
+	}
+
+	inline glm::vec3 transformPoint4x3(const glm::vec3& p, const float* matrix)
+	{
+		glm::vec3 transformed = {
+			matrix[0] * p.x + matrix[4] * p.y + matrix[8] * p.z + matrix[12],
+			matrix[1] * p.x + matrix[5] * p.y + matrix[9] * p.z + matrix[13],
+			matrix[2] * p.x + matrix[6] * p.y + matrix[10] * p.z + matrix[14],
+		};
+		return transformed;
+	}
+
+	inline glm::vec4 transformPoint4x4(const glm::vec3& p, const float* matrix)
+	{
+		glm::vec4 transformed = {
+			matrix[0] * p.x + matrix[4] * p.y + matrix[8] * p.z + matrix[12],
+			matrix[1] * p.x + matrix[5] * p.y + matrix[9] * p.z + matrix[13],
+			matrix[2] * p.x + matrix[6] * p.y + matrix[10] * p.z + matrix[14],
+			matrix[3] * p.x + matrix[7] * p.y + matrix[11] * p.z + matrix[15]
+		};
+		return transformed;
+	}
+
+	inline glm::vec3 transformVec4x3(const glm::vec3& p, const float* matrix)
+	{
+		glm::vec3 transformed = {
+			matrix[0] * p.x + matrix[4] * p.y + matrix[8] * p.z,
+			matrix[1] * p.x + matrix[5] * p.y + matrix[9] * p.z,
+			matrix[2] * p.x + matrix[6] * p.y + matrix[10] * p.z,
+		};
+		return transformed;
+	}
+
+	inline glm::vec3 transformVec4x3Transpose(const glm::vec3& p, const float* matrix)
+	{
+		glm::vec3 transformed = {
+			matrix[0] * p.x + matrix[1] * p.y + matrix[2] * p.z,
+			matrix[4] * p.x + matrix[5] * p.y + matrix[6] * p.z,
+			matrix[8] * p.x + matrix[9] * p.y + matrix[10] * p.z,
+		};
+		return transformed;
+	}
+
+	inline float dnormvdz(glm::vec3 v, glm::vec3 dv)
+	{
+		float sum2 = v.x * v.x + v.y * v.y + v.z * v.z;
+		float invsum32 = 1.0f / std::sqrt(sum2 * sum2 * sum2);
+		float dnormvdz = (-v.x * v.z * dv.x - v.y * v.z * dv.y + (sum2 - v.z * v.z) * dv.z) * invsum32;
+		return dnormvdz;
+	}
+
+	inline glm::vec3 dnormvdv(glm::vec3 v, glm::vec3 dv)
+	{
+		float sum2 = v.x * v.x + v.y * v.y + v.z * v.z;
+		float invsum32 = 1.0f / std::sqrt(sum2 * sum2 * sum2);
+
+		glm::vec3 dnormvdv;
+		dnormvdv.x = ((+sum2 - v.x * v.x) * dv.x - v.y * v.x * dv.y - v.z * v.x * dv.z) * invsum32;
+		dnormvdv.y = (-v.x * v.y * dv.x + (sum2 - v.y * v.y) * dv.y - v.z * v.y * dv.z) * invsum32;
+		dnormvdv.z = (-v.x * v.z * dv.x - v.y * v.z * dv.y + (sum2 - v.z * v.z) * dv.z) * invsum32;
+		return dnormvdv;
+	}
+
+	inline glm::vec4 dnormvdv(glm::vec4 v, glm::vec4 dv)
+	{
+		float sum2 = v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w;
+		float invsum32 = 1.0f / std::sqrt(sum2 * sum2 * sum2);
+
+		glm::vec4 vdv = { v.x * dv.x, v.y * dv.y, v.z * dv.z, v.w * dv.w };
+		float vdv_sum = vdv.x + vdv.y + vdv.z + vdv.w;
+		glm::vec4 dnormvdv;
+		dnormvdv.x = ((sum2 - v.x * v.x) * dv.x - v.x * (vdv_sum - vdv.x)) * invsum32;
+		dnormvdv.y = ((sum2 - v.y * v.y) * dv.y - v.y * (vdv_sum - vdv.y)) * invsum32;
+		dnormvdv.z = ((sum2 - v.z * v.z) * dv.z - v.z * (vdv_sum - vdv.z)) * invsum32;
+		dnormvdv.w = ((sum2 - v.w * v.w) * dv.w - v.w * (vdv_sum - vdv.w)) * invsum32;
+		return dnormvdv;
+	}
+
+	inline float sigmoid(float x)
+	{
+		return 1.0f / (1.0f + std::exp(-x));
+	}
+
+	// Same near-plane test as the CUDA version. A point that is filtered
+	// although prefiltered is set is reported through 'filter_error',
+	// since we cannot trap inside a parallel region on the host.
+	inline bool in_frustum(int idx,
+		const float* orig_points,
+		const float* viewmatrix,
+		const float* /* projmatrix */,
+		bool prefiltered,
+		glm::vec3& p_view,
+		bool* filter_error = nullptr)
+	{
+		glm::vec3 p_orig = { orig_points[3 * idx], orig_points[3 * idx + 1], orig_points[3 * idx + 2] };
+		p_view = transformPoint4x3(p_orig, viewmatrix);
+
+		if (p_view.z <= 0.2f)
+		{
+			if (prefiltered && filter_error != nullptr)
+				*filter_error = true;
+			return false;
+		}
+		return true;
+	}
+};
+
+#endif
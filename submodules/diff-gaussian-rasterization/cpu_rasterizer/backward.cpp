@@ -0,0 +1,890 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "backward.h"
+#include "auxiliary.h"
+#include "../cuda_rasterizer/dispatch.h"
+#include "simd.h"
+#include <cstring>
+
+namespace CpuRasterizer
+{
+
+// Backward pass for conversion of spherical harmonics to RGB for
+// each Gaussian, specialized on the SH degree.
+template<int deg>
+static void computeColorFromSH(int idx, int max_coeffs, const glm::vec3* means, glm::vec3 campos, const float* shs, const bool* clamped, const glm::vec3* dL_dcolor, glm::vec3* dL_dmeans, glm::vec3* dL_dshs)
+{
+	// Compute intermediate values, as it is done during forward
+	glm::vec3 pos = means[idx];
+	glm::vec3 dir_orig = pos - campos;
+	glm::vec3 dir = dir_orig / glm::length(dir_orig);
+
+	const glm::vec3* sh = ((const glm::vec3*)shs) + idx * max_coeffs;
+
+	// Use PyTorch rule for clamping: if clamping was applied,
+	// gradient becomes 0.
+	glm::vec3 dL_dRGB = dL_dcolor[idx];
+	dL_dRGB.x *= clamped[3 * idx + 0] ? 0 : 1;
+	dL_dRGB.y *= clamped[3 * idx + 1] ? 0 : 1;
+	dL_dRGB.z *= clamped[3 * idx + 2] ? 0 : 1;
+
+	glm::vec3 dRGBdx(0, 0, 0);
+	glm::vec3 dRGBdy(0, 0, 0);
+	glm::vec3 dRGBdz(0, 0, 0);
+	float x = dir.x;
+	float y = dir.y;
+	float z = dir.z;
+
+	// Target location for this Gaussian to write SH gradients to
+	glm::vec3* dL_dsh = dL_dshs + idx * max_coeffs;
+
+	// No tricks here, just high school-level calculus.
+	float dRGBdsh0 = SH_C0;
+	dL_dsh[0] = dRGBdsh0 * dL_dRGB;
+	if (deg > 0)
+	{
+		float dRGBdsh1 = -SH_C1 * y;
+		float dRGBdsh2 = SH_C1 * z;
+		float dRGBdsh3 = -SH_C1 * x;
+		dL_dsh[1] = dRGBdsh1 * dL_dRGB;
+		dL_dsh[2] = dRGBdsh2 * dL_dRGB;
+		dL_dsh[3] = dRGBdsh3 * dL_dRGB;
+
+		dRGBdx = -SH_C1 * sh[3];
+		dRGBdy = -SH_C1 * sh[1];
+		dRGBdz = SH_C1 * sh[2];
+
+		if (deg > 1)
+		{
+			float xx = x * x, yy = y * y, zz = z * z;
+			float xy = x * y, yz = y * z, xz = x * z;
+
+			float dRGBdsh4 = SH_C2[0] * xy;
+			float dRGBdsh5 = SH_C2[1] * yz;
+			float dRGBdsh6 = SH_C2[2] * (2.f * zz - xx - yy);
+			float dRGBdsh7 = SH_C2[3] * xz;
+			float dRGBdsh8 = SH_C2[4] * (xx - yy);
+			dL_dsh[4] = dRGBdsh4 * dL_dRGB;
+			dL_dsh[5] = dRGBdsh5 * dL_dRGB;
+			dL_dsh[6] = dRGBdsh6 * dL_dRGB;
+			dL_dsh[7] = dRGBdsh7 * dL_dRGB;
+			dL_dsh[8] = dRGBdsh8 * dL_dRGB;
+
+			dRGBdx += SH_C2[0] * y * sh[4] + SH_C2[2] * 2.f * -x * sh[6] + SH_C2[3] * z * sh[7] + SH_C2[4] * 2.f * x * sh[8];
+			dRGBdy += SH_C2[0] * x * sh[4] + SH_C2[1] * z * sh[5] + SH_C2[2] * 2.f * -y * sh[6] + SH_C2[4] * 2.f * -y * sh[8];
+			dRGBdz += SH_C2[1] * y * sh[5] + SH_C2[2] * 2.f * 2.f * z * sh[6] + SH_C2[3] * x * sh[7];
+
+			if (deg > 2)
+			{
+				float dRGBdsh9 = SH_C3[0] * y * (3.f * xx - yy);
+				float dRGBdsh10 = SH_C3[1] * xy * z;
+				float dRGBdsh11 = SH_C3[2] * y * (4.f * zz - xx - yy);
+				float dRGBdsh12 = SH_C3[3] * z * (2.f * zz - 3.f * xx - 3.f * yy);
+				float dRGBdsh13 = SH_C3[4] * x * (4.f * zz - xx - yy);
+				float dRGBdsh14 = SH_C3[5] * z * (xx - yy);
+				float dRGBdsh15 = SH_C3[6] * x * (xx - 3.f * yy);
+				dL_dsh[9] = dRGBdsh9 * dL_dRGB;
+				dL_dsh[10] = dRGBdsh10 * dL_dRGB;
+				dL_dsh[11] = dRGBdsh11 * dL_dRGB;
+				dL_dsh[12] = dRGBdsh12 * dL_dRGB;
+				dL_dsh[13] = dRGBdsh13 * dL_dRGB;
+				dL_dsh[14] = dRGBdsh14 * dL_dRGB;
+				dL_dsh[15] = dRGBdsh15 * dL_dRGB;
+
+				dRGBdx += (
+					SH_C3[0] * sh[9] * 3.f * 2.f * xy +
+					SH_C3[1] * sh[10] * yz +
+					SH_C3[2] * sh[11] * -2.f * xy +
+					SH_C3[3] * sh[12] * -3.f * 2.f * xz +
+					SH_C3[4] * sh[13] * (-3.f * xx + 4.f * zz - yy) +
+					SH_C3[5] * sh[14] * 2.f * xz +
+					SH_C3[6] * sh[15] * 3.f * (xx - yy));
+
+				dRGBdy += (
+					SH_C3[0] * sh[9] * 3.f * (xx - yy) +
+					SH_C3[1] * sh[10] * xz +
+					SH_C3[2] * sh[11] * (-3.f * yy + 4.f * zz - xx) +
+					SH_C3[3] * sh[12] * -3.f * 2.f * yz +
+					SH_C3[4] * sh[13] * -2.f * xy +
+					SH_C3[5] * sh[14] * -2.f * yz +
+					SH_C3[6] * sh[15] * -3.f * 2.f * xy);
+
+				dRGBdz += (
+					SH_C3[1] * sh[10] * xy +
+					SH_C3[2] * sh[11] * 4.f * 2.f * yz +
+					SH_C3[3] * sh[12] * 3.f * (2.f * zz - xx - yy) +
+					SH_C3[4] * sh[13] * 4.f * 2.f * xz +
+					SH_C3[5] * sh[14] * (xx - yy));
+			}
+		}
+	}
+
+	// The view direction is an input to the computation. View direction
+	// is influenced by the Gaussian's mean, so SHs gradients
+	// must propagate back into 3D position.
+	glm::vec3 dL_ddir(glm::dot(dRGBdx, dL_dRGB), glm::dot(dRGBdy, dL_dRGB), glm::dot(dRGBdz, dL_dRGB));
+
+	// Account for normalization of direction
+	glm::vec3 dL_dmean = dnormvdv(dir_orig, dL_ddir);
+
+	// Gradients of loss w.r.t. Gaussian means, but only the portion
+	// that is caused because the mean affects the view-dependent color.
+	// Additional mean gradient is accumulated in below methods.
+	dL_dmeans[idx] += dL_dmean;
+}
+
+// Backward version of INVERSE 2D covariance matrix computation.
+// On the host this runs for the same Gaussian right before the
+// remaining preprocessing steps.
+static void computeCov2D(int idx,
+	const glm::vec3* means,
+	const float* cov3Ds,
+	const float h_x, float h_y,
+	const float tan_fovx, float tan_fovy,
+	const float kernel_size,
+	const float* view_matrix,
+	const float* dL_dconics,
+	glm::vec3* dL_dmeans,
+	float* dL_dcov,
+	const glm::vec4* conic_opacity,
+	float* dL_dopacity)
+{
+	// Reading location of 3D covariance for this Gaussian
+	const float* cov3D = cov3Ds + 6 * idx;
+
+	// Fetch gradients, recompute 2D covariance and relevant
+	// intermediate forward results needed in the backward.
+	glm::vec3 mean = means[idx];
+	glm::vec3 dL_dconic = { dL_dconics[4 * idx], dL_dconics[4 * idx + 1], dL_dconics[4 * idx + 3] };
+	const glm::vec4 conic = conic_opacity[idx];
+	const float combined_opacity = conic.w;
+	glm::vec3 t = transformPoint4x3(mean, view_matrix);
+
+	const float limx = 1.3f * tan_fovx;
+	const float limy = 1.3f * tan_fovy;
+	const float txtz = t.x / t.z;
+	const float tytz = t.y / t.z;
+	t.x = std::min(limx, std::max(-limx, txtz)) * t.z;
+	t.y = std::min(limy, std::max(-limy, tytz)) * t.z;
+
+	const float x_grad_mul = txtz < -limx || txtz > limx ? 0 : 1;
+	const float y_grad_mul = tytz < -limy || tytz > limy ? 0 : 1;
+
+	glm::mat3 J = glm::mat3(h_x / t.z, 0.0f, -(h_x * t.x) / (t.z * t.z),
+		0.0f, h_y / t.z, -(h_y * t.y) / (t.z * t.z),
+		0, 0, 0);
+
+	glm::mat3 W = glm::mat3(
+		view_matrix[0], view_matrix[4], view_matrix[8],
+		view_matrix[1], view_matrix[5], view_matrix[9],
+		view_matrix[2], view_matrix[6], view_matrix[10]);
+
+	glm::mat3 Vrk = glm::mat3(
+		cov3D[0], cov3D[1], cov3D[2],
+		cov3D[1], cov3D[3], cov3D[4],
+		cov3D[2], cov3D[4], cov3D[5]);
+
+	glm::mat3 T = W * J;
+
+	glm::mat3 cov2D = glm::transpose(T) * glm::transpose(Vrk) * T;
+
+	const float det_0 = std::max(1e-6, (double)(cov2D[0][0] * cov2D[1][1] - cov2D[0][1] * cov2D[0][1]));
+	const float det_1 = std::max(1e-6, (double)((cov2D[0][0] + kernel_size) * (cov2D[1][1] + kernel_size) - cov2D[0][1] * cov2D[0][1]));
+	// sqrt here
+	const float coef = std::sqrt(det_0 / (det_1+1e-6) + 1e-6);
+
+	// update the gradient of alpha and save the gradient of dalpha_dcoef
+	// we need opacity as input
+	// new_opacity = coef * opacity
+	// if we know the new opacity, we can derive original opacity and then dalpha_dcoef = dopacity * opacity
+	const float opacity = combined_opacity / (coef + 1e-6);
+	const float dL_dcoef = dL_dopacity[idx] * opacity;
+	const float dL_dsqrtcoef = dL_dcoef * 0.5 * 1. / (coef + 1e-6);
+	const float dL_ddet0 = dL_dsqrtcoef / (det_1+1e-6);
+	const float dL_ddet1 = dL_dsqrtcoef * det_0 * (-1.f / (det_1 * det_1 + 1e-6));
+	//TODO gradient is zero if det_0 or det_1 < 0
+	const float dcoef_da = dL_ddet0 * cov2D[1][1] + dL_ddet1 * (cov2D[1][1] + kernel_size);
+	const float dcoef_db = dL_ddet0 * (-2. * cov2D[0][1]) + dL_ddet1 * (-2. * cov2D[0][1]);
+	const float dcoef_dc = dL_ddet0 * cov2D[0][0] + dL_ddet1 * (cov2D[0][0] + kernel_size);
+
+	// Use helper variables for 2D covariance entries. More compact.
+	float a = cov2D[0][0] += kernel_size;
+	float b = cov2D[0][1];
+	float c = cov2D[1][1] += kernel_size;
+
+	float denom = a * c - b * b;
+	float dL_da = 0, dL_db = 0, dL_dc = 0;
+	float denom2inv = 1.0f / ((denom * denom) + 0.0000001f);
+
+	if (denom2inv != 0)
+	{
+		// Gradients of loss w.r.t. entries of 2D covariance matrix,
+		// given gradients of loss w.r.t. conic matrix (inverse covariance matrix).
+		// e.g., dL / da = dL / d_conic_a * d_conic_a / d_a
+		dL_da = denom2inv * (-c * c * dL_dconic.x + 2 * b * c * dL_dconic.y + (denom - a * c) * dL_dconic.z);
+		dL_dc = denom2inv * (-a * a * dL_dconic.z + 2 * a * b * dL_dconic.y + (denom - a * c) * dL_dconic.x);
+		dL_db = denom2inv * 2 * (b * c * dL_dconic.x - (denom + 2 * b * b) * dL_dconic.y + a * b * dL_dconic.z);
+
+		if (det_0 <= 1e-6 || det_1 <= 1e-6){
+			dL_dopacity[idx] = 0;
+		} else {
+			// Gradiends of alpha respect to conv due to low pass filter
+			dL_da += dcoef_da;
+			dL_dc += dcoef_dc;
+			dL_db += dcoef_db;
+
+			// update dL_dopacity
+			dL_dopacity[idx] = dL_dopacity[idx] * coef;
+		}
+
+		// Gradients of loss L w.r.t. each 3D covariance matrix (Vrk) entry,
+		// given gradients w.r.t. 2D covariance matrix (diagonal).
+		// cov2D = transpose(T) * transpose(Vrk) * T;
+		dL_dcov[6 * idx + 0] = (T[0][0] * T[0][0] * dL_da + T[0][0] * T[1][0] * dL_db + T[1][0] * T[1][0] * dL_dc);
+		dL_dcov[6 * idx + 3] = (T[0][1] * T[0][1] * dL_da + T[0][1] * T[1][1] * dL_db + T[1][1] * T[1][1] * dL_dc);
+		dL_dcov[6 * idx + 5] = (T[0][2] * T[0][2] * dL_da + T[0][2] * T[1][2] * dL_db + T[1][2] * T[1][2] * dL_dc);
+
+		// Gradients of loss L w.r.t. each 3D covariance matrix (Vrk) entry,
+		// given gradients w.r.t. 2D covariance matrix (off-diagonal).
+		// Off-diagonal elements appear twice --> double the gradient.
+		// cov2D = transpose(T) * transpose(Vrk) * T;
+		dL_dcov[6 * idx + 1] = 2 * T[0][0] * T[0][1] * dL_da + (T[0][0] * T[1][1] + T[0][1] * T[1][0]) * dL_db + 2 * T[1][0] * T[1][1] * dL_dc;
+		dL_dcov[6 * idx + 2] = 2 * T[0][0] * T[0][2] * dL_da + (T[0][0] * T[1][2] + T[0][2] * T[1][0]) * dL_db + 2 * T[1][0] * T[1][2] * dL_dc;
+		dL_dcov[6 * idx + 4] = 2 * T[0][2] * T[0][1] * dL_da + (T[0][1] * T[1][2] + T[0][2] * T[1][1]) * dL_db + 2 * T[1][1] * T[1][2] * dL_dc;
+	}
+	else
+	{
+		for (int i = 0; i < 6; i++)
+			dL_dcov[6 * idx + i] = 0;
+	}
+
+	// Gradients of loss w.r.t. upper 2x3 portion of intermediate matrix T
+	// cov2D = transpose(T) * transpose(Vrk) * T;
+	float dL_dT00 = 2 * (T[0][0] * Vrk[0][0] + T[0][1] * Vrk[0][1] + T[0][2] * Vrk[0][2]) * dL_da +
+		(T[1][0] * Vrk[0][0] + T[1][1] * Vrk[0][1] + T[1][2] * Vrk[0][2]) * dL_db;
+	float dL_dT01 = 2 * (T[0][0] * Vrk[1][0] + T[0][1] * Vrk[1][1] + T[0][2] * Vrk[1][2]) * dL_da +
+		(T[1][0] * Vrk[1][0] + T[1][1] * Vrk[1][1] + T[1][2] * Vrk[1][2]) * dL_db;
+	float dL_dT02 = 2 * (T[0][0] * Vrk[2][0] + T[0][1] * Vrk[2][1] + T[0][2] * Vrk[2][2]) * dL_da +
+		(T[1][0] * Vrk[2][0] + T[1][1] * Vrk[2][1] + T[1][2] * Vrk[2][2]) * dL_db;
+	float dL_dT10 = 2 * (T[1][0] * Vrk[0][0] + T[1][1] * Vrk[0][1] + T[1][2] * Vrk[0][2]) * dL_dc +
+		(T[0][0] * Vrk[0][0] + T[0][1] * Vrk[0][1] + T[0][2] * Vrk[0][2]) * dL_db;
+	float dL_dT11 = 2 * (T[1][0] * Vrk[1][0] + T[1][1] * Vrk[1][1] + T[1][2] * Vrk[1][2]) * dL_dc +
+		(T[0][0] * Vrk[1][0] + T[0][1] * Vrk[1][1] + T[0][2] * Vrk[1][2]) * dL_db;
+	float dL_dT12 = 2 * (T[1][0] * Vrk[2][0] + T[1][1] * Vrk[2][1] + T[1][2] * Vrk[2][2]) * dL_dc +
+		(T[0][0] * Vrk[2][0] + T[0][1] * Vrk[2][1] + T[0][2] * Vrk[2][2]) * dL_db;
+
+	// Gradients of loss w.r.t. upper 3x2 non-zero entries of Jacobian matrix
+	// T = W * J
+	float dL_dJ00 = W[0][0] * dL_dT00 + W[0][1] * dL_dT01 + W[0][2] * dL_dT02;
+	float dL_dJ02 = W[2][0] * dL_dT00 + W[2][1] * dL_dT01 + W[2][2] * dL_dT02;
+	float dL_dJ11 = W[1][0] * dL_dT10 + W[1][1] * dL_dT11 + W[1][2] * dL_dT12;
+	float dL_dJ12 = W[2][0] * dL_dT10 + W[2][1] * dL_dT11 + W[2][2] * dL_dT12;
+
+	float tz = 1.f / t.z;
+	float tz2 = tz * tz;
+	float tz3 = tz2 * tz;
+
+	// Gradients of loss w.r.t. transformed Gaussian mean t
+	float dL_dtx = x_grad_mul * -h_x * tz2 * dL_dJ02;
+	float dL_dty = y_grad_mul * -h_y * tz2 * dL_dJ12;
+	float dL_dtz = -h_x * tz2 * dL_dJ00 - h_y * tz2 * dL_dJ11 + (2 * h_x * t.x) * tz3 * dL_dJ02 + (2 * h_y * t.y) * tz3 * dL_dJ12;
+
+	// Account for transformation of mean to t
+	// t = transformPoint4x3(mean, view_matrix);
+	glm::vec3 dL_dmean = transformVec4x3Transpose({ dL_dtx, dL_dty, dL_dtz }, view_matrix);
+
+	// Gradients of loss w.r.t. Gaussian means, but only the portion
+	// that is caused because the mean affects the covariance matrix.
+	// Additional mean gradient is accumulated in BACKWARD::preprocess.
+	dL_dmeans[idx] = dL_dmean;
+}
+
+// Backward pass for the conversion of scale and rotation to a
+// 3D covariance matrix for each Gaussian.
+static void computeCov3D(int idx, const glm::vec3 scale, float mod, const glm::vec4 rot, const float* dL_dcov3Ds, glm::vec3* dL_dscales, glm::vec4* dL_drots)
+{
+	// Recompute (intermediate) results for the 3D covariance computation.
+	glm::vec4 q = rot;// / glm::length(rot);
+	float r = q.x;
+	float x = q.y;
+	float y = q.z;
+	float z = q.w;
+
+	glm::mat3 R = glm::mat3(
+		1.f - 2.f * (y * y + z * z), 2.f * (x * y - r * z), 2.f * (x * z + r * y),
+		2.f * (x * y + r * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - r * x),
+		2.f * (x * z - r * y), 2.f * (y * z + r * x), 1.f - 2.f * (x * x + y * y)
+	);
+
+	glm::mat3 S = glm::mat3(1.0f);
+
+	glm::vec3 s = mod * scale;
+	S[0][0] = s.x;
+	S[1][1] = s.y;
+	S[2][2] = s.z;
+
+	glm::mat3 M = S * R;
+
+	const float* dL_dcov3D = dL_dcov3Ds + 6 * idx;
+
+	// Convert per-element covariance loss gradients to matrix form
+	glm::mat3 dL_dSigma = glm::mat3(
+		dL_dcov3D[0], 0.5f * dL_dcov3D[1], 0.5f * dL_dcov3D[2],
+		0.5f * dL_dcov3D[1], dL_dcov3D[3], 0.5f * dL_dcov3D[4],
+		0.5f * dL_dcov3D[2], 0.5f * dL_dcov3D[4], dL_dcov3D[5]
+	);
+
+	// Compute loss gradient w.r.t. matrix M
+	// dSigma_dM = 2 * M
+	glm::mat3 dL_dM = 2.0f * M * dL_dSigma;
+
+	glm::mat3 Rt = glm::transpose(R);
+	glm::mat3 dL_dMt = glm::transpose(dL_dM);
+
+	// Gradients of loss w.r.t. scale
+	glm::vec3* dL_dscale = dL_dscales + idx;
+	dL_dscale->x = glm::dot(Rt[0], dL_dMt[0]);
+	dL_dscale->y = glm::dot(Rt[1], dL_dMt[1]);
+	dL_dscale->z = glm::dot(Rt[2], dL_dMt[2]);
+
+	dL_dMt[0] *= s.x;
+	dL_dMt[1] *= s.y;
+	dL_dMt[2] *= s.z;
+
+	// Gradients of loss w.r.t. normalized quaternion
+	glm::vec4 dL_dq;
+	dL_dq.x = 2 * z * (dL_dMt[0][1] - dL_dMt[1][0]) + 2 * y * (dL_dMt[2][0] - dL_dMt[0][2]) + 2 * x * (dL_dMt[1][2] - dL_dMt[2][1]);
+	dL_dq.y = 2 * y * (dL_dMt[1][0] + dL_dMt[0][1]) + 2 * z * (dL_dMt[2][0] + dL_dMt[0][2]) + 2 * r * (dL_dMt[1][2] - dL_dMt[2][1]) - 4 * x * (dL_dMt[2][2] + dL_dMt[1][1]);
+	dL_dq.z = 2 * x * (dL_dMt[1][0] + dL_dMt[0][1]) + 2 * r * (dL_dMt[2][0] - dL_dMt[0][2]) + 2 * z * (dL_dMt[1][2] + dL_dMt[2][1]) - 4 * y * (dL_dMt[2][2] + dL_dMt[0][0]);
+	dL_dq.w = 2 * r * (dL_dMt[0][1] - dL_dMt[1][0]) + 2 * x * (dL_dMt[2][0] + dL_dMt[0][2]) + 2 * y * (dL_dMt[1][2] + dL_dMt[2][1]) - 4 * z * (dL_dMt[1][1] + dL_dMt[0][0]);
+
+	// Gradients of loss w.r.t. unnormalized quaternion
+	dL_drots[idx] = dL_dq;
+}
+
+// Backward pass of the preprocessing steps for one Gaussian, after
+// the covariance computation and inversion have been handled. D is the
+// SH degree, -1 if colors were precomputed.
+template<int D>
+static void preprocessGaussian(
+	int idx, int M,
+	const glm::vec3* means,
+	const float* shs,
+	const bool* clamped,
+	const glm::vec3* scales,
+	const glm::vec4* rotations,
+	const float scale_modifier,
+	const float* proj,
+	const glm::vec3* campos,
+	const glm::vec3* dL_dmean2D,
+	glm::vec3* dL_dmeans,
+	float* dL_dcolor,
+	float* dL_dcov3D,
+	float* dL_dsh,
+	glm::vec3* dL_dscale,
+	glm::vec4* dL_drot)
+{
+	glm::vec3 m = means[idx];
+
+	// Taking care of gradients from the screenspace points
+	glm::vec4 m_hom = transformPoint4x4(m, proj);
+	float m_w = 1.0f / (m_hom.w + 0.0000001f);
+
+	// Compute loss gradient w.r.t. 3D means due to gradients of 2D means
+	// from rendering procedure
+	glm::vec3 dL_dmean;
+	float mul1 = (proj[0] * m.x + proj[4] * m.y + proj[8] * m.z + proj[12]) * m_w * m_w;
+	float mul2 = (proj[1] * m.x + proj[5] * m.y + proj[9] * m.z + proj[13]) * m_w * m_w;
+	dL_dmean.x = (proj[0] * m_w - proj[3] * mul1) * dL_dmean2D[idx].x + (proj[1] * m_w - proj[3] * mul2) * dL_dmean2D[idx].y;
+	dL_dmean.y = (proj[4] * m_w - proj[7] * mul1) * dL_dmean2D[idx].x + (proj[5] * m_w - proj[7] * mul2) * dL_dmean2D[idx].y;
+	dL_dmean.z = (proj[8] * m_w - proj[11] * mul1) * dL_dmean2D[idx].x + (proj[9] * m_w - proj[11] * mul2) * dL_dmean2D[idx].y;
+
+	// That's the second part of the mean gradient. Previous computation
+	// of cov2D and following SH conversion also affects it.
+	dL_dmeans[idx] += dL_dmean;
+
+	// Compute gradient updates due to computing colors from SHs
+	if (D >= 0)
+		computeColorFromSH<D>(idx, M, means, *campos, shs, clamped, (glm::vec3*)dL_dcolor, dL_dmeans, (glm::vec3*)dL_dsh);
+
+	// Compute gradient updates due to computing covariance from scale/rotation
+	if (scales)
+		computeCov3D(idx, scales[idx], scale_modifier, rotations[idx], dL_dcov3D, dL_dscale, dL_drot);
+}
+
+// Backward version of the rendering procedure for one tile. The tile's
+// Gaussians are traversed back to front once; each one is evaluated for
+// all pixels of the tile in SIMD lanes and its gradient contributions
+// are summed over the tile before being written to its record.
+template <uint32_t C>
+static void renderTile(
+	const uint32_t tile_x, const uint32_t tile_y,
+	const TileGrid grid,
+	const glm::uvec2* __restrict__ ranges,
+	const uint32_t* __restrict__ point_list,
+	const uint32_t* __restrict__ point_list_origin,
+	int W, int H,
+	const glm::vec2* __restrict__ subpixel_offset,
+	const float* __restrict__ bg_color,
+	const glm::vec2* __restrict__ points_xy_image,
+	const glm::vec4* __restrict__ conic_opacity,
+	const float* __restrict__ colors,
+	const float* __restrict__ final_Ts,
+	const uint32_t* __restrict__ n_contrib,
+	const float* __restrict__ dL_dpixels,
+	float* __restrict__ instance_grads)
+{
+	using namespace simd;
+	constexpr int GROUPS = BLOCK_SIZE / WIDTH;
+	constexpr int REC = 7 + C;
+
+	const glm::uvec2 pix_min = { tile_x * BLOCK_X, tile_y * BLOCK_Y };
+	const glm::uvec2 range = ranges[tile_y * grid.x + tile_x];
+
+	alignas(64) float pixf_x[BLOCK_SIZE];
+	alignas(64) float pixf_y[BLOCK_SIZE];
+	alignas(64) float T[BLOCK_SIZE];
+	alignas(64) float T_final[BLOCK_SIZE];
+	alignas(64) int last_contributor[BLOCK_SIZE];
+	alignas(64) float dL_dpixel[C][BLOCK_SIZE];
+	alignas(64) float bg_dot_dpixel[BLOCK_SIZE];
+	alignas(64) float accum_rec[C][BLOCK_SIZE];
+	alignas(64) float last_color[C][BLOCK_SIZE];
+	alignas(64) float last_alpha[BLOCK_SIZE];
+
+	// In the forward, we stored the final value for T, the
+	// product of all (1 - alpha) factors, and the number of
+	// Gaussians that contributed to each pixel.
+	int max_contributor = 0;
+	for (int i = 0; i < BLOCK_SIZE; i++)
+	{
+		const uint32_t px = pix_min.x + i % BLOCK_X;
+		const uint32_t py = pix_min.y + i / BLOCK_X;
+		const bool inside = px < (uint32_t)W && py < (uint32_t)H;
+		const uint32_t pix_id = W * py + px;
+
+		pixf_x[i] = (float)px + (inside ? subpixel_offset[pix_id].x : 0.0f);
+		pixf_y[i] = (float)py + (inside ? subpixel_offset[pix_id].y : 0.0f);
+		T_final[i] = inside ? final_Ts[pix_id] : 0.0f;
+		T[i] = T_final[i];
+		last_contributor[i] = inside ? (int)n_contrib[pix_id] : 0;
+		max_contributor = std::max(max_contributor, last_contributor[i]);
+		bg_dot_dpixel[i] = 0.0f;
+		for (uint32_t ch = 0; ch < C; ch++)
+		{
+			dL_dpixel[ch][i] = inside ? dL_dpixels[ch * H * W + pix_id] : 0.0f;
+			bg_dot_dpixel[i] += bg_color[ch] * dL_dpixel[ch][i];
+			accum_rec[ch][i] = 0.0f;
+			last_color[ch][i] = 0.0f;
+		}
+		last_alpha[i] = 0.0f;
+	}
+
+	// Instances behind the last contributor of every pixel in the
+	// tile receive no gradient.
+	for (uint32_t i = range.x + max_contributor; i < range.y; i++)
+		std::memset(instance_grads + (size_t)point_list_origin[i] * REC, 0, REC * sizeof(float));
+
+	// Gradient of pixel coordinate w.r.t. normalized
+	// screen-space viewport corrdinates (-1 to 1)
+	const vfloat ddelx_dx = set1(0.5f * W);
+	const vfloat ddely_dy = set1(0.5f * H);
+	const vfloat one = set1(1.0f);
+	const vfloat max_alpha = set1(0.99f);
+	const vfloat min_alpha = set1(1.0f / 255.0f);
+	const vfloat zero_v = zero();
+
+	// Traverse all Gaussians that contribute to at least one pixel,
+	// starting in the BACK.
+	for (int contributor = max_contributor - 1; contributor >= 0; contributor--)
+	{
+		const uint32_t k = range.x + contributor;
+		const int global_id = point_list[k];
+		const glm::vec2 xy = points_xy_image[global_id];
+		const glm::vec4 con_o = conic_opacity[global_id];
+		const float* color = colors + global_id * C;
+		const vint contributor_v = set1i(contributor);
+
+		const vfloat xy_x = set1(xy.x), xy_y = set1(xy.y);
+		const vfloat con_x = set1(con_o.x), con_y = set1(con_o.y), con_z = set1(con_o.z);
+		const vfloat con_a = set1(-0.5f * con_o.x), con_b = set1(-con_o.y), con_c = set1(-0.5f * con_o.z);
+		const vfloat opacity = set1(con_o.w);
+
+		vfloat acc[REC];
+		for (int r = 0; r < REC; r++)
+			acc[r] = zero_v;
+
+		for (int g = 0; g < GROUPS; g++)
+		{
+			const int base = g * WIDTH;
+
+			// Skip, if this Gaussian is behind the last contributor
+			// of the pixel.
+			vmask m = gti(loadi(last_contributor + base), contributor_v);
+			if (!any(m))
+				continue;
+
+			// Compute blending values, as before.
+			const vfloat dx = sub(xy_x, load(pixf_x + base));
+			const vfloat dy = sub(xy_y, load(pixf_y + base));
+			const vfloat power = fmadd(con_a, mul(dx, dx), fmadd(con_c, mul(dy, dy), mul(con_b, mul(dx, dy))));
+			m = mask_and(m, le(power, zero_v));
+			if (!any(m))
+				continue;
+
+			const vfloat G = exp(power);
+			const vfloat alpha = min(max_alpha, mul(opacity, G));
+			m = mask_and(m, ge(alpha, min_alpha));
+			if (!any(m))
+				continue;
+
+			const vfloat one_minus_alpha = sub(one, alpha);
+			const vfloat T_g = select(m, div(load(T + base), one_minus_alpha), load(T + base));
+			store(T + base, T_g);
+			const vfloat dchannel_dcolor = mul(alpha, T_g);
+
+			// Propagate gradients to per-Gaussian colors and keep
+			// gradients w.r.t. alpha (blending factor for a Gaussian/pixel
+			// pair).
+			const vfloat l_alpha = load(last_alpha + base);
+			vfloat dL_dalpha = zero_v;
+			for (uint32_t ch = 0; ch < C; ch++)
+			{
+				const vfloat c = set1(color[ch]);
+				// Update last color (to be used in the next iteration)
+				const vfloat rec = fmadd(l_alpha, load(last_color[ch] + base), mul(sub(one, l_alpha), load(accum_rec[ch] + base)));
+				store(accum_rec[ch] + base, select(m, rec, load(accum_rec[ch] + base)));
+				store(last_color[ch] + base, select(m, c, load(last_color[ch] + base)));
+
+				const vfloat dL_dchannel = load(dL_dpixel[ch] + base);
+				dL_dalpha = fmadd(sub(c, rec), dL_dchannel, dL_dalpha);
+				// Update the gradients w.r.t. color of the Gaussian.
+				acc[7 + ch] = add(acc[7 + ch], select(m, mul(dchannel_dcolor, dL_dchannel), zero_v));
+			}
+			dL_dalpha = mul(dL_dalpha, T_g);
+			// Update last alpha (to be used in the next iteration)
+			store(last_alpha + base, select(m, alpha, l_alpha));
+
+			// Account for fact that alpha also influences how much of
+			// the background color is added if nothing left to blend
+			const vfloat bg_term = div(sub(zero_v, load(T_final + base)), one_minus_alpha);
+			dL_dalpha = fmadd(bg_term, load(bg_dot_dpixel + base), dL_dalpha);
+
+			// Helpful reusable temporary variables
+			const vfloat dL_dG = mul(opacity, dL_dalpha);
+			const vfloat gdx = mul(G, dx);
+			const vfloat gdy = mul(G, dy);
+			const vfloat dG_ddelx = sub(zero_v, fmadd(gdx, con_x, mul(gdy, con_y)));
+			const vfloat dG_ddely = sub(zero_v, fmadd(gdy, con_z, mul(gdx, con_y)));
+
+			// Gradients w.r.t. 2D mean position of the Gaussian
+			const vfloat dL_dmean_x = mul(mul(dL_dG, dG_ddelx), ddelx_dx);
+			const vfloat dL_dmean_y = mul(mul(dL_dG, dG_ddely), ddely_dy);
+			acc[0] = add(acc[0], select(m, dL_dmean_x, zero_v));
+			acc[1] = add(acc[1], select(m, dL_dmean_y, zero_v));
+
+			// we use this new metric for densification, please check https://arxiv.org/pdf/2404.10772.pdf Densification section for more details.
+			acc[2] = add(acc[2], select(m, add(abs(dL_dmean_x), abs(dL_dmean_y)), zero_v));
+
+			// Gradients w.r.t. 2D covariance (2x2 matrix, symmetric)
+			const vfloat half_dL_dG = mul(set1(-0.5f), dL_dG);
+			acc[3] = add(acc[3], select(m, mul(mul(gdx, dx), half_dL_dG), zero_v));
+			acc[4] = add(acc[4], select(m, mul(mul(gdx, dy), half_dL_dG), zero_v));
+			acc[5] = add(acc[5], select(m, mul(mul(gdy, dy), half_dL_dG), zero_v));
+
+			// Gradients w.r.t. opacity of the Gaussian
+			acc[6] = add(acc[6], select(m, mul(G, dL_dalpha), zero_v));
+		}
+
+		float* record = instance_grads + (size_t)point_list_origin[k] * REC;
+		for (int r = 0; r < REC; r++)
+			record[r] = reduce_add(acc[r]);
+	}
+}
+
+// Computes the instance records of all tiles with C channels
+struct RenderTiles
+{
+	template<int C>
+	static void run(
+		const TileGrid grid,
+		const glm::uvec2* ranges,
+		const uint32_t* point_list,
+		const uint32_t* point_list_origin,
+		int W, int H,
+		const glm::vec2* subpixel_offset,
+		const float* bg_color,
+		const glm::vec2* means2D,
+		const glm::vec4* conic_opacity,
+		const float* colors,
+		const float* final_Ts,
+		const uint32_t* n_contrib,
+		const float* dL_dpixels,
+		float* instance_grads)
+	{
+		const int num_tiles = grid.x * grid.y;
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int tile = 0; tile < num_tiles; tile++)
+		{
+			renderTile<C>(
+				tile % grid.x, tile / grid.x,
+				grid,
+				ranges,
+				point_list,
+				point_list_origin,
+				W, H,
+				subpixel_offset,
+				bg_color,
+				means2D,
+				conic_opacity,
+				colors,
+				final_Ts,
+				n_contrib,
+				dL_dpixels,
+				instance_grads);
+		}
+	}
+};
+
+// Sums the instance records with C channels
+struct ReduceRecords
+{
+	template<int C>
+	static void run(
+		int P,
+		const int* radii,
+		const uint32_t* point_offsets,
+		const float* instance_grads,
+		float* dL_dmean2D,
+		float* dL_dconic2D,
+		float* dL_dopacity,
+		float* dL_dcolors)
+	{
+		constexpr int REC = 7 + C;
+
+		#pragma omp parallel for schedule(static, 256)
+		for (int idx = 0; idx < P; idx++)
+		{
+			if (!(radii[idx] > 0))
+				continue;
+
+			float sum[REC] = { 0 };
+			const uint32_t begin = (idx == 0) ? 0 : point_offsets[idx - 1];
+			for (uint32_t slot = begin; slot < point_offsets[idx]; slot++)
+			{
+				const float* record = instance_grads + (size_t)slot * REC;
+				for (int r = 0; r < REC; r++)
+					sum[r] += record[r];
+			}
+
+			dL_dmean2D[3 * idx + 0] = sum[0];
+			dL_dmean2D[3 * idx + 1] = sum[1];
+			dL_dmean2D[3 * idx + 2] = sum[2];
+			dL_dconic2D[4 * idx + 0] = sum[3];
+			dL_dconic2D[4 * idx + 1] = sum[4];
+			dL_dconic2D[4 * idx + 3] = sum[5];
+			dL_dopacity[idx] = sum[6];
+			for (int ch = 0; ch < C; ch++)
+				dL_dcolors[C * idx + ch] = sum[7 + ch];
+		}
+	}
+};
+
+// Every Gaussian only touches its own gradients, so both steps run
+// back to back per Gaussian: propagate the gradients of the 2D conic
+// matrix computation, then finish 3D mean gradients, propagate color
+// gradients to SH (if desired) and 3D covariance gradients to scale
+// and rotation.
+struct PreprocessGaussians
+{
+	template<int D>
+	static void run(
+		int P, int M,
+		const float* means3D,
+		const int* radii,
+		const float* shs,
+		const bool* clamped,
+		const glm::vec3* scales,
+		const glm::vec4* rotations,
+		const float scale_modifier,
+		const float* cov3Ds,
+		const float* viewmatrix,
+		const float* projmatrix,
+		const float focal_x, float focal_y,
+		const float tan_fovx, float tan_fovy,
+		const float kernel_size,
+		const glm::vec3* campos,
+		const float* dL_dmean2D,
+		const float* dL_dconic,
+		glm::vec3* dL_dmean3D,
+		float* dL_dcolor,
+		float* dL_dcov3D,
+		float* dL_dsh,
+		glm::vec3* dL_dscale,
+		glm::vec4* dL_drot,
+		const glm::vec4* conic_opacity,
+		float* dL_dopacity)
+	{
+		#pragma omp parallel for schedule(static, 256)
+		for (int idx = 0; idx < P; idx++)
+		{
+			if (!(radii[idx] > 0))
+				continue;
+
+			computeCov2D(
+				idx,
+				(const glm::vec3*)means3D,
+				cov3Ds,
+				focal_x, focal_y,
+				tan_fovx, tan_fovy,
+				kernel_size,
+				viewmatrix,
+				dL_dconic,
+				dL_dmean3D,
+				dL_dcov3D,
+				conic_opacity,
+				dL_dopacity);
+
+			preprocessGaussian<D>(
+				idx, M,
+				(const glm::vec3*)means3D,
+				shs,
+				clamped,
+				scales,
+				rotations,
+				scale_modifier,
+				projmatrix,
+				campos,
+				(const glm::vec3*)dL_dmean2D,
+				dL_dmean3D,
+				dL_dcolor,
+				dL_dcov3D,
+				dL_dsh,
+				dL_dscale,
+				dL_drot);
+		}
+	}
+};
+
+}
+
+void CpuRasterizer::BACKWARD::render(
+	const TileGrid grid,
+	const glm::uvec2* ranges,
+	const uint32_t* point_list,
+	const uint32_t* point_list_origin,
+	int W, int H,
+	const glm::vec2* subpixel_offset,
+	const float* bg_color,
+	const glm::vec2* means2D,
+	const glm::vec4* conic_opacity,
+	const float* colors,
+	const int channels,
+	const float* final_Ts,
+	const uint32_t* n_contrib,
+	const float* dL_dpixels,
+	float* instance_grads)
+{
+	dispatchChannels<RenderTiles>(channels,
+		grid,
+		ranges,
+		point_list,
+		point_list_origin,
+		W, H,
+		subpixel_offset,
+		bg_color,
+		means2D,
+		conic_opacity,
+		colors,
+		final_Ts,
+		n_contrib,
+		dL_dpixels,
+		instance_grads);
+}
+
+void CpuRasterizer::BACKWARD::reduce(
+	int P,
+	const int channels,
+	const int* radii,
+	const uint32_t* point_offsets,
+	const float* instance_grads,
+	float* dL_dmean2D,
+	float* dL_dconic2D,
+	float* dL_dopacity,
+	float* dL_dcolors)
+{
+	dispatchChannels<ReduceRecords>(channels,
+		P,
+		radii,
+		point_offsets,
+		instance_grads,
+		dL_dmean2D,
+		dL_dconic2D,
+		dL_dopacity,
+		dL_dcolors);
+}
+
+void CpuRasterizer::BACKWARD::preprocess(
+	int P, int D, int M,
+	const float* means3D,
+	const int* radii,
+	const float* shs,
+	const bool* clamped,
+	const glm::vec3* scales,
+	const glm::vec4* rotations,
+	const float scale_modifier,
+	const float* cov3Ds,
+	const float* viewmatrix,
+	const float* projmatrix,
+	const float focal_x, float focal_y,
+	const float tan_fovx, float tan_fovy,
+	const float kernel_size,
+	const glm::vec3* campos,
+	const float* dL_dmean2D,
+	const float* dL_dconic,
+	glm::vec3* dL_dmean3D,
+	float* dL_dcolor,
+	float* dL_dcov3D,
+	float* dL_dsh,
+	glm::vec3* dL_dscale,
+	glm::vec4* dL_drot,
+	const glm::vec4* conic_opacity,
+	float* dL_dopacity)
+{
+	dispatchSHDegree<PreprocessGaussians>(D,
+		P, M,
+		means3D,
+		radii,
+		shs,
+		clamped,
+		scales,
+		rotations,
+		scale_modifier,
+		cov3Ds,
+		viewmatrix,
+		projmatrix,
+		focal_x, focal_y,
+		tan_fovx, tan_fovy,
+		kernel_size,
+		campos,
+		dL_dmean2D,
+		dL_dconic,
+		dL_dmean3D,
+		dL_dcolor,
+		dL_dcov3D,
+		dL_dsh,
+		dL_dscale,
+		dL_drot,
+		conic_opacity,
+		dL_dopacity);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_BACKWARD_H_INCLUDED
+#define CPU_RASTERIZER_BACKWARD_H_INCLUDED
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "auxiliary.h"
+
+namespace CpuRasterizer
+{
+namespace BACKWARD
+{
+	// Number of floats in the gradient record of one Gaussian/tile
+	// instance: dL_dmean2D (x, y, |x| + |y|), dL_dconic (x, y, w),
+	// dL_dopacity and dL_dcolor.
+	inline int recordSize(int channels) { return 7 + channels; }
+
+	// Computes the gradients of every Gaussian/tile instance. Instead of
+	// scattering into per-Gaussian gradients, each tile writes one record
+	// per instance to the instance's unsorted slot (given by
+	// point_list_origin), so no two threads ever write the same memory.
+	void render(
+		const TileGrid grid,
+		const glm::uvec2* ranges,
+		const uint32_t* point_list,
+		const uint32_t* point_list_origin,
+		int W, int H,
+		const glm::vec2* subpixel_offset,
+		const float* bg_color,
+		const glm::vec2* means2D,
+		const glm::vec4* conic_opacity,
+		const float* colors,
+		const int channels,
+		const float* final_Ts,
+		const uint32_t* n_contrib,
+		const float* dL_dpixels,
+		float* instance_grads);
+
+	// Sums the instance records of each Gaussian in slot order. Slots of
+	// a Gaussian are contiguous and ordered by tile, so the result does
+	// not depend on the number of threads or on scheduling.
+	void reduce(
+		int P,
+		const int channels,
+		const int* radii,
+		const uint32_t* point_offsets,
+		const float* instance_grads,
+		float* dL_dmean2D,
+		float* dL_dconic2D,
+		float* dL_dopacity,
+		float* dL_dcolors);
+
+	// D is the SH degree of the colors, -1 if they were precomputed.
+	void preprocess(
+		int P, int D, int M,
+		const float* means,
+		const int* radii,
+		const float* shs,
+		const bool* clamped,
+		const glm::vec3* scales,
+		const glm::vec4* rotations,
+		const float scale_modifier,
+		const float* cov3Ds,
+		const float* view,
+		const float* proj,
+		const float focal_x, float focal_y,
+		const float tan_fovx, float tan_fovy,
+		const float kernel_size,
+		const glm::vec3* campos,
+		const float* dL_dmean2D,
+		const float* dL_dconics,
+		glm::vec3* dL_dmeans,
+		float* dL_dcolor,
+		float* dL_dcov3D,
+		float* dL_dsh,
+		glm::vec3* dL_dscale,
+		glm::vec4* dL_drot,
+		const glm::vec4* conic_opacity,
+		float* dL_dopacity);
+}
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "bvh.h"
+#include "../cuda_rasterizer/config.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <omp.h>
+
+namespace
+{
+	constexpr int LEAF_SIZE = 8;
+
+	// Near plane of in_frustum, minus a margin for rounding
+	constexpr float NEAR_PLANE = 0.2f - 1e-3f;
+
+	enum class Overlap { Outside, Partial, Inside };
+
+	// Frustum of one camera, in the terms of the rasterizer's preprocess
+	struct Frustum
+	{
+		const float* view;
+		const float* proj;
+		int W, H;
+		float grid_u, grid_v;	// right/bottom end of the tile grid
+		float jacobian_scale;	// bounds |J|_F^2 * z^2 of the EWA Jacobian
+		float kernel_size;
+
+		// Upper bound of the rasterizer's radius (ceil of 3 sqrt of the
+		// larger eigenvalue of the dilated 2D covariance) for Gaussians
+		// at view depth >= z with standard deviations <= sigma. The trace
+		// of J Sigma J^T is at most |J|_F^2 sigma^2, and preprocess
+		// bounds the larger eigenvalue by the trace plus sqrt(0.1).
+		float radiusBound(float z, float sigma) const
+		{
+			const float trace = jacobian_scale * sigma * sigma / (z * z) + 2.0f * kernel_size;
+			return 3.0f * std::sqrt(trace + 0.32f) + 2.0f;
+		}
+
+		// Classifies the Gaussians with means in [lo, hi] and standard
+		// deviations <= sigma
+		Overlap test(const float* lo, const float* hi, float sigma) const
+		{
+			float z_min = INFINITY, z_max = -INFINITY;
+			float u_min = INFINITY, u_max = -INFINITY, v_min = INFINITY, v_max = -INFINITY;
+			bool projectable = true;
+			for (int c = 0; c < 8; c++)
+			{
+				const float x = (c & 1) ? hi[0] : lo[0];
+				const float y = (c & 2) ? hi[1] : lo[1];
+				const float z = (c & 4) ? hi[2] : lo[2];
+				const float depth = view[2] * x + view[6] * y + view[10] * z + view[14];
+				z_min = std::min(z_min, depth);
+				z_max = std::max(z_max, depth);
+
+				const float w = proj[3] * x + proj[7] * y + proj[11] * z + proj[15];
+				projectable = projectable && w > 0.0f;
+				const float p_w = 1.0f / (w + 0.0000001f);
+				const float u = (((proj[0] * x + proj[4] * y + proj[8] * z + proj[12]) * p_w + 1.0f) * W - 1.0f) * 0.5f;
+				const float v = (((proj[1] * x + proj[5] * y + proj[9] * z + proj[13]) * p_w + 1.0f) * H - 1.0f) * 0.5f;
+				u_min = std::min(u_min, u);
+				u_max = std::max(u_max, u);
+				v_min = std::min(v_min, v);
+				v_max = std::max(v_max, v);
+			}
+
+			// in_frustum drops every mean at depth <= 0.2
+			if (z_max <= NEAR_PLANE)
+				return Overlap::Outside;
+			// Projections are only bounded by the corners in front of the camera
+			if (z_min <= NEAR_PLANE || !projectable)
+				return Overlap::Partial;
+
+			// getRect rounds to tiles, hence the extra tile of margin
+			const float r = radiusBound(z_min, sigma);
+			if (u_max + r < -(float)(BLOCK_X + 1) || u_min - r > grid_u + 1.0f ||
+				v_max + r < -(float)(BLOCK_Y + 1) || v_min - r > grid_v + 1.0f)
+				return Overlap::Outside;
+			if (u_min >= 0.0f && u_max <= (float)W && v_min >= 0.0f && v_max <= (float)H)
+				return Overlap::Inside;
+			return Overlap::Partial;
+		}
+	};
+}
+
+int BVH::Tree::buildRange(int first, int count, const float* means)
+{
+	const int idx = (int)nodes.size();
+	nodes.push_back(Node{ {}, {}, 0.0f, first, count, -1 });
+	if (count <= LEAF_SIZE)
+		return idx;
+
+	float lo[3] = { INFINITY, INFINITY, INFINITY };
+	float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (int i = first; i < first + count; i++)
+	{
+		const float* p = means + 3 * order[i];
+		for (int k = 0; k < 3; k++)
+		{
+			lo[k] = std::min(lo[k], p[k]);
+			hi[k] = std::max(hi[k], p[k]);
+		}
+	}
+	int axis = 0;
+	for (int k = 1; k < 3; k++)
+		if (hi[k] - lo[k] > hi[axis] - lo[axis])
+			axis = k;
+
+	const int half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](int i, int j) {
+		return means[3 * i + axis] < means[3 * j + axis];
+	});
+
+	buildRange(first, half, means);
+	const int right = buildRange(first + half, count - half, means);
+	nodes[idx].right = right;
+	return idx;
+}
+
+void BVH::Tree::fitLeaf(Node& node) const
+{
+	for (int k = 0; k < 3; k++)
+	{
+		node.lo[k] = INFINITY;
+		node.hi[k] = -INFINITY;
+	}
+	node.sigma = 0.0f;
+	for (int i = node.first; i < node.first + node.count; i++)
+	{
+		const float* p = &points[4 * order[i]];
+		for (int k = 0; k < 3; k++)
+		{
+			node.lo[k] = std::min(node.lo[k], p[k]);
+			node.hi[k] = std::max(node.hi[k], p[k]);
+		}
+		node.sigma = std::max(node.sigma, p[3]);
+	}
+}
+
+void BVH::Tree::build(int P_, const float* means, const float* sigma)
+{
+	P = P_;
+	nodes.clear();
+	order.resize(P);
+	points.resize(4 * (size_t)P);
+	std::iota(order.begin(), order.end(), 0);
+	if (P == 0)
+		return;
+	nodes.reserve(2 * (P / LEAF_SIZE + 1));
+	buildRange(0, P, means);
+	refit(means, sigma);
+}
+
+void BVH::Tree::refit(const float* means, const float* sigma)
+{
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < P; i++)
+	{
+		points[4 * i] = means[3 * i];
+		points[4 * i + 1] = means[3 * i + 1];
+		points[4 * i + 2] = means[3 * i + 2];
+		points[4 * i + 3] = sigma[i];
+	}
+
+	const int N = (int)nodes.size();
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (int n = 0; n < N; n++)
+		if (nodes[n].right < 0)
+			fitLeaf(nodes[n]);
+
+	// Children come after their parent
+	for (int n = N - 1; n >= 0; n--)
+	{
+		Node& node = nodes[n];
+		if (node.right < 0)
+			continue;
+		const Node& l = nodes[n + 1];
+		const Node& r = nodes[node.right];
+		for (int k = 0; k < 3; k++)
+		{
+			node.lo[k] = std::min(l.lo[k], r.lo[k]);
+			node.hi[k] = std::max(l.hi[k], r.hi[k]);
+		}
+		node.sigma = std::max(l.sigma, r.sigma);
+	}
+}
+
+void BVH::Tree::cull(
+	const float* viewmatrix,
+	const float* projmatrix,
+	int W, int H,
+	float tan_fovx, float tan_fovy,
+	float kernel_size,
+	std::vector<int>& visible) const
+{
+	visible.clear();
+	if (nodes.empty())
+		return;
+
+	const float focal_x = W / (2.0f * tan_fovx);
+	const float focal_y = H / (2.0f * tan_fovy);
+	const float limx = 1.3f * tan_fovx;
+	const float limy = 1.3f * tan_fovy;
+
+	Frustum frustum;
+	frustum.view = viewmatrix;
+	frustum.proj = projmatrix;
+	frustum.W = W;
+	frustum.H = H;
+	frustum.grid_u = (float)(((W + BLOCK_X - 1) / BLOCK_X) * BLOCK_X);
+	frustum.grid_v = (float)(((H + BLOCK_Y - 1) / BLOCK_Y) * BLOCK_Y);
+	frustum.jacobian_scale = focal_x * focal_x * (1.0f + limx * limx) + focal_y * focal_y * (1.0f + limy * limy);
+	frustum.kernel_size = kernel_size;
+
+	std::vector<int> stack = { 0 };
+	while (!stack.empty())
+	{
+		const int n = stack.back();
+		const Node& node = nodes[n];
+		stack.pop_back();
+
+		const Overlap overlap = frustum.test(node.lo, node.hi, node.sigma);
+		if (overlap == Overlap::Outside)
+			continue;
+		if (overlap == Overlap::Inside)
+		{
+			visible.insert(visible.end(), order.begin() + node.first, order.begin() + node.first + node.count);
+			continue;
+		}
+		if (node.right >= 0)
+		{
+			stack.push_back(node.right);
+			stack.push_back(n + 1);
+			continue;
+		}
+
+		// Partially visible leaf: test its Gaussians one by one. They are
+		// only dropped when known to be outside.
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const int g = order[i];
+			const float* p = &points[4 * g];
+			if (frustum.test(p, p, p[3]) != Overlap::Outside)
+				visible.push_back(g);
+		}
+	}
+	std::sort(visible.begin(), visible.end());
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_BVH_H_INCLUDED
+#define CPU_RASTERIZER_BVH_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over the Gaussians for view frustum culling
+// ahead of preprocessing. Nodes bound the means of their Gaussians and
+// the largest standard deviation among them (for a Gaussian with scales
+// s, max(s)). The culling test is conservative with respect to the
+// rasterizer: a Gaussian is only dropped if preprocess would cull it
+// (view depth <= 0.2) or if its bounding rectangle, whose radius is
+// bounded from the depth, the standard deviation and the clamped EWA
+// Jacobian, can't touch a tile of the image. Rendering the visible list
+// therefore gives the same image as rendering everything.
+namespace BVH
+{
+	struct Node
+	{
+		float lo[3], hi[3];	// bounds of the means
+		float sigma;		// largest standard deviation
+		int first, count;	// Gaussians order[first, first + count)
+		int right;			// right child (left is the next node), -1 for leaves
+	};
+
+	class Tree
+	{
+	public:
+		// Builds the hierarchy by median splits along the longest axis
+		// of the means' bounding box. means is P x 3, sigma holds P values.
+		void build(int P, const float* means, const float* sigma);
+
+		// Recomputes the bounds for moved Gaussians, keeping the topology.
+		// P must not have changed since build (rebuild after densification).
+		void refit(const float* means, const float* sigma);
+
+		// Sorted ids of the Gaussians that may be visible to the camera
+		// (view and projection matrices as passed to the rasterizer).
+		void cull(
+			const float* viewmatrix,
+			const float* projmatrix,
+			int W, int H,
+			float tan_fovx, float tan_fovy,
+			float kernel_size,
+			std::vector<int>& visible) const;
+
+		int size() const { return P; }
+		int numNodes() const { return (int)nodes.size(); }
+
+	private:
+		int buildRange(int first, int count, const float* means);
+		void fitLeaf(Node& node) const;
+
+		int P = 0;
+		std::vector<Node> nodes;
+		std::vector<int> order;
+		std::vector<float> points;	// mean and sigma of every Gaussian
+	};
+}
+
+#endif
@@ -0,0 +1,756 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "forward.h"
+#include "auxiliary.h"
+#include "../cuda_rasterizer/tile_overlap.h"
+#include "../cuda_rasterizer/dispatch.h"
+#include "simd.h"
+#include "tile_scheduler.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace CpuRasterizer
+{
+
+// Coefficients of a compressed Gaussian: band 0 decoded from half, the
+// higher bands in its codebook entry. Indices are constant after
+// unrolling, so the selection is resolved at compile time.
+struct CodebookSH
+{
+	glm::vec3 dc;
+	const glm::vec3* rest;
+	glm::vec3 operator[](int i) const { return i == 0 ? dc : rest[i - 1]; }
+};
+
+// Forward method for converting the input spherical harmonics
+// coefficients of each Gaussian to a simple RGB color. The degree is a
+// template argument, the bands above it are compiled out. sh indexes the
+// coefficients of the Gaussian (a pointer or CodebookSH).
+template<int deg, typename SH>
+static glm::vec3 computeColorFromSH(int idx, const glm::vec3* means, glm::vec3 campos, const SH sh, bool* clamped)
+{
+	// The implementation is loosely based on code for
+	// "Differentiable Point-Based Radiance Fields for
+	// Efficient View Synthesis" by Zhang et al. (2022)
+	glm::vec3 pos = means[idx];
+	glm::vec3 dir = pos - campos;
+	dir = dir / glm::length(dir);
+
+	glm::vec3 result = SH_C0 * sh[0];
+
+	if (deg > 0)
+	{
+		float x = dir.x;
+		float y = dir.y;
+		float z = dir.z;
+		result = result - SH_C1 * y * sh[1] + SH_C1 * z * sh[2] - SH_C1 * x * sh[3];
+
+		if (deg > 1)
+		{
+			float xx = x * x, yy = y * y, zz = z * z;
+			float xy = x * y, yz = y * z, xz = x * z;
+			result = result +
+				SH_C2[0] * xy * sh[4] +
+				SH_C2[1] * yz * sh[5] +
+				SH_C2[2] * (2.0f * zz - xx - yy) * sh[6] +
+				SH_C2[3] * xz * sh[7] +
+				SH_C2[4] * (xx - yy) * sh[8];
+
+			if (deg > 2)
+			{
+				result = result +
+					SH_C3[0] * y * (3.0f * xx - yy) * sh[9] +
+					SH_C3[1] * xy * z * sh[10] +
+					SH_C3[2] * y * (4.0f * zz - xx - yy) * sh[11] +
+					SH_C3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy) * sh[12] +
+					SH_C3[4] * x * (4.0f * zz - xx - yy) * sh[13] +
+					SH_C3[5] * z * (xx - yy) * sh[14] +
+					SH_C3[6] * x * (xx - 3.0f * yy) * sh[15];
+			}
+		}
+	}
+	result += 0.5f;
+
+	// RGB colors are clamped to positive values. If values are
+	// clamped, we need to keep track of this for the backward pass.
+	clamped[3 * idx + 0] = (result.x < 0);
+	clamped[3 * idx + 1] = (result.y < 0);
+	clamped[3 * idx + 2] = (result.z < 0);
+	return glm::max(result, 0.0f);
+}
+
+// Forward version of 2D covariance matrix computation
+static glm::vec4 computeCov2D(const glm::vec3& mean, float focal_x, float focal_y, float tan_fovx, float tan_fovy, float kernel_size, const float* cov3D, const float* viewmatrix)
+{
+	// The following models the steps outlined by equations 29
+	// and 31 in "EWA Splatting" (Zwicker et al., 2002).
+	// Additionally considers aspect / scaling of viewport.
+	// Transposes used to account for row-/column-major conventions.
+	glm::vec3 t = transformPoint4x3(mean, viewmatrix);
+
+	const float limx = 1.3f * tan_fovx;
+	const float limy = 1.3f * tan_fovy;
+	const float txtz = t.x / t.z;
+	const float tytz = t.y / t.z;
+	t.x = std::min(limx, std::max(-limx, txtz)) * t.z;
+	t.y = std::min(limy, std::max(-limy, tytz)) * t.z;
+
+	glm::mat3 J = glm::mat3(
+		focal_x / t.z, 0.0f, -(focal_x * t.x) / (t.z * t.z),
+		0.0f, focal_y / t.z, -(focal_y * t.y) / (t.z * t.z),
+		0, 0, 0);
+
+	glm::mat3 W = glm::mat3(
+		viewmatrix[0], viewmatrix[4], viewmatrix[8],
+		viewmatrix[1], viewmatrix[5], viewmatrix[9],
+		viewmatrix[2], viewmatrix[6], viewmatrix[10]);
+
+	glm::mat3 T = W * J;
+
+	glm::mat3 Vrk = glm::mat3(
+		cov3D[0], cov3D[1], cov3D[2],
+		cov3D[1], cov3D[3], cov3D[4],
+		cov3D[2], cov3D[4], cov3D[5]);
+
+	glm::mat3 cov = glm::transpose(T) * glm::transpose(Vrk) * T;
+
+	// Apply low-pass filter: every Gaussian should be at least
+	// one pixel wide/high. Discard 3rd row and column.
+
+	// compute the coef of alpha based on the detemintant
+	const float det_0 = std::max(1e-6, (double)(cov[0][0] * cov[1][1] - cov[0][1] * cov[0][1]));
+	const float det_1 = std::max(1e-6, (double)((cov[0][0] + kernel_size) * (cov[1][1] + kernel_size) - cov[0][1] * cov[0][1]));
+	float coef = std::sqrt(det_0 / (det_1 + 1e-6) + 1e-6);
+
+	if (det_0 <= 1e-6 || det_1 <= 1e-6){
+		coef = 0.0f;
+	}
+
+	cov[0][0] += kernel_size;
+	cov[1][1] += kernel_size;
+
+	return { float(cov[0][0]), float(cov[0][1]), float(cov[1][1]), float(coef) };
+}
+
+// Forward method for converting scale and rotation properties of each
+// Gaussian to a 3D covariance matrix in world space. Also takes care
+// of quaternion normalization.
+static void computeCov3D(const glm::vec3 scale, float mod, const glm::vec4 rot, float* cov3D)
+{
+	// Create scaling matrix
+	glm::mat3 S = glm::mat3(1.0f);
+	S[0][0] = mod * scale.x;
+	S[1][1] = mod * scale.y;
+	S[2][2] = mod * scale.z;
+
+	// Normalize quaternion to get valid rotation
+	glm::vec4 q = rot;// / glm::length(rot);
+	float r = q.x;
+	float x = q.y;
+	float y = q.z;
+	float z = q.w;
+
+	// Compute rotation matrix from quaternion
+	glm::mat3 R = glm::mat3(
+		1.f - 2.f * (y * y + z * z), 2.f * (x * y - r * z), 2.f * (x * z + r * y),
+		2.f * (x * y + r * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - r * x),
+		2.f * (x * z - r * y), 2.f * (y * z + r * x), 1.f - 2.f * (x * x + y * y)
+	);
+
+	glm::mat3 M = S * R;
+
+	// Compute 3D world covariance matrix Sigma
+	glm::mat3 Sigma = glm::transpose(M) * M;
+
+	// Covariance is symmetric, only store upper right
+	cov3D[0] = Sigma[0][0];
+	cov3D[1] = Sigma[0][1];
+	cov3D[2] = Sigma[0][2];
+	cov3D[3] = Sigma[1][1];
+	cov3D[4] = Sigma[1][2];
+	cov3D[5] = Sigma[2][2];
+}
+
+// Perform initial steps for one Gaussian prior to rasterization.
+// Host counterpart of preprocessCUDA, invoked once per Gaussian. D is
+// the SH degree, -1 if colors are precomputed. If compressed.sh_index is
+// set, the attributes are decoded from compressed, see compressed.h.
+template<int D>
+static void preprocessGaussian(int idx, int M,
+	const float* orig_points,
+	const glm::vec3* scales,
+	const float scale_modifier,
+	const glm::vec4* rotations,
+	const float* opacities,
+	const float* shs,
+	bool* clamped,
+	const float* cov3D_precomp,
+	const float* viewmatrix,
+	const float* projmatrix,
+	const glm::vec3* cam_pos,
+	const int W, int H,
+	const float tan_fovx, float tan_fovy,
+	const float focal_x, float focal_y,
+	const float kernel_size,
+	int* radii,
+	glm::vec2* points_xy_image,
+	float* depths,
+	float* cov3Ds,
+	float* rgb,
+	glm::vec4* conic_opacity,
+	const TileGrid grid,
+	uint32_t* tiles_touched,
+	bool prefiltered,
+	const CompressedGaussians& compressed,
+	bool* filter_error)
+{
+	// Initialize radius and touched tiles to 0. If this isn't changed,
+	// this Gaussian will not be processed further.
+	radii[idx] = 0;
+	tiles_touched[idx] = 0;
+
+	// Perform near culling, quit if outside.
+	glm::vec3 p_view;
+	if (!in_frustum(idx, orig_points, viewmatrix, projmatrix, prefiltered, p_view, filter_error))
+		return;
+
+	// Transform point by projecting
+	glm::vec3 p_orig = { orig_points[3 * idx], orig_points[3 * idx + 1], orig_points[3 * idx + 2] };
+	glm::vec4 p_hom = transformPoint4x4(p_orig, projmatrix);
+	float p_w = 1.0f / (p_hom.w + 0.0000001f);
+	glm::vec3 p_proj = { p_hom.x * p_w, p_hom.y * p_w, p_hom.z * p_w };
+
+	// If 3D covariance matrix is precomputed, use it, otherwise compute
+	// from scaling and rotation parameters.
+	const float* cov3D;
+	if (cov3D_precomp != nullptr)
+	{
+		cov3D = cov3D_precomp + idx * 6;
+	}
+	else if (compressed.sh_index != nullptr)
+	{
+		glm::vec3 scale;
+		glm::vec4 rotation;
+		decodeHalves(compressed.scales + 3 * idx, 3, &scale.x);
+		decodeHalves(compressed.rotations + 4 * idx, 4, &rotation.x);
+		computeCov3D(scale, scale_modifier, rotation, cov3Ds + idx * 6);
+		cov3D = cov3Ds + idx * 6;
+	}
+	else
+	{
+		computeCov3D(scales[idx], scale_modifier, rotations[idx], cov3Ds + idx * 6);
+		cov3D = cov3Ds + idx * 6;
+	}
+
+	// Compute 2D screen-space covariance matrix
+	glm::vec4 cov = computeCov2D(p_orig, focal_x, focal_y, tan_fovx, tan_fovy, kernel_size, cov3D, viewmatrix);
+
+	// Invert covariance (EWA algorithm)
+	float det = (cov.x * cov.z - cov.y * cov.y);
+	if (det == 0.0f)
+		return;
+	float det_inv = 1.f / det;
+	glm::vec3 conic = { cov.z * det_inv, -cov.y * det_inv, cov.x * det_inv };
+
+	// Compute extent in screen space (by finding eigenvalues of
+	// 2D covariance matrix). Use extent to compute a bounding rectangle
+	// of screen-space tiles that this Gaussian overlaps with. Quit if
+	// rectangle covers 0 tiles.
+	float mid = 0.5f * (cov.x + cov.z);
+	float lambda1 = mid + std::sqrt(std::max(0.1f, mid * mid - det));
+	float lambda2 = mid - std::sqrt(std::max(0.1f, mid * mid - det));
+	float my_radius = std::ceil(3.f * std::sqrt(std::max(lambda1, lambda2)));
+	glm::vec2 point_image = { ndc2Pix(p_proj.x, W), ndc2Pix(p_proj.y, H) };
+	glm::uvec2 rect_min, rect_max;
+	getRect(point_image, my_radius, rect_min, rect_max, grid);
+	if ((rect_max.x - rect_min.x) * (rect_max.y - rect_min.y) == 0)
+		return;
+
+	// If colors have been precomputed, use them, otherwise convert
+	// spherical harmonics coefficients to RGB color.
+	if (D >= 0)
+	{
+		glm::vec3 result;
+		if (compressed.sh_index != nullptr)
+		{
+			CodebookSH sh;
+			decodeHalves(compressed.features_dc + 3 * idx, 3, &sh.dc.x);
+			sh.rest = (const glm::vec3*)compressed.sh_codebook + (size_t)compressed.sh_index[idx] * (M - 1);
+			result = computeColorFromSH<D>(idx, (const glm::vec3*)orig_points, *cam_pos, sh, clamped);
+		}
+		else
+			result = computeColorFromSH<D>(idx, (const glm::vec3*)orig_points, *cam_pos, (const glm::vec3*)shs + idx * M, clamped);
+		rgb[idx * NUM_CHANNELS + 0] = result.x;
+		rgb[idx * NUM_CHANNELS + 1] = result.y;
+		rgb[idx * NUM_CHANNELS + 2] = result.z;
+	}
+
+	// Store some useful helper data for the next steps.
+	depths[idx] = p_view.z;
+	radii[idx] = my_radius;
+	points_xy_image[idx] = point_image;
+	// Inverse 2D covariance and opacity neatly pack into one float4
+	const float opacity = (compressed.sh_index != nullptr ? halfToFloat(compressed.opacities[idx]) : opacities[idx]) * cov.w;
+	conic_opacity[idx] = { conic.x, conic.y, conic.z, opacity };
+
+	// Only tiles where the Gaussian can pass the alpha threshold are
+	// binned. This may be none: the radius stays set either way, as it
+	// also reports visibility to the densification statistics.
+	uint32_t touched = 0;
+	forEachOverlappedTile(point_image.x, point_image.y, conic.x, conic.y, conic.z, opacity,
+		rect_min.x, rect_min.y, rect_max.x, rect_max.y, [&](int, int) { touched++; });
+	tiles_touched[idx] = touched;
+}
+
+// Main rasterization method for one tile, or a band of its SIMD pixel
+// groups [group_begin, group_end) (see tile_scheduler.h). Mirrors
+// renderCUDA: the tile's Gaussians are traversed front to back once, and
+// each one is blended into all still-active pixels of the band, WIDTH
+// pixels per SIMD instruction. Pixel state lives in tile-local arrays. If
+// instance_contrib is not null, every instance of the tile gets its
+// contribution record (max weight, summed weight, pixels) in its
+// unsorted slot, as the instance gradients of the backward pass; the
+// band must then be the whole tile.
+template <uint32_t CHANNELS>
+static void renderTile(
+	const uint32_t tile_x, const uint32_t tile_y,
+	const int group_begin, const int group_end,
+	const TileGrid grid,
+	const glm::uvec2* __restrict__ ranges,
+	const uint32_t* __restrict__ point_list,
+	int W, int H,
+	const glm::vec2* __restrict__ subpixel_offset,
+	const glm::vec2* __restrict__ points_xy_image,
+	const float* __restrict__ features,
+	const glm::vec4* __restrict__ conic_opacity,
+	float* __restrict__ final_T,
+	uint32_t* __restrict__ n_contrib,
+	const float* __restrict__ bg_color,
+	float* __restrict__ out_color,
+	const uint32_t* __restrict__ point_list_origin,
+	float* __restrict__ instance_contrib)
+{
+	using namespace simd;
+	constexpr int GROUPS = BLOCK_SIZE / WIDTH;
+	static_assert(BLOCK_SIZE % WIDTH == 0, "Tile size must be a multiple of the SIMD width");
+
+	// Identify current tile and associated min/max pixel range.
+	const glm::uvec2 pix_min = { tile_x * BLOCK_X, tile_y * BLOCK_Y };
+
+	alignas(64) float pixf_x[BLOCK_SIZE];
+	alignas(64) float pixf_y[BLOCK_SIZE];
+	alignas(64) float T[BLOCK_SIZE];
+	alignas(64) float C[CHANNELS][BLOCK_SIZE];
+	alignas(64) int last_contributor[BLOCK_SIZE];
+	alignas(64) float inside[BLOCK_SIZE];
+
+	for (int i = group_begin * WIDTH; i < group_end * WIDTH; i++)
+	{
+		const uint32_t px = pix_min.x + i % BLOCK_X;
+		const uint32_t py = pix_min.y + i / BLOCK_X;
+		const bool in = px < (uint32_t)W && py < (uint32_t)H;
+		const uint32_t pix_id = W * py + px;
+
+		// add the offset to pixel
+		pixf_x[i] = (float)px + (in ? subpixel_offset[pix_id].x : 0.0f);
+		pixf_y[i] = (float)py + (in ? subpixel_offset[pix_id].y : 0.0f);
+		inside[i] = in ? 1.0f : 0.0f;
+		T[i] = 1.0f;
+		last_contributor[i] = 0;
+		for (uint32_t ch = 0; ch < CHANNELS; ch++)
+			C[ch][i] = 0.0f;
+	}
+
+	// Pixels outside of the image are never active.
+	vmask active[GROUPS];
+	for (int g = group_begin; g < group_end; g++)
+		active[g] = lt(set1(0.5f), load(inside + g * WIDTH));
+
+	const glm::uvec2 range = ranges[tile_y * grid.x + tile_x];
+	const vfloat one = set1(1.0f);
+	const vfloat max_alpha = set1(0.99f);
+	const vfloat min_alpha = set1(1.0f / 255.0f);
+	const vfloat min_T = set1(0.0001f);
+	const vfloat zero_v = zero();
+
+	// Iterate over Gaussians until all pixels are done or range is complete
+	uint32_t i = range.x;
+	for (; i < range.y; i++)
+	{
+		const int coll_id = point_list[i];
+		const glm::vec2 xy = points_xy_image[coll_id];
+		const glm::vec4 con_o = conic_opacity[coll_id];
+		const float* feat = features + coll_id * CHANNELS;
+		const vint contributor = set1i((int)(i - range.x + 1));
+
+		const vfloat xy_x = set1(xy.x), xy_y = set1(xy.y);
+		const vfloat con_a = set1(-0.5f * con_o.x), con_b = set1(-con_o.y), con_c = set1(-0.5f * con_o.z);
+		const vfloat opacity = set1(con_o.w);
+		vfloat weight_max = zero_v, weight_sum = zero_v, pixels = zero_v;
+
+		bool any_active = false;
+		for (int g = group_begin; g < group_end; g++)
+		{
+			vmask m = active[g];
+			if (!any(m))
+				continue;
+			any_active = true;
+
+			// Resample using conic matrix (cf. "Surface
+			// Splatting" by Zwicker et al., 2001)
+			const vfloat dx = sub(xy_x, load(pixf_x + g * WIDTH));
+			const vfloat dy = sub(xy_y, load(pixf_y + g * WIDTH));
+			const vfloat power = fmadd(con_a, mul(dx, dx), fmadd(con_c, mul(dy, dy), mul(con_b, mul(dx, dy))));
+			m = mask_and(m, le(power, zero_v));
+			if (!any(m))
+				continue;
+
+			// Eq. (2) from 3D Gaussian splatting paper.
+			const vfloat alpha = min(max_alpha, mul(opacity, exp(power)));
+			m = mask_and(m, ge(alpha, min_alpha));
+			if (!any(m))
+				continue;
+
+			const vfloat T_g = load(T + g * WIDTH);
+			const vfloat test_T = mul(T_g, sub(one, alpha));
+			const vmask finished = mask_and(m, lt(test_T, min_T));
+			active[g] = mask_andnot(active[g], finished);
+			m = mask_andnot(m, finished);
+			if (!any(m))
+				continue;
+
+			// Eq. (3) from 3D Gaussian splatting paper.
+			const vfloat weight = select(m, mul(alpha, T_g), zero_v);
+			for (uint32_t ch = 0; ch < CHANNELS; ch++)
+				store(C[ch] + g * WIDTH, fmadd(set1(feat[ch]), weight, load(C[ch] + g * WIDTH)));
+			if (instance_contrib != nullptr)
+			{
+				weight_max = max(weight_max, weight);
+				weight_sum = add(weight_sum, weight);
+				pixels = add(pixels, select(m, one, zero_v));
+			}
+
+			store(T + g * WIDTH, select(m, test_T, T_g));
+
+			// Keep track of last range entry to update this pixel.
+			storei(last_contributor + g * WIDTH, selecti(m, contributor, loadi(last_contributor + g * WIDTH)));
+		}
+
+		if (instance_contrib != nullptr)
+		{
+			float* record = instance_contrib + (size_t)point_list_origin[i] * 3;
+			record[0] = reduce_max(weight_max);
+			record[1] = reduce_add(weight_sum);
+			record[2] = reduce_add(pixels);
+		}
+
+		// End if entire tile is done rasterizing
+		if (!any_active)
+		{
+			i++;
+			break;
+		}
+	}
+
+	// Instances the tile never reached did not contribute
+	if (instance_contrib != nullptr)
+		for (; i < range.y; i++)
+			std::memset(instance_contrib + (size_t)point_list_origin[i] * 3, 0, 3 * sizeof(float));
+
+	// All valid pixels write out their final rendering data to the
+	// frame and auxiliary buffers.
+	for (int i = group_begin * WIDTH; i < group_end * WIDTH; i++)
+	{
+		if (inside[i] == 0.0f)
+			continue;
+		const uint32_t pix_id = W * (pix_min.y + i / BLOCK_X) + pix_min.x + i % BLOCK_X;
+		final_T[pix_id] = T[i];
+		n_contrib[pix_id] = last_contributor[i];
+		for (uint32_t ch = 0; ch < CHANNELS; ch++)
+			out_color[ch * H * W + pix_id] = C[ch][i] + T[i] * bg_color[ch];
+	}
+}
+
+// Bands a heavy tile is split into at most, and the fewest SIMD groups
+// of a band: every band walks the whole range of the tile
+constexpr int MAX_BANDS = 8;
+constexpr int MIN_BAND_GROUPS = 4;
+
+// Renders all tiles with C channels
+struct RenderTiles
+{
+	template<int C>
+	static void run(
+		const TileGrid grid,
+		const glm::uvec2* ranges,
+		const uint32_t* point_list,
+		int W, int H,
+		const glm::vec2* subpixel_offset,
+		const glm::vec2* means2D,
+		const float* colors,
+		const glm::vec4* conic_opacity,
+		float* final_T,
+		uint32_t* n_contrib,
+		const float* bg_color,
+		float* out_color,
+		RasterizerStats* stats,
+		const uint32_t* point_list_origin,
+		float* instance_contrib)
+	{
+		// Tile workloads are very uneven: heavy tiles are split into
+		// bands, and the threads steal each other's pending work. Bands
+		// of a tile would share its contribution records, so tiles stay
+		// whole when those are requested.
+		constexpr int GROUPS = BLOCK_SIZE / simd::WIDTH;
+		TileScheduler scheduler(ranges, grid.x * grid.y, GROUPS,
+			instance_contrib != nullptr ? 1 : std::min(MAX_BANDS, std::max(1, GROUPS / MIN_BAND_GROUPS)), maxThreads());
+		scheduler.run([&](const RenderItem& item) {
+			renderTile<C>(
+				item.tile % grid.x, item.tile / grid.x,
+				item.group_begin, item.group_end,
+				grid,
+				ranges,
+				point_list,
+				W, H,
+				subpixel_offset,
+				means2D,
+				colors,
+				conic_opacity,
+				final_T,
+				n_contrib,
+				bg_color,
+				out_color,
+				point_list_origin,
+				instance_contrib);
+		});
+
+		if (stats)
+		{
+			stats->render_items = scheduler.numItems();
+			stats->split_tiles = scheduler.splitTiles();
+			stats->stolen_items = scheduler.stolenItems();
+			stats->worker_imbalance = scheduler.workerImbalance();
+		}
+	}
+};
+
+// Preprocesses all Gaussians with SH degree D
+struct PreprocessGaussians
+{
+	template<int D>
+	static void run(int P, int M,
+		const float* means3D,
+		const glm::vec3* scales,
+		const float scale_modifier,
+		const glm::vec4* rotations,
+		const float* opacities,
+		const float* shs,
+		bool* clamped,
+		const float* cov3D_precomp,
+		const float* viewmatrix,
+		const float* projmatrix,
+		const glm::vec3* cam_pos,
+		const int W, int H,
+		const float focal_x, float focal_y,
+		const float tan_fovx, float tan_fovy,
+		const float kernel_size,
+		int* radii,
+		glm::vec2* means2D,
+		float* depths,
+		float* cov3Ds,
+		float* rgb,
+		glm::vec4* conic_opacity,
+		const TileGrid grid,
+		uint32_t* tiles_touched,
+		bool prefiltered,
+		const CompressedGaussians compressed)
+	{
+		bool filter_error = false;
+
+		#pragma omp parallel for schedule(static, 256)
+		for (int idx = 0; idx < P; idx++)
+		{
+			bool my_error = false;
+			preprocessGaussian<D>(
+				idx, M,
+				means3D,
+				scales,
+				scale_modifier,
+				rotations,
+				opacities,
+				shs,
+				clamped,
+				cov3D_precomp,
+				viewmatrix,
+				projmatrix,
+				cam_pos,
+				W, H,
+				tan_fovx, tan_fovy,
+				focal_x, focal_y,
+				kernel_size,
+				radii,
+				means2D,
+				depths,
+				cov3Ds,
+				rgb,
+				conic_opacity,
+				grid,
+				tiles_touched,
+				prefiltered,
+				compressed,
+				&my_error);
+			if (my_error)
+			{
+				#pragma omp atomic write
+				filter_error = true;
+			}
+		}
+
+		if (filter_error)
+			throw std::runtime_error("Point is filtered although prefiltered is set. This shouldn't happen!");
+	}
+};
+
+}
+
+void CpuRasterizer::FORWARD::render(
+	const TileGrid grid,
+	const glm::uvec2* ranges,
+	const uint32_t* point_list,
+	int W, int H,
+	const glm::vec2* subpixel_offset,
+	const glm::vec2* means2D,
+	const float* colors,
+	const int channels,
+	const glm::vec4* conic_opacity,
+	float* final_T,
+	uint32_t* n_contrib,
+	const float* bg_color,
+	float* out_color,
+	RasterizerStats* stats,
+	const uint32_t* point_list_origin,
+	float* instance_contrib)
+{
+	dispatchChannels<RenderTiles>(channels,
+		grid,
+		ranges,
+		point_list,
+		W, H,
+		subpixel_offset,
+		means2D,
+		colors,
+		conic_opacity,
+		final_T,
+		n_contrib,
+		bg_color,
+		out_color,
+		stats,
+		point_list_origin,
+		instance_contrib);
+}
+
+void CpuRasterizer::FORWARD::accumulateContributions(
+	int P,
+	const int* radii,
+	const uint32_t* point_offsets,
+	const float* instance_contrib,
+	const GaussianContributions& contributions)
+{
+	#pragma omp parallel for schedule(static, 256)
+	for (int idx = 0; idx < P; idx++)
+	{
+		if (!(radii[idx] > 0))
+			continue;
+
+		float weight_max = 0.0f, weight_sum = 0.0f, pixels = 0.0f;
+		const uint32_t begin = (idx == 0) ? 0 : point_offsets[idx - 1];
+		for (uint32_t slot = begin; slot < point_offsets[idx]; slot++)
+		{
+			const float* record = instance_contrib + (size_t)slot * 3;
+			weight_max = std::max(weight_max, record[0]);
+			weight_sum += record[1];
+			pixels += record[2];
+		}
+
+		contributions.max_weight[idx] = std::max(contributions.max_weight[idx], weight_max);
+		contributions.weight_sum[idx] += weight_sum;
+		contributions.pixels[idx] += pixels;
+	}
+}
+
+void CpuRasterizer::FORWARD::computeCov3D(int P,
+	const glm::vec3* scales,
+	const float scale_modifier,
+	const glm::vec4* rotations,
+	float* cov3Ds)
+{
+	#pragma omp parallel for schedule(static, 1024)
+	for (int idx = 0; idx < P; idx++)
+		CpuRasterizer::computeCov3D(scales[idx], scale_modifier, rotations[idx], cov3Ds + idx * 6);
+}
+
+void CpuRasterizer::FORWARD::preprocess(int P, int D, int M,
+	const float* means3D,
+	const glm::vec3* scales,
+	const float scale_modifier,
+	const glm::vec4* rotations,
+	const float* opacities,
+	const float* shs,
+	bool* clamped,
+	const float* cov3D_precomp,
+	const float* viewmatrix,
+	const float* projmatrix,
+	const glm::vec3* cam_pos,
+	const int W, int H,
+	const float focal_x, float focal_y,
+	const float tan_fovx, float tan_fovy,
+	const float kernel_size,
+	int* radii,
+	glm::vec2* means2D,
+	float* depths,
+	float* cov3Ds,
+	float* rgb,
+	glm::vec4* conic_opacity,
+	const TileGrid grid,
+	uint32_t* tiles_touched,
+	bool prefiltered,
+	const CompressedGaussians compressed)
+{
+	dispatchSHDegree<PreprocessGaussians>(D,
+		P, M,
+		means3D,
+		scales,
+		scale_modifier,
+		rotations,
+		opacities,
+		shs,
+		clamped,
+		cov3D_precomp,
+		viewmatrix,
+		projmatrix,
+		cam_pos,
+		W, H,
+		focal_x, focal_y,
+		tan_fovx, tan_fovy,
+		kernel_size,
+		radii,
+		means2D,
+		depths,
+		cov3Ds,
+		rgb,
+		conic_opacity,
+		grid,
+		tiles_touched,
+		prefiltered,
+		compressed);
+}
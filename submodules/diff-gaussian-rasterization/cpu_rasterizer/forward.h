@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_FORWARD_H_INCLUDED
+#define CPU_RASTERIZER_FORWARD_H_INCLUDED
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "auxiliary.h"
+#include "../cuda_rasterizer/contribution.h"
+#include "../cuda_rasterizer/compressed.h"
+#include "../cuda_rasterizer/stats.h"
+
+namespace CpuRasterizer
+{
+namespace FORWARD
+{
+	// Perform initial steps for each Gaussian prior to rasterization.
+	// D is the SH degree of the colors, -1 if they are precomputed.
+	// Attributes are decoded from compressed if its sh_index is set.
+	void preprocess(int P, int D, int M,
+		const float* orig_points,
+		const glm::vec3* scales,
+		const float scale_modifier,
+		const glm::vec4* rotations,
+		const float* opacities,
+		const float* shs,
+		bool* clamped,
+		const float* cov3D_precomp,
+		const float* viewmatrix,
+		const float* projmatrix,
+		const glm::vec3* cam_pos,
+		const int W, int H,
+		const float focal_x, float focal_y,
+		const float tan_fovx, float tan_fovy,
+		const float kernel_size,
+		int* radii,
+		glm::vec2* points_xy_image,
+		float* depths,
+		float* cov3Ds,
+		float* colors,
+		glm::vec4* conic_opacity,
+		const TileGrid grid,
+		uint32_t* tiles_touched,
+		bool prefiltered,
+		const CompressedGaussians compressed);
+
+	// Compute the 3D covariance of each Gaussian from scale and rotation.
+	void computeCov3D(int P,
+		const glm::vec3* scales,
+		const float scale_modifier,
+		const glm::vec4* rotations,
+		float* cov3Ds);
+
+	// Main rasterization method. Tiles, heavy ones split into bands,
+	// are distributed over all threads by a work-stealing schedule (see
+	// tile_scheduler.h), pixels of a tile are blended in SIMD lanes.
+	// features holds channels values per Gaussian. The schedule is
+	// summarized in stats if given. If instance_contrib is not
+	// null, it receives 3 floats per Gaussian/tile instance in the
+	// instance's unsorted slot (given by point_list_origin), see
+	// accumulateContributions.
+	void render(
+		const TileGrid grid,
+		const glm::uvec2* ranges,
+		const uint32_t* point_list,
+		int W, int H,
+		const glm::vec2* subpixel_offset,
+		const glm::vec2* points_xy_image,
+		const float* features,
+		const int channels,
+		const glm::vec4* conic_opacity,
+		float* final_T,
+		uint32_t* n_contrib,
+		const float* bg_color,
+		float* out_color,
+		RasterizerStats* stats = nullptr,
+		const uint32_t* point_list_origin = nullptr,
+		float* instance_contrib = nullptr);
+
+	// Adds the instance contribution records of the visible Gaussians
+	// to their statistics, see contribution.h. Slots of a Gaussian are
+	// contiguous, so no atomics are needed.
+	void accumulateContributions(
+		int P,
+		const int* radii,
+		const uint32_t* point_offsets,
+		const float* instance_contrib,
+		const GaussianContributions& contributions);
+}
+};
+
+#endif
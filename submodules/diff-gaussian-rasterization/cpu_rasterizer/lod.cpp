@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "lod.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <omp.h>
+
+namespace
+{
+	// Subtrees below this many leaves are built by the task that reaches them
+	constexpr int TASK_GRAIN = 1 << 14;
+
+	// Largest eigenvalue of a symmetric 3x3 matrix stored as
+	// (xx, xy, xz, yy, yz, zz), in closed form.
+	double maxEigenvalue(const double* c)
+	{
+		const double p1 = c[1] * c[1] + c[2] * c[2] + c[4] * c[4];
+		const double q = (c[0] + c[3] + c[5]) / 3.0;
+		const double a = c[0] - q, d = c[3] - q, f = c[5] - q;
+		const double p2 = a * a + d * d + f * f + 2.0 * p1;
+		if (p2 <= 0.0)
+			return q;
+		const double p = std::sqrt(p2 / 6.0);
+		const double det = a * (d * f - c[4] * c[4]) - c[1] * (c[1] * f - c[4] * c[2]) + c[2] * (c[1] * c[4] - d * c[2]);
+		const double r = std::min(1.0, std::max(-1.0, det / (2.0 * p * p * p)));
+		return q + 2.0 * p * std::cos(std::acos(r) / 3.0);
+	}
+
+	double determinant(const double* c)
+	{
+		return c[0] * (c[3] * c[5] - c[4] * c[4]) - c[1] * (c[1] * c[5] - c[4] * c[2]) + c[2] * (c[1] * c[4] - c[3] * c[2]);
+	}
+
+	// Footprint area of a Gaussian, up to a constant
+	double area(const double* c)
+	{
+		return std::cbrt(std::max(0.0, determinant(c)));
+	}
+
+	struct Builder
+	{
+		int P, F;
+		const float* means;
+		int* left;
+		int* right;
+		float* node_means;
+		float* node_cov3D;
+		float* node_opacities;
+		float* node_features;
+		float* node_size;
+		float* node_radius;
+		std::vector<int> order;
+		std::vector<double> weight;
+
+		// Builds the subtree over the leaves order[b, e). Its internal
+		// nodes are numbered in pre-order from o, so ids only depend on
+		// the split and subtrees can be built concurrently.
+		int buildRange(int b, int e, int o)
+		{
+			if (e - b == 1)
+				return order[b];
+
+			float lo[3] = { INFINITY, INFINITY, INFINITY };
+			float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+			for (int i = b; i < e; i++)
+			{
+				const float* p = means + 3 * order[i];
+				for (int k = 0; k < 3; k++)
+				{
+					lo[k] = std::min(lo[k], p[k]);
+					hi[k] = std::max(hi[k], p[k]);
+				}
+			}
+			int axis = 0;
+			for (int k = 1; k < 3; k++)
+				if (hi[k] - lo[k] > hi[axis] - lo[axis])
+					axis = k;
+
+			const int m = b + (e - b) / 2;
+			std::nth_element(order.begin() + b, order.begin() + m, order.begin() + e, [&](int i, int j) {
+				const float pi = means[3 * i + axis], pj = means[3 * j + axis];
+				return pi < pj || (pi == pj && i < j);
+			});
+
+			int l, r;
+			if (e - b > TASK_GRAIN)
+			{
+				#pragma omp task shared(l)
+				l = buildRange(b, m, o + 1);
+				r = buildRange(m, e, o + (m - b));
+				#pragma omp taskwait
+			}
+			else
+			{
+				l = buildRange(b, m, o + 1);
+				r = buildRange(m, e, o + (m - b));
+			}
+			merge(o, l, r);
+			return o;
+		}
+
+		// Moment matching: the parent has the mean and covariance of the
+		// weighted mixture of its children, their weighted mean features,
+		// and the opacity that conserves the total weight over its area.
+		void merge(int n, int l, int r)
+		{
+			const double W = weight[l] + weight[r];
+			const double wl = W > 0.0 ? weight[l] / W : 0.5;
+			const double wr = 1.0 - wl;
+
+			double mu[3], dl[3], dr[3];
+			for (int k = 0; k < 3; k++)
+			{
+				mu[k] = wl * node_means[3 * l + k] + wr * node_means[3 * r + k];
+				dl[k] = node_means[3 * l + k] - mu[k];
+				dr[k] = node_means[3 * r + k] - mu[k];
+			}
+
+			static const int row[6] = { 0, 0, 0, 1, 1, 2 };
+			static const int col[6] = { 0, 1, 2, 1, 2, 2 };
+			double cov[6];
+			for (int k = 0; k < 6; k++)
+			{
+				cov[k] = wl * (node_cov3D[6 * l + k] + dl[row[k]] * dl[col[k]]) +
+					wr * (node_cov3D[6 * r + k] + dr[row[k]] * dr[col[k]]);
+				node_cov3D[6 * n + k] = (float)cov[k];
+			}
+			for (int k = 0; k < 3; k++)
+				node_means[3 * n + k] = (float)mu[k];
+			for (int k = 0; k < F; k++)
+				node_features[(size_t)F * n + k] = (float)(wl * node_features[(size_t)F * l + k] + wr * node_features[(size_t)F * r + k]);
+
+			const double a = area(cov);
+			node_opacities[n] = a > 0.0 ? (float)std::min(1.0, W / a) : std::max(node_opacities[l], node_opacities[r]);
+			weight[n] = W;
+
+			const double len_l = std::sqrt(dl[0] * dl[0] + dl[1] * dl[1] + dl[2] * dl[2]);
+			const double len_r = std::sqrt(dr[0] * dr[0] + dr[1] * dr[1] + dr[2] * dr[2]);
+			node_size[n] = std::max({ (float)std::sqrt(std::max(0.0, maxEigenvalue(cov))), node_size[l], node_size[r] });
+			node_radius[n] = (float)std::max(len_l + node_radius[l], len_r + node_radius[r]);
+			left[n] = l;
+			right[n] = r;
+		}
+	};
+}
+
+void LOD::build(int P, int F,
+	const float* means,
+	const float* cov3D,
+	const float* opacities,
+	const float* features,
+	int* left,
+	int* right,
+	float* node_means,
+	float* node_cov3D,
+	float* node_opacities,
+	float* node_features,
+	float* node_size,
+	float* node_radius)
+{
+	if (P <= 0)
+		return;
+
+	Builder builder{ P, F, means, left, right, node_means, node_cov3D, node_opacities, node_features, node_size, node_radius,
+		std::vector<int>(P), std::vector<double>(numNodes(P)) };
+	std::iota(builder.order.begin(), builder.order.end(), 0);
+
+	// Leaves are copies of the input Gaussians
+	std::copy(means, means + 3 * (size_t)P, node_means);
+	std::copy(cov3D, cov3D + 6 * (size_t)P, node_cov3D);
+	std::copy(opacities, opacities + P, node_opacities);
+	std::copy(features, features + (size_t)F * P, node_features);
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < P; i++)
+	{
+		double c[6];
+		for (int k = 0; k < 6; k++)
+			c[k] = cov3D[6 * i + k];
+		const float sigma = (float)std::sqrt(std::max(0.0, maxEigenvalue(c)));
+		node_size[i] = sigma;
+		node_radius[i] = 3.0f * sigma;
+		builder.weight[i] = opacities[i] * area(c);
+		left[i] = -1;
+		right[i] = -1;
+	}
+
+	#pragma omp parallel
+	#pragma omp single
+	builder.buildRange(0, P, P);
+}
+
+void LOD::selectCut(int P,
+	const int* left,
+	const int* right,
+	const float* node_means,
+	const float* node_size,
+	const float* node_radius,
+	const float* campos,
+	float focal,
+	float target_size,
+	std::vector<int>& cut)
+{
+	cut.clear();
+	if (P <= 0)
+		return;
+
+	std::vector<int> stack = { root(P) };
+	while (!stack.empty())
+	{
+		const int n = stack.back();
+		stack.pop_back();
+		if (left[n] < 0)
+		{
+			cut.push_back(n);
+			continue;
+		}
+
+		const float dx = node_means[3 * n] - campos[0];
+		const float dy = node_means[3 * n + 1] - campos[1];
+		const float dz = node_means[3 * n + 2] - campos[2];
+		const float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - node_radius[n];
+		if (distance > 0.0f && node_size[n] * focal <= target_size * distance)
+		{
+			cut.push_back(n);
+			continue;
+		}
+		stack.push_back(right[n]);
+		stack.push_back(left[n]);
+	}
+}
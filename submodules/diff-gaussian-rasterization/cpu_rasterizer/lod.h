@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_LOD_H_INCLUDED
+#define CPU_RASTERIZER_LOD_H_INCLUDED
+
+#include <vector>
+
+// Level-of-detail hierarchy over a set of Gaussians. The tree is binary
+// with 2P - 1 nodes: nodes [0, P) are the input Gaussians themselves
+// (leaves, in input order), nodes [P, 2P - 1) are merged Gaussians with
+// the root at P. Every node carries a full Gaussian (mean, 3D covariance
+// in the rasterizer's 6-float layout, opacity and F feature floats), so
+// any cut through the tree can be rasterized like a regular model.
+//
+// The inputs should already include the mip-splatting 3D filter (scales
+// and opacities "with_3D_filter"): it is what makes a leaf the smallest
+// meaningful footprint of its Gaussian, and merged nodes inherit it.
+namespace LOD
+{
+	inline int numNodes(int P) { return P > 0 ? 2 * P - 1 : 0; }
+	inline int root(int P) { return P > 1 ? P : 0; }
+
+	// Builds the tree top-down by median splits along the longest axis
+	// of the means' bounding box; parents are moment-matched mixtures of
+	// their children, weighted by opacity times footprint area. Output
+	// arrays hold numNodes(P) entries; left/right are -1 for leaves.
+	// node_size is the largest standard deviation of the node's own
+	// Gaussian (at least that of its children) and node_radius bounds
+	// the 3 sigma extent of its whole subtree around node_means.
+	void build(int P, int F,
+		const float* means,
+		const float* cov3D,
+		const float* opacities,
+		const float* features,
+		int* left,
+		int* right,
+		float* node_means,
+		float* node_cov3D,
+		float* node_opacities,
+		float* node_features,
+		float* node_size,
+		float* node_radius);
+
+	// Selects the cut for one camera: descending from the root, a node
+	// is taken as soon as its size, projected at the nearest distance of
+	// its subtree's bounding sphere, is at most target_size pixels.
+	// Leaves are always taken. focal is the focal length in pixels.
+	void selectCut(int P,
+		const int* left,
+		const int* right,
+		const float* node_means,
+		const float* node_size,
+		const float* node_radius,
+		const float* campos,
+		float focal,
+		float target_size,
+		std::vector<int>& cut);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_H_INCLUDED
+#define CPU_RASTERIZER_H_INCLUDED
+
+#include <vector>
+#include <functional>
+#include "../cuda_rasterizer/stats.h"
+#include "../cuda_rasterizer/contribution.h"
+#include "../cuda_rasterizer/coherent_sort.h"
+#include "../cuda_rasterizer/compressed.h"
+
+// Host implementation of the rasterizer. The interface is identical to
+// CudaRasterizer::Rasterizer, all pointers refer to host memory.
+namespace CpuRasterizer
+{
+	class Rasterizer
+	{
+	public:
+
+		static void markVisible(
+			int P,
+			float* means3D,
+			float* viewmatrix,
+			float* projmatrix,
+			bool* present);
+
+		// View-independent part of preprocessing: 3D covariances from
+		// scales and rotations, e.g., to be shared by several views.
+		static void computeCov3D(
+			int P,
+			const float* scales,
+			const float scale_modifier,
+			const float* rotations,
+			float* cov3Ds);
+
+		// Minimum depth of every point over all cameras that see it (see
+		// filter3d.h for the camera layout) for the mip-splatting 3D filter.
+		// Points that no camera sees get FILTER3D_MAX_DISTANCE and
+		// valid = false.
+		static void computeFilter3D(
+			int P, int C,
+			const float* means3D,
+			const float* cameras,
+			float* distance,
+			bool* valid);
+
+		static int forward(
+			std::function<char* (size_t)> geometryBuffer,
+			std::function<char* (size_t)> binningBuffer,
+			std::function<char* (size_t)> imageBuffer,
+			const int P, int D, int M,
+			const int channels,
+			const float* background,
+			const int width, int height,
+			const float* means3D,
+			const float* shs,
+			const float* colors_precomp,
+			const float* opacities,
+			const float* scales,
+			const float scale_modifier,
+			const float* rotations,
+			const float* cov3D_precomp,
+			const float* viewmatrix,
+			const float* projmatrix,
+			const float* cam_pos,
+			const float tan_fovx, float tan_fovy,
+			const float kernel_size,
+			const float* subpixel_offset,
+			const bool prefiltered,
+			float* out_color,
+			int* radii = nullptr,
+			bool debug = false,
+			RasterizerStats* stats = nullptr,
+			GaussianContributions* contributions = nullptr,
+			CoherentSort* coherent = nullptr,
+			const CompressedGaussians* compressed = nullptr);
+
+		static void backward(
+			const int P, int D, int M, int R,
+			const int channels,
+			const float* background,
+			const int width, int height,
+			const float* means3D,
+			const float* shs,
+			const float* colors_precomp,
+			const float* scales,
+			const float scale_modifier,
+			const float* rotations,
+			const float* cov3D_precomp,
+			const float* viewmatrix,
+			const float* projmatrix,
+			const float* campos,
+			const float tan_fovx, float tan_fovy,
+			const float kernel_size,
+			const float* subpixel_offset,
+			const int* radii,
+			char* geom_buffer,
+			char* binning_buffer,
+			char* image_buffer,
+			const float* dL_dpix,
+			float* dL_dmean2D,
+			float* dL_dconic,
+			float* dL_dopacity,
+			float* dL_dcolor,
+			float* dL_dmean3D,
+			float* dL_dcov3D,
+			float* dL_dsh,
+			float* dL_dscale,
+			float* dL_drot,
+			bool debug,
+			std::function<char* (size_t)> scratchBuffer = nullptr,
+			RasterizerStats* stats = nullptr);
+	};
+};
+
+#endif
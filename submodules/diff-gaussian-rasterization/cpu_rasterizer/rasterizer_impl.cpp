@@ -0,0 +1,916 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "rasterizer_impl.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <stdexcept>
+#include <glm/glm.hpp>
+
+#include "auxiliary.h"
+#include "../cuda_rasterizer/filter3d.h"
+#include "../cuda_rasterizer/tile_overlap.h"
+#include "../cuda_rasterizer/dispatch.h"
+#include "../cuda_rasterizer/coherent_sort.h"
+#include "forward.h"
+#include "backward.h"
+
+namespace CpuRasterizer
+{
+
+// Helper function to find the next-highest bit of the MSB
+// on the CPU.
+static uint32_t getHigherMsb(uint32_t n)
+{
+	uint32_t msb = sizeof(n) * 4;
+	uint32_t step = msb;
+	while (step > 1)
+	{
+		step /= 2;
+		if (n >> msb)
+			msb += step;
+		else
+			msb -= step;
+	}
+	if (n >> msb)
+		msb++;
+	return msb;
+}
+
+// Host replacement for cub::DeviceScan::InclusiveSum. Each thread scans
+// one contiguous chunk, then adds the total of all preceding chunks.
+static void inclusiveSum(const uint32_t* in, uint32_t* out, int n)
+{
+	const int max_chunks = maxThreads();
+	std::vector<uint32_t> partial(max_chunks + 1, 0);
+
+	#pragma omp parallel num_threads(max_chunks)
+	{
+		const int chunks = std::max(1, std::min(max_chunks, (n + 4095) / 4096));
+		const int c = threadIndex();
+		const int begin = (int)((int64_t)n * c / chunks);
+		const int end = (int)((int64_t)n * (c + 1) / chunks);
+
+		uint32_t sum = 0;
+		if (c < chunks)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				sum += in[i];
+				out[i] = sum;
+			}
+			partial[c + 1] = sum;
+		}
+
+		#pragma omp barrier
+		#pragma omp single
+		for (int i = 1; i <= chunks; i++)
+			partial[i] += partial[i - 1];
+
+		if (c < chunks && c > 0)
+		{
+			const uint32_t offset = partial[c];
+			for (int i = begin; i < end; i++)
+				out[i] += offset;
+		}
+	}
+}
+
+// Host replacement for cub::DeviceRadixSort::SortPairs. Stable LSD radix
+// sort over the bits [begin_bit, end_bit) with 8-bit digits. Every pass
+// builds per-chunk histograms in parallel and scatters in chunk order,
+// which keeps the sort stable and independent of the thread count.
+// Passes in which all keys share the same digit are skipped.
+static void sortPairs(
+	uint64_t* keys_in, uint64_t* keys_out,
+	uint32_t* values_in, uint32_t* values_out,
+	int n, int end_bit, int begin_bit = 0)
+{
+	const int RADIX = 256;
+	const int passes = (end_bit - begin_bit + 7) / 8;
+	const int chunks = std::max(1, std::min(maxThreads(), (n + 65535) / 65536));
+	std::vector<uint32_t> histograms(chunks * RADIX);
+
+	uint64_t* keys_src = keys_in;
+	uint64_t* keys_dst = keys_out;
+	uint32_t* values_src = values_in;
+	uint32_t* values_dst = values_out;
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+		const int shift = begin_bit + pass * 8;
+		std::fill(histograms.begin(), histograms.end(), 0);
+
+		#pragma omp parallel for schedule(static, 1)
+		for (int c = 0; c < chunks; c++)
+		{
+			uint32_t* hist = histograms.data() + c * RADIX;
+			const int begin = (int)((int64_t)n * c / chunks);
+			const int end = (int)((int64_t)n * (c + 1) / chunks);
+			for (int i = begin; i < end; i++)
+				hist[(keys_src[i] >> shift) & 0xFF]++;
+		}
+
+		// Digit-major, chunk-minor exclusive offsets.
+		uint32_t sum = 0;
+		bool uniform = false;
+		for (int d = 0; d < RADIX; d++)
+		{
+			uint32_t digit_total = 0;
+			for (int c = 0; c < chunks; c++)
+			{
+				uint32_t count = histograms[c * RADIX + d];
+				histograms[c * RADIX + d] = sum;
+				sum += count;
+				digit_total += count;
+			}
+			if (digit_total == (uint32_t)n)
+				uniform = true;
+		}
+		if (uniform)
+			continue;
+
+		#pragma omp parallel for schedule(static, 1)
+		for (int c = 0; c < chunks; c++)
+		{
+			uint32_t* offsets = histograms.data() + c * RADIX;
+			const int begin = (int)((int64_t)n * c / chunks);
+			const int end = (int)((int64_t)n * (c + 1) / chunks);
+			for (int i = begin; i < end; i++)
+			{
+				const uint32_t pos = offsets[(keys_src[i] >> shift) & 0xFF]++;
+				keys_dst[pos] = keys_src[i];
+				values_dst[pos] = values_src[i];
+			}
+		}
+
+		std::swap(keys_src, keys_dst);
+		std::swap(values_src, values_dst);
+	}
+
+	if (keys_src != keys_out)
+	{
+		std::memcpy(keys_out, keys_src, n * sizeof(uint64_t));
+		std::memcpy(values_out, values_src, n * sizeof(uint32_t));
+	}
+}
+
+// Generates one key/value pair for all Gaussian / tile overlaps.
+// Run once per Gaussian (1:N mapping).
+static void duplicateWithKeys(
+	int P,
+	const glm::vec2* points_xy,
+	const float* depths,
+	const glm::vec4* conic_opacity,
+	const uint32_t* offsets,
+	uint64_t* gaussian_keys_unsorted,
+	uint32_t* gaussian_values_unsorted,
+	const int* radii,
+	const TileGrid grid)
+{
+	#pragma omp parallel for schedule(static, 256)
+	for (int idx = 0; idx < P; idx++)
+	{
+		// Generate no key/value pair for invisible Gaussians
+		if (radii[idx] <= 0)
+			continue;
+
+		// Find this Gaussian's offset in buffer for writing keys/values.
+		uint32_t off = (idx == 0) ? 0 : offsets[idx - 1];
+		const uint32_t end = offsets[idx];
+		glm::uvec2 rect_min, rect_max;
+
+		getRect(points_xy[idx], radii[idx], rect_min, rect_max, grid);
+
+		// For each tile the Gaussian was counted in by preprocess, emit a
+		// key/value pair. The key is |  tile ID  |      depth      |,
+		// and the value is the slot itself. Sorting slots instead of
+		// Gaussian IDs lets the backward pass address every instance;
+		// IDs are resolved from the slots after sorting.
+		uint32_t depth_bits;
+		std::memcpy(&depth_bits, &depths[idx], sizeof(uint32_t));
+		const glm::vec4 con_o = conic_opacity[idx];
+		forEachOverlappedTile(points_xy[idx].x, points_xy[idx].y, con_o.x, con_o.y, con_o.z, con_o.w,
+			rect_min.x, rect_min.y, rect_max.x, rect_max.y, [&](int x, int y)
+		{
+			// Never write past the slots preprocess counted
+			if (off == end)
+				return;
+			uint64_t key = (uint32_t)y * grid.x + (uint32_t)x;
+			key <<= 32;
+			key |= depth_bits;
+			gaussian_keys_unsorted[off] = key;
+			gaussian_values_unsorted[off] = off;
+			off++;
+		});
+
+		// Slots of tiles that preprocess counted but were not emitted
+		// again get a key past the last tile: they sort behind all
+		// ranges and are never rendered
+		for (; off < end; off++)
+		{
+			gaussian_keys_unsorted[off] = ((uint64_t)grid.x * grid.y << 32) | depth_bits;
+			gaussian_values_unsorted[off] = off;
+		}
+	}
+}
+
+// Map every sorted slot back to the Gaussian that emitted it. Slots of
+// Gaussian idx are [offsets[idx - 1], offsets[idx]).
+static void resolveGaussianIDs(int L, int P, const uint32_t* offsets, const uint32_t* point_list_origin, uint32_t* point_list)
+{
+	#pragma omp parallel for schedule(static, 4096)
+	for (int idx = 0; idx < L; idx++)
+		point_list[idx] = std::upper_bound(offsets, offsets + P, point_list_origin[idx]) - offsets;
+}
+
+// Keys | depth | id | of all Gaussians in the order given by ids, or in
+// index order without one. Visible Gaussians use the depths of
+// preprocess, so that they are ordered exactly as by the full sort.
+static void computeDepthKeys(
+	int P,
+	const uint32_t* ids,
+	const float* means3D,
+	const float* viewmatrix,
+	const float* depths,
+	const int* radii,
+	uint64_t* keys)
+{
+	#pragma omp parallel for schedule(static, 4096)
+	for (int k = 0; k < P; k++)
+	{
+		const uint32_t id = ids != nullptr ? ids[k] : k;
+		const float depth = radii[id] > 0 ? depths[id] : viewDepth(means3D + 3 * id, viewmatrix);
+		keys[k] = depthKey(depth, id);
+	}
+}
+
+// Restores the order of nearly sorted keys. Every chunk is insertion
+// sorted in parallel, then the chunk boundaries are merged in turn, each
+// within the window of keys that are out of place across it. Gives up
+// (returning false, with the keys permuted) once the moves exceed
+// COHERENT_MAX_MOVES per key.
+static bool repairDepthOrder(int P, uint64_t* keys)
+{
+	const int chunks = std::max(1, std::min(maxThreads(), (P + 65535) / 65536));
+	bool repaired = true;
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < chunks; c++)
+	{
+		const int begin = (int)((int64_t)P * c / chunks);
+		const int end = (int)((int64_t)P * (c + 1) / chunks);
+		const int64_t budget = (int64_t)COHERENT_MAX_MOVES * (end - begin);
+		int64_t moves = 0;
+		for (int i = begin + 1; i < end && moves <= budget; i++)
+		{
+			const uint64_t key = keys[i];
+			int j = i;
+			for (; j > begin && keys[j - 1] > key; j--)
+				keys[j] = keys[j - 1];
+			keys[j] = key;
+			moves += i - j;
+		}
+		if (moves > budget)
+		{
+			#pragma omp atomic write
+			repaired = false;
+		}
+	}
+	if (!repaired)
+		return false;
+
+	const int64_t budget = (int64_t)COHERENT_MAX_MOVES * P;
+	int64_t moves = 0;
+	for (int c = 1; c < chunks; c++)
+	{
+		uint64_t* mid = keys + (int64_t)P * c / chunks;
+		uint64_t* end = keys + (int64_t)P * (c + 1) / chunks;
+		if (mid[-1] <= mid[0])
+			continue;
+		uint64_t* first = std::upper_bound(keys, mid, mid[0]);
+		uint64_t* last = std::lower_bound(mid, end, mid[-1]);
+		moves += last - first;
+		if (moves > budget)
+			return false;
+		std::inplace_merge(first, mid, last);
+	}
+	return true;
+}
+
+// Depth order of the Gaussians (their ids from near to far) in the order
+// memory of coherent: the stored order of the previous frame repaired
+// if the frames are coherent, sorted from scratch otherwise.
+static const uint32_t* depthOrder(
+	int P,
+	const float* means3D,
+	const float* viewmatrix,
+	const float* depths,
+	const int* radii,
+	CoherentSort& coherent)
+{
+	uint32_t* order = (uint32_t*)coherent.orderBuffer(P * sizeof(uint32_t));
+	std::vector<uint64_t> keys(P);
+
+	bool full_sort = true;
+	if (coherent.coherentWith(P, viewmatrix, (const char*)order))
+	{
+		computeDepthKeys(P, order, means3D, viewmatrix, depths, radii, keys.data());
+		full_sort = !repairDepthOrder(P, keys.data());
+	}
+	if (full_sort)
+	{
+		// Keys are in index order, so the stable sort by depth alone
+		// breaks ties by index as well
+		computeDepthKeys(P, nullptr, means3D, viewmatrix, depths, radii, keys.data());
+		std::vector<uint64_t> keys_sorted(P);
+		std::vector<uint32_t> ids(P);
+		std::iota(ids.begin(), ids.end(), 0u);
+		sortPairs(keys.data(), keys_sorted.data(), ids.data(), order, P, 64, 32);
+	}
+	else
+	{
+		#pragma omp parallel for schedule(static, 4096)
+		for (int k = 0; k < P; k++)
+			order[k] = (uint32_t)keys[k];
+	}
+
+	coherent.remember(P, viewmatrix, (const char*)order, full_sort);
+	return order;
+}
+
+// Replaces the sort of all instances when the Gaussians are already in
+// depth order: the instances are visited in that order and bucketed by
+// tile with a stable counting sort, so that every tile lists its
+// Gaussians by depth. The output is that of sortPairs and
+// resolveGaussianIDs, including the unplaced instances of
+// duplicateWithKeys (tile num_tiles) at the end.
+static void bucketByTile(
+	int P,
+	int num_tiles,
+	const uint32_t* order,
+	const int* radii,
+	const uint32_t* offsets,
+	const uint64_t* keys_unsorted,
+	uint64_t* point_list_keys,
+	uint32_t* point_list_origin,
+	uint32_t* point_list)
+{
+	const int chunks = std::max(1, std::min(maxThreads(), (P + 65535) / 65536));
+	const int buckets = num_tiles + 1;
+	std::vector<uint32_t> counts((size_t)chunks * buckets, 0);
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < chunks; c++)
+	{
+		uint32_t* count = counts.data() + (size_t)c * buckets;
+		const int begin = (int)((int64_t)P * c / chunks);
+		const int end = (int)((int64_t)P * (c + 1) / chunks);
+		for (int k = begin; k < end; k++)
+		{
+			const uint32_t idx = order[k];
+			if (radii[idx] <= 0)
+				continue;
+			for (uint32_t s = idx == 0 ? 0 : offsets[idx - 1]; s < offsets[idx]; s++)
+				count[keys_unsorted[s] >> 32]++;
+		}
+	}
+
+	// Tile-major, chunk-minor exclusive offsets
+	uint32_t sum = 0;
+	for (int t = 0; t < buckets; t++)
+		for (int c = 0; c < chunks; c++)
+		{
+			uint32_t& count = counts[(size_t)c * buckets + t];
+			const uint32_t n = count;
+			count = sum;
+			sum += n;
+		}
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < chunks; c++)
+	{
+		uint32_t* next = counts.data() + (size_t)c * buckets;
+		const int begin = (int)((int64_t)P * c / chunks);
+		const int end = (int)((int64_t)P * (c + 1) / chunks);
+		for (int k = begin; k < end; k++)
+		{
+			const uint32_t idx = order[k];
+			if (radii[idx] <= 0)
+				continue;
+			for (uint32_t s = idx == 0 ? 0 : offsets[idx - 1]; s < offsets[idx]; s++)
+			{
+				const uint32_t pos = next[keys_unsorted[s] >> 32]++;
+				point_list_keys[pos] = keys_unsorted[s];
+				point_list_origin[pos] = s;
+				point_list[pos] = idx;
+			}
+		}
+	}
+}
+
+// Check keys to see if it is at the start/end of one tile's range in
+// the full sorted list. If yes, write start/end of this tile. Unplaced
+// instances (tile num_tiles, see duplicateWithKeys) get no range.
+static void identifyTileRanges(int L, uint32_t num_tiles, const uint64_t* point_list_keys, glm::uvec2* ranges)
+{
+	#pragma omp parallel for schedule(static, 4096)
+	for (int idx = 0; idx < L; idx++)
+	{
+		// Read tile ID from key. Update start/end of tile range if at limit.
+		uint64_t key = point_list_keys[idx];
+		uint32_t currtile = key >> 32;
+		if (idx == 0)
+		{
+			if (currtile < num_tiles)
+				ranges[currtile].x = 0;
+		}
+		else
+		{
+			uint32_t prevtile = point_list_keys[idx - 1] >> 32;
+			if (currtile != prevtile)
+			{
+				ranges[prevtile].y = idx;
+				if (currtile < num_tiles)
+					ranges[currtile].x = idx;
+			}
+		}
+		if (idx == L - 1 && currtile < num_tiles)
+			ranges[currtile].y = L;
+	}
+}
+
+// Clears the gradient records of the unplaced instances, which sort
+// last and are not covered by any tile range, so that reduce sums zeros
+// for them instead of what the scratch buffer held.
+static void clearUnplacedRecords(int R, uint32_t num_tiles, const uint64_t* point_list_keys, const uint32_t* point_list_origin, size_t record_size, float* instance_grads)
+{
+	for (int idx = R - 1; idx >= 0 && (point_list_keys[idx] >> 32) >= num_tiles; idx--)
+		std::memset(instance_grads + (size_t)point_list_origin[idx] * record_size, 0, record_size * sizeof(float));
+}
+
+}
+
+// Mark all Gaussians that pass the coarse frustum containment test.
+void CpuRasterizer::Rasterizer::markVisible(
+	int P,
+	float* means3D,
+	float* viewmatrix,
+	float* projmatrix,
+	bool* present)
+{
+	#pragma omp parallel for schedule(static, 1024)
+	for (int idx = 0; idx < P; idx++)
+	{
+		glm::vec3 p_view;
+		present[idx] = in_frustum(idx, means3D, viewmatrix, projmatrix, false, p_view);
+	}
+}
+
+void CpuRasterizer::Rasterizer::computeFilter3D(
+	int P, int C,
+	const float* means3D,
+	const float* cameras,
+	float* distance,
+	bool* valid)
+{
+	// Blocks of points are tested against one camera at a time, which
+	// vectorizes over the points of the block.
+	constexpr int BLOCK = 64;
+	#pragma omp parallel for schedule(static)
+	for (int first = 0; first < P; first += BLOCK)
+	{
+		const int n = std::min(BLOCK, P - first);
+		float px[BLOCK], py[BLOCK], pz[BLOCK], d[BLOCK];
+		int seen[BLOCK];
+		for (int i = 0; i < n; i++)
+		{
+			px[i] = means3D[3 * (first + i)];
+			py[i] = means3D[3 * (first + i) + 1];
+			pz[i] = means3D[3 * (first + i) + 2];
+			d[i] = FILTER3D_MAX_DISTANCE;
+			seen[i] = 0;
+		}
+
+		for (int c = 0; c < C; c++)
+		{
+			const float* cam = cameras + c * FILTER3D_CAMERA_STRIDE;
+			#pragma omp simd
+			for (int i = 0; i < n; i++)
+			{
+				const float z = filter3DDepth(px[i], py[i], pz[i], cam);
+				d[i] = z > 0.0f ? std::min(d[i], z) : d[i];
+				seen[i] |= z > 0.0f;
+			}
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			distance[first + i] = d[i];
+			valid[first + i] = seen[i] != 0;
+		}
+	}
+}
+
+// Compute 3D covariances once for all Gaussians
+void CpuRasterizer::Rasterizer::computeCov3D(
+	int P,
+	const float* scales,
+	const float scale_modifier,
+	const float* rotations,
+	float* cov3Ds)
+{
+	FORWARD::computeCov3D(P,
+		(glm::vec3*)scales,
+		scale_modifier,
+		(glm::vec4*)rotations,
+		cov3Ds);
+}
+
+CpuRasterizer::GeometryState CpuRasterizer::GeometryState::fromChunk(char*& chunk, size_t P)
+{
+	GeometryState geom;
+	obtain(chunk, geom.depths, P, 128);
+	obtain(chunk, geom.clamped, P * 3, 128);
+	obtain(chunk, geom.internal_radii, P, 128);
+	obtain(chunk, geom.means2D, P, 128);
+	obtain(chunk, geom.cov3D, P * 6, 128);
+	obtain(chunk, geom.conic_opacity, P, 128);
+	obtain(chunk, geom.rgb, P * 3, 128);
+	obtain(chunk, geom.tiles_touched, P, 128);
+	obtain(chunk, geom.point_offsets, P, 128);
+	return geom;
+}
+
+CpuRasterizer::ImageState CpuRasterizer::ImageState::fromChunk(char*& chunk, size_t N)
+{
+	ImageState img;
+	obtain(chunk, img.accum_alpha, N, 128);
+	obtain(chunk, img.n_contrib, N, 128);
+	obtain(chunk, img.ranges, N, 128);
+	return img;
+}
+
+CpuRasterizer::BinningState CpuRasterizer::BinningState::fromChunk(char*& chunk, size_t P)
+{
+	BinningState binning;
+	obtain(chunk, binning.point_list, P, 128);
+	obtain(chunk, binning.point_list_unsorted, P, 128);
+	obtain(chunk, binning.point_list_keys, P, 128);
+	obtain(chunk, binning.point_list_keys_unsorted, P, 128);
+	obtain(chunk, binning.point_list_origin, P, 128);
+	return binning;
+}
+
+// Forward rendering procedure for differentiable rasterization
+// of Gaussians on the host.
+int CpuRasterizer::Rasterizer::forward(
+	std::function<char* (size_t)> geometryBuffer,
+	std::function<char* (size_t)> binningBuffer,
+	std::function<char* (size_t)> imageBuffer,
+	const int P, int D, int M,
+	const int channels,
+	const float* background,
+	const int width, int height,
+	const float* means3D,
+	const float* shs,
+	const float* colors_precomp,
+	const float* opacities,
+	const float* scales,
+	const float scale_modifier,
+	const float* rotations,
+	const float* cov3D_precomp,
+	const float* viewmatrix,
+	const float* projmatrix,
+	const float* cam_pos,
+	const float tan_fovx, float tan_fovy,
+	const float kernel_size,
+	const float* subpixel_offset,
+	const bool prefiltered,
+	float* out_color,
+	int* radii,
+	bool /* debug */,
+	RasterizerStats* stats,
+	GaussianContributions* contributions,
+	CoherentSort* coherent,
+	const CompressedGaussians* compressed)
+{
+	StageTimer timer;
+	const float focal_y = height / (2.0f * tan_fovy);
+	const float focal_x = width / (2.0f * tan_fovx);
+
+	size_t chunk_size = required<GeometryState>(P);
+	char* chunkptr = geometryBuffer(chunk_size);
+	GeometryState geomState = GeometryState::fromChunk(chunkptr, P);
+
+	if (radii == nullptr)
+	{
+		radii = geomState.internal_radii;
+	}
+
+	const TileGrid tile_grid = { (uint32_t)(width + BLOCK_X - 1) / BLOCK_X, (uint32_t)(height + BLOCK_Y - 1) / BLOCK_Y };
+
+	// Dynamically resize image-based auxiliary buffers during training
+	size_t img_chunk_size = required<ImageState>(width * height);
+	char* img_chunkptr = imageBuffer(img_chunk_size);
+	ImageState imgState = ImageState::fromChunk(img_chunkptr, width * height);
+
+	if (channels != NUM_CHANNELS && colors_precomp == nullptr)
+	{
+		throw std::runtime_error("For non-RGB, provide precomputed Gaussian colors!");
+	}
+	const int sh_degree = shDegree(D, colors_precomp);
+
+	// Run preprocessing per-Gaussian (transformation, bounding, conversion of SHs to RGB)
+	FORWARD::preprocess(
+		P, sh_degree, M,
+		means3D,
+		(glm::vec3*)scales,
+		scale_modifier,
+		(glm::vec4*)rotations,
+		opacities,
+		shs,
+		geomState.clamped,
+		cov3D_precomp,
+		viewmatrix, projmatrix,
+		(glm::vec3*)cam_pos,
+		width, height,
+		focal_x, focal_y,
+		tan_fovx, tan_fovy,
+		kernel_size,
+		radii,
+		geomState.means2D,
+		geomState.depths,
+		geomState.cov3D,
+		geomState.rgb,
+		geomState.conic_opacity,
+		tile_grid,
+		geomState.tiles_touched,
+		prefiltered,
+		compressed != nullptr ? *compressed : CompressedGaussians{}
+	);
+	if (stats)
+		stats->preprocess_ms = timer.lap();
+
+	// Compute prefix sum over full list of touched tile counts by Gaussians
+	// E.g., [2, 3, 0, 2, 1] -> [2, 5, 5, 7, 8]
+	inclusiveSum(geomState.tiles_touched, geomState.point_offsets, P);
+	if (stats)
+		stats->scan_ms = timer.lap();
+
+	// Retrieve total number of Gaussian instances to launch and resize aux buffers
+	int num_rendered = geomState.point_offsets[P - 1];
+
+	size_t binning_chunk_size = required<BinningState>(num_rendered);
+	char* binning_chunkptr = binningBuffer(binning_chunk_size);
+	BinningState binningState = BinningState::fromChunk(binning_chunkptr, num_rendered);
+
+	// For each instance to be rendered, produce adequate [ tile | depth ] key
+	// and corresponding dublicated Gaussian indices to be sorted
+	duplicateWithKeys(
+		P,
+		geomState.means2D,
+		geomState.depths,
+		geomState.conic_opacity,
+		geomState.point_offsets,
+		binningState.point_list_keys_unsorted,
+		binningState.point_list_unsorted,
+		radii,
+		tile_grid);
+	if (stats)
+		stats->duplicate_ms = timer.lap();
+
+	// Keeping all Gaussians in depth order only pays off while they are
+	// instanced at least once on average
+	if (coherent != nullptr && num_rendered < P)
+	{
+		coherent->forget();
+		coherent = nullptr;
+	}
+
+	if (coherent != nullptr)
+	{
+		// Bucket the instances of the Gaussians in depth order by tile
+		const uint32_t* order = depthOrder(P, means3D, viewmatrix, geomState.depths, radii, *coherent);
+		bucketByTile(
+			P, tile_grid.x * tile_grid.y,
+			order, radii,
+			geomState.point_offsets,
+			binningState.point_list_keys_unsorted,
+			binningState.point_list_keys,
+			binningState.point_list_origin,
+			binningState.point_list);
+	}
+	else
+	{
+		int bit = getHigherMsb(tile_grid.x * tile_grid.y);
+
+		// Sort complete list of (duplicated) Gaussian indices by keys
+		sortPairs(
+			binningState.point_list_keys_unsorted, binningState.point_list_keys,
+			binningState.point_list_unsorted, binningState.point_list_origin,
+			num_rendered, 32 + bit);
+
+		resolveGaussianIDs(num_rendered, P, geomState.point_offsets, binningState.point_list_origin, binningState.point_list);
+	}
+	if (stats)
+		stats->sort_ms = timer.lap();
+
+	std::memset(imgState.ranges, 0, tile_grid.x * tile_grid.y * sizeof(glm::uvec2));
+
+	// Identify start and end of per-tile workloads in sorted list
+	if (num_rendered > 0)
+		identifyTileRanges(
+			num_rendered,
+			tile_grid.x * tile_grid.y,
+			binningState.point_list_keys,
+			imgState.ranges);
+	if (stats)
+		stats->ranges_ms = timer.lap();
+
+	// Let each tile blend its range of Gaussians independently in parallel
+	const float* feature_ptr = colors_precomp != nullptr ? colors_precomp : geomState.rgb;
+	std::vector<float> instance_contrib(contributions != nullptr ? (size_t)num_rendered * 3 : 0);
+	FORWARD::render(
+		tile_grid,
+		imgState.ranges,
+		binningState.point_list,
+		width, height,
+		(glm::vec2*)subpixel_offset,
+		geomState.means2D,
+		feature_ptr,
+		channels,
+		geomState.conic_opacity,
+		imgState.accum_alpha,
+		imgState.n_contrib,
+		background,
+		out_color,
+		stats,
+		binningState.point_list_origin,
+		contributions != nullptr ? instance_contrib.data() : nullptr);
+	if (contributions != nullptr)
+		FORWARD::accumulateContributions(P, radii, geomState.point_offsets, instance_contrib.data(), *contributions);
+
+	if (stats)
+	{
+		stats->render_ms = timer.lap();
+		stats->forward_ms = timer.total();
+		stats->num_rendered = num_rendered;
+		stats->geometry_bytes = chunk_size;
+		stats->binning_bytes = binning_chunk_size;
+		stats->image_bytes = img_chunk_size;
+		stats->countVisible(radii, P);
+		stats->summarizeTiles((const uint32_t*)imgState.ranges, tile_grid.x * tile_grid.y);
+		stats->summarizeContributors(imgState.n_contrib, width * height);
+	}
+
+	return num_rendered;
+}
+
+// Produce necessary gradients for optimization, corresponding
+// to forward render pass
+void CpuRasterizer::Rasterizer::backward(
+	const int P, int D, int M, int R,
+	const int channels,
+	const float* background,
+	const int width, int height,
+	const float* means3D,
+	const float* shs,
+	const float* colors_precomp,
+	const float* scales,
+	const float scale_modifier,
+	const float* rotations,
+	const float* cov3D_precomp,
+	const float* viewmatrix,
+	const float* projmatrix,
+	const float* campos,
+	const float tan_fovx, float tan_fovy,
+	const float kernel_size,
+	const float* subpixel_offset,
+	const int* radii,
+	char* geom_buffer,
+	char* binning_buffer,
+	char* img_buffer,
+	const float* dL_dpix,
+	float* dL_dmean2D,
+	float* dL_dconic,
+	float* dL_dopacity,
+	float* dL_dcolor,
+	float* dL_dmean3D,
+	float* dL_dcov3D,
+	float* dL_dsh,
+	float* dL_dscale,
+	float* dL_drot,
+	bool /* debug */,
+	std::function<char* (size_t)> scratchBuffer,
+	RasterizerStats* stats)
+{
+	StageTimer timer;
+	GeometryState geomState = GeometryState::fromChunk(geom_buffer, P);
+	BinningState binningState = BinningState::fromChunk(binning_buffer, R);
+	ImageState imgState = ImageState::fromChunk(img_buffer, width * height);
+
+	if (radii == nullptr)
+	{
+		radii = geomState.internal_radii;
+	}
+
+	const float focal_y = height / (2.0f * tan_fovy);
+	const float focal_x = width / (2.0f * tan_fovx);
+
+	const TileGrid tile_grid = { (uint32_t)(width + BLOCK_X - 1) / BLOCK_X, (uint32_t)(height + BLOCK_Y - 1) / BLOCK_Y };
+
+	// Compute loss gradients w.r.t. 2D mean position, conic matrix,
+	// opacity and RGB of every Gaussian/tile instance from per-pixel
+	// loss gradients, then sum them per Gaussian in a fixed order.
+	// If we were given precomputed colors and not SHs, use them.
+	const float* color_ptr = (colors_precomp != nullptr) ? colors_precomp : geomState.rgb;
+	const size_t num_records = (size_t)R * BACKWARD::recordSize(channels);
+	std::vector<float> local_grads;
+	float* instance_grads;
+	if (scratchBuffer)
+		instance_grads = reinterpret_cast<float*>(scratchBuffer(num_records * sizeof(float)));
+	else
+	{
+		local_grads.resize(num_records);
+		instance_grads = local_grads.data();
+	}
+	clearUnplacedRecords(R, tile_grid.x * tile_grid.y, binningState.point_list_keys, binningState.point_list_origin, BACKWARD::recordSize(channels), instance_grads);
+	BACKWARD::render(
+		tile_grid,
+		imgState.ranges,
+		binningState.point_list,
+		binningState.point_list_origin,
+		width, height,
+		(glm::vec2*)subpixel_offset,
+		background,
+		geomState.means2D,
+		geomState.conic_opacity,
+		color_ptr,
+		channels,
+		imgState.accum_alpha,
+		imgState.n_contrib,
+		dL_dpix,
+		instance_grads);
+	if (stats)
+		stats->backward_render_ms = timer.lap();
+
+	BACKWARD::reduce(
+		P,
+		channels,
+		radii,
+		geomState.point_offsets,
+		instance_grads,
+		dL_dmean2D,
+		dL_dconic,
+		dL_dopacity,
+		dL_dcolor);
+	if (stats)
+		stats->backward_reduce_ms = timer.lap();
+
+	// Take care of the rest of preprocessing. Was the precomputed covariance
+	// given to us or a scales/rot pair? If precomputed, pass that. If not,
+	// use the one we computed ourselves.
+	const float* cov3D_ptr = (cov3D_precomp != nullptr) ? cov3D_precomp : geomState.cov3D;
+	BACKWARD::preprocess(P, shDegree(D, colors_precomp), M,
+		means3D,
+		radii,
+		shs,
+		geomState.clamped,
+		(glm::vec3*)scales,
+		(glm::vec4*)rotations,
+		scale_modifier,
+		cov3D_ptr,
+		viewmatrix,
+		projmatrix,
+		focal_x, focal_y,
+		tan_fovx, tan_fovy,
+		kernel_size,
+		(glm::vec3*)campos,
+		dL_dmean2D,
+		dL_dconic,
+		(glm::vec3*)dL_dmean3D,
+		dL_dcolor,
+		dL_dcov3D,
+		dL_dsh,
+		(glm::vec3*)dL_dscale,
+		(glm::vec4*)dL_drot,
+		geomState.conic_opacity,
+		dL_dopacity);
+
+	if (stats)
+	{
+		stats->backward_preprocess_ms = timer.lap();
+		stats->backward_ms = timer.total();
+	}
+}
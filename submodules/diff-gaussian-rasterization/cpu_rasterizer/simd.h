@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_SIMD_H_INCLUDED
+#define CPU_RASTERIZER_SIMD_H_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Minimal set of packed float operations used by the tile blending
+// loops. One vector holds WIDTH horizontally adjacent pixels of a tile.
+// The instruction set is chosen at compile time (AVX-512, AVX2+FMA,
+// otherwise plain scalar code with a width of one).
+namespace CpuRasterizer
+{
+namespace simd
+{
+#if defined(__AVX512F__)
+
+	constexpr int WIDTH = 16;
+	typedef __m512 vfloat;
+	typedef __m512i vint;
+	typedef __mmask16 vmask;
+
+	inline vfloat set1(float v) { return _mm512_set1_ps(v); }
+	inline vfloat zero() { return _mm512_setzero_ps(); }
+	inline vfloat load(const float* p) { return _mm512_load_ps(p); }
+	inline void store(float* p, vfloat v) { _mm512_store_ps(p, v); }
+	inline vfloat add(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+	inline vfloat sub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+	inline vfloat mul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+	inline vfloat div(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+	inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return _mm512_fmadd_ps(a, b, c); }
+	inline vfloat min(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+	inline vfloat max(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+	inline vfloat abs(vfloat a) { return _mm512_abs_ps(a); }
+
+	inline vmask lt(vfloat a, vfloat b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	inline vmask le(vfloat a, vfloat b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+	inline vmask ge(vfloat a, vfloat b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+	inline vmask mask_and(vmask a, vmask b) { return a & b; }
+	inline vmask mask_andnot(vmask a, vmask b) { return a & ~b; }
+	inline vmask mask_none() { return 0; }
+	inline vmask mask_first(int n) { return (vmask)((n >= WIDTH) ? 0xFFFF : ((1u << n) - 1)); }
+	inline bool any(vmask m) { return m != 0; }
+	inline bool lane(vmask m, int i) { return (m >> i) & 1; }
+
+	// m ? a : b
+	inline vfloat select(vmask m, vfloat a, vfloat b) { return _mm512_mask_blend_ps(m, b, a); }
+
+	inline vint set1i(int v) { return _mm512_set1_epi32(v); }
+	inline vint loadi(const int* p) { return _mm512_load_si512((const void*)p); }
+	inline void storei(int* p, vint v) { _mm512_store_si512((void*)p, v); }
+	inline vint selecti(vmask m, vint a, vint b) { return _mm512_mask_blend_epi32(m, b, a); }
+	inline vmask gti(vint a, vint b) { return _mm512_cmpgt_epi32_mask(a, b); }
+
+	inline float reduce_add(vfloat v) { return _mm512_reduce_add_ps(v); }
+	inline float reduce_max(vfloat v) { return _mm512_reduce_max_ps(v); }
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+	constexpr int WIDTH = 8;
+	typedef __m256 vfloat;
+	typedef __m256i vint;
+	typedef __m256 vmask;
+
+	inline vfloat set1(float v) { return _mm256_set1_ps(v); }
+	inline vfloat zero() { return _mm256_setzero_ps(); }
+	inline vfloat load(const float* p) { return _mm256_load_ps(p); }
+	inline void store(float* p, vfloat v) { _mm256_store_ps(p, v); }
+	inline vfloat add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+	inline vfloat sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+	inline vfloat mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+	inline vfloat div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+	inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+	inline vfloat min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+	inline vfloat max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+	inline vfloat abs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+	inline vmask lt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline vmask le(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	inline vmask ge(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	inline vmask mask_and(vmask a, vmask b) { return _mm256_and_ps(a, b); }
+	inline vmask mask_andnot(vmask a, vmask b) { return _mm256_andnot_ps(b, a); }
+	inline vmask mask_none() { return _mm256_setzero_ps(); }
+	inline vmask mask_first(int n)
+	{
+		const __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(n), idx));
+	}
+	inline bool any(vmask m) { return _mm256_movemask_ps(m) != 0; }
+	inline bool lane(vmask m, int i) { return (_mm256_movemask_ps(m) >> i) & 1; }
+
+	// m ? a : b
+	inline vfloat select(vmask m, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, m); }
+
+	inline vint set1i(int v) { return _mm256_set1_epi32(v); }
+	inline vint loadi(const int* p) { return _mm256_load_si256((const __m256i*)p); }
+	inline void storei(int* p, vint v) { _mm256_store_si256((__m256i*)p, v); }
+	inline vint selecti(vmask m, vint a, vint b)
+	{
+		return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m));
+	}
+	inline vmask gti(vint a, vint b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)); }
+
+	inline float reduce_add(vfloat v)
+	{
+		// Fixed pairwise order, so results do not depend on the caller.
+		__m128 lo = _mm256_castps256_ps128(v);
+		__m128 hi = _mm256_extractf128_ps(v, 1);
+		lo = _mm_add_ps(lo, hi);
+		__m128 shuf = _mm_movehdup_ps(lo);
+		__m128 sums = _mm_add_ps(lo, shuf);
+		shuf = _mm_movehl_ps(shuf, sums);
+		sums = _mm_add_ss(sums, shuf);
+		return _mm_cvtss_f32(sums);
+	}
+	inline float reduce_max(vfloat v)
+	{
+		__m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_max_ss(m, _mm_movehdup_ps(m));
+		return _mm_cvtss_f32(m);
+	}
+
+#else
+
+	constexpr int WIDTH = 1;
+	typedef float vfloat;
+	typedef int vint;
+	typedef bool vmask;
+
+	inline vfloat set1(float v) { return v; }
+	inline vfloat zero() { return 0.0f; }
+	inline vfloat load(const float* p) { return *p; }
+	inline void store(float* p, vfloat v) { *p = v; }
+	inline vfloat add(vfloat a, vfloat b) { return a + b; }
+	inline vfloat sub(vfloat a, vfloat b) { return a - b; }
+	inline vfloat mul(vfloat a, vfloat b) { return a * b; }
+	inline vfloat div(vfloat a, vfloat b) { return a / b; }
+	inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return a * b + c; }
+	inline vfloat min(vfloat a, vfloat b) { return a < b ? a : b; }
+	inline vfloat max(vfloat a, vfloat b) { return a > b ? a : b; }
+	inline vfloat abs(vfloat a) { return std::fabs(a); }
+
+	inline vmask lt(vfloat a, vfloat b) { return a < b; }
+	inline vmask le(vfloat a, vfloat b) { return a <= b; }
+	inline vmask ge(vfloat a, vfloat b) { return a >= b; }
+	inline vmask mask_and(vmask a, vmask b) { return a && b; }
+	inline vmask mask_andnot(vmask a, vmask b) { return a && !b; }
+	inline vmask mask_none() { return false; }
+	inline vmask mask_first(int n) { return n > 0; }
+	inline bool any(vmask m) { return m; }
+	inline bool lane(vmask m, int i) { return m; }
+
+	inline vfloat select(vmask m, vfloat a, vfloat b) { return m ? a : b; }
+
+	inline vint set1i(int v) { return v; }
+	inline vint loadi(const int* p) { return *p; }
+	inline void storei(int* p, vint v) { *p = v; }
+	inline vint selecti(vmask m, vint a, vint b) { return m ? a : b; }
+	inline vmask gti(vint a, vint b) { return a > b; }
+
+	inline float reduce_add(vfloat v) { return v; }
+	inline float reduce_max(vfloat v) { return v; }
+
+#endif
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+	// Packed exponential (Cephes polynomial, ~2 ulp on the range used
+	// for Gaussian falloff). Inputs are clamped to the finite range.
+	inline vfloat exp(vfloat x)
+	{
+		x = min(x, set1(88.3762626647949f));
+		x = max(x, set1(-88.3762626647949f));
+
+		vfloat fx = fmadd(x, set1(1.44269504088896341f), set1(0.5f));
+#if defined(__AVX512F__)
+		fx = _mm512_roundscale_ps(fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+#else
+		fx = _mm256_floor_ps(fx);
+#endif
+		x = sub(x, mul(fx, set1(0.693359375f)));
+		x = sub(x, mul(fx, set1(-2.12194440e-4f)));
+
+		vfloat z = mul(x, x);
+		vfloat y = set1(1.9875691500E-4f);
+		y = fmadd(y, x, set1(1.3981999507E-3f));
+		y = fmadd(y, x, set1(8.3334519073E-3f));
+		y = fmadd(y, x, set1(4.1665795894E-2f));
+		y = fmadd(y, x, set1(1.6666665459E-1f));
+		y = fmadd(y, x, set1(5.0000001201E-1f));
+		y = fmadd(y, z, x);
+		y = add(y, set1(1.0f));
+
+#if defined(__AVX512F__)
+		__m512i n = _mm512_cvttps_epi32(fx);
+		n = _mm512_add_epi32(n, _mm512_set1_epi32(0x7f));
+		n = _mm512_slli_epi32(n, 23);
+		return mul(y, _mm512_castsi512_ps(n));
+#else
+		__m256i n = _mm256_cvttps_epi32(fx);
+		n = _mm256_add_epi32(n, _mm256_set1_epi32(0x7f));
+		n = _mm256_slli_epi32(n, 23);
+		return mul(y, _mm256_castsi256_ps(n));
+#endif
+	}
+#else
+	inline vfloat exp(vfloat x) { return std::exp(x); }
+#endif
+};
+};
+
+#endif
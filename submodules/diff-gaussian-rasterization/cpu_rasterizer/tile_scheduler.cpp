@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "tile_scheduler.h"
+
+namespace
+{
+	// Items per thread that the splitting aims for, and the shortest
+	// range worth splitting (every band walks the whole range)
+	constexpr uint64_t ITEMS_PER_THREAD = 8;
+	constexpr uint32_t MIN_SPLIT_RANGE = 128;
+
+	uint64_t pack(uint32_t front, uint32_t back)
+	{
+		return ((uint64_t)front << 32) | back;
+	}
+
+	uint64_t itemCost(uint32_t range, int groups)
+	{
+		// Empty tiles still write their pixels
+		return ((uint64_t)range + 1) * groups;
+	}
+}
+
+CpuRasterizer::TileScheduler::TileScheduler(const glm::uvec2* ranges, int num_tiles, int groups, int max_parts, int threads)
+	: threads(std::max(1, threads))
+{
+	uint64_t total = 0;
+	for (int t = 0; t < num_tiles; t++)
+		total += itemCost(ranges[t].y - ranges[t].x, groups);
+	const uint64_t target = std::max<uint64_t>(1, total / (this->threads * ITEMS_PER_THREAD));
+	max_parts = this->threads > 1 ? std::max(1, std::min(max_parts, groups)) : 1;
+
+	items.reserve(num_tiles);
+	for (int t = 0; t < num_tiles; t++)
+	{
+		const uint32_t range = ranges[t].y - ranges[t].x;
+		int parts = 1;
+		if (range >= MIN_SPLIT_RANGE)
+			parts = (int)std::min<uint64_t>(max_parts, (itemCost(range, groups) + target - 1) / target);
+		split_tiles += parts > 1;
+		for (int p = 0; p < parts; p++)
+			items.push_back({ (uint32_t)t, (uint16_t)(p * groups / parts), (uint16_t)((p + 1) * groups / parts) });
+	}
+
+	// Thread t owns the items whose cost midpoint lies in the t-th share
+	queues.reset(new Queue[this->threads]);
+	std::vector<uint32_t> first(this->threads + 1, (uint32_t)items.size());
+	uint64_t before = 0;
+	int owner = 0;
+	first[0] = 0;
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		const RenderItem& item = items[i];
+		const uint64_t cost = itemCost(ranges[item.tile].y - ranges[item.tile].x, item.group_end - item.group_begin);
+		const int thread = (int)std::min<uint64_t>(this->threads - 1, (before + cost / 2) * this->threads / std::max<uint64_t>(1, total));
+		while (owner < thread)
+			first[++owner] = (uint32_t)i;
+		before += cost;
+	}
+	for (int t = 0; t < this->threads; t++)
+		queues[t].bounds.store(pack(first[t], first[t + 1]), std::memory_order_relaxed);
+}
+
+bool CpuRasterizer::TileScheduler::pop(int queue, bool front, uint32_t& item)
+{
+	uint64_t bounds = queues[queue].bounds.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		const uint32_t begin = (uint32_t)(bounds >> 32), end = (uint32_t)bounds;
+		if (begin >= end)
+			return false;
+		const uint64_t rest = front ? pack(begin + 1, end) : pack(begin, end - 1);
+		if (queues[queue].bounds.compare_exchange_weak(bounds, rest, std::memory_order_relaxed))
+		{
+			item = front ? begin : end - 1;
+			return true;
+		}
+	}
+}
+
+bool CpuRasterizer::TileScheduler::next(int thread, uint32_t& item)
+{
+	if (pop(thread, true, item))
+		return true;
+
+	// Steal from the run with the most items left until all are empty
+	for (;;)
+	{
+		int victim = -1;
+		uint32_t most = 0;
+		for (int t = 0; t < threads; t++)
+		{
+			const uint64_t bounds = queues[t].bounds.load(std::memory_order_relaxed);
+			const uint32_t begin = (uint32_t)(bounds >> 32), end = (uint32_t)bounds;
+			if (end > begin && end - begin > most)
+			{
+				most = end - begin;
+				victim = t;
+			}
+		}
+		if (victim < 0)
+			return false;
+		if (pop(victim, false, item))
+		{
+			stolen++;
+			return true;
+		}
+	}
+}
+
+void CpuRasterizer::TileScheduler::finish(const std::vector<double>& busy)
+{
+	double sum = 0.0, most = 0.0;
+	int count = 0;
+	for (double time : busy)
+	{
+		if (time < 0.0)
+			continue;
+		sum += time;
+		most = std::max(most, time);
+		count++;
+	}
+	imbalance = sum > 0.0 ? most * count / sum : 1.0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CPU_RASTERIZER_TILE_SCHEDULER_H_INCLUDED
+#define CPU_RASTERIZER_TILE_SCHEDULER_H_INCLUDED
+
+#include "auxiliary.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Schedule of the forward render stage. Tile workloads are skewed: tiles
+// near dense geometry hold 10-100x the Gaussians of the median one, and
+// the thread that walks such a range alone sets the frame time. Once the
+// tile ranges are known, heavy tiles are cut into bands of pixel rows
+// (whole SIMD groups) that each walk the tile's range for their pixels.
+// Pixels blend independently, so the image is the same. The items are
+// dealt to the threads in tile order, as contiguous runs of about equal
+// estimated cost, which keeps neighbouring tiles (that share Gaussians)
+// on one thread; a thread that runs out steals from the back of the
+// fullest other run.
+namespace CpuRasterizer
+{
+	struct RenderItem
+	{
+		uint32_t tile;
+		uint16_t group_begin, group_end;	// SIMD pixel groups [begin, end) of the tile
+	};
+
+	class TileScheduler
+	{
+	public:
+		// Plans the items for the tile ranges. A tile of G SIMD groups is
+		// split into at most max_parts bands (1 disables splitting) when its
+		// range is much longer than an even share of the frame.
+		TileScheduler(const glm::uvec2* ranges, int num_tiles, int groups, int max_parts, int threads);
+
+		// Calls work(item) for every item, on up to the planned threads
+		template<typename Work>
+		void run(const Work& work);
+
+		int numItems() const { return (int)items.size(); }
+		int splitTiles() const { return split_tiles; }
+		int stolenItems() const { return stolen.load(); }
+		// Time the busiest thread spent rendering over the mean of the
+		// threads (1 is even), known after run
+		double workerImbalance() const { return imbalance; }
+
+	private:
+		// Front and back of a thread's run in one word: the owner takes
+		// items from the front, thieves from the back, both by CAS
+		struct alignas(64) Queue
+		{
+			std::atomic<uint64_t> bounds;
+		};
+
+		bool pop(int queue, bool front, uint32_t& item);
+		bool next(int thread, uint32_t& item);
+		void finish(const std::vector<double>& busy);
+
+		std::vector<RenderItem> items;
+		std::unique_ptr<Queue[]> queues;
+		int threads = 1;
+		int split_tiles = 0;
+		std::atomic<int> stolen{ 0 };
+		double imbalance = 0.0;
+	};
+};
+
+template<typename Work>
+void CpuRasterizer::TileScheduler::run(const Work& work)
+{
+	// Per thread render time, -1 for threads of a smaller team
+	std::vector<double> busy(threads, -1.0);
+	#pragma omp parallel num_threads(threads)
+	{
+		const int thread = threadIndex();
+		double time = 0.0;
+		uint32_t item;
+		while (next(thread, item))
+		{
+			const auto start = std::chrono::steady_clock::now();
+			work(items[item]);
+			time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		busy[thread] = time;
+	}
+	finish(busy);
+}
+
+#endif
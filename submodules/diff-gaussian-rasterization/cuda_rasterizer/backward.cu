@@ -11,13 +11,15 @@
 
 #include "backward.h"
 #include "auxiliary.h"
+#include "dispatch.h"
 #include <cooperative_groups.h>
 #include <cooperative_groups/reduce.h>
 namespace cg = cooperative_groups;
 
 // Backward pass for conversion of spherical harmonics to RGB for
-// each Gaussian.
-__device__ void computeColorFromSH(int idx, int deg, int max_coeffs, const glm::vec3* means, glm::vec3 campos, const float* shs, const bool* clamped, const glm::vec3* dL_dcolor, glm::vec3* dL_dmeans, glm::vec3* dL_dshs)
+// each Gaussian, specialized on the SH degree.
+template<int deg>
+__device__ void computeColorFromSH(int idx, int max_coeffs, const glm::vec3* means, glm::vec3 campos, const float* shs, const bool* clamped, const glm::vec3* dL_dcolor, glm::vec3* dL_dmeans, glm::vec3* dL_dshs)
 {
 	// Compute intermediate values, as it is done during forward
 	glm::vec3 pos = means[idx];
@@ -378,10 +380,11 @@ __device__ void computeCov3D(int idx, const glm::vec3 scale, float mod, const gl
 
 // Backward pass of the preprocessing steps, except
 // for the covariance computation and inversion
-// (those are handled by a previous kernel call)
-template<int C>
+// (those are handled by a previous kernel call). D is the SH degree,
+// -1 if colors were precomputed.
+template<int D>
 __global__ void preprocessCUDA(
-	int P, int D, int M,
+	int P, int M,
 	const float3* means,
 	const int* radii,
 	const float* shs,
@@ -423,19 +426,21 @@ __global__ void preprocessCUDA(
 	dL_dmeans[idx] += dL_dmean;
 
 	// Compute gradient updates due to computing colors from SHs
-	if (shs)
-		computeColorFromSH(idx, D, M, (glm::vec3*)means, *campos, shs, clamped, (glm::vec3*)dL_dcolor, (glm::vec3*)dL_dmeans, (glm::vec3*)dL_dsh);
+	if (D >= 0)
+		computeColorFromSH<D>(idx, M, (glm::vec3*)means, *campos, shs, clamped, (glm::vec3*)dL_dcolor, (glm::vec3*)dL_dmeans, (glm::vec3*)dL_dsh);
 
 	// Compute gradient updates due to computing covariance from scale/rotation
 	if (scales)
 		computeCov3D(idx, scales[idx], scale_modifier, rotations[idx], dL_dcov3D, dL_dscale, dL_drot);
 }
 
-// Backward version of the rendering procedure.
+// Backward version of the rendering procedure, with the blocks in the
+// forward pass's tile_order.
 template <uint32_t C>
 __global__ void __launch_bounds__(BLOCK_X * BLOCK_Y)
 renderCUDA(
 	const uint2* __restrict__ ranges,
+	const uint32_t* __restrict__ tile_order,
 	const uint32_t* __restrict__ point_list,
 	int W, int H,
 	const float2* __restrict__ subpixel_offset,
@@ -454,14 +459,15 @@ renderCUDA(
 	// We rasterize again. Compute necessary block info.
 	auto block = cg::this_thread_block();
 	const uint32_t horizontal_blocks = (W + BLOCK_X - 1) / BLOCK_X;
-	const uint2 pix_min = { block.group_index().x * BLOCK_X, block.group_index().y * BLOCK_Y };
+	const uint32_t tile = tile_order[block.group_index().x];
+	const uint2 pix_min = { tile % horizontal_blocks * BLOCK_X, tile / horizontal_blocks * BLOCK_Y };
 	const uint2 pix_max = { min(pix_min.x + BLOCK_X, W), min(pix_min.y + BLOCK_Y , H) };
 	const uint2 pix = { pix_min.x + block.thread_index().x, pix_min.y + block.thread_index().y };
 	const uint32_t pix_id = W * pix.y + pix.x;
 	float2 pixf = { (float)pix.x, (float)pix.y };
 
 	const bool inside = pix.x < W&& pix.y < H;
-	const uint2 range = ranges[block.group_index().y * horizontal_blocks + block.group_index().x];
+	const uint2 range = ranges[tile];
 
 	const int rounds = ((range.y - range.x + BLOCK_SIZE - 1) / BLOCK_SIZE);
 
@@ -607,6 +613,96 @@ renderCUDA(
 	}
 }
 
+// Kernel launches of every supported channel count / SH degree
+namespace
+{
+	struct PreprocessLaunch
+	{
+		template<int D>
+		static void run(
+			int P, int M,
+			const float3* means3D,
+			const int* radii,
+			const float* shs,
+			const bool* clamped,
+			const glm::vec3* scales,
+			const glm::vec4* rotations,
+			const float scale_modifier,
+			const float* projmatrix,
+			const glm::vec3* campos,
+			const float3* dL_dmean2D,
+			glm::vec3* dL_dmean3D,
+			float* dL_dcolor,
+			float* dL_dcov3D,
+			float* dL_dsh,
+			glm::vec3* dL_dscale,
+			glm::vec4* dL_drot)
+		{
+			preprocessCUDA<D> << < (P + 255) / 256, 256 >> > (
+				P, M,
+				means3D,
+				radii,
+				shs,
+				clamped,
+				scales,
+				rotations,
+				scale_modifier,
+				projmatrix,
+				campos,
+				dL_dmean2D,
+				dL_dmean3D,
+				dL_dcolor,
+				dL_dcov3D,
+				dL_dsh,
+				dL_dscale,
+				dL_drot);
+		}
+	};
+
+	struct RenderLaunch
+	{
+		template<int C>
+		static void run(
+			const dim3 grid, const dim3 block,
+			const uint2* ranges,
+			const uint32_t* tile_order,
+			const uint32_t* point_list,
+			int W, int H,
+			const float2* subpixel_offset,
+			const float* bg_color,
+			const float2* means2D,
+			const float4* conic_opacity,
+			const float* colors,
+			const float* final_Ts,
+			const uint32_t* n_contrib,
+			const float* dL_dpixels,
+			float3* dL_dmean2D,
+			float4* dL_dconic2D,
+			float* dL_dopacity,
+			float* dL_dcolors)
+		{
+			renderCUDA<C> << <grid.x * grid.y, block >> >(
+				ranges,
+				tile_order,
+				point_list,
+				W, H,
+				subpixel_offset,
+				bg_color,
+				means2D,
+				conic_opacity,
+				colors,
+				final_Ts,
+				n_contrib,
+				dL_dpixels,
+				dL_dmean2D,
+				dL_dconic2D,
+				dL_dopacity,
+				dL_dcolors
+				);
+		}
+	};
+}
+
 void BACKWARD::preprocess(
 	int P, int D, int M,
 	const float3* means3D,
@@ -658,8 +754,8 @@ void BACKWARD::preprocess(
 	// Propagate gradients for remaining steps: finish 3D mean gradients,
 	// propagate color gradients to SH (if desireD), propagate 3D covariance
 	// matrix gradients to scale and rotation.
-	preprocessCUDA<NUM_CHANNELS> << < (P + 255) / 256, 256 >> > (
-		P, D, M,
+	dispatchSHDegree<PreprocessLaunch>(D,
+		P, M,
 		(float3*)means3D,
 		radii,
 		shs,
@@ -681,6 +777,7 @@ void BACKWARD::preprocess(
 void BACKWARD::render(
 	const dim3 grid, const dim3 block,
 	const uint2* ranges,
+	const uint32_t* tile_order,
 	const uint32_t* point_list,
 	int W, int H,
 	const float2* subpixel_offset,
@@ -688,6 +785,7 @@ void BACKWARD::render(
 	const float2* means2D,
 	const float4* conic_opacity,
 	const float* colors,
+	const int channels,
 	const float* final_Ts,
 	const uint32_t* n_contrib,
 	const float* dL_dpixels,
@@ -696,8 +794,10 @@ void BACKWARD::render(
 	float* dL_dopacity,
 	float* dL_dcolors)
 {
-	renderCUDA<NUM_CHANNELS> << <grid, block >> >(
+	dispatchChannels<RenderLaunch>(channels,
+		grid, block,
 		ranges,
+		tile_order,
 		point_list,
 		W, H,
 		subpixel_offset,
@@ -711,6 +811,5 @@ void BACKWARD::render(
 		dL_dmean2D,
 		dL_dconic2D,
 		dL_dopacity,
-		dL_dcolors
-		);
-}
\ No newline at end of file
+		dL_dcolors);
+}
@@ -23,6 +23,7 @@ namespace BACKWARD
 	void render(
 		const dim3 grid, dim3 block,
 		const uint2* ranges,
+		const uint32_t* tile_order,
 		const uint32_t* point_list,
 		int W, int H,
 		const float2* subpixel_offset,
@@ -30,6 +31,7 @@ namespace BACKWARD
 		const float2* means2D,
 		const float4* conic_opacity,
 		const float* colors,
+		const int channels,
 		const float* final_Ts,
 		const uint32_t* n_contrib,
 		const float* dL_dpixels,
@@ -38,6 +40,7 @@ namespace BACKWARD
 		float* dL_dopacity,
 		float* dL_dcolors);
 
+	// D is the SH degree of the colors, -1 if they were precomputed.
 	void preprocess(
 		int P, int D, int M,
 		const float3* means,
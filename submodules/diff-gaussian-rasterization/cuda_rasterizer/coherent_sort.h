@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_COHERENT_SORT_H_INCLUDED
+#define CUDA_RASTERIZER_COHERENT_SORT_H_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#ifdef __CUDACC__
+#define COHERENT_FUNC __host__ __device__ __forceinline__
+#else
+#define COHERENT_FUNC inline
+#endif
+
+// Repair budget of the host rasterizer: insertion sort moves per Gaussian
+// before the repair gives up and sorts from scratch, which costs about as
+// much as the radix passes of the sort
+#define COHERENT_MAX_MOVES 32
+// Window of the block-local sorts the CUDA rasterizer repairs with
+#define COHERENT_WINDOW 1024
+
+// Optional state of a forward call for frames of an interactive viewer,
+// shared by the CUDA and host rasterizers. Instead of sorting all
+// Gaussian/tile instances by | tile | depth |, the Gaussians are kept in
+// depth order across frames: the order of the previous frame is re-keyed
+// with the new depths and repaired by a bounded local sort, which is
+// cheap while the camera moves smoothly. The instances are then emitted
+// in depth order and only bucketed by tile, which keeps the order within
+// every tile. The result is that of the full sort; Gaussians of equal
+// depth are ordered by index in both.
+//
+// The order is sorted from scratch when the number of Gaussians or the
+// order memory changed, when the camera turned by more than max_rotation
+// (radians) since the last frame, or when the repair exceeds its budget.
+// Frames with fewer instances than Gaussians (most of them culled) are
+// cheaper to sort directly and do not use the order.
+struct CoherentSort
+{
+	// Memory of the order (and its scratch space), which must keep its
+	// contents between calls as long as it does not grow, as the arenas
+	// of RasterizerContext do
+	std::function<char*(size_t)> orderBuffer;
+	float max_rotation = 0.2f;
+
+	// Frame of the stored order
+	int P = 0;
+	const char* memory = nullptr;
+	float viewmatrix[16] = {};
+
+	// Whether the last call sorted from scratch, and how often it did
+	bool full_sort = true;
+	int64_t frames = 0;
+	int64_t full_sorts = 0;
+
+	bool coherentWith(int P_, const float* view, const char* memory_) const
+	{
+		if (P_ != P || memory_ != memory || P == 0)
+			return false;
+		// Angle between the camera rotations: trace(R_prev R^T) = 1 + 2 cos
+		float trace = 0.0f;
+		for (int c = 0; c < 3; c++)
+			for (int r = 0; r < 3; r++)
+				trace += viewmatrix[4 * c + r] * view[4 * c + r];
+		return 0.5f * (trace - 1.0f) >= cosf(max_rotation);
+	}
+
+	// Drops the stored order, the next frame is sorted from scratch
+	void forget()
+	{
+		P = 0;
+		memory = nullptr;
+	}
+
+	void remember(int P_, const float* view, const char* memory_, bool sorted_from_scratch)
+	{
+		P = P_;
+		memory = memory_;
+		std::memcpy(viewmatrix, view, sizeof(viewmatrix));
+		full_sort = sorted_from_scratch;
+		frames++;
+		full_sorts += sorted_from_scratch;
+	}
+};
+
+// View space depth of point p, as transformPoint4x3 computes it
+COHERENT_FUNC float viewDepth(const float* p, const float* viewmatrix)
+{
+	return viewmatrix[2] * p[0] + viewmatrix[6] * p[1] + viewmatrix[10] * p[2] + viewmatrix[14];
+}
+
+// Key of Gaussian id at depth: | depth | id |, with the depth bits mapped
+// so that the keys of all depths (not only positive ones) are ordered
+COHERENT_FUNC uint64_t depthKey(float depth, uint32_t id)
+{
+#ifdef __CUDA_ARCH__
+	uint32_t bits = __float_as_uint(depth);
+#else
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+#endif
+	bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+	return ((uint64_t)bits << 32) | id;
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_COMPRESSED_H_INCLUDED
+#define CUDA_RASTERIZER_COMPRESSED_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __CUDACC__
+#include <cuda_fp16.h>
+#define COMPRESSED_FUNC __host__ __device__ __forceinline__
+#else
+#define COMPRESSED_FUNC inline
+#endif
+#if !defined(__CUDA_ARCH__) && defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// Optional input of a forward call for served (trained) models, shared by
+// the CUDA and host rasterizers. It replaces shs, opacities, scales and
+// rotations, which are then decoded per Gaussian in the preprocess step
+// instead of being expanded to float arrays first:
+//
+//   features_dc  P x 3 half, SH band 0
+//   sh_codebook  K x (M - 1) x 3 float, vector-quantized higher SH bands
+//   sh_index     P, the codebook entry of every Gaussian
+//   opacities    P half, scales P x 3 half: activated, 3D filter applied
+//   rotations    P x 4 half, normalized quaternions
+//
+// Together with the float means these are 38 bytes per Gaussian instead
+// of 236 at SH degree 3, the codebook is small and shared. Half values
+// are passed as their uint16_t bit patterns. Backward is not supported.
+struct CompressedGaussians
+{
+	const uint16_t* features_dc;
+	const float* sh_codebook;
+	const int32_t* sh_index;
+	const uint16_t* opacities;
+	const uint16_t* scales;
+	const uint16_t* rotations;
+};
+
+COMPRESSED_FUNC float halfToFloat(uint16_t h)
+{
+#if defined(__CUDA_ARCH__)
+	return __half2float(__ushort_as_half(h));
+#elif defined(__F16C__)
+	return _cvtsh_ss(h);
+#else
+	const uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+	uint32_t exponent = (h >> 10) & 0x1Fu;
+	uint32_t mantissa = h & 0x3FFu;
+	uint32_t bits;
+	if (exponent == 0x1Fu)
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	else if (exponent != 0)
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else if (mantissa == 0)
+		bits = sign;
+	else
+	{
+		// Subnormal, normalized for the float exponent
+		exponent = 113;
+		while (!(mantissa & 0x400u))
+		{
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+	}
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+#endif
+}
+
+#ifndef __CUDA_ARCH__
+// Half bit pattern of f, rounded to nearest even (host only; models are
+// compressed by torch, this serves tools and benchmarks)
+inline uint16_t floatToHalf(float f)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000u);
+	const uint32_t magnitude = bits & 0x7FFFFFFFu;
+	if (magnitude >= 0x7F800000u)
+		return sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u);
+	if (magnitude >= 0x477FF000u)
+		return sign | 0x7C00u;
+	if (magnitude < 0x38800000u)
+	{
+		// Subnormal or zero: shift the mantissa with its implicit bit in
+		if (magnitude < 0x33000000u)
+			return sign;
+		const uint32_t shift = 126 - (magnitude >> 23);
+		const uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+		const uint32_t half = mantissa >> shift;
+		const uint32_t rest = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		return sign | (uint16_t)(half + (rest > halfway || (rest == halfway && (half & 1))));
+	}
+	const uint32_t rounded = magnitude - 0x38000000u + 0xFFFu + ((magnitude >> 13) & 1);
+	return sign | (uint16_t)(rounded >> 13);
+}
+#endif
+
+COMPRESSED_FUNC void decodeHalves(const uint16_t* h, int n, float* out)
+{
+	for (int i = 0; i < n; i++)
+		out[i] = halfToFloat(h[i]);
+}
+
+#endif
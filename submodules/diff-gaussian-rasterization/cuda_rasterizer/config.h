@@ -12,7 +12,8 @@
 #ifndef CUDA_RASTERIZER_CONFIG_H_INCLUDED
 #define CUDA_RASTERIZER_CONFIG_H_INCLUDED
 
-#define NUM_CHANNELS 3 // Default 3, RGB
+#define NUM_CHANNELS 3 // Channels of colors from SHs (RGB), see dispatch.h for precomputed features
+#define MAX_SH_DEGREE 3
 #define BLOCK_X 16
 #define BLOCK_Y 16
 
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_CONTRIBUTION_H_INCLUDED
+#define CUDA_RASTERIZER_CONTRIBUTION_H_INCLUDED
+
+// Optional output of a forward call, shared by the CUDA and host
+// rasterizers: how much every Gaussian contributed to the image. The
+// blend weight of a Gaussian at a pixel is alpha * T, its share of the
+// pixel's color. Per Gaussian, max_weight receives the largest and
+// weight_sum the summed weight, pixels the number of pixels it was
+// blended into. The arrays (P floats each, in the memory of the
+// rasterizer) are accumulated into and not reset, so one set collects
+// the statistics of all views of a pass, e.g., for pruning Gaussians
+// that never visibly contribute.
+struct GaussianContributions
+{
+	float* max_weight;
+	float* weight_sum;
+	float* pixels;
+};
+
+#endif
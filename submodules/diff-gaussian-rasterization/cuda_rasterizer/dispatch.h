@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_DISPATCH_H_INCLUDED
+#define CUDA_RASTERIZER_DISPATCH_H_INCLUDED
+
+#include "config.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// Compile-time specialization of the rasterizer, shared by the CUDA and
+// host implementations. The render steps are templates on the number of
+// feature channels blended per Gaussian, the preprocess steps on the SH
+// degree of the color evaluation, so loops over channels and SH bands are
+// fully unrolled. The instance for a call is looked up at run time in a
+// table with one entry per supported value. F::run<V>(args...) must
+// exist for every value of the list.
+namespace Dispatch
+{
+	template<int... Vs>
+	struct Values {};
+
+	// Channel counts with specialized kernels. Features with other counts
+	// must be padded to the next one.
+	using Channels = Values<1, 2, 3, 4, 8, 16, 32>;
+
+	// SH degrees of the color evaluation, -1 for precomputed colors
+	using SHDegrees = Values<-1, 0, 1, 2, 3>;
+
+	template<typename F, int V, typename... Args>
+	void invoke(Args... args)
+	{
+		F::template run<V>(args...);
+	}
+
+	template<typename F, int... Vs, typename... Args>
+	void lookup(Values<Vs...>, const char* what, int value, Args... args)
+	{
+		using Fn = void (*)(Args...);
+		static constexpr int values[] = { Vs... };
+		static constexpr Fn table[] = { &invoke<F, Vs, Args...>... };
+		for (int i = 0; i < (int)sizeof...(Vs); i++)
+			if (values[i] == value)
+				return table[i](args...);
+		throw std::runtime_error("Unsupported " + std::string(what) + " " + std::to_string(value));
+	}
+}
+
+template<typename F, typename... Args>
+void dispatchChannels(int channels, Args... args)
+{
+	Dispatch::lookup<F>(Dispatch::Channels(), "number of channels", channels, args...);
+}
+
+template<typename F, typename... Args>
+void dispatchSHDegree(int degree, Args... args)
+{
+	Dispatch::lookup<F>(Dispatch::SHDegrees(), "SH degree", degree, args...);
+}
+
+// SH degree the preprocess steps are specialized on: -1 if colors are
+// precomputed, the active degree D otherwise
+inline int shDegree(int D, const float* colors_precomp)
+{
+	return colors_precomp != nullptr ? -1 : std::min(D, MAX_SH_DEGREE);
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_FILTER3D_H_INCLUDED
+#define CUDA_RASTERIZER_FILTER3D_H_INCLUDED
+
+#include <math.h>
+
+// Visibility test of the 3D filter, shared by the CUDA and host rasterizers.
+#ifdef __CUDACC__
+#define FILTER3D_FUNC __host__ __device__ __forceinline__
+#else
+#define FILTER3D_FUNC inline
+#endif
+
+// A camera is described by FILTER3D_CAMERA_STRIDE floats: the rotation R
+// (row-major, applied as p^T R like the Python camera), the translation T,
+// focal_x, focal_y, image width and image height.
+#define FILTER3D_CAMERA_STRIDE 16
+// Distance of points that no camera sees
+#define FILTER3D_MAX_DISTANCE 100000.0f
+
+// Depth of a point in a camera if it lies in front of the near plane and
+// projects into the image enlarged by 15% per side (the tangent space
+// filtering of the paper), a negative value otherwise.
+FILTER3D_FUNC float filter3DDepth(float px, float py, float pz, const float* cam)
+{
+	const float x = px * cam[0] + py * cam[3] + pz * cam[6] + cam[9];
+	const float y = px * cam[1] + py * cam[4] + pz * cam[7] + cam[10];
+	const float z = px * cam[2] + py * cam[5] + pz * cam[8] + cam[11];
+
+	const float zc = fmaxf(z, 0.001f);
+	const float sx = x / zc * cam[12] + cam[14] * 0.5f;
+	const float sy = y / zc * cam[13] + cam[15] * 0.5f;
+
+	const bool valid = z > 0.2f &&
+		sx >= -0.15f * cam[14] && sx <= 1.15f * cam[14] &&
+		sy >= -0.15f * cam[15] && sy <= 1.15f * cam[15];
+	return valid ? z : -1.0f;
+}
+
+#endif
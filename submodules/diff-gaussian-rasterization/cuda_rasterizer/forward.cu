@@ -11,13 +11,28 @@
 
 #include "forward.h"
 #include "auxiliary.h"
+#include "tile_overlap.h"
+#include "dispatch.h"
 #include <cooperative_groups.h>
 #include <cooperative_groups/reduce.h>
 namespace cg = cooperative_groups;
 
+// Coefficients of a compressed Gaussian: band 0 decoded from half, the
+// higher bands in its codebook entry. Indices are constant after
+// unrolling, so the selection is resolved at compile time.
+struct CodebookSH
+{
+	glm::vec3 dc;
+	const glm::vec3* rest;
+	__device__ glm::vec3 operator[](int i) const { return i == 0 ? dc : rest[i - 1]; }
+};
+
 // Forward method for converting the input spherical harmonics
-// coefficients of each Gaussian to a simple RGB color.
-__device__ glm::vec3 computeColorFromSH(int idx, int deg, int max_coeffs, const glm::vec3* means, glm::vec3 campos, const float* shs, bool* clamped)
+// coefficients of each Gaussian to a simple RGB color. The degree is a
+// template argument, the bands above it are compiled out. sh indexes the
+// coefficients of the Gaussian (a pointer or CodebookSH).
+template<int deg, typename SH>
+__device__ glm::vec3 computeColorFromSH(int idx, const glm::vec3* means, glm::vec3 campos, const SH sh, bool* clamped)
 {
 	// The implementation is loosely based on code for 
 	// "Differentiable Point-Based Radiance Fields for 
@@ -26,7 +41,6 @@ __device__ glm::vec3 computeColorFromSH(int idx, int deg, int max_coeffs, const
 	glm::vec3 dir = pos - campos;
 	dir = dir / glm::length(dir);
 
-	glm::vec3* sh = ((glm::vec3*)shs) + idx * max_coeffs;
 	glm::vec3 result = SH_C0 * sh[0];
 
 	if (deg > 0)
@@ -163,8 +177,26 @@ __device__ void computeCov3D(const glm::vec3 scale, float mod, const glm::vec4 r
 }
 
 // Perform initial steps for each Gaussian prior to rasterization.
-template<int C>
-__global__ void preprocessCUDA(int P, int D, int M,
+// Convert scale and rotation of every Gaussian to its 3D covariance.
+// Used when several views share the view-independent part of the
+// preprocessing step.
+__global__ void computeCov3DCUDA(int P,
+	const glm::vec3* scales,
+	const float scale_modifier,
+	const glm::vec4* rotations,
+	float* cov3Ds)
+{
+	auto idx = cg::this_grid().thread_rank();
+	if (idx >= P)
+		return;
+	computeCov3D(scales[idx], scale_modifier, rotations[idx], cov3Ds + idx * 6);
+}
+
+// D is the SH degree, -1 if colors are precomputed. If
+// compressed.sh_index is set, the attributes are decoded from compressed
+// (see compressed.h), which reads about a sixth of the bytes.
+template<int D>
+__global__ void preprocessCUDA(int P, int M,
 	const float* orig_points,
 	const glm::vec3* scales,
 	const float scale_modifier,
@@ -173,7 +205,6 @@ __global__ void preprocessCUDA(int P, int D, int M,
 	const float* shs,
 	bool* clamped,
 	const float* cov3D_precomp,
-	const float* colors_precomp,
 	const float* viewmatrix,
 	const float* projmatrix,
 	const glm::vec3* cam_pos,
@@ -189,7 +220,8 @@ __global__ void preprocessCUDA(int P, int D, int M,
 	float4* conic_opacity,
 	const dim3 grid,
 	uint32_t* tiles_touched,
-	bool prefiltered)
+	bool prefiltered,
+	const CompressedGaussians compressed)
 {
 	auto idx = cg::this_grid().thread_rank();
 	if (idx >= P)
@@ -218,6 +250,15 @@ __global__ void preprocessCUDA(int P, int D, int M,
 	{
 		cov3D = cov3D_precomp + idx * 6;
 	}
+	else if (compressed.sh_index != nullptr)
+	{
+		glm::vec3 scale;
+		glm::vec4 rotation;
+		decodeHalves(compressed.scales + 3 * idx, 3, &scale.x);
+		decodeHalves(compressed.rotations + 4 * idx, 4, &rotation.x);
+		computeCov3D(scale, scale_modifier, rotation, cov3Ds + idx * 6);
+		cov3D = cov3Ds + idx * 6;
+	}
 	else
 	{
 		computeCov3D(scales[idx], scale_modifier, rotations[idx], cov3Ds + idx * 6);
@@ -250,12 +291,21 @@ __global__ void preprocessCUDA(int P, int D, int M,
 
 	// If colors have been precomputed, use them, otherwise convert
 	// spherical harmonics coefficients to RGB color.
-	if (colors_precomp == nullptr)
+	if (D >= 0)
 	{
-		glm::vec3 result = computeColorFromSH(idx, D, M, (glm::vec3*)orig_points, *cam_pos, shs, clamped);
-		rgb[idx * C + 0] = result.x;
-		rgb[idx * C + 1] = result.y;
-		rgb[idx * C + 2] = result.z;
+		glm::vec3 result;
+		if (compressed.sh_index != nullptr)
+		{
+			CodebookSH sh;
+			decodeHalves(compressed.features_dc + 3 * idx, 3, &sh.dc.x);
+			sh.rest = (const glm::vec3*)compressed.sh_codebook + (size_t)compressed.sh_index[idx] * (M - 1);
+			result = computeColorFromSH<D>(idx, (glm::vec3*)orig_points, *cam_pos, sh, clamped);
+		}
+		else
+			result = computeColorFromSH<D>(idx, (glm::vec3*)orig_points, *cam_pos, (const glm::vec3*)shs + idx * M, clamped);
+		rgb[idx * NUM_CHANNELS + 0] = result.x;
+		rgb[idx * NUM_CHANNELS + 1] = result.y;
+		rgb[idx * NUM_CHANNELS + 2] = result.z;
 	}
 
 	// Store some useful helper data for the next steps.
@@ -263,17 +313,28 @@ __global__ void preprocessCUDA(int P, int D, int M,
 	radii[idx] = my_radius;
 	points_xy_image[idx] = point_image;
 	// Inverse 2D covariance and opacity neatly pack into one float4
-	conic_opacity[idx] = { conic.x, conic.y, conic.z, opacities[idx] * cov.w };
-	tiles_touched[idx] = (rect_max.y - rect_min.y) * (rect_max.x - rect_min.x);
+	const float opacity = (compressed.sh_index != nullptr ? halfToFloat(compressed.opacities[idx]) : opacities[idx]) * cov.w;
+	conic_opacity[idx] = { conic.x, conic.y, conic.z, opacity };
+
+	// Only tiles where the Gaussian can pass the alpha threshold are
+	// binned. This may be none: the radius stays set either way, as it
+	// also reports visibility to the densification statistics.
+	uint32_t touched = 0;
+	forEachOverlappedTile(point_image.x, point_image.y, conic.x, conic.y, conic.z, opacity,
+		rect_min.x, rect_min.y, rect_max.x, rect_max.y, [&](int, int) { touched++; });
+	tiles_touched[idx] = touched;
 }
 
 // Main rasterization method. Collaboratively works on one tile per
 // block, each thread treats one pixel. Alternates between fetching 
-// and rasterizing data.
+// and rasterizing data. Contribution statistics, if requested, are
+// accumulated with atomics per blended pixel. Blocks are launched
+// along tile_order, heaviest tiles first (see orderTiles).
 template <uint32_t CHANNELS>
 __global__ void __launch_bounds__(BLOCK_X * BLOCK_Y)
 renderCUDA(
 	const uint2* __restrict__ ranges,
+	const uint32_t* __restrict__ tile_order,
 	const uint32_t* __restrict__ point_list,
 	int W, int H,
 	const float2* __restrict__ subpixel_offset,
@@ -283,12 +344,14 @@ renderCUDA(
 	float* __restrict__ final_T,
 	uint32_t* __restrict__ n_contrib,
 	const float* __restrict__ bg_color,
-	float* __restrict__ out_color)
+	float* __restrict__ out_color,
+	const GaussianContributions contributions)
 {
 	// Identify current tile and associated min/max pixel range.
 	auto block = cg::this_thread_block();
 	uint32_t horizontal_blocks = (W + BLOCK_X - 1) / BLOCK_X;
-	uint2 pix_min = { block.group_index().x * BLOCK_X, block.group_index().y * BLOCK_Y };
+	uint32_t tile = tile_order[block.group_index().x];
+	uint2 pix_min = { tile % horizontal_blocks * BLOCK_X, tile / horizontal_blocks * BLOCK_Y };
 	uint2 pix_max = { min(pix_min.x + BLOCK_X, W), min(pix_min.y + BLOCK_Y , H) };
 	uint2 pix = { pix_min.x + block.thread_index().x, pix_min.y + block.thread_index().y };
 	uint32_t pix_id = W * pix.y + pix.x;
@@ -308,7 +371,7 @@ renderCUDA(
 		// }
 	}
 	// Load start/end range of IDs to process in bit sorted list.
-	uint2 range = ranges[block.group_index().y * horizontal_blocks + block.group_index().x];
+	uint2 range = ranges[tile];
 	const int rounds = ((range.y - range.x + BLOCK_SIZE - 1) / BLOCK_SIZE);
 	int toDo = range.y - range.x;
 
@@ -375,6 +438,16 @@ renderCUDA(
 			for (int ch = 0; ch < CHANNELS; ch++)
 				C[ch] += features[collected_id[j] * CHANNELS + ch] * alpha * T;
 
+			if (contributions.max_weight != nullptr)
+			{
+				// Weights are positive, so their bits order like integers
+				const int id = collected_id[j];
+				const float weight = alpha * T;
+				atomicMax((int*)&contributions.max_weight[id], __float_as_int(weight));
+				atomicAdd(&contributions.weight_sum[id], weight);
+				atomicAdd(&contributions.pixels[id], 1.0f);
+			}
+
 			T = test_T;
 
 			// Keep track of last range entry to update this
@@ -394,22 +467,128 @@ renderCUDA(
 	}
 }
 
+// Kernel launches of every supported channel count / SH degree
+namespace
+{
+	struct RenderLaunch
+	{
+		template<int C>
+		static void run(
+			const dim3 grid, dim3 block,
+			const uint2* ranges,
+			const uint32_t* tile_order,
+			const uint32_t* point_list,
+			int W, int H,
+			const float2* subpixel_offset,
+			const float2* means2D,
+			const float* colors,
+			const float4* conic_opacity,
+			float* final_T,
+			uint32_t* n_contrib,
+			const float* bg_color,
+			float* out_color,
+			const GaussianContributions contributions)
+		{
+			renderCUDA<C> << <grid.x * grid.y, block >> > (
+				ranges,
+				tile_order,
+				point_list,
+				W, H,
+				subpixel_offset,
+				means2D,
+				colors,
+				conic_opacity,
+				final_T,
+				n_contrib,
+				bg_color,
+				out_color,
+				contributions);
+		}
+	};
+
+	struct PreprocessLaunch
+	{
+		template<int D>
+		static void run(int P, int M,
+			const float* means3D,
+			const glm::vec3* scales,
+			const float scale_modifier,
+			const glm::vec4* rotations,
+			const float* opacities,
+			const float* shs,
+			bool* clamped,
+			const float* cov3D_precomp,
+			const float* viewmatrix,
+			const float* projmatrix,
+			const glm::vec3* cam_pos,
+			const int W, int H,
+			const float focal_x, float focal_y,
+			const float tan_fovx, float tan_fovy,
+			const float kernel_size,
+			int* radii,
+			float2* means2D,
+			float* depths,
+			float* cov3Ds,
+			float* rgb,
+			float4* conic_opacity,
+			const dim3 grid,
+			uint32_t* tiles_touched,
+			bool prefiltered,
+			const CompressedGaussians compressed)
+		{
+			preprocessCUDA<D> << <(P + 255) / 256, 256 >> > (
+				P, M,
+				means3D,
+				scales,
+				scale_modifier,
+				rotations,
+				opacities,
+				shs,
+				clamped,
+				cov3D_precomp,
+				viewmatrix,
+				projmatrix,
+				cam_pos,
+				W, H,
+				tan_fovx, tan_fovy,
+				focal_x, focal_y,
+				kernel_size,
+				radii,
+				means2D,
+				depths,
+				cov3Ds,
+				rgb,
+				conic_opacity,
+				grid,
+				tiles_touched,
+				prefiltered,
+				compressed
+				);
+		}
+	};
+}
+
 void FORWARD::render(
 	const dim3 grid, dim3 block,
 	const uint2* ranges,
+	const uint32_t* tile_order,
 	const uint32_t* point_list,
 	int W, int H,
 	const float2* subpixel_offset,
 	const float2* means2D,
 	const float* colors,
+	const int channels,
 	const float4* conic_opacity,
 	float* final_T,
 	uint32_t* n_contrib,
 	const float* bg_color,
-	float* out_color)
+	float* out_color,
+	const GaussianContributions contributions)
 {
-	renderCUDA<NUM_CHANNELS> << <grid, block >> > (
+	dispatchChannels<RenderLaunch>(channels,
+		grid, block,
 		ranges,
+		tile_order,
 		point_list,
 		W, H,
 		subpixel_offset,
@@ -419,7 +598,22 @@ void FORWARD::render(
 		final_T,
 		n_contrib,
 		bg_color,
-		out_color);
+		out_color,
+		contributions);
+}
+
+void FORWARD::computeCov3D(int P,
+	const glm::vec3* scales,
+	const float scale_modifier,
+	const glm::vec4* rotations,
+	float* cov3Ds)
+{
+	computeCov3DCUDA << <(P + 255) / 256, 256 >> > (
+		P,
+		scales,
+		scale_modifier,
+		rotations,
+		cov3Ds);
 }
 
 void FORWARD::preprocess(int P, int D, int M,
@@ -431,7 +625,6 @@ void FORWARD::preprocess(int P, int D, int M,
 	const float* shs,
 	bool* clamped,
 	const float* cov3D_precomp,
-	const float* colors_precomp,
 	const float* viewmatrix,
 	const float* projmatrix,
 	const glm::vec3* cam_pos,
@@ -447,10 +640,11 @@ void FORWARD::preprocess(int P, int D, int M,
 	float4* conic_opacity,
 	const dim3 grid,
 	uint32_t* tiles_touched,
-	bool prefiltered)
+	bool prefiltered,
+	const CompressedGaussians compressed)
 {
-	preprocessCUDA<NUM_CHANNELS> << <(P + 255) / 256, 256 >> > (
-		P, D, M,
+	dispatchSHDegree<PreprocessLaunch>(D,
+		P, M,
 		means3D,
 		scales,
 		scale_modifier,
@@ -459,13 +653,12 @@ void FORWARD::preprocess(int P, int D, int M,
 		shs,
 		clamped,
 		cov3D_precomp,
-		colors_precomp,
-		viewmatrix, 
+		viewmatrix,
 		projmatrix,
 		cam_pos,
 		W, H,
-		tan_fovx, tan_fovy,
 		focal_x, focal_y,
+		tan_fovx, tan_fovy,
 		kernel_size,
 		radii,
 		means2D,
@@ -475,6 +668,6 @@ void FORWARD::preprocess(int P, int D, int M,
 		conic_opacity,
 		grid,
 		tiles_touched,
-		prefiltered
-		);
+		prefiltered,
+		compressed);
 }
@@ -17,10 +17,14 @@
 #include "device_launch_parameters.h"
 #define GLM_FORCE_CUDA
 #include <glm/glm.hpp>
+#include "contribution.h"
+#include "compressed.h"
 
 namespace FORWARD
 {
 	// Perform initial steps for each Gaussian prior to rasterization.
+	// D is the SH degree of the colors, -1 if they are precomputed.
+	// Attributes are decoded from compressed if its sh_index is set.
 	void preprocess(int P, int D, int M,
 		const float* orig_points,
 		const glm::vec3* scales,
@@ -30,7 +34,6 @@ namespace FORWARD
 		const float* shs,
 		bool* clamped,
 		const float* cov3D_precomp,
-		const float* colors_precomp,
 		const float* viewmatrix,
 		const float* projmatrix,
 		const glm::vec3* cam_pos,
@@ -46,22 +49,37 @@ namespace FORWARD
 		float4* conic_opacity,
 		const dim3 grid,
 		uint32_t* tiles_touched,
-		bool prefiltered);
+		bool prefiltered,
+		const CompressedGaussians compressed);
 
-	// Main rasterization method.
+	// Compute the 3D covariance of each Gaussian from scale and rotation.
+	void computeCov3D(int P,
+		const glm::vec3* scales,
+		const float scale_modifier,
+		const glm::vec4* rotations,
+		float* cov3Ds);
+
+	// Main rasterization method, features holds channels values per
+	// Gaussian. Contribution statistics are accumulated into
+	// contributions unless its arrays are null, see contribution.h.
+	// One block is launched per tile of grid, in the order of
+	// tile_order (a permutation of the tile indices).
 	void render(
 		const dim3 grid, dim3 block,
 		const uint2* ranges,
+		const uint32_t* tile_order,
 		const uint32_t* point_list,
 		int W, int H,
 		const float2* subpixel_offset,
 		const float2* points_xy_image,
 		const float* features,
+		const int channels,
 		const float4* conic_opacity,
 		float* final_T,
 		uint32_t* n_contrib,
 		const float* bg_color,
-		float* out_color);
+		float* out_color,
+		const GaussianContributions contributions);
 }
 
 
@@ -14,6 +14,10 @@
 
 #include <vector>
 #include <functional>
+#include "stats.h"
+#include "contribution.h"
+#include "coherent_sort.h"
+#include "compressed.h"
 
 namespace CudaRasterizer
 {
@@ -28,11 +32,32 @@ namespace CudaRasterizer
 			float* projmatrix,
 			bool* present);
 
+		// View-independent part of preprocessing: 3D covariances from
+		// scales and rotations, e.g., to be shared by several views.
+		static void computeCov3D(
+			int P,
+			const float* scales,
+			const float scale_modifier,
+			const float* rotations,
+			float* cov3Ds);
+
+		// Minimum depth of every point over all cameras that see it (see
+		// filter3d.h for the camera layout) for the mip-splatting 3D filter.
+		// Points that no camera sees get FILTER3D_MAX_DISTANCE and
+		// valid = false.
+		static void computeFilter3D(
+			int P, int C,
+			const float* means3D,
+			const float* cameras,
+			float* distance,
+			bool* valid);
+
 		static int forward(
 			std::function<char* (size_t)> geometryBuffer,
 			std::function<char* (size_t)> binningBuffer,
 			std::function<char* (size_t)> imageBuffer,
 			const int P, int D, int M,
+			const int channels,
 			const float* background,
 			const int width, int height,
 			const float* means3D,
@@ -52,10 +77,15 @@ namespace CudaRasterizer
 			const bool prefiltered,
 			float* out_color,
 			int* radii = nullptr,
-			bool debug = false);
+			bool debug = false,
+			RasterizerStats* stats = nullptr,
+			GaussianContributions* contributions = nullptr,
+			CoherentSort* coherent = nullptr,
+			const CompressedGaussians* compressed = nullptr);
 
 		static void backward(
 			const int P, int D, int M, int R,
+			const int channels,
 			const float* background,
 			const int width, int height,
 			const float* means3D,
@@ -85,7 +115,8 @@ namespace CudaRasterizer
 			float* dL_dsh,
 			float* dL_dscale,
 			float* dL_drot,
-			bool debug);
+			bool debug,
+			RasterizerStats* stats = nullptr);
 	};
 };
 
@@ -14,6 +14,8 @@
 #include <fstream>
 #include <algorithm>
 #include <numeric>
+#include <cstdint>
+#include <vector>
 #include <cuda.h>
 #include "cuda_runtime.h"
 #include "device_launch_parameters.h"
@@ -27,6 +29,10 @@
 namespace cg = cooperative_groups;
 
 #include "auxiliary.h"
+#include "filter3d.h"
+#include "tile_overlap.h"
+#include "dispatch.h"
+#include "coherent_sort.h"
 #include "forward.h"
 #include "backward.h"
 
@@ -65,55 +71,256 @@ __global__ void checkFrustum(int P,
 	present[idx] = in_frustum(idx, orig_points, viewmatrix, projmatrix, false, p_view);
 }
 
+// Minimum depth of each point over all cameras that see it. The cameras
+// are staged through shared memory in groups of FILTER3D_BLOCK_CAMERAS.
+#define FILTER3D_BLOCK_CAMERAS 64
+__global__ void filter3DDistance(int P, int C,
+	const float* orig_points,
+	const float* cameras,
+	float* distance,
+	bool* valid)
+{
+	auto block = cg::this_thread_block();
+	auto idx = cg::this_grid().thread_rank();
+	__shared__ float collected[FILTER3D_BLOCK_CAMERAS * FILTER3D_CAMERA_STRIDE];
+
+	float px = 0.0f, py = 0.0f, pz = 0.0f;
+	if (idx < P)
+	{
+		px = orig_points[3 * idx];
+		py = orig_points[3 * idx + 1];
+		pz = orig_points[3 * idx + 2];
+	}
+
+	float d = FILTER3D_MAX_DISTANCE;
+	bool seen = false;
+	for (int first = 0; first < C; first += FILTER3D_BLOCK_CAMERAS)
+	{
+		const int n = min(FILTER3D_BLOCK_CAMERAS, C - first);
+		block.sync();
+		for (int i = block.thread_rank(); i < n * FILTER3D_CAMERA_STRIDE; i += block.size())
+			collected[i] = cameras[first * FILTER3D_CAMERA_STRIDE + i];
+		block.sync();
+
+		for (int c = 0; c < n; c++)
+		{
+			const float z = filter3DDepth(px, py, pz, collected + c * FILTER3D_CAMERA_STRIDE);
+			if (z > 0.0f)
+			{
+				d = fminf(d, z);
+				seen = true;
+			}
+		}
+	}
+
+	if (idx < P)
+	{
+		distance[idx] = d;
+		valid[idx] = seen;
+	}
+}
+
 // Generates one key/value pair for all Gaussian / tile overlaps. 
 // Run once per Gaussian (1:N mapping).
 __global__ void duplicateWithKeys(
 	int P,
 	const float2* points_xy,
 	const float* depths,
+	const float4* conic_opacity,
 	const uint32_t* offsets,
 	uint64_t* gaussian_keys_unsorted,
 	uint32_t* gaussian_values_unsorted,
 	int* radii,
-	dim3 grid)
+	dim3 grid,
+	const uint32_t* order)
 {
-	auto idx = cg::this_grid().thread_rank();
-	if (idx >= P)
+	// Gaussians are visited in the given order, if any, which the
+	// offsets follow as well
+	auto rank = cg::this_grid().thread_rank();
+	if (rank >= P)
 		return;
+	const uint32_t idx = order != nullptr ? order[rank] : rank;
 
 	// Generate no key/value pair for invisible Gaussians
 	if (radii[idx] > 0)
 	{
 		// Find this Gaussian's offset in buffer for writing keys/values.
-		uint32_t off = (idx == 0) ? 0 : offsets[idx - 1];
+		uint32_t off = (rank == 0) ? 0 : offsets[rank - 1];
+		const uint32_t end = offsets[rank];
 		uint2 rect_min, rect_max;
 
 		getRect(points_xy[idx], radii[idx], rect_min, rect_max, grid);
 
-		// For each tile that the bounding rect overlaps, emit a 
+		// For each tile the Gaussian was counted in by preprocess, emit a 
 		// key/value pair. The key is |  tile ID  |      depth      |,
 		// and the value is the ID of the Gaussian. Sorting the values 
 		// with this key yields Gaussian IDs in a list, such that they
 		// are first sorted by tile and then by depth. 
-		for (int y = rect_min.y; y < rect_max.y; y++)
+		const uint32_t depth_bits = *((uint32_t*)&depths[idx]);
+		const float2 xy = points_xy[idx];
+		const float4 con_o = conic_opacity[idx];
+		forEachOverlappedTile(xy.x, xy.y, con_o.x, con_o.y, con_o.z, con_o.w,
+			rect_min.x, rect_min.y, rect_max.x, rect_max.y, [&](int x, int y)
+		{
+			// Never write past the slots preprocess counted
+			if (off == end)
+				return;
+			uint64_t key = y * grid.x + x;
+			key <<= 32;
+			key |= depth_bits;
+			gaussian_keys_unsorted[off] = key;
+			gaussian_values_unsorted[off] = idx;
+			off++;
+		});
+
+		// Slots of tiles that preprocess counted but were not emitted
+		// again (contraction may differ between the kernels) get a key
+		// past the last tile: they sort behind all ranges and are never
+		// rendered
+		for (; off < end; off++)
+		{
+			gaussian_keys_unsorted[off] = ((uint64_t)(grid.x * grid.y) << 32) | depth_bits;
+			gaussian_values_unsorted[off] = idx;
+		}
+	}
+}
+
+// Keys | depth | id | of all Gaussians in the order given by ids, or in
+// index order without one. Visible Gaussians use the depths of
+// preprocess, so that they are ordered exactly as by the full sort.
+__global__ void depthKeys(
+	int P,
+	const uint32_t* ids,
+	const float* means3D,
+	const float* viewmatrix,
+	const float* depths,
+	const int* radii,
+	uint64_t* keys)
+{
+	auto k = cg::this_grid().thread_rank();
+	if (k >= P)
+		return;
+	const uint32_t id = ids != nullptr ? ids[k] : k;
+	const float depth = radii[id] > 0 ? depths[id] : viewDepth(means3D + 3 * id, viewmatrix);
+	keys[k] = depthKey(depth, id);
+}
+
+// Bitonic sort of the window of COHERENT_WINDOW keys starting at
+// offset + blockIdx.x * COHERENT_WINDOW in shared memory. Keys past P are
+// padded with the largest key and not written back.
+__global__ void sortWindows(int P, int offset, uint64_t* keys)
+{
+	__shared__ uint64_t window[COHERENT_WINDOW];
+	const int base = offset + blockIdx.x * COHERENT_WINDOW;
+	for (int i = threadIdx.x; i < COHERENT_WINDOW; i += blockDim.x)
+		window[i] = base + i < P ? keys[base + i] : UINT64_MAX;
+	__syncthreads();
+
+	for (int k = 2; k <= COHERENT_WINDOW; k <<= 1)
+		for (int j = k >> 1; j > 0; j >>= 1)
 		{
-			for (int x = rect_min.x; x < rect_max.x; x++)
+			for (int i = threadIdx.x; i < COHERENT_WINDOW; i += blockDim.x)
 			{
-				uint64_t key = y * grid.x + x;
-				key <<= 32;
-				key |= *((uint32_t*)&depths[idx]);
-				gaussian_keys_unsorted[off] = key;
-				gaussian_values_unsorted[off] = idx;
-				off++;
+				const int partner = i ^ j;
+				if (partner > i)
+				{
+					const uint64_t a = window[i], b = window[partner];
+					if ((a > b) == ((i & k) == 0))
+					{
+						window[i] = b;
+						window[partner] = a;
+					}
+				}
 			}
+			__syncthreads();
 		}
+
+	for (int i = threadIdx.x; i < COHERENT_WINDOW; i += blockDim.x)
+		if (base + i < P)
+			keys[base + i] = window[i];
+}
+
+// Flags keys that are out of order
+__global__ void checkSorted(int P, const uint64_t* keys, int* unsorted)
+{
+	auto k = cg::this_grid().thread_rank();
+	if (k + 1 < P && keys[k] > keys[k + 1])
+		*unsorted = 1;
+}
+
+__global__ void keysToOrder(int P, const uint64_t* keys, uint32_t* order)
+{
+	auto k = cg::this_grid().thread_rank();
+	if (k < P)
+		order[k] = (uint32_t)keys[k];
+}
+
+__global__ void gatherTiles(int P, const uint32_t* order, const uint32_t* tiles_touched, uint32_t* tiles_in_order)
+{
+	auto k = cg::this_grid().thread_rank();
+	if (k < P)
+		tiles_in_order[k] = tiles_touched[order[k]];
+}
+
+// Depth order of the Gaussians (their ids from near to far) in the order
+// memory of coherent. The stored order of the previous frame is repaired
+// by sorting windows of COHERENT_WINDOW keys in shared memory, twice with
+// the windows shifted by half their size, which restores it as long as
+// no Gaussian moved by more than about half a window. The result is
+// checked, and the keys are sorted from scratch if it failed or the
+// frames are not coherent.
+static CudaRasterizer::OrderState depthOrder(
+	int P,
+	const float* means3D,
+	const float* viewmatrix,
+	const float* depths,
+	const int* radii,
+	CoherentSort& coherent,
+	bool debug)
+{
+	char* chunkptr = coherent.orderBuffer(CudaRasterizer::required<CudaRasterizer::OrderState>(P));
+	const char* memory = chunkptr;
+	CudaRasterizer::OrderState order = CudaRasterizer::OrderState::fromChunk(chunkptr, P);
+	const int blocks = (P + 255) / 256;
+
+	bool full_sort = true;
+	if (coherent.coherentWith(P, viewmatrix, memory))
+	{
+		depthKeys << <blocks, 256 >> > (P, order.order, means3D, viewmatrix, depths, radii, order.keys);
+		sortWindows << <(P + COHERENT_WINDOW - 1) / COHERENT_WINDOW, COHERENT_WINDOW / 2 >> > (P, 0, order.keys);
+		if (P > COHERENT_WINDOW / 2)
+			sortWindows << <(P - COHERENT_WINDOW / 2 + COHERENT_WINDOW - 1) / COHERENT_WINDOW, COHERENT_WINDOW / 2 >> > (P, COHERENT_WINDOW / 2, order.keys);
+		cudaMemset(order.unsorted, 0, sizeof(int));
+		checkSorted << <blocks, 256 >> > (P, order.keys, order.unsorted);
+		CHECK_CUDA(, debug)
+		int unsorted;
+		cudaMemcpy(&unsorted, order.unsorted, sizeof(int), cudaMemcpyDeviceToHost);
+		full_sort = unsorted != 0;
+		if (!full_sort)
+			keysToOrder << <blocks, 256 >> > (P, order.keys, order.order);
 	}
+	if (full_sort)
+	{
+		// Keys are in index order, so the stable sort by depth alone
+		// breaks ties by index as well
+		depthKeys << <blocks, 256 >> > (P, nullptr, means3D, viewmatrix, depths, radii, order.keys);
+		CHECK_CUDA(cub::DeviceRadixSort::SortKeys(
+			order.sorting_space, order.sorting_size,
+			order.keys, order.keys_sorted,
+			P, 32, 64), debug)
+		keysToOrder << <blocks, 256 >> > (P, order.keys_sorted, order.order);
+	}
+	CHECK_CUDA(, debug)
+
+	coherent.remember(P, viewmatrix, memory, full_sort);
+	return order;
 }
 
 // Check keys to see if it is at the start/end of one tile's range in 
 // the full sorted list. If yes, write start/end of this tile. 
-// Run once per instanced (duplicated) Gaussian ID.
-__global__ void identifyTileRanges(int L, uint64_t* point_list_keys, uint2* ranges)
+// Run once per instanced (duplicated) Gaussian ID. Unplaced instances
+// (tile num_tiles, see duplicateWithKeys) get no range.
+__global__ void identifyTileRanges(int L, uint32_t num_tiles, uint64_t* point_list_keys, uint2* ranges)
 {
 	auto idx = cg::this_grid().thread_rank();
 	if (idx >= L)
@@ -123,20 +330,67 @@ __global__ void identifyTileRanges(int L, uint64_t* point_list_keys, uint2* rang
 	uint64_t key = point_list_keys[idx];
 	uint32_t currtile = key >> 32;
 	if (idx == 0)
-		ranges[currtile].x = 0;
+	{
+		if (currtile < num_tiles)
+			ranges[currtile].x = 0;
+	}
 	else
 	{
 		uint32_t prevtile = point_list_keys[idx - 1] >> 32;
 		if (currtile != prevtile)
 		{
 			ranges[prevtile].y = idx;
-			ranges[currtile].x = idx;
+			if (currtile < num_tiles)
+				ranges[currtile].x = idx;
 		}
 	}
-	if (idx == L - 1)
+	if (idx == L - 1 && currtile < num_tiles)
 		ranges[currtile].y = L;
 }
 
+// Tiles are ordered by the bit length of their range, which buckets them
+// like the tile histogram of RasterizerStats.
+static constexpr int TILE_BUCKETS = 32;
+
+__device__ inline int tileBucket(uint2 range)
+{
+	return min(32 - __clz(range.y - range.x), TILE_BUCKETS - 1);
+}
+
+__global__ void countTileBuckets(int num_tiles, const uint2* ranges, uint32_t* counts)
+{
+	auto idx = cg::this_grid().thread_rank();
+	if (idx >= num_tiles)
+		return;
+	atomicAdd(&counts[tileBucket(ranges[idx])], 1);
+}
+
+// Scatter the tiles into tile_order, longest bucket first. Within a
+// bucket the order is arbitrary, which the blending does not depend on.
+__global__ void scatterTileBuckets(int num_tiles, const uint2* ranges, const uint32_t* counts, uint32_t* cursors, uint32_t* tile_order)
+{
+	auto idx = cg::this_grid().thread_rank();
+	if (idx >= num_tiles)
+		return;
+	const int bucket = tileBucket(ranges[idx]);
+	uint32_t offset = 0;
+	for (int b = bucket + 1; b < TILE_BUCKETS; b++)
+		offset += counts[b];
+	tile_order[offset + atomicAdd(&cursors[bucket], 1)] = idx;
+}
+
+// Heaviest tiles first: tiles near dense geometry hold 10-100x the
+// Gaussians of the median one, and a heavy tile whose block starts in
+// the last wave of the render launch sets the frame time alone. Started
+// first, it runs alongside the light tiles that the hardware block
+// scheduler keeps handing to the free multiprocessors.
+static void orderTiles(int num_tiles, const uint2* ranges, uint32_t* buckets, uint32_t* tile_order)
+{
+	cudaMemset(buckets, 0, 2 * TILE_BUCKETS * sizeof(uint32_t));
+	countTileBuckets << <(num_tiles + 255) / 256, 256 >> > (num_tiles, ranges, buckets);
+	scatterTileBuckets << <(num_tiles + 255) / 256, 256 >> > (num_tiles, ranges, buckets, buckets + TILE_BUCKETS, tile_order);
+}
+
 // Mark Gaussians as visible/invisible, based on view frustum testing
 void CudaRasterizer::Rasterizer::markVisible(
 	int P,
@@ -152,6 +406,36 @@ void CudaRasterizer::Rasterizer::markVisible(
 		present);
 }
 
+void CudaRasterizer::Rasterizer::computeFilter3D(
+	int P, int C,
+	const float* means3D,
+	const float* cameras,
+	float* distance,
+	bool* valid)
+{
+	filter3DDistance << <(P + 255) / 256, 256 >> > (
+		P, C,
+		means3D,
+		cameras,
+		distance,
+		valid);
+}
+
+// Compute 3D covariances once for all Gaussians
+void CudaRasterizer::Rasterizer::computeCov3D(
+	int P,
+	const float* scales,
+	const float scale_modifier,
+	const float* rotations,
+	float* cov3Ds)
+{
+	FORWARD::computeCov3D(P,
+		(glm::vec3*)scales,
+		scale_modifier,
+		(glm::vec4*)rotations,
+		cov3Ds);
+}
+
 CudaRasterizer::GeometryState CudaRasterizer::GeometryState::fromChunk(char*& chunk, size_t P)
 {
 	GeometryState geom;
@@ -163,7 +447,20 @@ CudaRasterizer::GeometryState CudaRasterizer::GeometryState::fromChunk(char*& ch
 	obtain(chunk, geom.conic_opacity, P, 128);
 	obtain(chunk, geom.rgb, P * 3, 128);
 	obtain(chunk, geom.tiles_touched, P, 128);
-	cub::DeviceScan::InclusiveSum(nullptr, geom.scan_size, geom.tiles_touched, geom.tiles_touched, P);
+	// The temporary storage size only depends on P (and the device), so
+	// the last query is remembered: sizing and carving up a buffer for
+	// the same workload does not ask cub again.
+	static thread_local size_t cached_P = SIZE_MAX, cached_scan_size = 0;
+	static thread_local int cached_device = -1;
+	int device;
+	cudaGetDevice(&device);
+	if (P != cached_P || device != cached_device)
+	{
+		cub::DeviceScan::InclusiveSum(nullptr, cached_scan_size, geom.tiles_touched, geom.tiles_touched, P);
+		cached_P = P;
+		cached_device = device;
+	}
+	geom.scan_size = cached_scan_size;
 	obtain(chunk, geom.scanning_space, geom.scan_size, 128);
 	obtain(chunk, geom.point_offsets, P, 128);
 	return geom;
@@ -175,6 +472,8 @@ CudaRasterizer::ImageState CudaRasterizer::ImageState::fromChunk(char*& chunk, s
 	obtain(chunk, img.accum_alpha, N, 128);
 	obtain(chunk, img.n_contrib, N, 128);
 	obtain(chunk, img.ranges, N, 128);
+	obtain(chunk, img.tile_order, N, 128);
+	obtain(chunk, img.tile_buckets, 2 * TILE_BUCKETS, 128);
 	return img;
 }
 
@@ -185,14 +484,51 @@ CudaRasterizer::BinningState CudaRasterizer::BinningState::fromChunk(char*& chun
 	obtain(chunk, binning.point_list_unsorted, P, 128);
 	obtain(chunk, binning.point_list_keys, P, 128);
 	obtain(chunk, binning.point_list_keys_unsorted, P, 128);
-	cub::DeviceRadixSort::SortPairs(
-		nullptr, binning.sorting_size,
-		binning.point_list_keys_unsorted, binning.point_list_keys,
-		binning.point_list_unsorted, binning.point_list, P);
+	// Same as for the scan in GeometryState::fromChunk.
+	static thread_local size_t cached_P = SIZE_MAX, cached_sorting_size = 0;
+	static thread_local int cached_device = -1;
+	int device;
+	cudaGetDevice(&device);
+	if (P != cached_P || device != cached_device)
+	{
+		cub::DeviceRadixSort::SortPairs(
+			nullptr, cached_sorting_size,
+			binning.point_list_keys_unsorted, binning.point_list_keys,
+			binning.point_list_unsorted, binning.point_list, P);
+		cached_P = P;
+		cached_device = device;
+	}
+	binning.sorting_size = cached_sorting_size;
 	obtain(chunk, binning.list_sorting_space, binning.sorting_size, 128);
 	return binning;
 }
 
+CudaRasterizer::OrderState CudaRasterizer::OrderState::fromChunk(char*& chunk, size_t P)
+{
+	OrderState order;
+	obtain(chunk, order.order, P, 128);
+	obtain(chunk, order.keys, P, 128);
+	obtain(chunk, order.keys_sorted, P, 128);
+	obtain(chunk, order.tiles_touched, P, 128);
+	obtain(chunk, order.unsorted, 1, 128);
+	// Same as for the scan in GeometryState::fromChunk.
+	static thread_local size_t cached_P = SIZE_MAX, cached_sorting_size = 0;
+	static thread_local int cached_device = -1;
+	int device;
+	cudaGetDevice(&device);
+	if (P != cached_P || device != cached_device)
+	{
+		cub::DeviceRadixSort::SortKeys(
+			nullptr, cached_sorting_size,
+			order.keys, order.keys_sorted, P);
+		cached_P = P;
+		cached_device = device;
+	}
+	order.sorting_size = cached_sorting_size;
+	obtain(chunk, order.sorting_space, order.sorting_size, 128);
+	return order;
+}
+
 // Forward rendering procedure for differentiable rasterization
 // of Gaussians.
 int CudaRasterizer::Rasterizer::forward(
@@ -200,6 +536,7 @@ int CudaRasterizer::Rasterizer::forward(
 	std::function<char* (size_t)> binningBuffer,
 	std::function<char* (size_t)> imageBuffer,
 	const int P, int D, int M,
+	const int channels,
 	const float* background,
 	const int width, int height,
 	const float* means3D,
@@ -219,8 +556,21 @@ int CudaRasterizer::Rasterizer::forward(
 	const bool prefiltered,
 	float* out_color,
 	int* radii,
-	bool debug)
+	bool debug,
+	RasterizerStats* stats,
+	GaussianContributions* contributions,
+	CoherentSort* coherent,
+	const CompressedGaussians* compressed)
 {
+	// Stage boundaries are only synchronized when collecting stats
+	if (stats)
+		cudaDeviceSynchronize();
+	StageTimer timer;
+	auto lap = [&](double& ms) {
+		cudaDeviceSynchronize();
+		ms = timer.lap();
+	};
+
 	const float focal_y = height / (2.0f * tan_fovy);
 	const float focal_x = width / (2.0f * tan_fovx);
 
@@ -241,14 +591,15 @@ int CudaRasterizer::Rasterizer::forward(
 	char* img_chunkptr = imageBuffer(img_chunk_size);
 	ImageState imgState = ImageState::fromChunk(img_chunkptr, width * height);
 
-	if (NUM_CHANNELS != 3 && colors_precomp == nullptr)
+	if (channels != NUM_CHANNELS && colors_precomp == nullptr)
 	{
 		throw std::runtime_error("For non-RGB, provide precomputed Gaussian colors!");
 	}
+	const int sh_degree = shDegree(D, colors_precomp);
 
 	// Run preprocessing per-Gaussian (transformation, bounding, conversion of SHs to RGB)
 	CHECK_CUDA(FORWARD::preprocess(
-		P, D, M,
+		P, sh_degree, M,
 		means3D,
 		(glm::vec3*)scales,
 		scale_modifier,
@@ -257,7 +608,6 @@ int CudaRasterizer::Rasterizer::forward(
 		shs,
 		geomState.clamped,
 		cov3D_precomp,
-		colors_precomp,
 		viewmatrix, projmatrix,
 		(glm::vec3*)cam_pos,
 		width, height,
@@ -272,12 +622,17 @@ int CudaRasterizer::Rasterizer::forward(
 		geomState.conic_opacity,
 		tile_grid,
 		geomState.tiles_touched,
-		prefiltered
+		prefiltered,
+		compressed != nullptr ? *compressed : CompressedGaussians{}
 	), debug)
+	if (stats)
+		lap(stats->preprocess_ms);
 
 	// Compute prefix sum over full list of touched tile counts by Gaussians
 	// E.g., [2, 3, 0, 2, 1] -> [2, 5, 5, 7, 8]
 	CHECK_CUDA(cub::DeviceScan::InclusiveSum(geomState.scanning_space, geomState.scan_size, geomState.tiles_touched, geomState.point_offsets, P), debug)
+	if (stats)
+		lap(stats->scan_ms);
 
 	// Retrieve total number of Gaussian instances to launch and resize aux buffers
 	int num_rendered;
@@ -287,28 +642,54 @@ int CudaRasterizer::Rasterizer::forward(
 	char* binning_chunkptr = binningBuffer(binning_chunk_size);
 	BinningState binningState = BinningState::fromChunk(binning_chunkptr, num_rendered);
 
+	// Keeping all Gaussians in depth order only pays off while they are
+	// instanced at least once on average
+	if (coherent != nullptr && num_rendered < P)
+	{
+		coherent->forget();
+		coherent = nullptr;
+	}
+
+	// With a coherent order, the instances are laid out with the Gaussians
+	// in depth order and only need to be sorted by tile
+	const uint32_t* order = nullptr;
+	if (coherent != nullptr)
+	{
+		OrderState orderState = depthOrder(P, means3D, viewmatrix, geomState.depths, radii, *coherent, debug);
+		order = orderState.order;
+		gatherTiles << <(P + 255) / 256, 256 >> > (P, order, geomState.tiles_touched, orderState.tiles_touched);
+		CHECK_CUDA(cub::DeviceScan::InclusiveSum(geomState.scanning_space, geomState.scan_size, orderState.tiles_touched, geomState.point_offsets, P), debug)
+	}
+
 	// For each instance to be rendered, produce adequate [ tile | depth ] key 
 	// and corresponding dublicated Gaussian indices to be sorted
 	duplicateWithKeys << <(P + 255) / 256, 256 >> > (
 		P,
 		geomState.means2D,
 		geomState.depths,
+		geomState.conic_opacity,
 		geomState.point_offsets,
 		binningState.point_list_keys_unsorted,
 		binningState.point_list_unsorted,
 		radii,
-		tile_grid)
+		tile_grid,
+		order)
 	CHECK_CUDA(, debug)
+	if (stats)
+		lap(stats->duplicate_ms);
 
 	int bit = getHigherMsb(tile_grid.x * tile_grid.y);
 
-	// Sort complete list of (duplicated) Gaussian indices by keys
+	// Sort complete list of (duplicated) Gaussian indices by keys. In
+	// depth order, the stable sort by tile alone keeps it within tiles.
 	CHECK_CUDA(cub::DeviceRadixSort::SortPairs(
 		binningState.list_sorting_space,
 		binningState.sorting_size,
 		binningState.point_list_keys_unsorted, binningState.point_list_keys,
 		binningState.point_list_unsorted, binningState.point_list,
-		num_rendered, 0, 32 + bit), debug)
+		num_rendered, order != nullptr ? 32 : 0, 32 + bit), debug)
+	if (stats)
+		lap(stats->sort_ms);
 
 	CHECK_CUDA(cudaMemset(imgState.ranges, 0, tile_grid.x * tile_grid.y * sizeof(uint2)), debug);
 
@@ -316,25 +697,54 @@ int CudaRasterizer::Rasterizer::forward(
 	if (num_rendered > 0)
 		identifyTileRanges << <(num_rendered + 255) / 256, 256 >> > (
 			num_rendered,
+			tile_grid.x * tile_grid.y,
 			binningState.point_list_keys,
 			imgState.ranges);
+	orderTiles(tile_grid.x * tile_grid.y, imgState.ranges, imgState.tile_buckets, imgState.tile_order);
 	CHECK_CUDA(, debug)
+	if (stats)
+		lap(stats->ranges_ms);
 
 	// Let each tile blend its range of Gaussians independently in parallel
 	const float* feature_ptr = colors_precomp != nullptr ? colors_precomp : geomState.rgb;
 	CHECK_CUDA(FORWARD::render(
 		tile_grid, block,
 		imgState.ranges,
+		imgState.tile_order,
 		binningState.point_list,
 		width, height,
 		(float2*)subpixel_offset,
 		geomState.means2D,
 		feature_ptr,
+		channels,
 		geomState.conic_opacity,
 		imgState.accum_alpha,
 		imgState.n_contrib,
 		background,
-		out_color), debug)
+		out_color,
+		contributions != nullptr ? *contributions : GaussianContributions{}), debug)
+
+	if (stats)
+	{
+		lap(stats->render_ms);
+		stats->forward_ms = timer.total();
+		stats->num_rendered = num_rendered;
+		stats->geometry_bytes = chunk_size;
+		stats->binning_bytes = binning_chunk_size;
+		stats->image_bytes = img_chunk_size;
+
+		const int tiles = tile_grid.x * tile_grid.y;
+		std::vector<int> host_radii(P);
+		std::vector<uint32_t> host_ranges(2 * tiles);
+		std::vector<uint32_t> host_contrib(width * height);
+		cudaMemcpy(host_radii.data(), radii, P * sizeof(int), cudaMemcpyDeviceToHost);
+		cudaMemcpy(host_ranges.data(), imgState.ranges, tiles * sizeof(uint2), cudaMemcpyDeviceToHost);
+		cudaMemcpy(host_contrib.data(), imgState.n_contrib, width * height * sizeof(uint32_t), cudaMemcpyDeviceToHost);
+		stats->countVisible(host_radii.data(), P);
+		stats->summarizeTiles(host_ranges.data(), tiles);
+		stats->render_items = tiles;
+		stats->summarizeContributors(host_contrib.data(), width * height);
+	}
 
 	return num_rendered;
 }
@@ -343,6 +753,7 @@ int CudaRasterizer::Rasterizer::forward(
 // to forward render pass
 void CudaRasterizer::Rasterizer::backward(
 	const int P, int D, int M, int R,
+	const int channels,
 	const float* background,
 	const int width, int height,
 	const float* means3D,
@@ -372,8 +783,17 @@ void CudaRasterizer::Rasterizer::backward(
 	float* dL_dsh,
 	float* dL_dscale,
 	float* dL_drot,
-	bool debug)
+	bool debug,
+	RasterizerStats* stats)
 {
+	if (stats)
+		cudaDeviceSynchronize();
+	StageTimer timer;
+	auto lap = [&](double& ms) {
+		cudaDeviceSynchronize();
+		ms = timer.lap();
+	};
+
 	GeometryState geomState = GeometryState::fromChunk(geom_buffer, P);
 	BinningState binningState = BinningState::fromChunk(binning_buffer, R);
 	ImageState imgState = ImageState::fromChunk(img_buffer, width * height);
@@ -397,6 +817,7 @@ void CudaRasterizer::Rasterizer::backward(
 		tile_grid,
 		block,
 		imgState.ranges,
+		imgState.tile_order,
 		binningState.point_list,
 		width, height,
 		(float2*)subpixel_offset,
@@ -404,6 +825,7 @@ void CudaRasterizer::Rasterizer::backward(
 		geomState.means2D,
 		geomState.conic_opacity,
 		color_ptr,
+		channels,
 		imgState.accum_alpha,
 		imgState.n_contrib,
 		dL_dpix,
@@ -411,12 +833,14 @@ void CudaRasterizer::Rasterizer::backward(
 		(float4*)dL_dconic,
 		dL_dopacity,
 		dL_dcolor), debug)
+	if (stats)
+		lap(stats->backward_render_ms);
 
 	// Take care of the rest of preprocessing. Was the precomputed covariance
 	// given to us or a scales/rot pair? If precomputed, pass that. If not,
 	// use the one we computed ourselves.
 	const float* cov3D_ptr = (cov3D_precomp != nullptr) ? cov3D_precomp : geomState.cov3D;
-	CHECK_CUDA(BACKWARD::preprocess(P, D, M,
+	CHECK_CUDA(BACKWARD::preprocess(P, shDegree(D, colors_precomp), M,
 		(float3*)means3D,
 		radii,
 		shs,
@@ -441,4 +865,10 @@ void CudaRasterizer::Rasterizer::backward(
 		(glm::vec4*)dL_drot,
 		geomState.conic_opacity,
 		dL_dopacity), debug)
+
+	if (stats)
+	{
+		lap(stats->backward_preprocess_ms);
+		stats->backward_ms = timer.total();
+	}
 }
\ No newline at end of file
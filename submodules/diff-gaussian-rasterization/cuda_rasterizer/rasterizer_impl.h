@@ -47,6 +47,8 @@ namespace CudaRasterizer
 	struct ImageState
 	{
 		uint2* ranges;
+		uint32_t* tile_order;		// tiles by descending range length
+		uint32_t* tile_buckets;		// counts and cursors of orderTiles
 		uint32_t* n_contrib;
 		float* accum_alpha;
 
@@ -65,6 +67,21 @@ namespace CudaRasterizer
 		static BinningState fromChunk(char*& chunk, size_t P);
 	};
 
+	// Memory of CoherentSort. The order comes first, so that it stays in
+	// place while the memory does not grow.
+	struct OrderState
+	{
+		uint32_t* order;
+		uint64_t* keys;
+		uint64_t* keys_sorted;
+		uint32_t* tiles_touched;
+		int* unsorted;
+		size_t sorting_size;
+		char* sorting_space;
+
+		static OrderState fromChunk(char*& chunk, size_t P);
+	};
+
 	template<typename T> 
 	size_t required(size_t P)
 	{
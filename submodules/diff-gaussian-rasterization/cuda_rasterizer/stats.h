@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_STATS_H_INCLUDED
+#define CUDA_RASTERIZER_STATS_H_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Optional instrumentation of a forward/backward call, shared by the CUDA
+// and host rasterizers. When a stats object is passed, every stage is
+// timed (on the GPU by synchronizing after it) and the workload is
+// summarized, which costs extra device-to-host copies: meant for
+// profiling and benchmarks, not for training.
+struct RasterizerStats
+{
+	static constexpr int HISTOGRAM_BINS = 32;
+
+	// Forward stage timings in milliseconds
+	double preprocess_ms = 0;
+	double scan_ms = 0;
+	double duplicate_ms = 0;
+	double sort_ms = 0;
+	double ranges_ms = 0;
+	double render_ms = 0;
+	double forward_ms = 0;
+
+	// Backward stage timings in milliseconds. reduce is the host
+	// rasterizer's per-Gaussian summation of instance gradients.
+	double backward_render_ms = 0;
+	double backward_reduce_ms = 0;
+	double backward_preprocess_ms = 0;
+	double backward_ms = 0;
+
+	int num_points = 0;
+	int num_visible = 0;		// points with a radius > 0
+	int num_rendered = 0;		// Gaussian/tile instances
+	int num_tiles = 0;
+
+	// Gaussians per tile: bin 0 counts empty tiles, bin b > 0 counts
+	// tiles with [2^(b-1), 2^b) Gaussians.
+	uint64_t tile_histogram[HISTOGRAM_BINS] = {};
+	uint32_t max_tile_range = 0;
+	double mean_tile_range = 0;
+	// Longest range over the mean of the non-empty tiles: how much the
+	// heaviest tile alone would hold up a frame of evenly shared work
+	double tile_imbalance = 0;
+
+	// Render schedule: work items (tiles, or bands of heavy tiles on the
+	// host), tiles split into bands, items stolen by a thread other than
+	// their owner, and the busiest thread's render time over the mean
+	// (1 is even). The last three are only known for the host rasterizer.
+	int render_items = 0;
+	int split_tiles = 0;
+	int stolen_items = 0;
+	double worker_imbalance = 0;
+
+	// Gaussians blended per pixel before saturation (n_contrib)
+	uint32_t max_contributors = 0;
+	double mean_contributors = 0;
+
+	// Bytes requested for the auxiliary buffers
+	size_t geometry_bytes = 0;
+	size_t binning_bytes = 0;
+	size_t image_bytes = 0;
+
+	void countVisible(const int* radii, int P)
+	{
+		num_points = P;
+		num_visible = 0;
+		for (int i = 0; i < P; i++)
+			num_visible += radii[i] > 0;
+	}
+
+	// ranges holds one (start, end) pair per tile
+	void summarizeTiles(const uint32_t* ranges, int tiles)
+	{
+		num_tiles = tiles;
+		std::fill(tile_histogram, tile_histogram + HISTOGRAM_BINS, 0);
+		max_tile_range = 0;
+		uint64_t sum = 0;
+		for (int t = 0; t < tiles; t++)
+		{
+			const uint32_t n = ranges[2 * t + 1] - ranges[2 * t];
+			int bin = 0;
+			while (bin < HISTOGRAM_BINS - 1 && (n >> bin) != 0)
+				bin++;
+			tile_histogram[bin]++;
+			max_tile_range = std::max(max_tile_range, n);
+			sum += n;
+		}
+		mean_tile_range = tiles ? (double)sum / tiles : 0.0;
+		const uint64_t filled = tiles - tile_histogram[0];
+		tile_imbalance = sum ? (double)max_tile_range * filled / sum : 0.0;
+	}
+
+	void summarizeContributors(const uint32_t* n_contrib, int pixels)
+	{
+		max_contributors = 0;
+		uint64_t sum = 0;
+		for (int i = 0; i < pixels; i++)
+		{
+			max_contributors = std::max(max_contributors, n_contrib[i]);
+			sum += n_contrib[i];
+		}
+		mean_contributors = pixels ? (double)sum / pixels : 0.0;
+	}
+};
+
+// Wall clock stopwatch for the stage timings
+class StageTimer
+{
+public:
+	StageTimer() : start(std::chrono::steady_clock::now()), last(start) {}
+
+	// Milliseconds since the previous lap (or construction)
+	double lap()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const double ms = std::chrono::duration<double, std::milli>(now - last).count();
+		last = now;
+		return ms;
+	}
+
+	double total() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point last;
+};
+
+#endif
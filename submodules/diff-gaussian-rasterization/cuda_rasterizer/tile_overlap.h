@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef CUDA_RASTERIZER_TILE_OVERLAP_H_INCLUDED
+#define CUDA_RASTERIZER_TILE_OVERLAP_H_INCLUDED
+
+#include "config.h"
+#include <math.h>
+
+// Tile binning of a Gaussian, shared by the CUDA and host rasterizers.
+// preprocess counts the tiles with it and duplicateWithKeys emits them,
+// so both must classify every tile the same way: multiply-adds are
+// spelled out to keep the compiler from contracting them differently
+// in the two call sites.
+#ifdef __CUDACC__
+#define OVERLAP_FUNC __host__ __device__ __forceinline__
+#else
+#define OVERLAP_FUNC inline
+#endif
+
+#if defined(__CUDACC__) || defined(FP_FAST_FMAF)
+#define OVERLAP_FMA(a, b, c) fmaf(a, b, c)
+#else
+#define OVERLAP_FMA(a, b, c) ((a) * (b) + (c))
+#endif
+
+// Largest subpixel offset added to pixel positions (train.py draws
+// them from [-0.5, 0.5))
+#define OVERLAP_PIXEL_MARGIN 0.5f
+// Slack on the cutoff, absolute and relative to the magnitude of the
+// terms the renderers sum up, so rounding in their exp() and in the
+// quadratic form never makes them blend a Gaussian the binning dropped
+#define OVERLAP_SLACK_ABS 0.01f
+#define OVERLAP_SLACK_REL 1e-5f
+
+// Minimum of the quadratic form a u^2 + 2 b u v + c v^2 along the
+// segment u = const, v in [v0, v1]
+OVERLAP_FUNC float overlapEdgeMin(float a, float b, float c, float u, float v0, float v1)
+{
+	const float v = fminf(fmaxf(-b * u / c, v0), v1);
+	return OVERLAP_FMA(a * u, u, OVERLAP_FMA(2.0f * b * u, v, c * v * v));
+}
+
+// Minimum of the (positive definite) quadratic form over the rectangle
+// [u0, u1] x [v0, v1]: zero if it contains the origin, otherwise
+// attained on one of the edges.
+OVERLAP_FUNC float overlapRectMin(float a, float b, float c, float u0, float u1, float v0, float v1)
+{
+	if (u0 <= 0.0f && u1 >= 0.0f && v0 <= 0.0f && v1 >= 0.0f)
+		return 0.0f;
+	float q = fminf(overlapEdgeMin(a, b, c, u0, v0, v1), overlapEdgeMin(a, b, c, u1, v0, v1));
+	q = fminf(q, overlapEdgeMin(c, b, a, v0, u0, u1));
+	return fminf(q, overlapEdgeMin(c, b, a, v1, u0, u1));
+}
+
+// Calls emit(x, y) for every tile of the bounding rectangle [rect_min,
+// rect_max) in which the Gaussian reaches the renderers' alpha
+// threshold at some pixel, in row-major order.
+//
+// The renderers blend a Gaussian with conic (a, b, c) and opacity o at
+// a pixel d away from its center iff o * exp(-q / 2) >= 1/255, with
+// q = a dx^2 + 2 b dx dy + c dy^2, i.e. iff q <= 2 ln(255 o). That
+// ellipse is usually much smaller than the 3 sigma square of the
+// radius, most of all for low opacities and elongated Gaussians, and
+// tiles it misses only cost sorting and traversal. Tiles are tested
+// exactly: the minimum of q over the pixel positions of the tile
+// (widened by the subpixel margin) against the cutoff. The rectangle
+// is kept as a bound, so the image is unchanged.
+#ifdef __CUDACC__
+#pragma nv_exec_check_disable
+#endif
+template <typename F>
+OVERLAP_FUNC void forEachOverlappedTile(
+	float px, float py,
+	float a, float b, float c, float opacity,
+	int rect_min_x, int rect_min_y, int rect_max_x, int rect_max_y,
+	F emit)
+{
+	const float det = a * c - b * b;
+	if (!(a > 0.0f && det > 0.0f))
+	{
+		// Degenerate conic, fall back to the bounding rectangle
+		for (int y = rect_min_y; y < rect_max_y; y++)
+			for (int x = rect_min_x; x < rect_max_x; x++)
+				emit(x, y);
+		return;
+	}
+
+	const float cutoff = 2.0f * logf(255.0f * opacity);
+	const float q_max = OVERLAP_FMA(fabsf(cutoff) * (a * c / det), OVERLAP_SLACK_REL, cutoff + OVERLAP_SLACK_ABS);
+	if (!(q_max >= 0.0f))
+		return;
+
+	// Per-axis extents of the cutoff ellipse, sqrt(q_max * Sigma_ii)
+	// with Sigma the inverse of the conic, narrow the rectangle first.
+	const float ex = sqrtf(q_max * c / det) + OVERLAP_PIXEL_MARGIN;
+	const float ey = sqrtf(q_max * a / det) + OVERLAP_PIXEL_MARGIN;
+	const int x_begin = (int)fmaxf((float)rect_min_x, floorf((px - ex) / BLOCK_X));
+	const int x_end = (int)fminf((float)rect_max_x, floorf((px + ex) / BLOCK_X) + 1.0f);
+	const int y_begin = (int)fmaxf((float)rect_min_y, floorf((py - ey) / BLOCK_Y));
+	const int y_end = (int)fminf((float)rect_max_y, floorf((py + ey) / BLOCK_Y) + 1.0f);
+
+	for (int y = y_begin; y < y_end; y++)
+	{
+		const float v0 = (float)(y * BLOCK_Y) - OVERLAP_PIXEL_MARGIN - py;
+		const float v1 = v0 + (float)(BLOCK_Y - 1) + 2.0f * OVERLAP_PIXEL_MARGIN;
+		for (int x = x_begin; x < x_end; x++)
+		{
+			const float u0 = (float)(x * BLOCK_X) - OVERLAP_PIXEL_MARGIN - px;
+			const float u1 = u0 + (float)(BLOCK_X - 1) + 2.0f * OVERLAP_PIXEL_MARGIN;
+			if (overlapRectMin(a, b, c, u0, u1, v0, v1) <= q_max)
+				emit(x, y);
+		}
+	}
+}
+
+#endif
@@ -13,6 +13,7 @@ from typing import NamedTuple
 import torch.nn as nn
 import torch
 from . import _C
+from ._C import RasterizerContext, GaussianBVH
 
 def cpu_deep_copy_tuple(input_tuple):
     copied_tensors = [item.cpu().clone() if isinstance(item, torch.Tensor) else item for item in input_tuple]
@@ -78,12 +79,13 @@ class _RasterizeGaussians(torch.autograd.Function):
             raster_settings.sh_degree,
             raster_settings.campos,
             raster_settings.prefiltered,
-            raster_settings.debug
+            raster_settings.debug,
+            raster_settings.context
         )
 
         # Invoke C++/CUDA rasterizer
         if raster_settings.debug:
-            cpu_args = cpu_deep_copy_tuple(args) # Copy them before they can be corrupted
+            cpu_args = cpu_deep_copy_tuple(args[:-1]) + (None,) # Copy them before they can be corrupted
             try:
                 num_rendered, color, radii, geomBuffer, binningBuffer, imgBuffer = _C.rasterize_gaussians(*args)
             except Exception as ex:
@@ -130,11 +132,12 @@ class _RasterizeGaussians(torch.autograd.Function):
                 num_rendered,
                 binningBuffer,
                 imgBuffer,
-                raster_settings.debug)
+                raster_settings.debug,
+                raster_settings.context)
 
         # Compute gradients for relevant tensors by invoking backward method
         if raster_settings.debug:
-            cpu_args = cpu_deep_copy_tuple(args) # Copy them before they can be corrupted
+            cpu_args = cpu_deep_copy_tuple(args[:-1]) + (None,) # Copy them before they can be corrupted
             try:
                 grad_means2D, grad_colors_precomp, grad_opacities, grad_means3D, grad_cov3Ds_precomp, grad_sh, grad_scales, grad_rotations = _C.rasterize_gaussians_backward(*args)
             except Exception as ex:
@@ -173,6 +176,13 @@ class GaussianRasterizationSettings(NamedTuple):
     campos : torch.Tensor
     prefiltered : bool
     debug : bool
+    # Optional RasterizerContext. When set, the auxiliary buffers are kept
+    # in the context and reused across calls instead of being reallocated.
+    # A forward with the same context must not run between a forward and
+    # its backward. With context.set_coherent_sort(True), the depth order
+    # of the Gaussians is kept across its calls and repaired per frame,
+    # for consecutive frames of one moving camera.
+    context : object = None
 
 class GaussianRasterizer(nn.Module):
     def __init__(self, raster_settings):
@@ -225,3 +235,137 @@ class GaussianRasterizer(nn.Module):
             raster_settings, 
         )
 
+
+def rasterize_gaussians_batched(means3D, opacities, viewmatrices, projmatrices, tanfovx, tanfovy, campos,
+                                image_height, image_width, kernel_size, bg, sh_degree = 0, shs = None,
+                                colors_precomp = None, scales = None, rotations = None, cov3D_precomp = None,
+                                scale_modifier = 1.0, prefiltered = False, debug = False, context = None,
+                                contributions = None):
+    # Render the same Gaussians from N views of equal resolution in one call.
+    # viewmatrices/projmatrices are (N, 4, 4), campos is (N, 3) and tanfovx/tanfovy
+    # are sequences of N floats. The 3D covariances are computed once and shared
+    # by all views. This is an inference path: no gradients are propagated.
+    # If contributions (3, P) is given, the largest and summed blend weight
+    # (alpha * T) of every Gaussian and its number of blended pixels over all
+    # views are accumulated into its rows.
+    if (shs is None and colors_precomp is None) or (shs is not None and colors_precomp is not None):
+        raise Exception('Please provide excatly one of either SHs or precomputed colors!')
+
+    if ((scales is None or rotations is None) and cov3D_precomp is None) or ((scales is not None or rotations is not None) and cov3D_precomp is not None):
+        raise Exception('Please provide exactly one of either scale/rotation pair or precomputed 3D covariance!')
+
+    if shs is None:
+        shs = torch.Tensor([])
+    if colors_precomp is None:
+        colors_precomp = torch.Tensor([])
+
+    if scales is None:
+        scales = torch.Tensor([])
+    if rotations is None:
+        rotations = torch.Tensor([])
+    if cov3D_precomp is None:
+        cov3D_precomp = torch.Tensor([])
+    if contributions is None:
+        contributions = torch.Tensor([])
+
+    with torch.no_grad():
+        return _C.rasterize_gaussians_batched(
+            bg,
+            means3D,
+            colors_precomp,
+            opacities,
+            scales,
+            rotations,
+            scale_modifier,
+            cov3D_precomp,
+            viewmatrices,
+            projmatrices,
+            [float(t) for t in tanfovx],
+            [float(t) for t in tanfovy],
+            kernel_size,
+            image_height,
+            image_width,
+            shs,
+            sh_degree,
+            campos,
+            contributions,
+            prefiltered,
+            debug,
+            context)
+
+class CompressedGaussians(NamedTuple):
+    # Attributes of a served model, see cuda_rasterizer/compressed.h. The
+    # opacities and scales include the 3D filter.
+    features_dc : torch.Tensor  # (P, 1, 3) half
+    sh_codebook : torch.Tensor  # (K, M - 1, 3) float
+    sh_index : torch.Tensor     # (P,) int32
+    opacities : torch.Tensor    # (P, 1) half
+    scales : torch.Tensor       # (P, 3) half
+    rotations : torch.Tensor    # (P, 4) half, normalized
+
+def rasterize_gaussians_compressed(means3D, compressed, raster_settings):
+    # Render Gaussians whose attributes are decoded by the rasterizer from
+    # a CompressedGaussians instead of being expanded to float tensors.
+    # This is an inference path: no gradients are propagated. Returns the
+    # image and the radii.
+    with torch.no_grad():
+        return _C.rasterize_compressed(
+            raster_settings.bg,
+            means3D,
+            compressed.features_dc,
+            compressed.sh_codebook,
+            compressed.sh_index,
+            compressed.opacities,
+            compressed.scales,
+            compressed.rotations,
+            raster_settings.scale_modifier,
+            raster_settings.viewmatrix,
+            raster_settings.projmatrix,
+            raster_settings.tanfovx,
+            raster_settings.tanfovy,
+            raster_settings.kernel_size,
+            raster_settings.subpixel_offset,
+            raster_settings.image_height,
+            raster_settings.image_width,
+            raster_settings.sh_degree,
+            raster_settings.campos,
+            raster_settings.prefiltered,
+            raster_settings.debug,
+            raster_settings.context)
+
+def filter_3D_cameras(cameras, device):
+    # Pack cameras into the (num_cameras, 16) layout of compute_filter_3D:
+    # R (row-major), T, focal_x, focal_y, image width, image height
+    return torch.tensor([[*camera.R.reshape(-1), *camera.T.reshape(-1), camera.focal_x, camera.focal_y, camera.image_width, camera.image_height]
+                         for camera in cameras], dtype=torch.float32, device=device)
+
+def compute_filter_3D(means3D, cameras):
+    # Minimum depth of each point over all cameras it projects into, in one
+    # pass over all cameras. Returns (distance, valid); points that no camera
+    # sees have valid == False.
+    with torch.no_grad():
+        return _C.compute_filter_3D(means3D, cameras)
+
+class LODTree(NamedTuple):
+    # One row per node, see cpu_rasterizer/lod.h for the layout
+    left : torch.Tensor
+    right : torch.Tensor
+    means3D : torch.Tensor
+    cov3D : torch.Tensor
+    opacities : torch.Tensor
+    features : torch.Tensor
+    size : torch.Tensor
+    radius : torch.Tensor
+
+def build_lod_tree(means3D, cov3D, opacities, features):
+    # Offline build of the level-of-detail tree over Gaussians whose cov3D
+    # and opacities already include the 3D filter. Runs on the host, the
+    # returned tree lives in CPU tensors.
+    with torch.no_grad():
+        return LODTree(*_C.build_lod_tree(means3D.cpu(), cov3D.cpu(), opacities.cpu(), features.cpu()))
+
+def select_lod_cut(tree, campos, focal, target_size = 1.0):
+    # Node ids (CPU, int64) of the coarsest cut whose nodes project to at
+    # most target_size pixels for a camera at campos with the given focal
+    # length in pixels.
+    return _C.select_lod_cut(tree.left, tree.right, tree.means3D, tree.size, tree.radius, campos.cpu(), focal, target_size)
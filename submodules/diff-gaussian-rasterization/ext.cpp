@@ -3,7 +3,7 @@
  * GRAPHDECO research group, https://team.inria.fr/graphdeco
  * All rights reserved.
  *
- * This software is free for non-commercial, research and evaluation use 
+ * This software is free for non-commercial, research and evaluation use
  * under the terms of the LICENSE.md file.
  *
  * For inquiries contact  george.drettakis@inria.fr
@@ -11,9 +11,261 @@
 
 #include <torch/extension.h>
 #include "rasterize_points.h"
+#include "cpu_rasterizer/bvh.h"
+
+static torch::Tensor hostFloats(const torch::Tensor& t)
+{
+  return t.to(torch::kCPU, torch::kFloat32).contiguous();
+}
+
+// Entry points dispatch on the device of the Gaussian means: CUDA tensors
+// go to the CUDA rasterizer (if compiled in), CPU tensors to the host one.
+
+std::tuple<int, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+RasterizeGaussians(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return RasterizeGaussiansCUDA(background, means3D, colors, opacity, scales, rotations, scale_modifier,
+      cov3D_precomp, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+      image_height, image_width, sh, degree, campos, prefiltered, debug, context);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return RasterizeGaussiansCPU(background, means3D, colors, opacity, scales, rotations, scale_modifier,
+    cov3D_precomp, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+    image_height, image_width, sh, degree, campos, prefiltered, debug, context);
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+ RasterizeGaussiansBackward(
+ 	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& radii,
+    const torch::Tensor& colors,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+    const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const torch::Tensor& dL_dout_color,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const torch::Tensor& geomBuffer,
+	const int R,
+	const torch::Tensor& binningBuffer,
+	const torch::Tensor& imageBuffer,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return RasterizeGaussiansBackwardCUDA(background, means3D, radii, colors, scales, rotations, scale_modifier,
+      cov3D_precomp, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+      dL_dout_color, sh, degree, campos, geomBuffer, R, binningBuffer, imageBuffer, debug, context);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return RasterizeGaussiansBackwardCPU(background, means3D, radii, colors, scales, rotations, scale_modifier,
+    cov3D_precomp, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+    dL_dout_color, sh, degree, campos, geomBuffer, R, binningBuffer, imageBuffer, debug, context);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeGaussiansBatched(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrices,
+	const torch::Tensor& projmatrices,
+	const std::vector<float>& tan_fovx,
+	const std::vector<float>& tan_fovy,
+	const float kernel_size,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& camposes,
+	const torch::Tensor& contributions,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return RasterizeGaussiansBatchedCUDA(background, means3D, colors, opacity, scales, rotations, scale_modifier,
+      cov3D_precomp, viewmatrices, projmatrices, tan_fovx, tan_fovy, kernel_size,
+      image_height, image_width, sh, degree, camposes, contributions, prefiltered, debug, context);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return RasterizeGaussiansBatchedCPU(background, means3D, colors, opacity, scales, rotations, scale_modifier,
+    cov3D_precomp, viewmatrices, projmatrices, tan_fovx, tan_fovy, kernel_size,
+    image_height, image_width, sh, degree, camposes, contributions, prefiltered, debug, context);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeCompressed(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& features_dc,
+	const torch::Tensor& sh_codebook,
+	const torch::Tensor& sh_index,
+	const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return RasterizeCompressedCUDA(background, means3D, features_dc, sh_codebook, sh_index, opacity, scales, rotations,
+      scale_modifier, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+      image_height, image_width, degree, campos, prefiltered, debug, context);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return RasterizeCompressedCPU(background, means3D, features_dc, sh_codebook, sh_index, opacity, scales, rotations,
+    scale_modifier, viewmatrix, projmatrix, tan_fovx, tan_fovy, kernel_size, subpixel_offset,
+    image_height, image_width, degree, campos, prefiltered, debug, context);
+}
+
+torch::Tensor markVisibleDispatch(
+		torch::Tensor& means3D,
+		torch::Tensor& viewmatrix,
+		torch::Tensor& projmatrix)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return markVisible(means3D, viewmatrix, projmatrix);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return markVisibleCPU(means3D, viewmatrix, projmatrix);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+ComputeFilter3D(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cameras)
+{
+  if (means3D.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return ComputeFilter3DCUDA(means3D, cameras);
+#else
+    AT_ERROR("diff_gaussian_rasterization was built without CUDA support");
+#endif
+  }
+  return ComputeFilter3DCPU(means3D, cameras);
+}
 
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
-  m.def("rasterize_gaussians", &RasterizeGaussiansCUDA);
-  m.def("rasterize_gaussians_backward", &RasterizeGaussiansBackwardCUDA);
-  m.def("mark_visible", &markVisible);
-}
\ No newline at end of file
+  // The trailing context argument is optional (None), see RasterizerContext.
+  m.def("rasterize_gaussians", &RasterizeGaussians);
+  m.def("rasterize_gaussians_backward", &RasterizeGaussiansBackward);
+  m.def("rasterize_gaussians_batched", &RasterizeGaussiansBatched);
+  m.def("rasterize_compressed", &RasterizeCompressed);
+  m.def("mark_visible", &markVisibleDispatch);
+  m.def("compute_filter_3D", &ComputeFilter3D);
+  m.def("build_lod_tree", &BuildLODTreeCPU, py::call_guard<py::gil_scoped_release>());
+  m.def("select_lod_cut", &SelectLODCutCPU);
+
+  py::class_<RasterizerContext, std::shared_ptr<RasterizerContext>>(m, "RasterizerContext")
+    .def(py::init<double>(), py::arg("growth_factor") = 1.5)
+    .def("reserve", [](RasterizerContext& self, const torch::Device& device, size_t geom_bytes, size_t binning_bytes, size_t image_bytes) {
+        self.reserve(device, geom_bytes, binning_bytes, image_bytes);
+      }, py::arg("device"), py::arg("geometry_bytes"), py::arg("binning_bytes"), py::arg("image_bytes"))
+    .def("set_coherent_sort", &RasterizerContext::setCoherentSort, py::arg("enabled"), py::arg("max_rotation") = 0.2)
+    .def("release", &RasterizerContext::release)
+    .def("reset_stats", &RasterizerContext::resetStats)
+    .def("stats", &RasterizerContext::stats);
+
+  // Culling runs on the host for either device: build/refit copy the
+  // means (P x 3) and per-Gaussian largest scales (P) over, cull returns
+  // the sorted ids of the possibly visible Gaussians as a CPU tensor.
+  py::class_<BVH::Tree>(m, "GaussianBVH")
+    .def(py::init<>())
+    .def("build", [](BVH::Tree& self, const torch::Tensor& means3D, const torch::Tensor& sigma) {
+        const torch::Tensor means_h = hostFloats(means3D), sigma_h = hostFloats(sigma);
+        py::gil_scoped_release release;
+        self.build(means_h.size(0), means_h.data_ptr<float>(), sigma_h.data_ptr<float>());
+      }, py::arg("means3D"), py::arg("sigma"))
+    .def("refit", [](BVH::Tree& self, const torch::Tensor& means3D, const torch::Tensor& sigma) {
+        if (means3D.size(0) != self.size() || sigma.numel() != self.size())
+          AT_ERROR("refit needs the Gaussians the BVH was built over, rebuild after densification");
+        const torch::Tensor means_h = hostFloats(means3D), sigma_h = hostFloats(sigma);
+        py::gil_scoped_release release;
+        self.refit(means_h.data_ptr<float>(), sigma_h.data_ptr<float>());
+      }, py::arg("means3D"), py::arg("sigma"))
+    .def("cull", [](const BVH::Tree& self, const torch::Tensor& viewmatrix, const torch::Tensor& projmatrix,
+        int image_height, int image_width, float tanfovx, float tanfovy, float kernel_size) {
+        const torch::Tensor view_h = hostFloats(viewmatrix), proj_h = hostFloats(projmatrix);
+        std::vector<int> visible;
+        {
+          py::gil_scoped_release release;
+          self.cull(view_h.data_ptr<float>(), proj_h.data_ptr<float>(), image_width, image_height,
+            tanfovx, tanfovy, kernel_size, visible);
+        }
+        torch::Tensor ids = torch::empty({(int64_t)visible.size()}, torch::kLong);
+        std::copy(visible.begin(), visible.end(), ids.data_ptr<int64_t>());
+        return ids;
+      }, py::arg("viewmatrix"), py::arg("projmatrix"), py::arg("image_height"), py::arg("image_width"),
+        py::arg("tanfovx"), py::arg("tanfovy"), py::arg("kernel_size"))
+    .def_property_readonly("size", &BVH::Tree::size);
+}
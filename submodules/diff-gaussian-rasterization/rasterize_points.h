@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <tuple>
 #include <string>
+#include <vector>
+#include "rasterizer_context.h"
 	
 std::tuple<int, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
 RasterizeGaussiansCUDA(
@@ -37,7 +39,8 @@ RasterizeGaussiansCUDA(
 	const int degree,
 	const torch::Tensor& campos,
 	const bool prefiltered,
-	const bool debug);
+	const bool debug,
+	RasterizerContext* context = nullptr);
 
 std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
  RasterizeGaussiansBackwardCUDA(
@@ -63,9 +66,214 @@ std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Te
 	const int R,
 	const torch::Tensor& binningBuffer,
 	const torch::Tensor& imageBuffer,
-	const bool debug);
+	const bool debug,
+	RasterizerContext* context = nullptr);
 		
+// Renders the same Gaussians from N views (stacked view/projection
+// matrices and camera positions) into an N x C x H x W tensor. The
+// view-independent 3D covariances are computed once for all views.
+// Unless contributions is empty, the contribution statistics of all
+// views are accumulated into its rows (max weight, summed weight,
+// pixels) of P floats, see cuda_rasterizer/contribution.h.
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeGaussiansBatchedCUDA(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrices,
+	const torch::Tensor& projmatrices,
+	const std::vector<float>& tan_fovx,
+	const std::vector<float>& tan_fovy,
+	const float kernel_size,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& camposes,
+	const torch::Tensor& contributions,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
+// Forward pass over compressed attributes (see
+// cuda_rasterizer/compressed.h): half features_dc (P x 3), opacity (P),
+// scales (P x 3) and rotations (P x 4), and a float codebook
+// (K x (M - 1) x 3) of the higher SH bands indexed by the int32 sh_index
+// (P). Returns the C x H x W image and the radii. No backward.
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeCompressedCUDA(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& features_dc,
+	const torch::Tensor& sh_codebook,
+	const torch::Tensor& sh_index,
+	const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
 torch::Tensor markVisible(
 		torch::Tensor& means3D,
 		torch::Tensor& viewmatrix,
-		torch::Tensor& projmatrix);
\ No newline at end of file
+		torch::Tensor& projmatrix);
+
+// Host implementations, see rasterize_points_cpu.cpp.
+std::tuple<int, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+RasterizeGaussiansCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx, 
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+ RasterizeGaussiansBackwardCPU(
+ 	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& radii,
+    const torch::Tensor& colors,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+    const torch::Tensor& projmatrix,
+	const float tan_fovx, 
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const torch::Tensor& dL_dout_color,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const torch::Tensor& geomBuffer,
+	const int R,
+	const torch::Tensor& binningBuffer,
+	const torch::Tensor& imageBuffer,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeGaussiansBatchedCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrices,
+	const torch::Tensor& projmatrices,
+	const std::vector<float>& tan_fovx,
+	const std::vector<float>& tan_fovy,
+	const float kernel_size,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& camposes,
+	const torch::Tensor& contributions,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeCompressedCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& features_dc,
+	const torch::Tensor& sh_codebook,
+	const torch::Tensor& sh_index,
+	const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context = nullptr);
+
+torch::Tensor markVisibleCPU(
+		torch::Tensor& means3D,
+		torch::Tensor& viewmatrix,
+		torch::Tensor& projmatrix);
+
+// Minimum depth of every point over the cameras that see it, for the 3D
+// filter. cameras holds one row of FILTER3D_CAMERA_STRIDE floats per
+// camera, see cuda_rasterizer/filter3d.h.
+std::tuple<torch::Tensor, torch::Tensor>
+ComputeFilter3DCUDA(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cameras);
+
+std::tuple<torch::Tensor, torch::Tensor>
+ComputeFilter3DCPU(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cameras);
+
+// Level-of-detail tree over the Gaussians, see cpu_rasterizer/lod.h.
+// Returns (left, right, means, cov3D, opacity, features, size, radius)
+// with one row per node. Host tensors only.
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+BuildLODTreeCPU(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cov3D,
+	const torch::Tensor& opacity,
+	const torch::Tensor& features);
+
+// Node ids of the cut through a LOD tree for a camera at campos
+torch::Tensor
+SelectLODCutCPU(
+	const torch::Tensor& left,
+	const torch::Tensor& right,
+	const torch::Tensor& node_means,
+	const torch::Tensor& node_size,
+	const torch::Tensor& node_radius,
+	const torch::Tensor& campos,
+	const float focal,
+	const float target_size);
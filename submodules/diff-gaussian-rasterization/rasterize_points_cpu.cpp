@@ -0,0 +1,652 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <math.h>
+#include <torch/extension.h>
+#include <cstdio>
+#include <sstream>
+#include <iostream>
+#include <tuple>
+#include <stdio.h>
+#include <memory>
+#include "cuda_rasterizer/config.h"
+#include "cpu_rasterizer/rasterizer.h"
+#include "cuda_rasterizer/filter3d.h"
+#include "cpu_rasterizer/lod.h"
+#include <fstream>
+#include <string>
+#include <functional>
+#include "rasterizer_context.h"
+
+static std::function<char*(size_t N)> resizeFunctional(torch::Tensor& t) {
+    auto lambda = [&t](size_t N) {
+        t.resize_({(long long)N});
+		return reinterpret_cast<char*>(t.contiguous().data_ptr());
+    };
+    return lambda;
+}
+
+std::tuple<int, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+RasterizeGaussiansCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.ndimension() != 2 || means3D.size(1) != 3) {
+    AT_ERROR("means3D must have dimensions (num_points, 3)");
+  }
+  // Precomputed features may have any supported number of channels
+  const int channels = colors.ndimension() == 2 ? colors.size(1) : NUM_CHANNELS;
+  if (background.numel() != channels) {
+    AT_ERROR("background must have one value per color channel");
+  }
+
+  const int P = means3D.size(0);
+  const int H = image_height;
+  const int W = image_width;
+
+  auto int_opts = means3D.options().dtype(torch::kInt32);
+  auto float_opts = means3D.options().dtype(torch::kFloat32);
+
+  torch::Tensor out_color = torch::full({channels, H, W}, 0.0, float_opts);
+  torch::Tensor radii = torch::full({P}, 0, means3D.options().dtype(torch::kInt32));
+
+  torch::Device device(torch::kCPU);
+  torch::TensorOptions options(torch::kByte);
+  torch::Tensor geomBuffer, binningBuffer, imgBuffer;
+  std::function<char*(size_t)> geomFunc, binningFunc, imgFunc;
+  if (context != nullptr)
+  {
+	// Reuse the persistent arenas of the context
+	device = means3D.device();
+	context->countCall();
+	geomFunc = context->geometryBuffer(device);
+	binningFunc = context->binningBuffer(device);
+	imgFunc = context->imageBuffer(device);
+  }
+  else
+  {
+	geomBuffer = torch::empty({0}, options.device(device));
+	binningBuffer = torch::empty({0}, options.device(device));
+	imgBuffer = torch::empty({0}, options.device(device));
+	geomFunc = resizeFunctional(geomBuffer);
+	binningFunc = resizeFunctional(binningBuffer);
+	imgFunc = resizeFunctional(imgBuffer);
+  }
+
+  int rendered = 0;
+  if(P != 0)
+  {
+	  int M = 0;
+	  if(sh.size(0) != 0)
+	  {
+		M = sh.size(1);
+      }
+
+	  try
+	  {
+		  rendered = CpuRasterizer::Rasterizer::forward(
+		    geomFunc,
+			binningFunc,
+			imgFunc,
+		    P, degree, M,
+		    channels,
+			background.contiguous().data<float>(),
+			W, H,
+			means3D.contiguous().data<float>(),
+			sh.contiguous().data_ptr<float>(),
+			colors.contiguous().data<float>(),
+			opacity.contiguous().data<float>(),
+			scales.contiguous().data_ptr<float>(),
+			scale_modifier,
+			rotations.contiguous().data_ptr<float>(),
+			cov3D_precomp.contiguous().data<float>(),
+			viewmatrix.contiguous().data<float>(),
+			projmatrix.contiguous().data<float>(),
+			campos.contiguous().data<float>(),
+			tan_fovx,
+			tan_fovy,
+			kernel_size,
+			subpixel_offset.contiguous().data<float>(),
+			prefiltered,
+			out_color.contiguous().data<float>(),
+			radii.contiguous().data<int>(),
+			debug,
+			nullptr,
+			nullptr,
+			context != nullptr ? context->coherentSort(device) : nullptr);
+	  }
+	  catch (const std::runtime_error& e)
+	  {
+		  AT_ERROR(e.what());
+	  }
+  }
+  if (context != nullptr)
+  {
+	geomBuffer = context->geometry();
+	binningBuffer = context->binning();
+	imgBuffer = context->image();
+	if (!geomBuffer.defined())
+	{
+		geomBuffer = torch::empty({0}, options.device(device));
+		binningBuffer = torch::empty({0}, options.device(device));
+		imgBuffer = torch::empty({0}, options.device(device));
+	}
+  }
+  return std::make_tuple(rendered, out_color, radii, geomBuffer, binningBuffer, imgBuffer);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeGaussiansBatchedCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+    const torch::Tensor& colors,
+    const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrices,
+	const torch::Tensor& projmatrices,
+	const std::vector<float>& tan_fovx,
+	const std::vector<float>& tan_fovy,
+	const float kernel_size,
+    const int image_height,
+    const int image_width,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& camposes,
+	const torch::Tensor& contributions,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.ndimension() != 2 || means3D.size(1) != 3) {
+    AT_ERROR("means3D must have dimensions (num_points, 3)");
+  }
+  // Precomputed features may have any supported number of channels
+  const int channels = colors.ndimension() == 2 ? colors.size(1) : NUM_CHANNELS;
+  if (background.numel() != channels) {
+    AT_ERROR("background must have one value per color channel");
+  }
+  const int N = viewmatrices.size(0);
+  if (projmatrices.size(0) != N || camposes.size(0) != N || (int)tan_fovx.size() != N || (int)tan_fovy.size() != N) {
+    AT_ERROR("All per-view inputs must have the same number of views");
+  }
+
+  const int P = means3D.size(0);
+  const int H = image_height;
+  const int W = image_width;
+  if (contributions.numel() != 0 && (contributions.ndimension() != 2 || contributions.size(0) != 3 || contributions.size(1) != P
+    || contributions.scalar_type() != torch::kFloat32 || !contributions.is_contiguous() || contributions.device() != means3D.device())) {
+    AT_ERROR("contributions must be a contiguous float tensor (3, num_points) on the device of means3D");
+  }
+  float* contrib_ptr = contributions.numel() != 0 ? contributions.data_ptr<float>() : nullptr;
+  GaussianContributions contrib = { contrib_ptr, contrib_ptr + P, contrib_ptr + 2 * P };
+
+  auto float_opts = means3D.options().dtype(torch::kFloat32);
+
+  torch::Tensor out_color = torch::full({N, channels, H, W}, 0.0, float_opts);
+  torch::Tensor radii = torch::full({N, P}, 0, means3D.options().dtype(torch::kInt32));
+  torch::Tensor subpixel_offset = torch::zeros({H, W, 2}, float_opts);
+
+  // All views share one set of auxiliary buffers
+  RasterizerContext local_context;
+  if (context == nullptr)
+	context = &local_context;
+
+  if(P != 0 && N != 0)
+  {
+	  int M = 0;
+	  if(sh.size(0) != 0)
+	  {
+		M = sh.size(1);
+      }
+
+	  // The 3D covariances do not depend on the view, compute them once
+	  torch::Tensor cov3D = cov3D_precomp;
+	  if (cov3D_precomp.numel() == 0)
+	  {
+		cov3D = torch::empty({P, 6}, float_opts);
+		CpuRasterizer::Rasterizer::computeCov3D(P,
+			scales.contiguous().data<float>(),
+			scale_modifier,
+			rotations.contiguous().data<float>(),
+			cov3D.data<float>());
+	  }
+
+	  torch::Tensor views = viewmatrices.contiguous();
+	  torch::Tensor projs = projmatrices.contiguous();
+	  torch::Tensor cams = camposes.contiguous();
+	  torch::Tensor means = means3D.contiguous();
+	  cov3D = cov3D.contiguous();
+
+	  for (int v = 0; v < N; v++)
+	  {
+		context->countCall();
+		try
+		{
+		  CpuRasterizer::Rasterizer::forward(
+		    context->geometryBuffer(means3D.device()),
+			context->binningBuffer(means3D.device()),
+			context->imageBuffer(means3D.device()),
+		    P, degree, M,
+		    channels,
+			background.contiguous().data<float>(),
+			W, H,
+			means.data<float>(),
+			sh.contiguous().data_ptr<float>(),
+			colors.contiguous().data<float>(),
+			opacity.contiguous().data<float>(),
+			nullptr,
+			scale_modifier,
+			nullptr,
+			cov3D.data<float>(),
+			views.data<float>() + 16 * v,
+			projs.data<float>() + 16 * v,
+			cams.data<float>() + 3 * v,
+			tan_fovx[v],
+			tan_fovy[v],
+			kernel_size,
+			subpixel_offset.data<float>(),
+			prefiltered,
+			out_color.data<float>() + (size_t)v * channels * H * W,
+			radii.data<int>() + (size_t)v * P,
+			debug,
+			nullptr,
+			contrib_ptr != nullptr ? &contrib : nullptr);
+		}
+		catch (const std::runtime_error& e)
+		{
+		  AT_ERROR(e.what());
+		}
+	  }
+  }
+  return std::make_tuple(out_color, radii);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+RasterizeCompressedCPU(
+	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& features_dc,
+	const torch::Tensor& sh_codebook,
+	const torch::Tensor& sh_index,
+	const torch::Tensor& opacity,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& viewmatrix,
+	const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const int image_height,
+    const int image_width,
+	const int degree,
+	const torch::Tensor& campos,
+	const bool prefiltered,
+	const bool debug,
+	RasterizerContext* context)
+{
+  if (means3D.ndimension() != 2 || means3D.size(1) != 3) {
+    AT_ERROR("means3D must have dimensions (num_points, 3)");
+  }
+  if (background.numel() != NUM_CHANNELS) {
+    AT_ERROR("background must have one value per color channel");
+  }
+  const int P = means3D.size(0);
+  auto check = [&](const torch::Tensor& t, torch::ScalarType type, int64_t numel, const char* what) {
+    if (t.scalar_type() != type || t.numel() != numel || t.device() != means3D.device()) {
+      AT_ERROR(what);
+    }
+  };
+  check(features_dc, torch::kHalf, 3 * (int64_t)P, "features_dc must be a half tensor with 3 values per point");
+  check(sh_index, torch::kInt32, P, "sh_index must be an int32 tensor with one index per point");
+  check(opacity, torch::kHalf, P, "opacity must be a half tensor with one value per point");
+  check(scales, torch::kHalf, 3 * (int64_t)P, "scales must be a half tensor with 3 values per point");
+  check(rotations, torch::kHalf, 4 * (int64_t)P, "rotations must be a half tensor with 4 values per point");
+  if (sh_codebook.ndimension() != 3 || sh_codebook.size(2) != 3 || sh_codebook.scalar_type() != torch::kFloat32
+    || sh_codebook.device() != means3D.device()) {
+    AT_ERROR("sh_codebook must be a float tensor (entries, coefficients - 1, 3)");
+  }
+  // Every entry holds the bands above 0 of all coefficients
+  const int M = sh_codebook.size(1) + 1;
+  if ((degree + 1) * (degree + 1) > M) {
+    AT_ERROR("sh_codebook has too few coefficients for the SH degree");
+  }
+
+  const int H = image_height;
+  const int W = image_width;
+  auto float_opts = means3D.options().dtype(torch::kFloat32);
+  torch::Tensor out_color = torch::full({NUM_CHANNELS, H, W}, 0.0, float_opts);
+  torch::Tensor radii = torch::full({P}, 0, means3D.options().dtype(torch::kInt32));
+
+  // Forward only, nothing has to be kept for a backward pass
+  RasterizerContext local_context;
+  if (context == nullptr)
+	context = &local_context;
+
+  if (P != 0)
+  {
+	  const torch::Tensor dc = features_dc.contiguous(), codebook = sh_codebook.contiguous(), index = sh_index.contiguous();
+	  const torch::Tensor opacity_h = opacity.contiguous(), scales_h = scales.contiguous(), rotations_h = rotations.contiguous();
+	  CompressedGaussians compressed = {
+		(const uint16_t*)dc.data_ptr(),
+		codebook.data_ptr<float>(),
+		index.data_ptr<int32_t>(),
+		(const uint16_t*)opacity_h.data_ptr(),
+		(const uint16_t*)scales_h.data_ptr(),
+		(const uint16_t*)rotations_h.data_ptr() };
+
+	  const torch::Device device = means3D.device();
+	  context->countCall();
+	  try
+	  {
+		  CpuRasterizer::Rasterizer::forward(
+		    context->geometryBuffer(device),
+			context->binningBuffer(device),
+			context->imageBuffer(device),
+		    P, degree, M,
+		    NUM_CHANNELS,
+			background.contiguous().data<float>(),
+			W, H,
+			means3D.contiguous().data<float>(),
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			scale_modifier,
+			nullptr,
+			nullptr,
+			viewmatrix.contiguous().data<float>(),
+			projmatrix.contiguous().data<float>(),
+			campos.contiguous().data<float>(),
+			tan_fovx,
+			tan_fovy,
+			kernel_size,
+			subpixel_offset.contiguous().data<float>(),
+			prefiltered,
+			out_color.data<float>(),
+			radii.data<int>(),
+			debug,
+			nullptr,
+			nullptr,
+			context->coherentSort(device),
+			&compressed);
+	  }
+	  catch (const std::runtime_error& e)
+	  {
+		  AT_ERROR(e.what());
+	  }
+  }
+  return std::make_tuple(out_color, radii);
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+ RasterizeGaussiansBackwardCPU(
+ 	const torch::Tensor& background,
+	const torch::Tensor& means3D,
+	const torch::Tensor& radii,
+    const torch::Tensor& colors,
+	const torch::Tensor& scales,
+	const torch::Tensor& rotations,
+	const float scale_modifier,
+	const torch::Tensor& cov3D_precomp,
+	const torch::Tensor& viewmatrix,
+    const torch::Tensor& projmatrix,
+	const float tan_fovx,
+	const float tan_fovy,
+	const float kernel_size,
+	const torch::Tensor& subpixel_offset,
+    const torch::Tensor& dL_dout_color,
+	const torch::Tensor& sh,
+	const int degree,
+	const torch::Tensor& campos,
+	const torch::Tensor& geomBuffer,
+	const int R,
+	const torch::Tensor& binningBuffer,
+	const torch::Tensor& imageBuffer,
+	const bool debug,
+	RasterizerContext* context)
+{
+  const int P = means3D.size(0);
+  const int H = dL_dout_color.size(1);
+  const int W = dL_dout_color.size(2);
+  const int channels = dL_dout_color.size(0);
+
+  int M = 0;
+  if(sh.size(0) != 0)
+  {
+	M = sh.size(1);
+  }
+
+  torch::Tensor dL_dmeans3D = torch::zeros({P, 3}, means3D.options());
+  torch::Tensor dL_dmeans2D = torch::zeros({P, 3}, means3D.options());
+  torch::Tensor dL_dcolors = torch::zeros({P, channels}, means3D.options());
+  torch::Tensor dL_dconic = torch::zeros({P, 2, 2}, means3D.options());
+  torch::Tensor dL_dopacity = torch::zeros({P, 1}, means3D.options());
+  torch::Tensor dL_dcov3D = torch::zeros({P, 6}, means3D.options());
+  torch::Tensor dL_dsh = torch::zeros({P, M, 3}, means3D.options());
+  torch::Tensor dL_dscales = torch::zeros({P, 3}, means3D.options());
+  torch::Tensor dL_drotations = torch::zeros({P, 4}, means3D.options());
+
+  if(P != 0)
+  {
+	  CpuRasterizer::Rasterizer::backward(P, degree, M, R,
+	  channels,
+	  background.contiguous().data<float>(),
+	  W, H,
+	  means3D.contiguous().data<float>(),
+	  sh.contiguous().data<float>(),
+	  colors.contiguous().data<float>(),
+	  scales.data_ptr<float>(),
+	  scale_modifier,
+	  rotations.data_ptr<float>(),
+	  cov3D_precomp.contiguous().data<float>(),
+	  viewmatrix.contiguous().data<float>(),
+	  projmatrix.contiguous().data<float>(),
+	  campos.contiguous().data<float>(),
+	  tan_fovx,
+	  tan_fovy,
+	  kernel_size,
+	  subpixel_offset.contiguous().data<float>(),
+	  radii.contiguous().data<int>(),
+	  reinterpret_cast<char*>(geomBuffer.contiguous().data_ptr()),
+	  reinterpret_cast<char*>(binningBuffer.contiguous().data_ptr()),
+	  reinterpret_cast<char*>(imageBuffer.contiguous().data_ptr()),
+	  dL_dout_color.contiguous().data<float>(),
+	  dL_dmeans2D.contiguous().data<float>(),
+	  dL_dconic.contiguous().data<float>(),
+	  dL_dopacity.contiguous().data<float>(),
+	  dL_dcolors.contiguous().data<float>(),
+	  dL_dmeans3D.contiguous().data<float>(),
+	  dL_dcov3D.contiguous().data<float>(),
+	  dL_dsh.contiguous().data<float>(),
+	  dL_dscales.contiguous().data<float>(),
+	  dL_drotations.contiguous().data<float>(),
+	  debug,
+	  context != nullptr ? context->scratchBuffer(means3D.device()) : nullptr);
+  }
+
+  return std::make_tuple(dL_dmeans2D, dL_dcolors, dL_dopacity, dL_dmeans3D, dL_dcov3D, dL_dsh, dL_dscales, dL_drotations);
+}
+
+torch::Tensor markVisibleCPU(
+		torch::Tensor& means3D,
+		torch::Tensor& viewmatrix,
+		torch::Tensor& projmatrix)
+{
+  const int P = means3D.size(0);
+
+  torch::Tensor present = torch::full({P}, false, means3D.options().dtype(at::kBool));
+
+  if(P != 0)
+  {
+	CpuRasterizer::Rasterizer::markVisible(P,
+		means3D.contiguous().data<float>(),
+		viewmatrix.contiguous().data<float>(),
+		projmatrix.contiguous().data<float>(),
+		present.contiguous().data<bool>());
+  }
+
+  return present;
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+ComputeFilter3DCPU(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cameras)
+{
+  if (means3D.ndimension() != 2 || means3D.size(1) != 3) {
+    AT_ERROR("means3D must have dimensions (num_points, 3)");
+  }
+  if (cameras.ndimension() != 2 || cameras.size(1) != FILTER3D_CAMERA_STRIDE) {
+    AT_ERROR("cameras must have dimensions (num_cameras, 16)");
+  }
+
+  const int P = means3D.size(0);
+  const int C = cameras.size(0);
+
+  torch::Tensor distance = torch::full({P}, FILTER3D_MAX_DISTANCE, means3D.options().dtype(torch::kFloat32));
+  torch::Tensor valid = torch::zeros({P}, means3D.options().dtype(torch::kBool));
+
+  if (P != 0 && C != 0)
+  {
+	CpuRasterizer::Rasterizer::computeFilter3D(P, C,
+		means3D.contiguous().data<float>(),
+		cameras.contiguous().data<float>(),
+		distance.data<float>(),
+		valid.data<bool>());
+  }
+  return std::make_tuple(distance, valid);
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+BuildLODTreeCPU(
+	const torch::Tensor& means3D,
+	const torch::Tensor& cov3D,
+	const torch::Tensor& opacity,
+	const torch::Tensor& features)
+{
+  if (means3D.is_cuda() || cov3D.is_cuda() || opacity.is_cuda() || features.is_cuda()) {
+    AT_ERROR("LOD trees are built on the host, pass CPU tensors");
+  }
+  if (means3D.ndimension() != 2 || means3D.size(1) != 3) {
+    AT_ERROR("means3D must have dimensions (num_points, 3)");
+  }
+  const int P = means3D.size(0);
+  if (cov3D.ndimension() != 2 || cov3D.size(0) != P || cov3D.size(1) != 6) {
+    AT_ERROR("cov3D must have dimensions (num_points, 6)");
+  }
+  if (opacity.numel() != P || features.size(0) != P) {
+    AT_ERROR("opacity and features must have one row per point");
+  }
+
+  const int N = LOD::numNodes(P);
+  const torch::Tensor means_c = means3D.to(torch::kFloat32).contiguous();
+  const torch::Tensor cov3D_c = cov3D.to(torch::kFloat32).contiguous();
+  const torch::Tensor opacity_c = opacity.to(torch::kFloat32).contiguous();
+  const torch::Tensor features_c = features.to(torch::kFloat32).contiguous();
+  const int F = P ? features_c.numel() / P : 0;
+
+  auto float_opts = means3D.options().dtype(torch::kFloat32);
+  auto int_opts = means3D.options().dtype(torch::kInt32);
+  std::vector<int64_t> feature_shape = features.sizes().vec();
+  feature_shape[0] = N;
+
+  torch::Tensor left = torch::empty({N}, int_opts);
+  torch::Tensor right = torch::empty({N}, int_opts);
+  torch::Tensor node_means = torch::empty({N, 3}, float_opts);
+  torch::Tensor node_cov3D = torch::empty({N, 6}, float_opts);
+  torch::Tensor node_opacity = torch::empty({N, 1}, float_opts);
+  torch::Tensor node_features = torch::empty(feature_shape, float_opts);
+  torch::Tensor node_size = torch::empty({N}, float_opts);
+  torch::Tensor node_radius = torch::empty({N}, float_opts);
+
+  LOD::build(P, F,
+	means_c.data<float>(),
+	cov3D_c.data<float>(),
+	opacity_c.data<float>(),
+	features_c.data<float>(),
+	left.data<int>(),
+	right.data<int>(),
+	node_means.data<float>(),
+	node_cov3D.data<float>(),
+	node_opacity.data<float>(),
+	node_features.data<float>(),
+	node_size.data<float>(),
+	node_radius.data<float>());
+
+  return std::make_tuple(left, right, node_means, node_cov3D, node_opacity, node_features, node_size, node_radius);
+}
+
+torch::Tensor
+SelectLODCutCPU(
+	const torch::Tensor& left,
+	const torch::Tensor& right,
+	const torch::Tensor& node_means,
+	const torch::Tensor& node_size,
+	const torch::Tensor& node_radius,
+	const torch::Tensor& campos,
+	const float focal,
+	const float target_size)
+{
+  if (left.is_cuda() || node_means.is_cuda()) {
+    AT_ERROR("LOD cuts are selected on the host, pass CPU tensors");
+  }
+  const int N = left.size(0);
+  const int P = (N + 1) / 2;
+  if (right.size(0) != N || node_means.size(0) != N || node_size.size(0) != N || node_radius.size(0) != N) {
+    AT_ERROR("LOD tree tensors must have one row per node");
+  }
+
+  const torch::Tensor left_c = left.contiguous();
+  const torch::Tensor right_c = right.contiguous();
+  const torch::Tensor means_c = node_means.contiguous();
+  const torch::Tensor size_c = node_size.contiguous();
+  const torch::Tensor radius_c = node_radius.contiguous();
+  const torch::Tensor campos_c = campos.to(torch::kCPU, torch::kFloat32).contiguous();
+
+  std::vector<int> cut;
+  LOD::selectCut(P,
+	left_c.data<int>(),
+	right_c.data<int>(),
+	means_c.data<float>(),
+	size_c.data<float>(),
+	radius_c.data<float>(),
+	campos_c.data<float>(),
+	focal, target_size, cut);
+
+  torch::Tensor nodes = torch::empty({(long long)cut.size()}, left.options().dtype(torch::kLong));
+  std::copy(cut.begin(), cut.end(), nodes.data<int64_t>());
+  return nodes;
+}
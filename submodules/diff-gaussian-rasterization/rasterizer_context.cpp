@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "rasterizer_context.h"
+#include <algorithm>
+#include <map>
+#include <string>
+
+RasterizerContext::RasterizerContext(double growth_factor)
+	: growth(std::max(1.0, growth_factor))
+{
+}
+
+std::function<char*(size_t)> RasterizerContext::obtain(Arena& arena, const torch::Device& device)
+{
+	return [this, &arena, device](size_t N) {
+		arena.last_request = N;
+		arena.peak_request = std::max(arena.peak_request, N);
+
+		const bool wrong_device = arena.buffer.defined() && arena.buffer.device() != device;
+		if (!arena.buffer.defined() || wrong_device || (size_t)arena.buffer.numel() < N)
+		{
+			// Grow geometrically so that slowly increasing workloads
+			// (e.g., during densification) settle after a few calls.
+			size_t capacity = N;
+			if (arena.buffer.defined() && !wrong_device)
+				capacity = std::max(N, (size_t)(arena.buffer.numel() * growth));
+			arena.buffer = torch::empty({(long long)capacity}, torch::TensorOptions(torch::kByte).device(device));
+			arena.allocations++;
+		}
+		return reinterpret_cast<char*>(arena.buffer.data_ptr());
+	};
+}
+
+std::function<char*(size_t)> RasterizerContext::geometryBuffer(const torch::Device& device)
+{
+	return obtain(geom, device);
+}
+
+std::function<char*(size_t)> RasterizerContext::binningBuffer(const torch::Device& device)
+{
+	return obtain(binning_, device);
+}
+
+std::function<char*(size_t)> RasterizerContext::imageBuffer(const torch::Device& device)
+{
+	return obtain(img, device);
+}
+
+std::function<char*(size_t)> RasterizerContext::scratchBuffer(const torch::Device& device)
+{
+	return obtain(scratch, device);
+}
+
+void RasterizerContext::setCoherentSort(bool enabled, double max_rotation)
+{
+	coherent_enabled = enabled;
+	coherent.max_rotation = (float)max_rotation;
+	coherent.forget();
+}
+
+CoherentSort* RasterizerContext::coherentSort(const torch::Device& device)
+{
+	if (!coherent_enabled)
+		return nullptr;
+	coherent.orderBuffer = obtain(order, device);
+	return &coherent;
+}
+
+void RasterizerContext::reserve(const torch::Device& device, size_t geom_bytes, size_t binning_bytes, size_t image_bytes)
+{
+	// Reservations are not requests, keep the request statistics intact.
+	for (auto& entry : { std::make_pair(&geom, geom_bytes), std::make_pair(&binning_, binning_bytes), std::make_pair(&img, image_bytes) })
+	{
+		Arena& arena = *entry.first;
+		const size_t last = arena.last_request, peak = arena.peak_request;
+		obtain(arena, device)(entry.second);
+		arena.last_request = last;
+		arena.peak_request = peak;
+	}
+}
+
+void RasterizerContext::release()
+{
+	for (Arena* arena : { &geom, &binning_, &img, &scratch, &order })
+		arena->buffer = torch::Tensor();
+	coherent.forget();
+}
+
+void RasterizerContext::resetStats()
+{
+	calls = 0;
+	coherent.frames = 0;
+	coherent.full_sorts = 0;
+	for (Arena* arena : { &geom, &binning_, &img, &scratch, &order })
+	{
+		arena->peak_request = 0;
+		arena->last_request = 0;
+		arena->allocations = 0;
+	}
+}
+
+std::map<std::string, int64_t> RasterizerContext::stats() const
+{
+	std::map<std::string, int64_t> result;
+	result["calls"] = calls;
+	int64_t allocations = 0, reserved = 0;
+	const std::pair<const char*, const Arena*> arenas[] = { { "geometry", &geom }, { "binning", &binning_ }, { "image", &img }, { "scratch", &scratch }, { "order", &order } };
+	for (const auto& entry : arenas)
+	{
+		const std::string name = entry.first;
+		const Arena& arena = *entry.second;
+		const int64_t capacity = arena.buffer.defined() ? arena.buffer.numel() : 0;
+		result[name + "_bytes"] = capacity;
+		result[name + "_peak_bytes"] = arena.peak_request;
+		result[name + "_last_bytes"] = arena.last_request;
+		result[name + "_allocations"] = arena.allocations;
+		allocations += arena.allocations;
+		reserved += capacity;
+	}
+	result["allocations"] = allocations;
+	result["reserved_bytes"] = reserved;
+	result["coherent_frames"] = coherent.frames;
+	result["coherent_full_sorts"] = coherent.full_sorts;
+	return result;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <functional>
+#include <cstdint>
+#include <map>
+#include <string>
+#include "cuda_rasterizer/coherent_sort.h"
+
+// Long-lived owner of the rasterizer's auxiliary buffers. Instead of
+// allocating fresh geometry/binning/image buffers for every call, the
+// arenas kept here only grow (geometrically, up to the high-water mark)
+// and are reused by all subsequent calls on the same device.
+//
+// Note that the buffers handed to a backward pass are the arenas
+// themselves: a forward pass using the same context overwrites the
+// state that a still pending backward pass relies on.
+class RasterizerContext
+{
+public:
+	struct Arena
+	{
+		torch::Tensor buffer;
+		size_t peak_request = 0;
+		size_t last_request = 0;
+		int64_t allocations = 0;
+	};
+
+	explicit RasterizerContext(double growth_factor = 1.5);
+
+	std::function<char*(size_t)> geometryBuffer(const torch::Device& device);
+	std::function<char*(size_t)> binningBuffer(const torch::Device& device);
+	std::function<char*(size_t)> imageBuffer(const torch::Device& device);
+	// Scratch memory of the host backward pass (per-instance gradients).
+	std::function<char*(size_t)> scratchBuffer(const torch::Device& device);
+
+	const torch::Tensor& geometry() const { return geom.buffer; }
+	const torch::Tensor& binning() const { return binning_.buffer; }
+	const torch::Tensor& image() const { return img.buffer; }
+
+	// Keeps the depth order of the Gaussians across the forward passes of
+	// this context, for the frames of an interactive viewer, see
+	// CoherentSort. The order lives in an arena of its own.
+	void setCoherentSort(bool enabled, double max_rotation);
+	// The state to pass to a forward pass, nullptr while disabled.
+	CoherentSort* coherentSort(const torch::Device& device);
+
+	// Grow the arenas to at least the given sizes (in bytes) up front.
+	void reserve(const torch::Device& device, size_t geom_bytes, size_t binning_bytes, size_t image_bytes);
+	// Free all arenas. They are reallocated on the next call.
+	void release();
+	void resetStats();
+	void countCall() { calls++; }
+
+	// Allocation statistics: number of calls, number of arena
+	// (re)allocations and current/peak sizes in bytes.
+	std::map<std::string, int64_t> stats() const;
+
+private:
+	std::function<char*(size_t)> obtain(Arena& arena, const torch::Device& device);
+
+	double growth;
+	int64_t calls = 0;
+	Arena geom;
+	Arena binning_;
+	Arena img;
+	Arena scratch;
+	Arena order;
+	bool coherent_enabled = false;
+	CoherentSort coherent;
+};
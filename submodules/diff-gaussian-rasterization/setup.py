@@ -10,24 +10,56 @@
 #
 
 from setuptools import setup
-from torch.utils.cpp_extension import CUDAExtension, BuildExtension
+from torch.utils.cpp_extension import CUDAExtension, CppExtension, BuildExtension, CUDA_HOME
 import os
-os.path.dirname(os.path.abspath(__file__))
+import platform
+root = os.path.dirname(os.path.abspath(__file__))
+
+# The host rasterizer is always built. Set DIFF_RASTERIZATION_CPU_ONLY=1 to
+# skip the CUDA sources, and DIFF_RASTERIZATION_CPU_ARCH to set the target
+# architecture of the host code. The default is a baseline that any recent
+# x86-64 machine runs, so that a build can be shared across a cluster;
+# "native" enables the AVX2 / AVX-512 paths of the build machine.
+cpu_only = os.environ.get("DIFF_RASTERIZATION_CPU_ONLY", "0") == "1" or CUDA_HOME is None
+cpu_arch = os.environ.get("DIFF_RASTERIZATION_CPU_ARCH", "x86-64-v2" if platform.machine() in ("x86_64", "AMD64") else "")
+
+cpu_sources = [
+    "cpu_rasterizer/rasterizer_impl.cpp",
+    "cpu_rasterizer/forward.cpp",
+    "cpu_rasterizer/backward.cpp",
+    "cpu_rasterizer/lod.cpp",
+    "cpu_rasterizer/bvh.cpp",
+    "cpu_rasterizer/tile_scheduler.cpp",
+    "rasterize_points_cpu.cpp",
+    "rasterizer_context.cpp",
+    "ext.cpp"]
+cuda_sources = [
+    "cuda_rasterizer/rasterizer_impl.cu",
+    "cuda_rasterizer/forward.cu",
+    "cuda_rasterizer/backward.cu",
+    "rasterize_points.cu"]
+
+glm_dir = os.path.join(root, "third_party/glm/")
+cxx_args = ["-O3", "-fopenmp", "-I" + glm_dir] + (["-march=" + cpu_arch] if cpu_arch else [])
+
+if cpu_only:
+    extension = CppExtension(
+        name="diff_gaussian_rasterization._C",
+        sources=cpu_sources,
+        extra_compile_args={"cxx": cxx_args},
+        extra_link_args=["-fopenmp"])
+else:
+    extension = CUDAExtension(
+        name="diff_gaussian_rasterization._C",
+        sources=cuda_sources + cpu_sources,
+        define_macros=[("WITH_CUDA", None)],
+        extra_compile_args={"cxx": cxx_args, "nvcc": ["-I" + glm_dir]},
+        extra_link_args=["-fopenmp"])
 
 setup(
     name="diff_gaussian_rasterization",
     packages=['diff_gaussian_rasterization'],
-    ext_modules=[
-        CUDAExtension(
-            name="diff_gaussian_rasterization._C",
-            sources=[
-            "cuda_rasterizer/rasterizer_impl.cu",
-            "cuda_rasterizer/forward.cu",
-            "cuda_rasterizer/backward.cu",
-            "rasterize_points.cu",
-            "ext.cpp"],
-            extra_compile_args={"nvcc": ["-I" + os.path.join(os.path.dirname(os.path.abspath(__file__)), "third_party/glm/")]})
-        ],
+    ext_modules=[extension],
     cmdclass={
         'build_ext': BuildExtension
     }
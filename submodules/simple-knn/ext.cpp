@@ -11,7 +11,37 @@
 
 #include <torch/extension.h>
 #include "spatial.h"
+#include "knn_tree.h"
+
+// Exact K nearest neighbors, on the device of the points
+std::tuple<torch::Tensor, torch::Tensor>
+Knn(const torch::Tensor& points, const int K, const bool return_indices)
+{
+  if (points.ndimension() != 2 || points.size(1) != 3) {
+    AT_ERROR("points must have dimensions (num_points, 3)");
+  }
+  if (K < 1 || K > KNN_MAX_K) {
+    AT_ERROR("K must be between 1 and ", KNN_MAX_K);
+  }
+  if (points.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return KnnCUDA(points, K, return_indices);
+#else
+    AT_ERROR("simple_knn was built without CUDA support");
+#endif
+  }
+  return KnnCPU(points, K, return_indices);
+}
+
+// Mean squared distance to the 3 nearest neighbors. Despite the name,
+// CPU tensors are supported as well.
+torch::Tensor distCUDA2(const torch::Tensor& points)
+{
+  return std::get<0>(Knn(points, 3, false)).mean(1);
+}
 
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
   m.def("distCUDA2", &distCUDA2);
+  m.def("knn", &Knn, pybind11::arg("points"), pybind11::arg("K") = 3, pybind11::arg("return_indices") = false);
 }
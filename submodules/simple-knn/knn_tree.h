@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef KNN_TREE_H_INCLUDED
+#define KNN_TREE_H_INCLUDED
+
+#include <float.h>
+#include <stdint.h>
+
+// Balanced k-d tree for exact nearest neighbor queries, shared by the CUDA
+// and the host implementation.
+//
+// The tree is implicit in the order of the points: a node spans the
+// positions [first, first + count), its split point sits at the middle
+// position mid = first + count / 2 and its children span [first, mid) and
+// [mid + 1, first + count). Along the node's split axis, stored at
+// axes[mid], points of the left child are <= the split point and points of
+// the right child >= it. The axis is the longest side of the node's cell,
+// the bounding box of the cloud cut by the split planes of its ancestors,
+// so the tree depends only on the points and is the same for both builds.
+#ifdef __CUDACC__
+#define KNN_FUNC __host__ __device__ __forceinline__
+#else
+#define KNN_FUNC inline
+#endif
+
+// Largest supported number of neighbors
+#define KNN_MAX_K 32
+// Traversal stack, one entry per level at most
+#define KNN_STACK_SIZE 64
+
+KNN_FUNC int knnMid(int first, int count)
+{
+	return first + count / 2;
+}
+
+KNN_FUNC uint8_t knnSplitAxis(const float* lo, const float* hi)
+{
+	const float ex = hi[0] - lo[0], ey = hi[1] - lo[1], ez = hi[2] - lo[2];
+	return (ex >= ey && ex >= ez) ? 0 : (ey >= ez ? 1 : 2);
+}
+
+// Locates the node at depth target_depth (or the shallower split) that
+// contains position s, given that the split points and axes of all levels
+// above it are final. Returns false if s is the split point of a
+// shallower node, otherwise the node's range and cell.
+KNN_FUNC bool knnLocate(
+	int P, const float* points, const uint8_t* axes,
+	int s, int target_depth, int& first, int& count, float* lo, float* hi)
+{
+	first = 0;
+	count = P;
+	for (int depth = 0; depth < target_depth; depth++)
+	{
+		const int mid = knnMid(first, count);
+		if (s == mid)
+			return false;
+		const int axis = axes[mid];
+		const float split = points[3 * mid + axis];
+		if (s < mid)
+		{
+			count = mid - first;
+			hi[axis] = split;
+		}
+		else
+		{
+			count = first + count - mid - 1;
+			first = mid + 1;
+			lo[axis] = split;
+		}
+	}
+	return true;
+}
+
+// Keeps best_d[0, K) ascending
+KNN_FUNC void knnInsert(float d, int j, int K, float* best_d, int* best_i)
+{
+	int k = K - 1;
+	while (k > 0 && best_d[k - 1] > d)
+	{
+		best_d[k] = best_d[k - 1];
+		best_i[k] = best_i[k - 1];
+		k--;
+	}
+	best_d[k] = d;
+	best_i[k] = j;
+}
+
+// Exact K nearest neighbors (squared distances, ascending) of the point p
+// with id self, which is excluded. points and ids are in tree order. The
+// far child of a node is only visited if its split plane is closer than
+// the current K-th neighbor; as rounding is monotonic, no point behind the
+// plane can be closer than that. Missing neighbors (P <= K) are reported
+// with FLT_MAX and id -1.
+KNN_FUNC void knnSearch(
+	int P,
+	const float* points,
+	const int* ids,
+	const uint8_t* axes,
+	int self, const float* p, int K,
+	float* best_d, int* best_i)
+{
+	for (int k = 0; k < K; k++)
+	{
+		best_d[k] = FLT_MAX;
+		best_i[k] = -1;
+	}
+
+	int stack_first[KNN_STACK_SIZE], stack_count[KNN_STACK_SIZE];
+	float stack_bound[KNN_STACK_SIZE];
+	int top = 0;
+	stack_first[0] = 0;
+	stack_count[0] = P;
+	stack_bound[0] = 0.0f;
+	top++;
+
+	while (top > 0)
+	{
+		top--;
+		if (stack_bound[top] >= best_d[K - 1])
+			continue;
+		int first = stack_first[top];
+		int count = stack_count[top];
+
+		while (count > 0)
+		{
+			const int mid = knnMid(first, count);
+			const float ex = points[3 * mid] - p[0];
+			const float ey = points[3 * mid + 1] - p[1];
+			const float ez = points[3 * mid + 2] - p[2];
+			const float d = ex * ex + ey * ey + ez * ez;
+			if (d < best_d[K - 1] && ids[mid] != self)
+				knnInsert(d, ids[mid], K, best_d, best_i);
+
+			const int axis = axes[mid];
+			const float diff = p[axis] - points[3 * mid + axis];
+			const int left_count = mid - first;
+			const int right_count = first + count - mid - 1;
+			const bool go_left = diff < 0.0f;
+
+			// Far side first onto the stack, then descend into the near side
+			const int far_count = go_left ? right_count : left_count;
+			if (far_count > 0 && diff * diff < best_d[K - 1])
+			{
+				stack_first[top] = go_left ? mid + 1 : first;
+				stack_count[top] = far_count;
+				stack_bound[top] = diff * diff;
+				top++;
+			}
+			if (go_left)
+				count = left_count;
+			else
+			{
+				first = mid + 1;
+				count = right_count;
+			}
+		}
+	}
+}
+
+#endif
@@ -10,25 +10,49 @@
 #
 
 from setuptools import setup
-from torch.utils.cpp_extension import CUDAExtension, BuildExtension
+from torch.utils.cpp_extension import CUDAExtension, CppExtension, BuildExtension, CUDA_HOME
 import os
 
+# The host search is always built. Set SIMPLE_KNN_CPU_ONLY=1 to skip the
+# CUDA sources.
+cpu_only = os.environ.get("SIMPLE_KNN_CPU_ONLY", "0") == "1" or CUDA_HOME is None
+
 cxx_compiler_flags = []
 
 if os.name == 'nt':
     cxx_compiler_flags.append("/wd4624")
+    cxx_compiler_flags.append("/openmp")
+    link_flags = []
+else:
+    cxx_compiler_flags.append("-O3")
+    cxx_compiler_flags.append("-fopenmp")
+    link_flags = ["-fopenmp"]
+
+cpu_sources = [
+    "simple_knn_cpu.cpp",
+    "spatial_cpu.cpp",
+    "ext.cpp"]
+cuda_sources = [
+    "spatial.cu", 
+    "simple_knn.cu"]
+
+if cpu_only:
+    extension = CppExtension(
+        name="simple_knn._C",
+        sources=cpu_sources,
+        extra_compile_args={"cxx": cxx_compiler_flags},
+        extra_link_args=link_flags)
+else:
+    extension = CUDAExtension(
+        name="simple_knn._C",
+        sources=cuda_sources + cpu_sources,
+        define_macros=[("WITH_CUDA", None)],
+        extra_compile_args={"nvcc": [], "cxx": cxx_compiler_flags},
+        extra_link_args=link_flags)
 
 setup(
     name="simple_knn",
-    ext_modules=[
-        CUDAExtension(
-            name="simple_knn._C",
-            sources=[
-            "spatial.cu", 
-            "simple_knn.cu",
-            "ext.cpp"],
-            extra_compile_args={"nvcc": [], "cxx": cxx_compiler_flags})
-        ],
+    ext_modules=[extension],
     cmdclass={
         'build_ext': BuildExtension
     }
@@ -9,20 +9,17 @@
  * For inquiries contact  george.drettakis@inria.fr
  */
 
-#define BOX_SIZE 1024
-
 #include "cuda_runtime.h"
 #include "device_launch_parameters.h"
 #include "simple_knn.h"
+#include "knn_tree.h"
 #include <cub/cub.cuh>
 #include <cub/device/device_radix_sort.cuh>
 #include <vector>
 #include <cuda_runtime_api.h>
 #include <thrust/device_vector.h>
 #include <thrust/sequence.h>
-#define __CUDACC__
 #include <cooperative_groups.h>
-#include <cooperative_groups/reduce.h>
 
 namespace cg = cooperative_groups;
 
@@ -42,180 +39,114 @@ struct CustomMax
 	}
 };
 
-__host__ __device__ uint32_t prepMorton(uint32_t x)
+// Maps floats to unsigned integers of the same order
+__device__ __forceinline__ uint32_t orderedBits(float f)
 {
-	x = (x | (x << 16)) & 0x030000FF;
-	x = (x | (x << 8)) & 0x0300F00F;
-	x = (x | (x << 4)) & 0x030C30C3;
-	x = (x | (x << 2)) & 0x09249249;
-	return x;
-}
-
-__host__ __device__ uint32_t coord2Morton(float3 coord, float3 minn, float3 maxx)
-{
-	uint32_t x = prepMorton(((coord.x - minn.x) / (maxx.x - minn.x)) * ((1 << 10) - 1));
-	uint32_t y = prepMorton(((coord.y - minn.y) / (maxx.y - minn.y)) * ((1 << 10) - 1));
-	uint32_t z = prepMorton(((coord.z - minn.z) / (maxx.z - minn.z)) * ((1 << 10) - 1));
-
-	return x | (y << 1) | (z << 2);
+	const uint32_t u = __float_as_uint(f);
+	return (u & 0x80000000) ? ~u : (u | 0x80000000);
 }
 
-__global__ void coord2Morton(int P, const float3* points, float3 minn, float3 maxx, uint32_t* codes)
+// Sort keys for one level of the tree: points of a node at this depth are
+// keyed by the node's first position and their coordinate along its split
+// axis, split points of the levels above by their own (final) position,
+// so that sorting the keys performs the median splits of all nodes of
+// the level at once. Also stores the split axes of the level's nodes.
+__global__ void levelKeys(int P, int depth, const float* points, uint8_t* axes, float3 minn, float3 maxx, uint64_t* keys)
 {
 	auto idx = cg::this_grid().thread_rank();
 	if (idx >= P)
 		return;
 
-	codes[idx] = coord2Morton(points[idx], minn, maxx);
-}
-
-struct MinMax
-{
-	float3 minn;
-	float3 maxx;
-};
-
-__global__ void boxMinMax(uint32_t P, float3* points, uint32_t* indices, MinMax* boxes)
-{
-	auto idx = cg::this_grid().thread_rank();
-
-	MinMax me;
-	if (idx < P)
-	{
-		me.minn = points[indices[idx]];
-		me.maxx = points[indices[idx]];
-	}
-	else
+	float lo[3] = { minn.x, minn.y, minn.z };
+	float hi[3] = { maxx.x, maxx.y, maxx.z };
+	int first, count;
+	if (!knnLocate(P, points, axes, idx, depth, first, count, lo, hi))
 	{
-		me.minn = { FLT_MAX, FLT_MAX, FLT_MAX };
-		me.maxx = { -FLT_MAX,-FLT_MAX,-FLT_MAX };
-	}
-
-	__shared__ MinMax redResult[BOX_SIZE];
-
-	for (int off = BOX_SIZE / 2; off >= 1; off /= 2)
-	{
-		if (threadIdx.x < 2 * off)
-			redResult[threadIdx.x] = me;
-		__syncthreads();
-
-		if (threadIdx.x < off)
-		{
-			MinMax other = redResult[threadIdx.x + off];
-			me.minn.x = min(me.minn.x, other.minn.x);
-			me.minn.y = min(me.minn.y, other.minn.y);
-			me.minn.z = min(me.minn.z, other.minn.z);
-			me.maxx.x = max(me.maxx.x, other.maxx.x);
-			me.maxx.y = max(me.maxx.y, other.maxx.y);
-			me.maxx.z = max(me.maxx.z, other.maxx.z);
-		}
-		__syncthreads();
+		keys[idx] = (uint64_t)idx << 32;
+		return;
 	}
 
-	if (threadIdx.x == 0)
-		boxes[blockIdx.x] = me;
+	const uint8_t axis = knnSplitAxis(lo, hi);
+	if (idx == knnMid(first, count))
+		axes[idx] = axis;
+	keys[idx] = ((uint64_t)first << 32) | orderedBits(points[3 * idx + axis]);
 }
 
-__device__ __host__ float distBoxPoint(const MinMax& box, const float3& p)
+__global__ void gatherPoints(int P, const float* points, const int* ids, float* tree_points)
 {
-	float3 diff = { 0, 0, 0 };
-	if (p.x < box.minn.x || p.x > box.maxx.x)
-		diff.x = min(abs(p.x - box.minn.x), abs(p.x - box.maxx.x));
-	if (p.y < box.minn.y || p.y > box.maxx.y)
-		diff.y = min(abs(p.y - box.minn.y), abs(p.y - box.maxx.y));
-	if (p.z < box.minn.z || p.z > box.maxx.z)
-		diff.z = min(abs(p.z - box.minn.z), abs(p.z - box.maxx.z));
-	return diff.x * diff.x + diff.y * diff.y + diff.z * diff.z;
-}
+	auto idx = cg::this_grid().thread_rank();
+	if (idx >= P)
+		return;
 
-template<int K>
-__device__ void updateKBest(const float3& ref, const float3& point, float* knn)
-{
-	float3 d = { point.x - ref.x, point.y - ref.y, point.z - ref.z };
-	float dist = d.x * d.x + d.y * d.y + d.z * d.z;
-	for (int j = 0; j < K; j++)
-	{
-		if (knn[j] > dist)
-		{
-			float t = knn[j];
-			knn[j] = dist;
-			dist = t;
-		}
-	}
+	const int i = ids[idx];
+	tree_points[3 * idx] = points[3 * i];
+	tree_points[3 * idx + 1] = points[3 * i + 1];
+	tree_points[3 * idx + 2] = points[3 * i + 2];
 }
 
-__global__ void boxMeanDist(uint32_t P, float3* points, uint32_t* indices, MinMax* boxes, float* dists)
+// One thread per point, in tree order so that neighboring threads
+// traverse similar paths
+__global__ void searchKNN(int P, int K, const float* tree_points, const int* ids, const uint8_t* axes, float* dists, int* indices)
 {
-	int idx = cg::this_grid().thread_rank();
+	auto idx = cg::this_grid().thread_rank();
 	if (idx >= P)
 		return;
 
-	float3 point = points[indices[idx]];
-	float best[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
-
-	for (int i = max(0, idx - 3); i <= min(P - 1, idx + 3); i++)
+	const int i = ids[idx];
+	const float p[3] = { tree_points[3 * idx], tree_points[3 * idx + 1], tree_points[3 * idx + 2] };
+	float best_d[KNN_MAX_K];
+	int best_i[KNN_MAX_K];
+	knnSearch(P, tree_points, ids, axes, i, p, K, best_d, best_i);
+	for (int k = 0; k < K; k++)
 	{
-		if (i == idx)
-			continue;
-		updateKBest<3>(point, points[indices[i]], best);
+		dists[(size_t)i * K + k] = best_d[k];
+		if (indices)
+			indices[(size_t)i * K + k] = best_i[k];
 	}
-
-	float reject = best[2];
-	best[0] = FLT_MAX;
-	best[1] = FLT_MAX;
-	best[2] = FLT_MAX;
-
-	for (int b = 0; b < (P + BOX_SIZE - 1) / BOX_SIZE; b++)
-	{
-		MinMax box = boxes[b];
-		float dist = distBoxPoint(box, point);
-		if (dist > reject || dist > best[2])
-			continue;
-
-		for (int i = b * BOX_SIZE; i < min(P, (b + 1) * BOX_SIZE); i++)
-		{
-			if (i == idx)
-				continue;
-			updateKBest<3>(point, points[indices[i]], best);
-		}
-	}
-	dists[indices[idx]] = (best[0] + best[1] + best[2]) / 3.0f;
 }
 
-void SimpleKNN::knn(int P, float3* points, float* meanDists)
+void SimpleKNN::knn(int P, int K, const float* points, float* dists, int* indices)
 {
+	if (P == 0)
+		return;
+
 	float3* result;
 	cudaMalloc(&result, sizeof(float3));
 	size_t temp_storage_bytes;
 
-	float3 init = { 0, 0, 0 }, minn, maxx;
+	float3 init_min = { FLT_MAX, FLT_MAX, FLT_MAX }, init_max = { -FLT_MAX, -FLT_MAX, -FLT_MAX }, minn, maxx;
+	const float3* points3 = (const float3*)points;
 
-	cub::DeviceReduce::Reduce(nullptr, temp_storage_bytes, points, result, P, CustomMin(), init);
+	cub::DeviceReduce::Reduce(nullptr, temp_storage_bytes, points3, result, P, CustomMin(), init_min);
 	thrust::device_vector<char> temp_storage(temp_storage_bytes);
 
-	cub::DeviceReduce::Reduce(temp_storage.data().get(), temp_storage_bytes, points, result, P, CustomMin(), init);
+	cub::DeviceReduce::Reduce(temp_storage.data().get(), temp_storage_bytes, points3, result, P, CustomMin(), init_min);
 	cudaMemcpy(&minn, result, sizeof(float3), cudaMemcpyDeviceToHost);
 
-	cub::DeviceReduce::Reduce(temp_storage.data().get(), temp_storage_bytes, points, result, P, CustomMax(), init);
+	cub::DeviceReduce::Reduce(temp_storage.data().get(), temp_storage_bytes, points3, result, P, CustomMax(), init_max);
 	cudaMemcpy(&maxx, result, sizeof(float3), cudaMemcpyDeviceToHost);
 
-	thrust::device_vector<uint32_t> morton(P);
-	thrust::device_vector<uint32_t> morton_sorted(P);
-	coord2Morton << <(P + 255) / 256, 256 >> > (P, points, minn, maxx, morton.data().get());
+	// Level by level construction of the tree, see knn_tree.h
+	thrust::device_vector<uint64_t> keys(P), keys_alt(P);
+	thrust::device_vector<int> ids(P), ids_alt(P);
+	thrust::device_vector<uint8_t> axes(P);
+	thrust::device_vector<float> tree_points(thrust::device_pointer_cast(points), thrust::device_pointer_cast(points) + 3 * (size_t)P);
+	thrust::sequence(ids.begin(), ids.end());
+	cub::DoubleBuffer<uint64_t> sort_keys(keys.data().get(), keys_alt.data().get());
+	cub::DoubleBuffer<int> sort_ids(ids.data().get(), ids_alt.data().get());
 
-	thrust::device_vector<uint32_t> indices(P);
-	thrust::sequence(indices.begin(), indices.end());
-	thrust::device_vector<uint32_t> indices_sorted(P);
-
-	cub::DeviceRadixSort::SortPairs(nullptr, temp_storage_bytes, morton.data().get(), morton_sorted.data().get(), indices.data().get(), indices_sorted.data().get(), P);
+	cub::DeviceRadixSort::SortPairs(nullptr, temp_storage_bytes, sort_keys, sort_ids, P);
 	temp_storage.resize(temp_storage_bytes);
 
-	cub::DeviceRadixSort::SortPairs(temp_storage.data().get(), temp_storage_bytes, morton.data().get(), morton_sorted.data().get(), indices.data().get(), indices_sorted.data().get(), P);
+	const int blocks = (P + 255) / 256;
+	for (int depth = 0; (1ll << depth) <= P; depth++)
+	{
+		levelKeys << <blocks, 256 >> > (P, depth, tree_points.data().get(), axes.data().get(), minn, maxx, sort_keys.Current());
+		cub::DeviceRadixSort::SortPairs(temp_storage.data().get(), temp_storage_bytes, sort_keys, sort_ids, P);
+		gatherPoints << <blocks, 256 >> > (P, points, sort_ids.Current(), tree_points.data().get());
+	}
 
-	uint32_t num_boxes = (P + BOX_SIZE - 1) / BOX_SIZE;
-	thrust::device_vector<MinMax> boxes(num_boxes);
-	boxMinMax << <num_boxes, BOX_SIZE >> > (P, points, indices_sorted.data().get(), boxes.data().get());
-	boxMeanDist << <num_boxes, BOX_SIZE >> > (P, points, indices_sorted.data().get(), boxes.data().get(), meanDists);
+	searchKNN << <blocks, 256 >> > (P, K, tree_points.data().get(), sort_ids.Current(), axes.data().get(), dists, indices);
 
 	cudaFree(result);
-}
\ No newline at end of file
+}
@@ -12,10 +12,22 @@
 #ifndef SIMPLEKNN_H_INCLUDED
 #define SIMPLEKNN_H_INCLUDED
 
+// Exact K nearest neighbors of every point of a cloud (excluding the point
+// itself), see knn_tree.h. points is P x 3, dists receives P x K squared
+// distances in ascending order and indices, if not null, the P x K ids of
+// the neighbors. Points without K neighbors get FLT_MAX and id -1 for the
+// missing ones. SimpleKNN works on device memory, SimpleKNNCpu on host
+// memory.
 class SimpleKNN
 {
 public:
-	static void knn(int P, float3* points, float* meanDists);
+	static void knn(int P, int K, const float* points, float* dists, int* indices);
 };
 
-#endif
\ No newline at end of file
+class SimpleKNNCpu
+{
+public:
+	static void knn(int P, int K, const float* points, float* dists, int* indices);
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "simple_knn.h"
+#include "knn_tree.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <omp.h>
+
+namespace
+{
+	// Subtrees below this size are built by the task that reaches them
+	constexpr int TASK_SIZE = 1 << 14;
+
+	void buildNode(const float* points, int* ids, uint8_t* axes, int first, int count, float lo[3], float hi[3])
+	{
+		if (count <= 0)
+			return;
+		const int mid = knnMid(first, count);
+		const uint8_t axis = knnSplitAxis(lo, hi);
+		std::nth_element(ids + first, ids + mid, ids + first + count, [&](int i, int j) {
+			return points[3 * i + axis] < points[3 * j + axis];
+		});
+		axes[mid] = axis;
+		const float split = points[3 * ids[mid] + axis];
+
+		float left_hi[3] = { hi[0], hi[1], hi[2] };
+		float right_lo[3] = { lo[0], lo[1], lo[2] };
+		left_hi[axis] = split;
+		right_lo[axis] = split;
+		#pragma omp task if(count > TASK_SIZE)
+		buildNode(points, ids, axes, first, mid - first, lo, left_hi);
+		buildNode(points, ids, axes, mid + 1, first + count - mid - 1, right_lo, hi);
+		#pragma omp taskwait
+	}
+}
+
+void SimpleKNNCpu::knn(int P, int K, const float* points, float* dists, int* indices)
+{
+	if (P == 0)
+		return;
+
+	float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = 0; i < P; i++)
+		for (int k = 0; k < 3; k++)
+		{
+			lo[k] = std::min(lo[k], points[3 * i + k]);
+			hi[k] = std::max(hi[k], points[3 * i + k]);
+		}
+
+	std::vector<int> ids(P);
+	std::vector<uint8_t> axes(P);
+	std::iota(ids.begin(), ids.end(), 0);
+	#pragma omp parallel
+	#pragma omp single
+	buildNode(points, ids.data(), axes.data(), 0, P, lo, hi);
+
+	std::vector<float> tree_points(3 * (size_t)P);
+	#pragma omp parallel for schedule(static)
+	for (int s = 0; s < P; s++)
+		for (int k = 0; k < 3; k++)
+			tree_points[3 * (size_t)s + k] = points[3 * (size_t)ids[s] + k];
+
+	// Queries in tree order are spatially coherent; their cost varies
+	// with the local density
+	#pragma omp parallel for schedule(dynamic, 256)
+	for (int s = 0; s < P; s++)
+	{
+		const int i = ids[s];
+		float best_d[KNN_MAX_K];
+		int best_i[KNN_MAX_K];
+		knnSearch(P, tree_points.data(), ids.data(), axes.data(), i, &tree_points[3 * (size_t)s], K, best_d, best_i);
+		for (int k = 0; k < K; k++)
+		{
+			dists[(size_t)i * K + k] = best_d[k];
+			if (indices)
+				indices[(size_t)i * K + k] = best_i[k];
+		}
+	}
+}
@@ -12,15 +12,19 @@
 #include "spatial.h"
 #include "simple_knn.h"
 
-torch::Tensor
-distCUDA2(const torch::Tensor& points)
+std::tuple<torch::Tensor, torch::Tensor>
+KnnCUDA(const torch::Tensor& points, const int K, const bool return_indices)
 {
   const int P = points.size(0);
+  const torch::Tensor points_c = points.to(torch::kFloat32).contiguous();
 
   auto float_opts = points.options().dtype(torch::kFloat32);
-  torch::Tensor means = torch::full({P}, 0.0, float_opts);
-  
-  SimpleKNN::knn(P, (float3*)points.contiguous().data<float>(), means.contiguous().data<float>());
+  auto int_opts = points.options().dtype(torch::kInt32);
+  torch::Tensor dists = torch::full({P, K}, 0.0, float_opts);
+  torch::Tensor indices = torch::full({return_indices ? P : 0, K}, -1, int_opts);
 
-  return means;
-}
\ No newline at end of file
+  SimpleKNN::knn(P, K, points_c.data_ptr<float>(), dists.data_ptr<float>(),
+    return_indices ? indices.data_ptr<int>() : nullptr);
+
+  return std::make_tuple(dists, indices);
+}
@@ -11,4 +11,11 @@
 
 #include <torch/extension.h>
 
-torch::Tensor distCUDA2(const torch::Tensor& points);
\ No newline at end of file
+// Squared distances (P, K) to the K nearest neighbors of every point of a
+// (P, 3) cloud and, if requested, their ids (P, K) as int32 (otherwise an
+// empty tensor). Points without K neighbors get FLT_MAX and id -1.
+std::tuple<torch::Tensor, torch::Tensor>
+KnnCUDA(const torch::Tensor& points, const int K, const bool return_indices);
+
+std::tuple<torch::Tensor, torch::Tensor>
+KnnCPU(const torch::Tensor& points, const int K, const bool return_indices);
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "spatial.h"
+#include "simple_knn.h"
+
+std::tuple<torch::Tensor, torch::Tensor>
+KnnCPU(const torch::Tensor& points, const int K, const bool return_indices)
+{
+  const int P = points.size(0);
+  const torch::Tensor points_c = points.to(torch::kFloat32).contiguous();
+
+  auto float_opts = points.options().dtype(torch::kFloat32);
+  auto int_opts = points.options().dtype(torch::kInt32);
+  torch::Tensor dists = torch::full({P, K}, 0.0, float_opts);
+  torch::Tensor indices = torch::full({return_indices ? P : 0, K}, -1, int_opts);
+
+  SimpleKNNCpu::knn(P, K, points_c.data_ptr<float>(), dists.data_ptr<float>(),
+    return_indices ? indices.data_ptr<int>() : nullptr);
+
+  return std::make_tuple(dists, indices);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "chunk_tensors.h"
+#include "splat_tensors.h"
+#include <cstring>
+
+std::unique_ptr<SplatIO::ChunkCache> createChunkCache(
+	const std::string& path,
+	const std::string& table_path,
+	const int64_t budget_bytes,
+	const int threads)
+{
+	if (budget_bytes <= 0) {
+		AT_ERROR("The chunk cache needs a positive budget");
+	}
+	SplatIO::ChunkCache::Options options;
+	options.budget_bytes = (uint64_t)budget_bytes;
+	options.threads = threads;
+	return std::make_unique<SplatIO::ChunkCache>(path, table_path, options);
+}
+
+std::tuple<torch::Tensor, torch::Tensor> chunkTable(const SplatIO::ChunkCache& cache)
+{
+	const int64_t C = cache.numChunks();
+	torch::Tensor bounds = torch::empty({ C, 2, 3 }, torch::kFloat32);
+	torch::Tensor rows = torch::empty({ C }, torch::kInt64);
+	for (int c = 0; c < C; c++)
+	{
+		std::memcpy(bounds[c].data_ptr<float>(), &cache.chunkBounds(c), sizeof(SplatIO::ChunkBounds));
+		rows[c] = (int64_t)cache.chunkRows(c);
+	}
+	return std::make_tuple(bounds, rows);
+}
+
+std::tuple<std::vector<int>, std::vector<int>> selectChunks(
+	const SplatIO::ChunkCache& cache,
+	const torch::Tensor& projmatrix,
+	const torch::Tensor& campos,
+	const float margin)
+{
+	if (projmatrix.numel() != 16 || campos.numel() != 3) {
+		AT_ERROR("projmatrix must be 4 x 4 and campos must have 3 elements");
+	}
+	torch::Tensor proj = projmatrix.detach().to(torch::kCPU, torch::kFloat32).contiguous();
+	torch::Tensor position = campos.detach().to(torch::kCPU, torch::kFloat32).contiguous();
+	auto selection = cache.select(proj.data_ptr<float>(), position.data_ptr<float>(), margin);
+	return std::make_tuple(std::move(selection.first), std::move(selection.second));
+}
+
+std::optional<std::map<std::string, torch::Tensor>> acquireChunk(SplatIO::ChunkCache& cache, const int chunk, const bool wait)
+{
+	std::shared_ptr<const SplatIO::LoadedChunk> loaded;
+	{
+		py::gil_scoped_release release;
+		loaded = cache.acquire(chunk, wait);
+	}
+	if (!loaded)
+		return std::nullopt;
+
+	std::map<std::string, torch::Tensor> tensors;
+	const std::vector<SplatIO::AttributeDesc>& attributes = cache.attributes();
+	for (size_t i = 0; i < attributes.size(); i++)
+	{
+		const SplatIO::AttributeDesc& attribute = attributes[i];
+		std::vector<int64_t> sizes = { (int64_t)loaded->rows };
+		for (uint32_t d = 0; d < attribute.ndim; d++)
+			sizes.push_back(attribute.dims[d]);
+
+		// Every tensor holds a reference to the chunk
+		tensors[attribute.name] = torch::from_blob(
+			loaded->column(i),
+			sizes,
+			[loaded](void*) {},
+			torch::TensorOptions().dtype(scalarType((SplatIO::DataType)attribute.dtype)));
+	}
+	return tensors;
+}
+
+std::map<std::string, double> chunkCacheStats(const SplatIO::ChunkCache& cache)
+{
+	const SplatIO::ChunkCache::Stats stats = cache.stats();
+	return {
+		{ "requests", (double)stats.requests },
+		{ "hits", (double)stats.hits },
+		{ "misses", (double)stats.misses },
+		{ "stalls", (double)stats.stalls },
+		{ "stall_ms", stats.stall_ms },
+		{ "loads", (double)stats.loads },
+		{ "bytes_loaded", (double)stats.bytes_loaded },
+		{ "load_ms", stats.load_ms },
+		{ "evictions", (double)stats.evictions },
+		{ "deferred", (double)stats.deferred },
+		{ "resident_chunks", (double)stats.resident_chunks },
+		{ "resident_bytes", (double)stats.resident_bytes },
+		{ "peak_bytes", (double)stats.peak_bytes } };
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "host_io/chunk_cache.h"
+
+// Chunk cache over a chunked model, see host_io/chunk_cache.h
+std::unique_ptr<SplatIO::ChunkCache> createChunkCache(
+	const std::string& path,
+	const std::string& table_path,
+	const int64_t budget_bytes,
+	const int threads);
+
+// (bounds (chunks, 2, 3) float, rows (chunks,) int64) of the chunk table
+std::tuple<torch::Tensor, torch::Tensor> chunkTable(const SplatIO::ChunkCache& cache);
+
+// (visible, near) chunks for a camera, given its 4 x 4 full projection
+// transform and its position as tensors on any device
+std::tuple<std::vector<int>, std::vector<int>> selectChunks(
+	const SplatIO::ChunkCache& cache,
+	const torch::Tensor& projmatrix,
+	const torch::Tensor& campos,
+	const float margin);
+
+// The attributes of a chunk as CPU tensors by name, sharing the memory of
+// the loaded chunk (which stays in use, and is not evicted, while any of
+// them lives); None if the chunk is not loaded and wait is false
+std::optional<std::map<std::string, torch::Tensor>> acquireChunk(SplatIO::ChunkCache& cache, const int chunk, const bool wait);
+
+std::map<std::string, double> chunkCacheStats(const SplatIO::ChunkCache& cache);
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "colmap_tensors.h"
+#include "host_io/colmap_reader.h"
+
+// Moves the vector into a tensor of the given trailing dimensions
+template<typename T>
+static torch::Tensor adopt(std::vector<T>& values, torch::ScalarType type, std::vector<int64_t> dims = {})
+{
+	int64_t row = 1;
+	for (int64_t d : dims)
+		row *= d;
+	dims.insert(dims.begin(), (int64_t)values.size() / row);
+
+	auto* owner = new std::vector<T>(std::move(values));
+	return torch::from_blob(
+		owner->data(),
+		dims,
+		[owner](void*) { delete owner; },
+		torch::TensorOptions().dtype(type));
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapCameras(const std::string& path)
+{
+	SplatIO::ColmapCameras cameras = SplatIO::readColmapCameras(path);
+	return std::make_tuple(
+		adopt(cameras.ids, torch::kInt32),
+		adopt(cameras.model_ids, torch::kInt32),
+		adopt(cameras.widths, torch::kInt64),
+		adopt(cameras.heights, torch::kInt64),
+		adopt(cameras.param_offsets, torch::kInt64),
+		adopt(cameras.params, torch::kFloat64));
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, std::vector<std::string>, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapImages(const std::string& path, const bool points2D)
+{
+	SplatIO::ColmapImages images = SplatIO::readColmapImages(path, points2D);
+	return std::make_tuple(
+		adopt(images.ids, torch::kInt32),
+		adopt(images.qvecs, torch::kFloat64, { 4 }),
+		adopt(images.tvecs, torch::kFloat64, { 3 }),
+		adopt(images.camera_ids, torch::kInt32),
+		std::move(images.names),
+		adopt(images.point2D_offsets, torch::kInt64),
+		adopt(images.xys, torch::kFloat64, { 2 }),
+		adopt(images.point3D_ids, torch::kInt64));
+}
+
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapPoints(const std::string& path, const bool tracks)
+{
+	SplatIO::ColmapPoints points = SplatIO::readColmapPoints(path, tracks);
+	return std::make_tuple(
+		adopt(points.ids, torch::kInt64),
+		adopt(points.xyz, torch::kFloat64, { 3 }),
+		adopt(points.rgb, torch::kUInt8, { 3 }),
+		adopt(points.errors, torch::kFloat64),
+		adopt(points.track_offsets, torch::kInt64),
+		adopt(points.tracks, torch::kInt32, { 2 }));
+}
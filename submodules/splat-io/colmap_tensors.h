@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// COLMAP binary models as CPU tensors, see host_io/colmap_reader.h. The
+// arrays decoded by the reader are handed over without a copy.
+
+// (ids, model_ids, widths, heights, param_offsets, params)
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapCameras(const std::string& path);
+
+// (ids, qvecs, tvecs, camera_ids, names, point2D_offsets, xys, point3D_ids),
+// the last three are empty unless points2D is set
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, std::vector<std::string>, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapImages(const std::string& path, const bool points2D);
+
+// (ids, xyz, rgb, errors, track_offsets, tracks), the last two are empty
+// unless tracks is set
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor, torch::Tensor>
+readColmapPoints(const std::string& path, const bool tracks);
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <torch/extension.h>
+#include "splat_tensors.h"
+#include "colmap_tensors.h"
+#include "image_tensors.h"
+#include "viewer_tensors.h"
+#include "chunk_tensors.h"
+
+PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
+  m.def("read_splat", &readSplat, py::arg("path"), py::arg("prefetch") = false);
+  py::class_<SplatIO::SplatWriter>(m, "SplatWriter")
+    .def(py::init<const std::string&, uint64_t, uint32_t>(), py::arg("path"), py::arg("count"), py::arg("sh_degree"))
+    .def("add_attribute", &addSplatAttribute, py::arg("name"), py::arg("dims"), py::arg("dtype") = "float32")
+    .def("write", &writeSplatRows, py::arg("name"), py::arg("rows"), py::call_guard<py::gil_scoped_release>())
+    .def("close", &SplatIO::SplatWriter::close);
+  m.def("read_colmap_cameras", &readColmapCameras, py::arg("path"), py::call_guard<py::gil_scoped_release>());
+  m.def("read_colmap_images", &readColmapImages, py::arg("path"), py::arg("points2D") = false, py::call_guard<py::gil_scoped_release>());
+  py::class_<SplatIO::ImageLoader>(m, "ImageLoader")
+    .def(py::init(&createImageLoader), py::arg("paths"), py::arg("cache_path"), py::arg("resolution") = -1,
+      py::arg("factors") = std::vector<int>{ 1, 2, 4, 8 }, py::arg("background") = py::none(),
+      py::arg("threads") = 0, py::arg("capacity") = 8)
+    .def("prepare", &SplatIO::ImageLoader::prepare, py::call_guard<py::gil_scoped_release>())
+    .def("num_images", &SplatIO::ImageLoader::numImages)
+    .def("num_levels", &SplatIO::ImageLoader::numLevels)
+    .def("level_size", &imageLevelSize, py::arg("image"), py::arg("level"))
+    .def("submit", &SplatIO::ImageLoader::submit, py::arg("image"), py::arg("level"))
+    .def("take", &takeImage, py::arg("image"), py::arg("level"), py::call_guard<py::gil_scoped_release>())
+    .def("cancel", &SplatIO::ImageLoader::cancel, py::arg("image"), py::arg("level"))
+    .def("clear", &SplatIO::ImageLoader::clear);
+  py::class_<SplatIO::ImageWriter>(m, "ImageWriter")
+    .def(py::init(&createImageWriter), py::arg("threads") = 0, py::arg("capacity") = 16, py::arg("fast") = true)
+    .def("submit", &submitImage, py::arg("path"), py::arg("image"))
+    .def("flush", &SplatIO::ImageWriter::flush, py::call_guard<py::gil_scoped_release>())
+    .def("stats", &imageWriterStats);
+  py::class_<SplatIO::ViewerServer>(m, "ViewerServer")
+    .def(py::init(&createViewerServer), py::arg("host") = "127.0.0.1", py::arg("port") = 6009,
+      py::arg("max_clients") = 4, py::arg("jpeg_quality") = 85)
+    .def("port", &SplatIO::ViewerServer::port)
+    .def("poll", &pollViewer, py::arg("timeout_ms") = 0, py::call_guard<py::gil_scoped_release>())
+    .def("reply", &replyViewer, py::arg("client"), py::arg("image"), py::arg("encoding") = "raw", py::arg("verify") = "")
+    .def("stats", &viewerStats)
+    .def("stop", &SplatIO::ViewerServer::stop, py::call_guard<py::gil_scoped_release>());
+  py::class_<SplatIO::ChunkCache>(m, "ChunkCache")
+    .def(py::init(&createChunkCache), py::arg("path"), py::arg("table_path"), py::arg("budget_bytes") = 1ll << 30, py::arg("threads") = 2)
+    .def("num_chunks", &SplatIO::ChunkCache::numChunks)
+    .def("count", &SplatIO::ChunkCache::count)
+    .def("sh_degree", &SplatIO::ChunkCache::shDegree)
+    .def("chunk_bytes", &SplatIO::ChunkCache::chunkBytes, py::arg("chunk"))
+    .def("table", &chunkTable)
+    .def("select", &selectChunks, py::arg("projmatrix"), py::arg("campos"), py::arg("margin") = 0.0f)
+    .def("prefetch", &SplatIO::ChunkCache::prefetch, py::arg("chunks"))
+    .def("acquire", &acquireChunk, py::arg("chunk"), py::arg("wait") = true)
+    .def("resident", &SplatIO::ChunkCache::resident, py::arg("chunk"))
+    .def("stats", &chunkCacheStats)
+    .def("reset_stats", &SplatIO::ChunkCache::resetStats);
+  m.def("read_colmap_points", &readColmapPoints, py::arg("path"), py::arg("tracks") = false, py::call_guard<py::gil_scoped_release>());
+}
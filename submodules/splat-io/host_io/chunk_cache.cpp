@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "chunk_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr uint64_t COLUMN_ALIGNMENT = 64;
+
+	uint64_t alignColumn(uint64_t bytes)
+	{
+		return (bytes + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+	}
+
+	[[noreturn]] void fail(const std::string& path, const std::string& what)
+	{
+		throw std::runtime_error(path + ": " + what);
+	}
+
+	double now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void readAll(int fd, char* data, uint64_t bytes, uint64_t offset, const std::string& path)
+	{
+		while (bytes > 0)
+		{
+			ssize_t n = pread(fd, data, bytes, offset);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				fail(path, std::string("read failed (") + std::strerror(errno) + ")");
+			}
+			if (n == 0)
+				fail(path, "unexpected end of file");
+			data += n;
+			bytes -= n;
+			offset += n;
+		}
+	}
+
+	// Largest value of the plane a.x + b.y + c.z + d over a box
+	float planeMax(const float* plane, const SplatIO::ChunkBounds& box, float margin)
+	{
+		float value = plane[3];
+		for (int k = 0; k < 3; k++)
+			value += plane[k] * (plane[k] > 0.0f ? box.max[k] + margin : box.min[k] - margin);
+		return value;
+	}
+}
+
+SplatIO::ChunkCache::ChunkCache(const std::string& path, const std::string& table_path, const Options& options)
+	: path(path), reader(path), options(options)
+{
+	const FileHeader& h = reader.header();
+	for (uint32_t i = 0; i < h.num_attributes; i++)
+		columns.push_back(h.attributes[i]);
+
+	// The table is copied, its file is only open while reading it
+	{
+		SplatReader table(table_path);
+		const AttributeDesc* box = table.find("bounds");
+		const AttributeDesc* count = table.find("rows");
+		if (!box || (DataType)box->dtype != DataType::Float32 || box->rowElements() != 6 ||
+			!count || (DataType)count->dtype != DataType::Int32 || count->rowElements() != 1)
+			fail(table_path, "not a chunk table (float32 bounds 2 x 3, int32 rows)");
+
+		const uint64_t chunks = table.count();
+		bounds.resize(chunks);
+		std::memcpy(bounds.data(), table.data(*box), chunks * sizeof(ChunkBounds));
+		const int32_t* counts = (const int32_t*)table.data(*count);
+		uint64_t total = 0;
+		for (uint64_t c = 0; c < chunks; c++)
+		{
+			if (counts[c] < 0)
+				fail(table_path, "negative row count of chunk " + std::to_string(c));
+			first.push_back(total);
+			rows.push_back((uint64_t)counts[c]);
+			total += counts[c];
+		}
+		if (total != reader.count())
+			fail(table_path, "the chunks have " + std::to_string(total) + " rows, " + path + " has " + std::to_string(reader.count()));
+	}
+
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		fail(path, std::string("cannot open (") + std::strerror(errno) + ")");
+
+	if (this->options.threads <= 0)
+		this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+	for (int t = 0; t < this->options.threads; t++)
+		workers.emplace_back(&ChunkCache::loader, this);
+}
+
+SplatIO::ChunkCache::~ChunkCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_cv.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	::close(fd);
+}
+
+int SplatIO::ChunkCache::check(int chunk) const
+{
+	if (chunk < 0 || chunk >= numChunks())
+		fail(path, "no chunk " + std::to_string(chunk));
+	return chunk;
+}
+
+std::pair<std::vector<int>, std::vector<int>> SplatIO::ChunkCache::select(const float* projmatrix, const float* campos, float margin) const
+{
+	// Frustum planes w + x, w - x, w + y, w - y, z (near), w - z (far) of
+	// clip space, each as coefficients of world x, y, z and 1
+	const float* m = projmatrix;
+	float planes[6][4];
+	for (int k = 0; k < 4; k++)
+	{
+		const float x = m[4 * k], y = m[4 * k + 1], z = m[4 * k + 2], w = m[4 * k + 3];
+		planes[0][k] = w + x;
+		planes[1][k] = w - x;
+		planes[2][k] = w + y;
+		planes[3][k] = w - y;
+		planes[4][k] = z;
+		planes[5][k] = w - z;
+	}
+
+	std::vector<std::pair<float, int>> visible, near;
+	for (int c = 0; c < numChunks(); c++)
+	{
+		const ChunkBounds& box = bounds[c];
+		bool inside = true, grown = true;
+		for (int p = 0; p < 6 && grown; p++)
+		{
+			inside = inside && planeMax(planes[p], box, 0.0f) >= 0.0f;
+			grown = planeMax(planes[p], box, margin) >= 0.0f;
+		}
+		if (!grown)
+			continue;
+
+		float distance = 0.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			const float d = std::max({ box.min[k] - campos[k], campos[k] - box.max[k], 0.0f });
+			distance += d * d;
+		}
+		(inside ? visible : near).push_back({ distance, c });
+	}
+
+	auto ordered = [](std::vector<std::pair<float, int>>& chunks) {
+		std::sort(chunks.begin(), chunks.end());
+		std::vector<int> result;
+		for (const auto& chunk : chunks)
+			result.push_back(chunk.second);
+		return result;
+	};
+	return { ordered(visible), ordered(near) };
+}
+
+std::shared_ptr<SplatIO::LoadedChunk> SplatIO::ChunkCache::read(int chunk) const
+{
+	auto loaded = std::make_shared<LoadedChunk>();
+	loaded->index = chunk;
+	loaded->rows = rows[chunk];
+	for (const AttributeDesc& a : columns)
+	{
+		loaded->offsets.push_back(loaded->bytes);
+		loaded->bytes += alignColumn(loaded->rows * a.rowBytes());
+	}
+	loaded->data.reset(new char[std::max<uint64_t>(loaded->bytes, 1)]);
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		const uint64_t bytes = columns[i].rowBytes();
+		readAll(fd, loaded->column(i), loaded->rows * bytes, columns[i].offset + first[chunk] * bytes, path);
+	}
+	return loaded;
+}
+
+uint64_t SplatIO::ChunkCache::chunkBytes(int chunk) const
+{
+	check(chunk);
+	uint64_t bytes = 0;
+	for (const AttributeDesc& a : columns)
+		bytes += alignColumn(rows[chunk] * a.rowBytes());
+	return bytes;
+}
+
+// Evicts unwanted chunks, least recently used first, until bytes more fit
+// the budget. Chunks still referenced outside the cache are kept, their
+// memory would not be released. Returns whether the bytes fit.
+bool SplatIO::ChunkCache::reserve(uint64_t bytes)
+{
+	while (counters.resident_bytes + reserved + bytes > options.budget_bytes)
+	{
+		auto victim = lru.end();
+		for (auto it = lru.rbegin(); it != lru.rend(); ++it)
+		{
+			if (!wanted.count(*it) && entries.at(*it).chunk.use_count() == 1)
+			{
+				victim = std::prev(it.base());
+				break;
+			}
+		}
+		if (victim == lru.end())
+			return false;
+
+		const int chunk = *victim;
+		lru.erase(victim);
+		counters.resident_bytes -= entries.at(chunk).chunk->bytes;
+		counters.resident_chunks--;
+		counters.evictions++;
+		entries.erase(chunk);
+	}
+	return true;
+}
+
+void SplatIO::ChunkCache::insert(std::shared_ptr<const LoadedChunk> chunk)
+{
+	const int index = chunk->index;
+	counters.resident_bytes += chunk->bytes;
+	counters.resident_chunks++;
+	counters.peak_bytes = std::max(counters.peak_bytes, counters.resident_bytes);
+	lru.push_front(index);
+	entries[index] = Entry{ std::move(chunk), lru.begin() };
+}
+
+void SplatIO::ChunkCache::prefetch(const std::vector<int>& chunks)
+{
+	for (int chunk : chunks)
+		check(chunk);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	wanted = std::unordered_set<int>(chunks.begin(), chunks.end());
+	pending.clear();
+	for (int chunk : chunks)
+		if (!entries.count(chunk) && !loading.count(chunk))
+			pending.push_back(chunk);
+	work_cv.notify_all();
+}
+
+std::shared_ptr<const SplatIO::LoadedChunk> SplatIO::ChunkCache::acquire(int chunk, bool wait)
+{
+	check(chunk);
+	std::unique_lock<std::mutex> lock(mutex);
+	auto rethrow = [this]() {
+		if (!error.empty())
+		{
+			const std::string message = error;
+			error.clear();
+			throw std::runtime_error(message);
+		}
+	};
+	rethrow();
+
+	counters.requests++;
+	auto it = entries.find(chunk);
+	if (it != entries.end())
+	{
+		counters.hits++;
+		lru.splice(lru.begin(), lru, it->second.lru);
+		return it->second.chunk;
+	}
+	counters.misses++;
+	if (!wait)
+	{
+		if (!loading.count(chunk))
+		{
+			pending.erase(std::remove(pending.begin(), pending.end(), chunk), pending.end());
+			pending.push_front(chunk);
+			work_cv.notify_one();
+		}
+		return nullptr;
+	}
+
+	counters.stalls++;
+	const double start = now();
+	if (loading.count(chunk))
+	{
+		// In flight on a loader thread
+		ready_cv.wait(lock, [&] { return !loading.count(chunk); });
+		rethrow();
+		it = entries.find(chunk);
+		if (it != entries.end())
+		{
+			lru.splice(lru.begin(), lru, it->second.lru);
+			counters.stall_ms += now() - start;
+			return it->second.chunk;
+		}
+	}
+
+	// Loaded here, over the budget if need be
+	pending.erase(std::remove(pending.begin(), pending.end(), chunk), pending.end());
+	const uint64_t bytes = chunkBytes(chunk);
+	reserve(bytes);
+	reserved += bytes;
+	loading.insert(chunk);
+	lock.unlock();
+
+	std::shared_ptr<LoadedChunk> loaded;
+	std::string failure;
+	const double load_start = now();
+	try
+	{
+		loaded = read(chunk);
+	}
+	catch (const std::exception& e)
+	{
+		failure = e.what();
+	}
+	const double end = now();
+
+	lock.lock();
+	reserved -= bytes;
+	loading.erase(chunk);
+	ready_cv.notify_all();
+	if (!failure.empty())
+		throw std::runtime_error(failure);
+	counters.loads++;
+	counters.bytes_loaded += loaded->bytes;
+	counters.load_ms += end - load_start;
+	counters.stall_ms += end - start;
+	insert(loaded);
+	return loaded;
+}
+
+bool SplatIO::ChunkCache::resident(int chunk) const
+{
+	check(chunk);
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.count(chunk) != 0;
+}
+
+SplatIO::ChunkCache::Stats SplatIO::ChunkCache::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void SplatIO::ChunkCache::resetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats reset;
+	reset.resident_chunks = counters.resident_chunks;
+	reset.resident_bytes = counters.resident_bytes;
+	reset.peak_bytes = counters.resident_bytes;
+	counters = reset;
+}
+
+void SplatIO::ChunkCache::loader()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		work_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+		if (stopping)
+			return;
+		const int chunk = pending.front();
+		pending.pop_front();
+		if (entries.count(chunk) || loading.count(chunk))
+			continue;
+		const uint64_t bytes = chunkBytes(chunk);
+		if (!reserve(bytes))
+		{
+			counters.deferred++;
+			continue;
+		}
+		reserved += bytes;
+		loading.insert(chunk);
+		lock.unlock();
+
+		std::shared_ptr<LoadedChunk> loaded;
+		std::string failure;
+		const double start = now();
+		try
+		{
+			loaded = read(chunk);
+		}
+		catch (const std::exception& e)
+		{
+			failure = e.what();
+		}
+		const double end = now();
+
+		lock.lock();
+		reserved -= bytes;
+		loading.erase(chunk);
+		counters.load_ms += end - start;
+		if (failure.empty())
+		{
+			counters.loads++;
+			counters.bytes_loaded += loaded->bytes;
+			insert(loaded);
+		}
+		else if (error.empty())
+			error = failure;
+		ready_cv.notify_all();
+	}
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_CHUNK_CACHE_H_INCLUDED
+#define SPLAT_IO_CHUNK_CACHE_H_INCLUDED
+
+#include "splat_file.h"
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Out-of-core residency of a model that is partitioned into spatial chunks.
+//
+// A chunked model is a pair of splat files. The data file is an ordinary
+// splat file whose rows are grouped by chunk, chunk after chunk. The chunk
+// table file has one row per chunk:
+//
+//   bounds  float32 2 x 3, the box (min, max) around the extent of the
+//           chunk's Gaussians, not only their centers
+//   rows    int32, the number of rows of the chunk
+//
+// Chunks are read from the data file into host memory on loader threads,
+// ahead of use for the chunks the camera sees or is about to see, and are
+// evicted least recently used first to stay within a byte budget.
+namespace SplatIO
+{
+	struct ChunkBounds
+	{
+		float min[3];
+		float max[3];
+	};
+
+	// The rows of one chunk, every attribute as a contiguous column
+	struct LoadedChunk
+	{
+		int index = 0;
+		uint64_t rows = 0;
+		uint64_t bytes = 0;
+		std::vector<uint64_t> offsets;		// of every attribute's column in data
+		std::unique_ptr<char[]> data;
+
+		char* column(size_t attribute) const { return data.get() + offsets[attribute]; }
+	};
+
+	class ChunkCache
+	{
+	public:
+		struct Options
+		{
+			uint64_t budget_bytes = 1ull << 30;	// host memory for loaded chunks
+			int threads = 2;					// 0: one per hardware thread
+		};
+
+		struct Stats
+		{
+			uint64_t requests = 0;			// acquire calls
+			uint64_t hits = 0;				// of them served from memory
+			uint64_t misses = 0;
+			uint64_t stalls = 0;			// misses the caller waited for
+			double stall_ms = 0.0;
+			uint64_t loads = 0;
+			uint64_t bytes_loaded = 0;
+			double load_ms = 0.0;			// summed over the threads
+			uint64_t evictions = 0;
+			uint64_t deferred = 0;			// prefetches dropped for lack of budget
+			uint64_t resident_chunks = 0;
+			uint64_t resident_bytes = 0;
+			uint64_t peak_bytes = 0;
+		};
+
+		ChunkCache(const std::string& path, const std::string& table_path, const Options& options);
+		~ChunkCache();
+
+		ChunkCache(const ChunkCache&) = delete;
+		ChunkCache& operator=(const ChunkCache&) = delete;
+
+		int numChunks() const { return (int)bounds.size(); }
+		uint64_t count() const { return reader.count(); }
+		uint32_t shDegree() const { return reader.shDegree(); }
+		const ChunkBounds& chunkBounds(int chunk) const { return bounds[check(chunk)]; }
+		uint64_t chunkRows(int chunk) const { return rows[check(chunk)]; }
+		// Host memory the chunk takes when loaded
+		uint64_t chunkBytes(int chunk) const;
+		// The attributes of the data file, in the order of LoadedChunk::offsets
+		const std::vector<AttributeDesc>& attributes() const { return columns; }
+
+		// Chunks in front of a camera, given its projection matrix (world to
+		// clip space, column major as handed to the rasterizer) and position.
+		// Returns the chunks whose bounds intersect the view frustum, then
+		// those that only do once grown by margin (world units) on every
+		// side, both ordered by distance from the camera.
+		std::pair<std::vector<int>, std::vector<int>> select(const float* projmatrix, const float* campos, float margin) const;
+
+		// Sets the chunks that are wanted next, in order of priority, and
+		// queues those not in memory for loading; earlier requests that are
+		// not among them are dropped. Wanted chunks are never evicted, and
+		// a prefetch that does not fit the budget without evicting one is
+		// skipped.
+		void prefetch(const std::vector<int>& chunks);
+		// A chunk from memory, or nullptr if it is not loaded yet and wait
+		// is false; it is then loaded ahead of the other requests. With
+		// wait, a chunk that is not in memory is loaded before returning,
+		// beyond the budget if nothing can be evicted. Throws
+		// std::runtime_error with the first failed load.
+		std::shared_ptr<const LoadedChunk> acquire(int chunk, bool wait);
+		bool resident(int chunk) const;
+
+		Stats stats() const;
+		void resetStats();
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<const LoadedChunk> chunk;
+			std::list<int>::iterator lru;
+		};
+
+		int check(int chunk) const;
+		std::shared_ptr<LoadedChunk> read(int chunk) const;
+		bool reserve(uint64_t bytes);
+		void insert(std::shared_ptr<const LoadedChunk> chunk);
+		void loader();
+
+		std::string path;
+		SplatReader reader;
+		int fd = -1;
+		std::vector<AttributeDesc> columns;
+		std::vector<ChunkBounds> bounds;
+		std::vector<uint64_t> rows;
+		std::vector<uint64_t> first;		// first row of every chunk
+
+		Options options;
+		mutable std::mutex mutex;
+		std::condition_variable work_cv, ready_cv;
+		std::deque<int> pending;
+		std::unordered_set<int> wanted;
+		std::unordered_set<int> loading;
+		std::unordered_map<int, Entry> entries;
+		std::list<int> lru;					// most recently used first
+		uint64_t reserved = 0;				// bytes of the loads in flight
+		std::string error;
+		Stats counters;
+		bool stopping = false;
+		std::vector<std::thread> workers;
+	};
+};
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "colmap_reader.h"
+#include "splat_file.h"
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <omp.h>
+
+namespace
+{
+	// Sizes of the fixed parts of the records
+	constexpr size_t CAMERA_BYTES = 24;		// id, model, width, height
+	constexpr size_t IMAGE_BYTES = 64;		// id, qvec, tvec, camera id
+	constexpr size_t POINT2D_BYTES = 24;	// x, y, point3D id
+	constexpr size_t POINT3D_BYTES = 43;	// id, xyz, rgb, error
+	constexpr size_t TRACK_BYTES = 8;		// image id, point2D index
+
+	// Bounds checked little endian cursor over a mapped file
+	class Cursor
+	{
+	public:
+		explicit Cursor(const std::string& path)
+			: path(path), file(SplatIO::MappedFile::open(path)) {}
+
+		template<typename T>
+		T read()
+		{
+			T value;
+			std::memcpy(&value, take(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		const char* take(size_t bytes)
+		{
+			if (bytes > file->size() - offset)
+				throw std::runtime_error(path + ": file is truncated");
+			const char* data = file->data() + offset;
+			offset += bytes;
+			return data;
+		}
+
+		// Checks that count records of the given size can follow, without
+		// overflowing on corrupt counts
+		void require(uint64_t count, size_t bytes) const
+		{
+			if (count > (file->size() - offset) / bytes)
+				throw std::runtime_error(path + ": file is truncated");
+		}
+
+		const char* takeArray(uint64_t count, size_t bytes)
+		{
+			require(count, bytes);
+			return take(count * bytes);
+		}
+
+		std::string readString()
+		{
+			const char* begin = file->data() + offset;
+			const void* end = std::memchr(begin, 0, file->size() - offset);
+			if (end == nullptr)
+				throw std::runtime_error(path + ": file is truncated");
+			const size_t length = (const char*)end - begin;
+			take(length + 1);
+			return std::string(begin, length);
+		}
+
+		const char* at(size_t position) const { return file->data() + position; }
+		size_t position() const { return offset; }
+
+		const std::string path;
+
+	private:
+		std::shared_ptr<SplatIO::MappedFile> file;
+		size_t offset = 0;
+	};
+
+	template<typename T>
+	T load(const char* data)
+	{
+		T value;
+		std::memcpy(&value, data, sizeof(T));
+		return value;
+	}
+}
+
+int SplatIO::colmapModelParams(int model_id)
+{
+	// SIMPLE_PINHOLE, PINHOLE, SIMPLE_RADIAL, RADIAL, OPENCV, OPENCV_FISHEYE,
+	// FULL_OPENCV, FOV, SIMPLE_RADIAL_FISHEYE, RADIAL_FISHEYE, THIN_PRISM_FISHEYE
+	static const int params[] = { 3, 4, 4, 5, 8, 8, 12, 5, 4, 5, 12 };
+	if (model_id < 0 || model_id >= (int)(sizeof(params) / sizeof(params[0])))
+		return 0;
+	return params[model_id];
+}
+
+SplatIO::ColmapCameras SplatIO::readColmapCameras(const std::string& path)
+{
+	Cursor cursor(path);
+	const uint64_t count = cursor.read<uint64_t>();
+	cursor.require(count, CAMERA_BYTES);
+
+	ColmapCameras cameras;
+	cameras.param_offsets.push_back(0);
+	for (uint64_t i = 0; i < count; i++)
+	{
+		cameras.ids.push_back(cursor.read<int32_t>());
+		const int32_t model_id = cursor.read<int32_t>();
+		cameras.model_ids.push_back(model_id);
+		cameras.widths.push_back((int64_t)cursor.read<uint64_t>());
+		cameras.heights.push_back((int64_t)cursor.read<uint64_t>());
+
+		const int num_params = colmapModelParams(model_id);
+		if (num_params == 0)
+			throw std::runtime_error(path + ": unknown camera model " + std::to_string(model_id));
+		const char* data = cursor.takeArray(num_params, sizeof(double));
+		for (int k = 0; k < num_params; k++)
+			cameras.params.push_back(load<double>(data + k * sizeof(double)));
+		cameras.param_offsets.push_back((int64_t)cameras.params.size());
+	}
+	return cameras;
+}
+
+SplatIO::ColmapImages SplatIO::readColmapImages(const std::string& path, bool points2D)
+{
+	Cursor cursor(path);
+	const uint64_t count = cursor.read<uint64_t>();
+	cursor.require(count, IMAGE_BYTES);
+
+	// Records have variable length: find them first, skipping the 2D
+	// points, then decode them in parallel
+	ColmapImages images;
+	images.names.resize(count);
+	images.point2D_offsets.resize(count + 1, 0);
+	std::vector<size_t> records(count), observations(count);
+	for (uint64_t i = 0; i < count; i++)
+	{
+		records[i] = cursor.position();
+		cursor.take(IMAGE_BYTES);
+		images.names[i] = cursor.readString();
+		const uint64_t num_points2D = cursor.read<uint64_t>();
+		observations[i] = cursor.position();
+		cursor.takeArray(num_points2D, POINT2D_BYTES);
+		images.point2D_offsets[i + 1] = images.point2D_offsets[i] + num_points2D;
+	}
+
+	images.ids.resize(count);
+	images.camera_ids.resize(count);
+	images.qvecs.resize(4 * count);
+	images.tvecs.resize(3 * count);
+	if (points2D)
+	{
+		images.xys.resize(2 * images.point2D_offsets[count]);
+		images.point3D_ids.resize(images.point2D_offsets[count]);
+	}
+	else
+		images.point2D_offsets.clear();
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for (int64_t i = 0; i < (int64_t)count; i++)
+	{
+		const char* data = cursor.at(records[i]);
+		images.ids[i] = load<int32_t>(data);
+		for (int k = 0; k < 4; k++)
+			images.qvecs[4 * i + k] = load<double>(data + 4 + 8 * k);
+		for (int k = 0; k < 3; k++)
+			images.tvecs[3 * i + k] = load<double>(data + 36 + 8 * k);
+		images.camera_ids[i] = load<int32_t>(data + 60);
+
+		if (!points2D)
+			continue;
+		const char* point = cursor.at(observations[i]);
+		for (int64_t j = images.point2D_offsets[i]; j < images.point2D_offsets[i + 1]; j++, point += POINT2D_BYTES)
+		{
+			images.xys[2 * j] = load<double>(point);
+			images.xys[2 * j + 1] = load<double>(point + 8);
+			images.point3D_ids[j] = load<int64_t>(point + 16);
+		}
+	}
+	return images;
+}
+
+SplatIO::ColmapPoints SplatIO::readColmapPoints(const std::string& path, bool tracks)
+{
+	Cursor cursor(path);
+	const uint64_t count = cursor.read<uint64_t>();
+	// Every record is at least a point and an empty track
+	cursor.require(count, POINT3D_BYTES + sizeof(uint64_t));
+
+	ColmapPoints points;
+	points.ids.resize(count);
+	points.xyz.resize(3 * count);
+	points.rgb.resize(3 * count);
+	points.errors.resize(count);
+	if (tracks)
+		points.track_offsets.push_back(0);
+
+	for (uint64_t i = 0; i < count; i++)
+	{
+		const char* data = cursor.take(POINT3D_BYTES);
+		points.ids[i] = (int64_t)load<uint64_t>(data);
+		for (int k = 0; k < 3; k++)
+			points.xyz[3 * i + k] = load<double>(data + 8 + 8 * k);
+		std::memcpy(&points.rgb[3 * i], data + 32, 3);
+		points.errors[i] = load<double>(data + 35);
+
+		const uint64_t track_length = cursor.read<uint64_t>();
+		const char* track = cursor.takeArray(track_length, TRACK_BYTES);
+		if (!tracks)
+			continue;
+		const size_t first = points.tracks.size();
+		points.tracks.resize(first + 2 * track_length);
+		std::memcpy(&points.tracks[first], track, track_length * TRACK_BYTES);
+		points.track_offsets.push_back((int64_t)(points.tracks.size() / 2));
+	}
+	return points;
+}
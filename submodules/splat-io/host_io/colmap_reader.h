@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_COLMAP_READER_H_INCLUDED
+#define SPLAT_IO_COLMAP_READER_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Readers for the binary model files of COLMAP (cameras.bin, images.bin,
+// points3D.bin, see src/base/reconstruction.cc in COLMAP). Files are
+// mapped and decoded straight into flat arrays, one row per record in
+// file order. The per-observation data (2D points of the images, tracks
+// of the 3D points) makes up most of the files and is only decoded on
+// request; otherwise it is skipped over without being touched.
+namespace SplatIO
+{
+	struct ColmapCameras
+	{
+		std::vector<int32_t> ids;
+		std::vector<int32_t> model_ids;
+		std::vector<int64_t> widths, heights;
+		// Parameters of camera i are params[param_offsets[i], param_offsets[i + 1])
+		std::vector<int64_t> param_offsets;
+		std::vector<double> params;
+	};
+
+	struct ColmapImages
+	{
+		std::vector<int32_t> ids;
+		std::vector<double> qvecs;			// N x 4, w x y z
+		std::vector<double> tvecs;			// N x 3
+		std::vector<int32_t> camera_ids;
+		std::vector<std::string> names;
+		// Only filled if requested. Observations of image i are
+		// [point2D_offsets[i], point2D_offsets[i + 1]).
+		std::vector<int64_t> point2D_offsets;
+		std::vector<double> xys;			// M x 2
+		std::vector<int64_t> point3D_ids;	// M, -1 for unmatched points
+	};
+
+	struct ColmapPoints
+	{
+		std::vector<int64_t> ids;
+		std::vector<double> xyz;			// N x 3
+		std::vector<uint8_t> rgb;			// N x 3
+		std::vector<double> errors;
+		// Only filled if requested. Track of point i is
+		// [track_offsets[i], track_offsets[i + 1]).
+		std::vector<int64_t> track_offsets;
+		std::vector<int32_t> tracks;		// M x 2, image id and point2D index
+	};
+
+	// Number of parameters of a COLMAP camera model, 0 for unknown models
+	int colmapModelParams(int model_id);
+
+	ColmapCameras readColmapCameras(const std::string& path);
+	ColmapImages readColmapImages(const std::string& path, bool points2D);
+	ColmapPoints readColmapPoints(const std::string& path, bool tracks);
+};
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "image_codec.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <png.h>
+#include <jpeglib.h>
+
+namespace
+{
+	[[noreturn]] void fail(const std::string& path, const std::string& what)
+	{
+		throw std::runtime_error(path + ": " + what);
+	}
+
+	struct FileCloser
+	{
+		void operator()(FILE* file) const { std::fclose(file); }
+	};
+
+	SplatIO::Image8 decodePNG(const std::string& path)
+	{
+		png_image png;
+		std::memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_file(&png, path.c_str()))
+			fail(path, std::string("cannot decode PNG (") + png.message + ")");
+
+		SplatIO::Image8 image;
+		image.width = (int)png.width;
+		image.height = (int)png.height;
+		image.channels = (png.format & PNG_FORMAT_FLAG_ALPHA) ? 4 : 3;
+		png.format = image.channels == 4 ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+		image.pixels.resize(PNG_IMAGE_SIZE(png));
+		if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+		{
+			png_image_free(&png);
+			fail(path, std::string("cannot decode PNG (") + png.message + ")");
+		}
+		return image;
+	}
+
+	struct JPEGError
+	{
+		jpeg_error_mgr manager;
+		std::jmp_buf jump;
+		char message[JMSG_LENGTH_MAX];
+	};
+
+	void onJPEGError(j_common_ptr info)
+	{
+		JPEGError* error = (JPEGError*)info->err;
+		info->err->format_message(info, error->message);
+		std::longjmp(error->jump, 1);
+	}
+
+	SplatIO::Image8 decodeJPEG(const std::string& path, FILE* file)
+	{
+		jpeg_decompress_struct info;
+		JPEGError error;
+		info.err = jpeg_std_error(&error.manager);
+		error.manager.error_exit = onJPEGError;
+
+		// Everything that lives across the setjmp is set up before it
+		SplatIO::Image8 image;
+		std::vector<JSAMPROW> rows;
+		if (setjmp(error.jump))
+		{
+			jpeg_destroy_decompress(&info);
+			fail(path, std::string("cannot decode JPEG (") + error.message + ")");
+		}
+
+		jpeg_create_decompress(&info);
+		jpeg_stdio_src(&info, file);
+		jpeg_read_header(&info, TRUE);
+		info.out_color_space = JCS_RGB;
+		jpeg_start_decompress(&info);
+
+		image.width = (int)info.output_width;
+		image.height = (int)info.output_height;
+		image.channels = 3;
+		image.pixels.resize((size_t)image.width * image.height * 3);
+		rows.resize(image.height);
+		for (int y = 0; y < image.height; y++)
+			rows[y] = image.pixels.data() + (size_t)y * image.width * 3;
+		while (info.output_scanline < info.output_height)
+			jpeg_read_scanlines(&info, rows.data() + info.output_scanline, info.output_height - info.output_scanline);
+
+		jpeg_finish_decompress(&info);
+		jpeg_destroy_decompress(&info);
+		return image;
+	}
+}
+
+SplatIO::Image8 SplatIO::decodeImage(const std::string& path)
+{
+	std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+	if (!file)
+		fail(path, "cannot open");
+
+	unsigned char signature[8] = {};
+	const size_t n = std::fread(signature, 1, sizeof(signature), file.get());
+	if (n == 8 && png_sig_cmp(signature, 0, 8) == 0)
+	{
+		file.reset();
+		return decodePNG(path);
+	}
+	if (n >= 3 && signature[0] == 0xFF && signature[1] == 0xD8 && signature[2] == 0xFF)
+	{
+		std::rewind(file.get());
+		return decodeJPEG(path, file.get());
+	}
+	fail(path, "unsupported image format (PNG and JPEG are supported)");
+}
+
+void SplatIO::writePNG(const std::string& path, const Image8& image, bool fast)
+{
+	png_image png;
+	std::memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	png.width = (png_uint_32)image.width;
+	png.height = (png_uint_32)image.height;
+	png.format = image.channels == 4 ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+	if (fast)
+		png.flags |= PNG_IMAGE_FLAG_FAST;
+	if (!png_image_write_to_file(&png, path.c_str(), 0, image.pixels.data(), 0, nullptr))
+		fail(path, std::string("cannot write PNG (") + png.message + ")");
+}
+
+std::vector<uint8_t> SplatIO::encodeJPEG(const uint8_t* rgb, int width, int height, int quality)
+{
+	jpeg_compress_struct info;
+	JPEGError error;
+	info.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = onJPEGError;
+
+	// Everything that lives across the setjmp is set up before it
+	unsigned char* buffer = nullptr;
+	unsigned long size = 0;
+	std::vector<uint8_t> encoded;
+	if (setjmp(error.jump))
+	{
+		jpeg_destroy_compress(&info);
+		std::free(buffer);
+		throw std::runtime_error(std::string("cannot encode JPEG (") + error.message + ")");
+	}
+
+	jpeg_create_compress(&info);
+	jpeg_mem_dest(&info, &buffer, &size);
+	info.image_width = (JDIMENSION)width;
+	info.image_height = (JDIMENSION)height;
+	info.input_components = 3;
+	info.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&info);
+	jpeg_set_quality(&info, quality, TRUE);
+	jpeg_start_compress(&info, TRUE);
+	while (info.next_scanline < info.image_height)
+	{
+		JSAMPROW row = (JSAMPROW)(rgb + (size_t)info.next_scanline * width * 3);
+		jpeg_write_scanlines(&info, &row, 1);
+	}
+	jpeg_finish_compress(&info);
+	jpeg_destroy_compress(&info);
+
+	encoded.assign(buffer, buffer + size);
+	std::free(buffer);
+	return encoded;
+}
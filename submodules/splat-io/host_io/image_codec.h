@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_IMAGE_CODEC_H_INCLUDED
+#define SPLAT_IO_IMAGE_CODEC_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SplatIO
+{
+	// 8 bit image, rows top to bottom, channels interleaved (RGB or RGBA)
+	struct Image8
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	// Decodes a PNG or JPEG file (detected from its signature) to RGB, or
+	// RGBA if the file has an alpha channel. Grayscale and palette images
+	// are expanded. Thread safe.
+	Image8 decodeImage(const std::string& path);
+
+	// Writes an 8 bit RGB or RGBA image as PNG. fast trades size for
+	// encoding speed. Thread safe.
+	void writePNG(const std::string& path, const Image8& image, bool fast);
+
+	// Encodes an 8 bit RGB image (rows top to bottom) as baseline JPEG of
+	// the given quality (1 to 100). Thread safe.
+	std::vector<uint8_t> encodeJPEG(const uint8_t* rgb, int width, int height, int quality);
+};
+
+#endif
@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "image_loader.h"
+#include "image_pyramid.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr uint64_t LEVEL_ALIGNMENT = 64;
+
+	[[noreturn]] void fail(const std::string& path, const std::string& what)
+	{
+		throw std::runtime_error(path + ": " + what);
+	}
+
+	void writeAll(int fd, const void* data, uint64_t bytes, uint64_t offset, const std::string& path)
+	{
+		const char* p = (const char*)data;
+		while (bytes > 0)
+		{
+			ssize_t n = pwrite(fd, p, bytes, offset);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				fail(path, std::string("write failed (") + std::strerror(errno) + ")");
+			}
+			p += n;
+			bytes -= n;
+			offset += n;
+		}
+	}
+
+	uint64_t hashPath(const std::string& path)
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : path)
+			hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+		return hash;
+	}
+
+	SplatIO::PyramidSource describeSource(const std::string& path)
+	{
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+			fail(path, std::string("cannot stat (") + std::strerror(errno) + ")");
+		return { hashPath(path), (uint64_t)st.st_size, (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec };
+	}
+
+	uint64_t levelBytes(const SplatIO::PyramidLevel& level)
+	{
+		return (uint64_t)level.width * level.height * level.channels;
+	}
+
+	uint64_t alignLevel(uint64_t offset)
+	{
+		return (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+	}
+}
+
+SplatIO::ImageLoader::ImageLoader(const std::vector<std::string>& paths, const std::string& cache_path, const Options& options)
+	: paths(paths), cache_path(cache_path), options(options)
+{
+	if (options.factors.empty() || options.factors.size() > MAX_PYRAMID_LEVELS)
+		fail(cache_path, "a pyramid needs between 1 and " + std::to_string(MAX_PYRAMID_LEVELS) + " levels");
+	for (int factor : options.factors)
+		if (factor < 1)
+			fail(cache_path, "downscale factors must be positive");
+	if (this->options.threads <= 0)
+		this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+	this->options.capacity = std::max(1, options.capacity);
+}
+
+SplatIO::ImageLoader::~ImageLoader()
+{
+	stop();
+}
+
+int SplatIO::ImageLoader::key(int image, int level) const
+{
+	if (!levels)
+		fail(cache_path, "the image cache is not prepared");
+	if (image < 0 || image >= numImages() || level < 0 || level >= numLevels())
+		fail(cache_path, "no level " + std::to_string(level) + " of image " + std::to_string(image));
+	return image * numLevels() + level;
+}
+
+const SplatIO::PyramidLevel& SplatIO::ImageLoader::level(int image, int level) const
+{
+	return levels[key(image, level)];
+}
+
+// Maps the cache if it exists and was built with the same settings
+bool SplatIO::ImageLoader::openCache()
+{
+	struct stat st;
+	if (stat(cache_path.c_str(), &st) != 0 || (uint64_t)st.st_size < sizeof(PyramidHeader))
+		return false;
+
+	std::shared_ptr<MappedFile> file = MappedFile::open(cache_path);
+	const PyramidHeader& h = *(const PyramidHeader*)file->data();
+	const uint64_t table_bytes = sizeof(PyramidHeader) + paths.size() * (sizeof(PyramidSource) + options.factors.size() * sizeof(PyramidLevel));
+	if (std::memcmp(h.magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC)) != 0 || h.version != PYRAMID_VERSION ||
+		h.file_bytes != file->size() || table_bytes > file->size() ||
+		h.num_images != paths.size() || h.num_levels != options.factors.size() ||
+		h.resolution != options.resolution || h.composite != (uint32_t)options.composite)
+		return false;
+	for (size_t l = 0; l < options.factors.size(); l++)
+		if (h.factors[l] != (uint32_t)options.factors[l])
+			return false;
+	if (options.composite && std::memcmp(h.background, options.background, sizeof(h.background)) != 0)
+		return false;
+
+	const PyramidLevel* table = (const PyramidLevel*)(file->data() + sizeof(PyramidHeader) + paths.size() * sizeof(PyramidSource));
+	for (size_t i = 0; i < paths.size() * options.factors.size(); i++)
+		if (table[i].offset + levelBytes(table[i]) > file->size())
+			return false;
+
+	cache = file;
+	levels = table;
+	return true;
+}
+
+int SplatIO::ImageLoader::prepare()
+{
+	stop();
+	stopping = false;
+
+	const int N = numImages();
+	std::vector<PyramidSource> sources(N);
+	for (int i = 0; i < N; i++)
+		sources[i] = describeSource(paths[i]);
+
+	std::vector<bool> valid(N, false);
+	int decoded = N;
+	if (openCache())
+	{
+		const PyramidSource* cached = (const PyramidSource*)(cache->data() + sizeof(PyramidHeader));
+		decoded = 0;
+		for (int i = 0; i < N; i++)
+		{
+			valid[i] = std::memcmp(&cached[i], &sources[i], sizeof(PyramidSource)) == 0;
+			decoded += !valid[i];
+		}
+	}
+	if (decoded > 0)
+		writeCache(sources, valid);
+
+	for (int t = 0; t < options.threads; t++)
+		workers.emplace_back(&ImageLoader::prefetchWorker, this);
+	return decoded;
+}
+
+// Writes a new cache next to the old one, copying the levels of valid
+// images from it, and replaces it once complete
+void SplatIO::ImageLoader::writeCache(const std::vector<PyramidSource>& sources, const std::vector<bool>& valid)
+{
+	const int N = numImages();
+	const int L = numLevels();
+	const std::string temp_path = cache_path + ".tmp";
+	const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		fail(temp_path, std::string("cannot create (") + std::strerror(errno) + ")");
+
+	const uint64_t table_bytes = sizeof(PyramidHeader) + N * sizeof(PyramidSource) + (uint64_t)N * L * sizeof(PyramidLevel);
+	std::vector<PyramidLevel> table((size_t)N * L);
+	uint64_t end = alignUp(table_bytes);
+
+	// Workers take images in turn; each writes its levels to space claimed
+	// at the end of the file
+	std::atomic<int> next(0);
+	std::mutex claim;
+	std::exception_ptr error;
+	auto work = [&]() {
+		for (int i = next++; i < N; i = next++)
+		{
+			try
+			{
+				std::vector<Image8> pyramid(L);
+				if (valid[i])
+				{
+					for (int l = 0; l < L; l++)
+					{
+						const PyramidLevel& old = levels[i * L + l];
+						pyramid[l].width = old.width;
+						pyramid[l].height = old.height;
+						pyramid[l].channels = old.channels;
+						const uint8_t* pixels = (const uint8_t*)cache->data() + old.offset;
+						pyramid[l].pixels.assign(pixels, pixels + levelBytes(old));
+					}
+				}
+				else
+				{
+					Image8 image = decodeImage(paths[i]);
+					if (options.composite)
+						image = compositeBackground(image, options.background);
+					for (int l = 0; l < L; l++)
+					{
+						int width, height;
+						levelSize(image.width, image.height, options.resolution, options.factors[l], width, height);
+						pyramid[l] = resampleArea(image, width, height);
+					}
+				}
+
+				uint64_t offset;
+				{
+					std::lock_guard<std::mutex> lock(claim);
+					offset = end;
+					for (int l = 0; l < L; l++)
+						end = alignLevel(end + pyramid[l].pixels.size());
+				}
+				for (int l = 0; l < L; l++)
+				{
+					PyramidLevel& level = table[i * L + l];
+					level = { (uint32_t)pyramid[l].width, (uint32_t)pyramid[l].height, (uint32_t)pyramid[l].channels, 0, offset };
+					writeAll(fd, pyramid[l].pixels.data(), pyramid[l].pixels.size(), offset, temp_path);
+					offset = alignLevel(offset + pyramid[l].pixels.size());
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(claim);
+				if (!error)
+					error = std::current_exception();
+				next = N;
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int t = 1; t < options.threads; t++)
+		threads.emplace_back(work);
+	work();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	if (!error)
+	{
+		PyramidHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC));
+		header.version = PYRAMID_VERSION;
+		header.num_images = N;
+		header.num_levels = L;
+		header.resolution = options.resolution;
+		for (int l = 0; l < L; l++)
+			header.factors[l] = options.factors[l];
+		header.composite = options.composite;
+		std::memcpy(header.background, options.background, sizeof(header.background));
+		header.file_bytes = std::max(end, alignUp(table_bytes));
+
+		std::vector<char> head(table_bytes);
+		std::memcpy(head.data(), &header, sizeof(header));
+		std::memcpy(head.data() + sizeof(header), sources.data(), N * sizeof(PyramidSource));
+		std::memcpy(head.data() + sizeof(header) + N * sizeof(PyramidSource), table.data(), table.size() * sizeof(PyramidLevel));
+		try
+		{
+			if (ftruncate(fd, (off_t)header.file_bytes) != 0)
+				fail(temp_path, std::string("cannot resize (") + std::strerror(errno) + ")");
+			writeAll(fd, head.data(), head.size(), 0, temp_path);
+			if (fsync(fd) != 0)
+				fail(temp_path, std::string("cannot sync (") + std::strerror(errno) + ")");
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+	}
+	::close(fd);
+	if (!error && std::rename(temp_path.c_str(), cache_path.c_str()) != 0)
+		error = std::make_exception_ptr(std::runtime_error(cache_path + ": cannot replace (" + std::strerror(errno) + ")"));
+	if (error)
+	{
+		unlink(temp_path.c_str());
+		std::rethrow_exception(error);
+	}
+
+	cache.reset();
+	levels = nullptr;
+	if (!openCache())
+		fail(cache_path, "cannot read back the image cache");
+}
+
+SplatIO::LoadedImage SplatIO::ImageLoader::load(int key) const
+{
+	const PyramidLevel& level = levels[key];
+	const uint8_t* pixels = (const uint8_t*)cache->data() + level.offset;
+	const int C = level.channels;
+	const size_t P = (size_t)level.width * level.height;
+
+	LoadedImage image;
+	image.width = level.width;
+	image.height = level.height;
+	image.channels = C;
+	image.data.resize(P * C);
+	for (size_t p = 0; p < P; p++)
+		for (int c = 0; c < C; c++)
+			image.data[c * P + p] = (float)pixels[p * C + c] / 255.0f;
+	return image;
+}
+
+void SplatIO::ImageLoader::submit(int image, int level)
+{
+	const int k = key(image, level);
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.push_back({ submitted++, k });
+	work_cv.notify_one();
+}
+
+// Earliest request for a level that is not dropped, UINT64_MAX if none.
+// Called with the mutex held.
+uint64_t SplatIO::ImageLoader::outstanding(int key) const
+{
+	uint64_t sequence = UINT64_MAX;
+	for (const auto& r : ready)
+		if (r.second.key == key)
+			sequence = std::min(sequence, r.first);
+	for (const Request& r : running)
+		if (r.key == key && dropped.count(r.sequence) == 0)
+			sequence = std::min(sequence, r.sequence);
+	for (const Request& r : pending)
+		if (r.key == key)
+		{
+			sequence = std::min(sequence, r.sequence);
+			break;
+		}
+	return sequence;
+}
+
+// Removes a single request. One being loaded is discarded by its worker.
+// Called with the mutex held.
+void SplatIO::ImageLoader::drop(uint64_t sequence)
+{
+	auto queued = std::find_if(pending.begin(), pending.end(), [&](const Request& r) { return r.sequence == sequence; });
+	if (queued != pending.end())
+		pending.erase(queued);
+	else if (ready.erase(sequence) == 0)
+		dropped.insert(sequence);
+	work_cv.notify_all();
+}
+
+SplatIO::LoadedImage SplatIO::ImageLoader::take(int image, int level)
+{
+	const int k = key(image, level);
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		const uint64_t sequence = outstanding(k);
+		if (sequence == UINT64_MAX)
+			break;
+
+		auto it = ready.find(sequence);
+		if (it != ready.end())
+		{
+			LoadedImage loaded = std::move(it->second.image);
+			ready.erase(it);
+			work_cv.notify_all();
+			return loaded;
+		}
+		if (std::any_of(running.begin(), running.end(), [&](const Request& r) { return r.sequence == sequence; }))
+		{
+			ready_cv.wait(lock);
+			continue;
+		}
+		// Not started yet: load it here rather than waiting for the queue
+		drop(sequence);
+		break;
+	}
+	lock.unlock();
+	return load(k);
+}
+
+void SplatIO::ImageLoader::cancel(int image, int level)
+{
+	const int k = key(image, level);
+	std::lock_guard<std::mutex> lock(mutex);
+	const uint64_t sequence = outstanding(k);
+	if (sequence != UINT64_MAX)
+		drop(sequence);
+}
+
+void SplatIO::ImageLoader::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.clear();
+	ready.clear();
+	for (const Request& r : running)
+		dropped.insert(r.sequence);
+	work_cv.notify_all();
+}
+
+void SplatIO::ImageLoader::prefetchWorker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		work_cv.wait(lock, [this] {
+			return stopping || (!pending.empty() && ready.size() + running.size() < (size_t)options.capacity);
+		});
+		if (stopping)
+			return;
+
+		const Request request = pending.front();
+		pending.pop_front();
+		running.push_back(request);
+		lock.unlock();
+
+		LoadedImage loaded = load(request.key);
+
+		lock.lock();
+		running.erase(std::find_if(running.begin(), running.end(), [&](const Request& r) { return r.sequence == request.sequence; }));
+		if (dropped.erase(request.sequence) == 0)
+			ready.emplace(request.sequence, Prefetched{ request.key, std::move(loaded) });
+		ready_cv.notify_all();
+		work_cv.notify_all();
+	}
+}
+
+void SplatIO::ImageLoader::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		pending.clear();
+		ready.clear();
+	}
+	work_cv.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+}
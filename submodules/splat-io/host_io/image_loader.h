@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_IMAGE_LOADER_H_INCLUDED
+#define SPLAT_IO_IMAGE_LOADER_H_INCLUDED
+
+#include "splat_file.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Training images as a multi-scale pyramid in an on-disk cache, streamed
+// through a bounded prefetch queue.
+//
+// On-disk layout of a pyramid cache:
+//
+//   [PyramidHeader][PyramidSource x num_images]
+//   [PyramidLevel x num_images * num_levels][padding to ALIGNMENT]
+//   [pixel data of every level, 8 bit, rows top to bottom, channels
+//    interleaved, each level starting on a 64 byte boundary]
+//
+// A cache is reused if it was built with the same settings; images whose
+// source file changed (size, modification time or path) are decoded again.
+namespace SplatIO
+{
+	constexpr char PYRAMID_MAGIC[8] = { 'M', 'I', 'P', 'P', 'Y', 'R', 'M', 'D' };
+	constexpr uint32_t PYRAMID_VERSION = 1;
+	constexpr uint32_t MAX_PYRAMID_LEVELS = 8;
+
+	struct PyramidHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t num_images;
+		uint32_t num_levels;
+		int32_t resolution;				// --resolution setting the levels were made for
+		uint32_t factors[MAX_PYRAMID_LEVELS];	// downscale factor of every level
+		uint32_t composite;				// RGBA images were blended over background
+		float background[3];
+		uint64_t file_bytes;
+	};
+
+	struct PyramidSource
+	{
+		uint64_t path_hash;
+		uint64_t bytes;
+		int64_t mtime_ns;
+	};
+
+	struct PyramidLevel
+	{
+		uint32_t width, height, channels, reserved;
+		uint64_t offset;				// byte offset of the pixels from the file start
+	};
+
+	// A decoded level as floats in [0, 1], channels first (C x H x W)
+	struct LoadedImage
+	{
+		int width = 0, height = 0, channels = 0;
+		std::vector<float> data;
+	};
+
+	class ImageLoader
+	{
+	public:
+		struct Options
+		{
+			int resolution = -1;				// as the --resolution argument
+			std::vector<int> factors = { 1, 2, 4, 8 };
+			bool composite = false;				// blend RGBA images over background
+			float background[3] = { 0.0f, 0.0f, 0.0f };
+			int threads = 0;					// 0: one per hardware thread
+			int capacity = 8;					// prefetched images held at most
+		};
+
+		ImageLoader(const std::vector<std::string>& paths, const std::string& cache_path, const Options& options);
+		~ImageLoader();
+
+		ImageLoader(const ImageLoader&) = delete;
+		ImageLoader& operator=(const ImageLoader&) = delete;
+
+		// Brings the cache up to date, decoding the images that are missing
+		// from it on the worker threads, then starts the prefetch workers.
+		// Every worker holds one image at a time. Returns the number of
+		// images decoded.
+		int prepare();
+
+		int numImages() const { return (int)paths.size(); }
+		int numLevels() const { return (int)options.factors.size(); }
+		const PyramidLevel& level(int image, int level) const;
+
+		// Queues a level for loading ahead of take(). At most capacity
+		// loaded levels are held; further requests wait in the queue.
+		void submit(int image, int level);
+		// The given level, from the queue if it was submitted, otherwise
+		// loaded right away. Only the earliest request for the level
+		// leaves the queue, levels may be taken in any order.
+		LoadedImage take(int image, int level);
+		// Drops the earliest request for a level that will not be taken,
+		// so that it does not hold on to its slot
+		void cancel(int image, int level);
+		// Drops all queued and prefetched levels
+		void clear();
+
+	private:
+		int key(int image, int level) const;
+		LoadedImage load(int key) const;
+		bool openCache();
+		void writeCache(const std::vector<PyramidSource>& sources, const std::vector<bool>& valid);
+		void prefetchWorker();
+		uint64_t outstanding(int key) const;
+		void drop(uint64_t sequence);
+		void stop();
+
+		std::vector<std::string> paths;
+		std::string cache_path;
+		Options options;
+
+		std::shared_ptr<MappedFile> cache;
+		const PyramidLevel* levels = nullptr;
+
+		// Requests are numbered in submission order
+		struct Request
+		{
+			uint64_t sequence;
+			int key;
+		};
+
+		std::mutex mutex;
+		std::condition_variable work_cv, ready_cv;
+		std::deque<Request> pending;
+		std::vector<Request> running;
+		struct Prefetched
+		{
+			int key;
+			LoadedImage image;
+		};
+
+		std::unordered_map<uint64_t, Prefetched> ready;
+		std::unordered_set<uint64_t> dropped;	// running requests to discard
+		uint64_t submitted = 0;
+		bool stopping = false;
+		std::vector<std::thread> workers;
+	};
+};
+
+#endif
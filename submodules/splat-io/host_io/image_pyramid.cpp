@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "image_pyramid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Source pixels and weights of every output pixel along one axis
+	struct Footprint
+	{
+		std::vector<int> first, count;
+		std::vector<float> weights;
+		std::vector<int> offsets;
+	};
+
+	Footprint footprint(int src, int dst)
+	{
+		Footprint f;
+		const double scale = (double)src / dst;
+		for (int i = 0; i < dst; i++)
+		{
+			const double begin = i * scale, end = (i + 1) * scale;
+			const int first = (int)std::floor(begin);
+			const int last = std::min(src, (int)std::ceil(end));
+			f.first.push_back(first);
+			f.count.push_back(last - first);
+			f.offsets.push_back((int)f.weights.size());
+			for (int s = first; s < last; s++)
+			{
+				const double covered = std::min(end, s + 1.0) - std::max(begin, (double)s);
+				f.weights.push_back((float)(covered / scale));
+			}
+		}
+		return f;
+	}
+}
+
+void SplatIO::levelSize(int width, int height, int resolution, int factor, int& level_width, int& level_height)
+{
+	switch (resolution)
+	{
+	case 1: case 2: case 4: case 8: case 16: case 32: case 64:
+		// Python's round, ties to even
+		level_width = (int)std::nearbyint((double)width / ((double)factor * resolution));
+		level_height = (int)std::nearbyint((double)height / ((double)factor * resolution));
+		break;
+	default:
+	{
+		double down = 1.0;
+		if (resolution == -1)
+			down = width > 1600 ? width / 1600.0 : 1.0;
+		else
+			down = (double)width / resolution;
+		const double scale = down * factor;
+		level_width = (int)(width / scale);
+		level_height = (int)(height / scale);
+	}
+	}
+	level_width = std::max(1, level_width);
+	level_height = std::max(1, level_height);
+}
+
+SplatIO::Image8 SplatIO::compositeBackground(const Image8& image, const float* background)
+{
+	if (image.channels != 4)
+		return image;
+
+	Image8 out;
+	out.width = image.width;
+	out.height = image.height;
+	out.channels = 3;
+	out.pixels.resize((size_t)image.width * image.height * 3);
+	const size_t pixels = (size_t)image.width * image.height;
+	for (size_t i = 0; i < pixels; i++)
+	{
+		const double alpha = image.pixels[4 * i + 3] / 255.0;
+		for (int c = 0; c < 3; c++)
+		{
+			const double value = image.pixels[4 * i + c] / 255.0 * alpha + (double)background[c] * (1.0 - alpha);
+			out.pixels[3 * i + c] = (uint8_t)(value * 255.0);
+		}
+	}
+	return out;
+}
+
+SplatIO::Image8 SplatIO::resampleArea(const Image8& image, int width, int height)
+{
+	if (width == image.width && height == image.height)
+		return image;
+
+	const int C = image.channels;
+	const Footprint fx = footprint(image.width, width);
+	const Footprint fy = footprint(image.height, height);
+
+	// Horizontal pass into floats, then vertical pass with rounding
+	std::vector<float> rows((size_t)image.height * width * C);
+	for (int y = 0; y < image.height; y++)
+	{
+		const uint8_t* src = &image.pixels[(size_t)y * image.width * C];
+		float* dst = &rows[(size_t)y * width * C];
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < C; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < fx.count[x]; k++)
+					sum += fx.weights[fx.offsets[x] + k] * src[(fx.first[x] + k) * C + c];
+				dst[x * C + c] = sum;
+			}
+	}
+
+	Image8 out;
+	out.width = width;
+	out.height = height;
+	out.channels = C;
+	out.pixels.resize((size_t)width * height * C);
+	for (int y = 0; y < height; y++)
+	{
+		uint8_t* dst = &out.pixels[(size_t)y * width * C];
+		for (int i = 0; i < width * C; i++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < fy.count[y]; k++)
+				sum += fy.weights[fy.offsets[y] + k] * rows[((size_t)(fy.first[y] + k) * width) * C + i];
+			dst[i] = (uint8_t)std::min(255.0f, std::max(0.0f, std::round(sum)));
+		}
+	}
+	return out;
+}
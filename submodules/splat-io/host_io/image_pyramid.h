@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_IMAGE_PYRAMID_H_INCLUDED
+#define SPLAT_IO_IMAGE_PYRAMID_H_INCLUDED
+
+#include "image_codec.h"
+
+namespace SplatIO
+{
+	// Size of an image of width x height pixels when loaded at the given
+	// downscale factor, for the --resolution setting of the training
+	// scripts (1, 2, 4, ... 64 divide the size, -1 limits the width to
+	// 1600 pixels, other values set the width). Matches loadCam.
+	void levelSize(int width, int height, int resolution, int factor, int& level_width, int& level_height);
+
+	// Blends an RGBA image over a constant background (RGB in [0, 1]),
+	// with the rounding of the Python loaders. RGB images are returned as is.
+	Image8 compositeBackground(const Image8& image, const float* background);
+
+	// Area-averaging resample (every output pixel is the mean of the input
+	// area it covers), the filter of the multi-scale datasets.
+	Image8 resampleArea(const Image8& image, int width, int height);
+};
+
+#endif
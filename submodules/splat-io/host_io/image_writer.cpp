@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "image_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace
+{
+	double now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+SplatIO::ImageWriter::ImageWriter(const Options& options)
+	: options(options)
+{
+	if (this->options.threads <= 0)
+		this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+	this->options.capacity = std::max(1, this->options.capacity);
+	for (int t = 0; t < this->options.threads; t++)
+		workers.emplace_back(&ImageWriter::worker, this);
+}
+
+SplatIO::ImageWriter::~ImageWriter()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done_cv.wait(lock, [this] { return queue.empty() && running == 0; });
+		stopping = true;
+	}
+	work_cv.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void SplatIO::ImageWriter::submit(const std::string& path, Image8 image)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const double start = now();
+	if (first_submit < 0.0)
+		first_submit = start;
+	space_cv.wait(lock, [this] { return queue.size() < (size_t)options.capacity; });
+	counters.wait_ms += now() - start;
+	queue.push_back(Job{ path, std::move(image) });
+	work_cv.notify_one();
+}
+
+void SplatIO::ImageWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cv.wait(lock, [this] { return queue.empty() && running == 0; });
+	if (!error.empty())
+	{
+		const std::string message = error;
+		error.clear();
+		throw std::runtime_error(message);
+	}
+}
+
+SplatIO::ImageWriter::Stats SplatIO::ImageWriter::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void SplatIO::ImageWriter::worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		work_cv.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (queue.empty())
+			return;
+		Job job = std::move(queue.front());
+		queue.pop_front();
+		running++;
+		space_cv.notify_one();
+		lock.unlock();
+
+		const double start = now();
+		std::string failure;
+		try
+		{
+			writePNG(job.path, job.image, options.fast);
+		}
+		catch (const std::exception& e)
+		{
+			failure = e.what();
+		}
+		const double end = now();
+
+		lock.lock();
+		running--;
+		counters.encode_ms += end - start;
+		counters.wall_ms = end - first_submit;
+		if (failure.empty())
+		{
+			counters.images++;
+			counters.bytes += job.image.pixels.size();
+		}
+		else if (error.empty())
+			error = failure;
+		if (queue.empty() && running == 0)
+			done_cv.notify_all();
+	}
+}
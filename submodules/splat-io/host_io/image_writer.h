@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_IMAGE_WRITER_H_INCLUDED
+#define SPLAT_IO_IMAGE_WRITER_H_INCLUDED
+
+#include "image_codec.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes images as PNG on a pool of encoder threads, fed through a bounded
+// queue: submit returns as soon as the image is queued, so rendering
+// continues while earlier images are encoded, and blocks while capacity
+// images are waiting, which bounds the memory held.
+namespace SplatIO
+{
+	class ImageWriter
+	{
+	public:
+		struct Options
+		{
+			int threads = 0;				// 0: one per hardware thread
+			int capacity = 16;				// queued images held at most
+			bool fast = true;				// faster, larger PNGs
+		};
+
+		struct Stats
+		{
+			uint64_t images = 0;			// written
+			uint64_t bytes = 0;				// of the written pixels
+			double encode_ms = 0.0;			// summed over the threads
+			double wait_ms = 0.0;			// submit blocked on a full queue
+			double wall_ms = 0.0;			// from the first submit to the last write
+		};
+
+		explicit ImageWriter(const Options& options);
+		// Writes the queued images
+		~ImageWriter();
+
+		ImageWriter(const ImageWriter&) = delete;
+		ImageWriter& operator=(const ImageWriter&) = delete;
+
+		void submit(const std::string& path, Image8 image);
+		// Waits until all submitted images are written. Throws
+		// std::runtime_error with the first error since the last flush.
+		void flush();
+
+		Stats stats() const;
+
+	private:
+		struct Job
+		{
+			std::string path;
+			Image8 image;
+		};
+
+		void worker();
+
+		Options options;
+		mutable std::mutex mutex;
+		std::condition_variable work_cv, space_cv, done_cv;
+		std::deque<Job> queue;
+		int running = 0;
+		bool stopping = false;
+		std::string error;
+		Stats counters;
+		double first_submit = -1.0;
+		std::vector<std::thread> workers;
+	};
+};
+
+#endif
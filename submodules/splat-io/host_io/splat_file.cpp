@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "splat_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	[[noreturn]] void fail(const std::string& path, const std::string& what)
+	{
+		throw std::runtime_error(path + ": " + what);
+	}
+
+	[[noreturn]] void failErrno(const std::string& path, const std::string& what)
+	{
+		fail(path, what + " (" + std::strerror(errno) + ")");
+	}
+
+	void writeAll(int fd, const char* data, uint64_t bytes, uint64_t offset, const std::string& path)
+	{
+		while (bytes > 0)
+		{
+			ssize_t n = pwrite(fd, data, bytes, offset);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				failErrno(path, "write failed");
+			}
+			data += n;
+			bytes -= n;
+			offset += n;
+		}
+	}
+
+	// Page-aligned sub-range of [offset, offset + bytes) within a mapping
+	void pageRange(size_t length, size_t& offset, size_t& bytes)
+	{
+		const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		size_t end = std::min(length, offset + bytes);
+		offset = offset / page * page;
+		bytes = end > offset ? end - offset : 0;
+	}
+}
+
+std::shared_ptr<SplatIO::MappedFile> SplatIO::MappedFile::open(const std::string& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		failErrno(path, "cannot open");
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		failErrno(path, "cannot stat");
+	}
+	if (st.st_size == 0)
+	{
+		::close(fd);
+		fail(path, "file is empty");
+	}
+
+	// Private writable mapping: tensors wrapping the pages may be modified
+	// in place (e.g. by an optimizer), the file itself stays untouched.
+	void* base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (base == MAP_FAILED)
+		failErrno(path, "cannot map");
+
+	return std::shared_ptr<MappedFile>(new MappedFile((char*)base, st.st_size));
+}
+
+SplatIO::MappedFile::~MappedFile()
+{
+	munmap(base, length);
+}
+
+void SplatIO::MappedFile::prefetch(size_t offset, size_t bytes) const
+{
+	pageRange(length, offset, bytes);
+	if (bytes)
+		madvise(base + offset, bytes, MADV_WILLNEED);
+}
+
+void SplatIO::MappedFile::evict(size_t offset, size_t bytes) const
+{
+	pageRange(length, offset, bytes);
+	if (bytes)
+		madvise(base + offset, bytes, MADV_DONTNEED);
+}
+
+SplatIO::SplatReader::SplatReader(const std::string& path)
+{
+	file = MappedFile::open(path);
+
+	if (file->size() < sizeof(FileHeader))
+		fail(path, "file too small for a splat header");
+	const FileHeader& h = header();
+	if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0)
+		fail(path, "not a splat file");
+	if (h.version != FORMAT_VERSION)
+		fail(path, "unsupported splat format version " + std::to_string(h.version));
+	if (h.file_bytes != file->size())
+		fail(path, "file is truncated");
+	if (h.num_attributes > MAX_ATTRIBUTES)
+		fail(path, "corrupt attribute table");
+
+	for (uint32_t i = 0; i < h.num_attributes; i++)
+	{
+		const AttributeDesc& a = h.attributes[i];
+		if (std::memchr(a.name, 0, MAX_NAME_LENGTH) == nullptr || a.ndim > MAX_DIMS || dataTypeSize((DataType)a.dtype) == 0)
+			fail(path, "corrupt attribute table");
+		if (a.offset % ALIGNMENT != 0 || a.offset + a.bytes > file->size() || a.bytes != h.count * a.rowBytes())
+			fail(path, std::string("corrupt attribute ") + a.name);
+	}
+}
+
+const SplatIO::AttributeDesc* SplatIO::SplatReader::find(const std::string& name) const
+{
+	const FileHeader& h = header();
+	for (uint32_t i = 0; i < h.num_attributes; i++)
+		if (name == h.attributes[i].name)
+			return &h.attributes[i];
+	return nullptr;
+}
+
+std::vector<std::string> SplatIO::SplatReader::attributeNames() const
+{
+	std::vector<std::string> names;
+	const FileHeader& h = header();
+	for (uint32_t i = 0; i < h.num_attributes; i++)
+		names.push_back(h.attributes[i].name);
+	return names;
+}
+
+SplatIO::SplatWriter::SplatWriter(const std::string& path, uint64_t count, uint32_t sh_degree)
+	: path(path), temp_path(path + ".tmp")
+{
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = FORMAT_VERSION;
+	header.header_bytes = ALIGNMENT;
+	header.count = count;
+	header.sh_degree = sh_degree;
+
+	fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		failErrno(temp_path, "cannot create");
+}
+
+SplatIO::SplatWriter::~SplatWriter()
+{
+	if (fd >= 0)
+		abort();
+}
+
+void SplatIO::SplatWriter::abort()
+{
+	::close(fd);
+	fd = -1;
+	unlink(temp_path.c_str());
+}
+
+void SplatIO::SplatWriter::addAttribute(const std::string& name, DataType dtype, const std::vector<uint32_t>& dims)
+{
+	if (laid_out)
+		fail(path, "attributes must be declared before the first write");
+	if (header.num_attributes == MAX_ATTRIBUTES)
+		fail(path, "too many attributes");
+	if (name.empty() || name.size() >= MAX_NAME_LENGTH)
+		fail(path, "invalid attribute name '" + name + "'");
+	if (dims.size() > MAX_DIMS)
+		fail(path, "attribute '" + name + "' has too many dimensions");
+	for (uint32_t i = 0; i < header.num_attributes; i++)
+		if (name == header.attributes[i].name)
+			fail(path, "duplicate attribute '" + name + "'");
+
+	AttributeDesc& a = header.attributes[header.num_attributes++];
+	std::strncpy(a.name, name.c_str(), MAX_NAME_LENGTH - 1);
+	a.dtype = (uint32_t)dtype;
+	a.ndim = (uint32_t)dims.size();
+	for (uint32_t i = 0; i < MAX_DIMS; i++)
+		a.dims[i] = i < dims.size() ? dims[i] : 1;
+	written.push_back(0);
+}
+
+void SplatIO::SplatWriter::layout()
+{
+	uint64_t offset = ALIGNMENT;
+	for (uint32_t i = 0; i < header.num_attributes; i++)
+	{
+		AttributeDesc& a = header.attributes[i];
+		a.offset = offset;
+		a.bytes = header.count * a.rowBytes();
+		offset = alignUp(offset + a.bytes);
+	}
+	header.file_bytes = offset;
+
+	// Reserve the whole file up front, the columns are then filled in place
+	if (ftruncate(fd, (off_t)header.file_bytes) != 0)
+		failErrno(temp_path, "cannot resize");
+	laid_out = true;
+}
+
+size_t SplatIO::SplatWriter::index(const std::string& name) const
+{
+	for (uint32_t i = 0; i < header.num_attributes; i++)
+		if (name == header.attributes[i].name)
+			return i;
+	fail(path, "unknown attribute '" + name + "'");
+}
+
+uint64_t SplatIO::SplatWriter::rowsWritten(const std::string& name) const
+{
+	return written[index(name)];
+}
+
+void SplatIO::SplatWriter::write(const std::string& name, const void* data, uint64_t rows)
+{
+	if (fd < 0)
+		fail(path, "writer is closed");
+	if (!laid_out)
+		layout();
+
+	const size_t i = index(name);
+	const AttributeDesc& a = header.attributes[i];
+	if (written[i] + rows > header.count)
+		fail(path, "too many rows for attribute '" + name + "'");
+
+	writeAll(fd, (const char*)data, rows * a.rowBytes(), a.offset + written[i] * a.rowBytes(), temp_path);
+	written[i] += rows;
+}
+
+void SplatIO::SplatWriter::close()
+{
+	if (fd < 0)
+		fail(path, "writer is closed");
+	if (!laid_out)
+		layout();
+
+	for (uint32_t i = 0; i < header.num_attributes; i++)
+	{
+		if (written[i] != header.count)
+		{
+			std::string name = header.attributes[i].name;
+			abort();
+			fail(path, "attribute '" + name + "' is incomplete");
+		}
+	}
+
+	// The header goes last, a file without it is never mistaken for a
+	// valid one.
+	std::vector<char> page(ALIGNMENT, 0);
+	std::memcpy(page.data(), &header, sizeof(header));
+	writeAll(fd, page.data(), page.size(), 0, temp_path);
+
+	if (fsync(fd) != 0)
+	{
+		const int error = errno;
+		abort();
+		errno = error;
+		failErrno(temp_path, "cannot sync");
+	}
+	::close(fd);
+	fd = -1;
+	if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+	{
+		unlink(temp_path.c_str());
+		failErrno(path, "cannot replace");
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_FILE_H_INCLUDED
+#define SPLAT_IO_FILE_H_INCLUDED
+
+#include "splat_format.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SplatIO
+{
+	// Read-only file mapping. Pages are mapped copy-on-write, so memory
+	// handed out from a mapping may be modified without touching the file.
+	class MappedFile
+	{
+	public:
+		static std::shared_ptr<MappedFile> open(const std::string& path);
+		~MappedFile();
+
+		char* data() const { return base; }
+		size_t size() const { return length; }
+
+		// Hint the kernel to read the given byte range ahead.
+		void prefetch(size_t offset, size_t bytes) const;
+		// Give the pages of the given byte range back (they are reloaded
+		// from the file on the next access).
+		void evict(size_t offset, size_t bytes) const;
+
+	private:
+		MappedFile(char* base, size_t length) : base(base), length(length) {}
+
+		char* base;
+		size_t length;
+	};
+
+	class SplatReader
+	{
+	public:
+		explicit SplatReader(const std::string& path);
+
+		uint64_t count() const { return header().count; }
+		uint32_t shDegree() const { return header().sh_degree; }
+		const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(file->data()); }
+
+		// nullptr if the file has no attribute of that name
+		const AttributeDesc* find(const std::string& name) const;
+		std::vector<std::string> attributeNames() const;
+
+		char* data(const AttributeDesc& attribute) const { return file->data() + attribute.offset; }
+		const std::shared_ptr<MappedFile>& mapping() const { return file; }
+
+	private:
+		std::shared_ptr<MappedFile> file;
+	};
+
+	// Writes a splat file column by column. Attributes are declared up
+	// front, after which rows can be appended to each attribute in chunks
+	// of any size, so the caller never needs to hold a full copy of the
+	// model in host memory. The data goes to a temporary file that only
+	// replaces the target once close() has verified that every attribute
+	// was written completely.
+	class SplatWriter
+	{
+	public:
+		SplatWriter(const std::string& path, uint64_t count, uint32_t sh_degree);
+		~SplatWriter();
+
+		SplatWriter(const SplatWriter&) = delete;
+		SplatWriter& operator=(const SplatWriter&) = delete;
+
+		void addAttribute(const std::string& name, DataType dtype, const std::vector<uint32_t>& dims);
+		// Append rows to an attribute. data holds rows * rowBytes() bytes.
+		void write(const std::string& name, const void* data, uint64_t rows);
+		void close();
+
+		const AttributeDesc& attribute(const std::string& name) const { return header.attributes[index(name)]; }
+		uint64_t rowsWritten(const std::string& name) const;
+
+	private:
+		size_t index(const std::string& name) const;
+		void layout();
+		void abort();
+
+		std::string path;
+		std::string temp_path;
+		int fd = -1;
+		bool laid_out = false;
+		FileHeader header;
+		std::vector<uint64_t> written;
+	};
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_FORMAT_H_INCLUDED
+#define SPLAT_IO_FORMAT_H_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+
+// On-disk layout of a splat file:
+//
+//   [FileHeader, padded to ALIGNMENT bytes]
+//   [attribute 0: count rows, structure-of-arrays column][padding]
+//   [attribute 1: ...]
+//
+// Every attribute is stored as one contiguous, row-major column that
+// starts on an ALIGNMENT boundary, in exactly the memory layout of the
+// corresponding model tensor (e.g. features_dc is count x 1 x 3). A
+// mapped file can therefore be wrapped as tensors without any copy or
+// parsing. All values are little endian.
+namespace SplatIO
+{
+	constexpr char MAGIC[8] = { 'M', 'I', 'P', 'S', 'P', 'L', 'A', 'T' };
+	constexpr uint32_t FORMAT_VERSION = 1;
+	constexpr uint64_t ALIGNMENT = 4096;
+	constexpr uint32_t MAX_ATTRIBUTES = 30;
+	constexpr uint32_t MAX_NAME_LENGTH = 32;
+	constexpr uint32_t MAX_DIMS = 2;
+
+	enum class DataType : uint32_t
+	{
+		Float32 = 0,
+		Float16 = 1,
+		UInt8 = 2,
+		Int32 = 3
+	};
+
+	inline size_t dataTypeSize(DataType type)
+	{
+		switch (type)
+		{
+		case DataType::Float32: return 4;
+		case DataType::Float16: return 2;
+		case DataType::UInt8: return 1;
+		case DataType::Int32: return 4;
+		}
+		return 0;
+	}
+
+	struct AttributeDesc
+	{
+		char name[MAX_NAME_LENGTH];	// zero terminated
+		uint32_t dtype;				// DataType
+		uint32_t ndim;				// number of trailing (per-row) dimensions
+		uint32_t dims[MAX_DIMS];	// trailing dimensions, unused entries are 1
+		uint64_t offset;			// byte offset of the column from the file start
+		uint64_t bytes;				// byte size of the column (count rows)
+
+		uint64_t rowElements() const
+		{
+			uint64_t n = 1;
+			for (uint32_t i = 0; i < ndim; i++)
+				n *= dims[i];
+			return n;
+		}
+		uint64_t rowBytes() const { return rowElements() * dataTypeSize((DataType)dtype); }
+	};
+
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t header_bytes;		// bytes reserved for the header (ALIGNMENT)
+		uint64_t count;				// number of Gaussians (rows of every attribute)
+		uint32_t sh_degree;			// maximum SH degree of the stored features
+		uint32_t num_attributes;
+		uint64_t file_bytes;		// total size, used to detect truncated files
+		uint64_t reserved[4];
+		AttributeDesc attributes[MAX_ATTRIBUTES];
+	};
+
+	static_assert(sizeof(AttributeDesc) == 64, "AttributeDesc must be packed to 64 bytes");
+	static_assert(sizeof(FileHeader) <= ALIGNMENT, "FileHeader must fit into the first page");
+
+	inline uint64_t alignUp(uint64_t offset)
+	{
+		return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+};
+
+#endif
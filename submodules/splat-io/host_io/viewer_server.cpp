@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "viewer_server.h"
+#include "image_codec.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+	// Requests are small JSON objects, anything larger is a broken client
+	constexpr uint32_t MAX_MESSAGE_BYTES = 1 << 20;
+
+	bool receiveAll(int socket, void* data, size_t size)
+	{
+		char* bytes = (char*)data;
+		while (size > 0)
+		{
+			const ssize_t n = ::recv(socket, bytes, size, 0);
+			if (n <= 0)
+				return false;
+			bytes += n;
+			size -= (size_t)n;
+		}
+		return true;
+	}
+
+	bool sendAll(int socket, const void* data, size_t size)
+	{
+		const char* bytes = (const char*)data;
+		while (size > 0)
+		{
+			const ssize_t n = ::send(socket, bytes, size, MSG_NOSIGNAL);
+			if (n <= 0)
+				return false;
+			bytes += n;
+			size -= (size_t)n;
+		}
+		return true;
+	}
+
+	void putLength(uint8_t* out, uint32_t length)
+	{
+		for (int i = 0; i < 4; i++)
+			out[i] = (uint8_t)(length >> (8 * i));
+	}
+}
+
+SplatIO::ViewerServer::ViewerServer(const Options& options)
+	: options(options)
+{
+}
+
+SplatIO::ViewerServer::~ViewerServer()
+{
+	stop();
+}
+
+void SplatIO::ViewerServer::start()
+{
+	if (listener >= 0)
+		return;
+
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((uint16_t)options.port);
+	if (::inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1)
+		throw std::runtime_error("Invalid viewer address " + options.host);
+
+	const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		throw std::runtime_error("Cannot create the viewer socket");
+	const int reuse = 1;
+	::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (::bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(fd, 4) != 0)
+	{
+		::close(fd);
+		throw std::runtime_error("Cannot listen on " + options.host + ":" + std::to_string(options.port) + " (" + std::strerror(errno) + ")");
+	}
+	socklen_t length = sizeof(address);
+	::getsockname(fd, (sockaddr*)&address, &length);
+
+	listener = fd;
+	bound_port = ntohs(address.sin_port);
+	stopping = false;
+	acceptor = std::thread(&ViewerServer::acceptLoop, this);
+	encoder = std::thread(&ViewerServer::encodeLoop, this);
+}
+
+void SplatIO::ViewerServer::stop()
+{
+	if (listener < 0)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		for (auto& entry : clients)
+			close(*entry.second);
+		to_encode.clear();
+	}
+	request_cv.notify_all();
+	encode_cv.notify_all();
+	send_cv.notify_all();
+	acceptor.join();
+	encoder.join();
+	reap(true);
+	::close(listener);
+	listener = -1;
+}
+
+void SplatIO::ViewerServer::close(Client& client)
+{
+	if (client.closed)
+		return;
+	client.closed = true;
+	client.has_request = false;
+	// Unblocks the reader in recv and the sender in send
+	::shutdown(client.socket, SHUT_RDWR);
+	send_cv.notify_all();
+}
+
+void SplatIO::ViewerServer::reap(bool all)
+{
+	std::vector<std::shared_ptr<Client>> closed;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = clients.begin(); it != clients.end();)
+		{
+			if (all || it->second->closed)
+			{
+				closed.push_back(it->second);
+				it = clients.erase(it);
+			}
+			else
+				++it;
+		}
+		counters.clients = (int)clients.size();
+	}
+	for (const auto& client : closed)
+	{
+		client->reader.join();
+		client->sender.join();
+		::close(client->socket);
+	}
+}
+
+void SplatIO::ViewerServer::acceptLoop()
+{
+	for (;;)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (stopping)
+				return;
+		}
+		reap(false);
+
+		pollfd waiting = { listener, POLLIN, 0 };
+		if (::poll(&waiting, 1, 100) <= 0)
+			continue;
+		const int fd = ::accept(listener, nullptr, nullptr);
+		if (fd < 0)
+			continue;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping || (int)clients.size() >= options.max_clients)
+		{
+			::close(fd);
+			continue;
+		}
+		const int nodelay = 1;
+		::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+		auto client = std::make_shared<Client>();
+		client->id = next_id++;
+		client->socket = fd;
+		client->reader = std::thread(&ViewerServer::readLoop, this, client);
+		client->sender = std::thread(&ViewerServer::sendLoop, this, client);
+		clients.emplace(client->id, client);
+		counters.clients = (int)clients.size();
+	}
+}
+
+void SplatIO::ViewerServer::readLoop(std::shared_ptr<Client> client)
+{
+	std::string message;
+	for (;;)
+	{
+		uint8_t header[4];
+		bool ok = receiveAll(client->socket, header, 4);
+		const uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+		ok = ok && length <= MAX_MESSAGE_BYTES;
+		if (ok)
+		{
+			message.resize(length);
+			ok = receiveAll(client->socket, &message[0], length);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!ok || client->closed)
+		{
+			close(*client);
+			return;
+		}
+		counters.requests++;
+		if (client->has_request)
+			counters.requests_replaced++;
+		client->request.swap(message);
+		client->has_request = true;
+		request_cv.notify_all();
+	}
+}
+
+bool SplatIO::ViewerServer::poll(Request& request, int timeout_ms)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	auto next = [this]() -> std::shared_ptr<Client> {
+		// Round robin: the first waiting client after the last one served
+		std::shared_ptr<Client> first;
+		for (const auto& entry : clients)
+		{
+			if (!entry.second->has_request)
+				continue;
+			if (entry.first > last_polled)
+				return entry.second;
+			if (!first)
+				first = entry.second;
+		}
+		return first;
+	};
+
+	std::shared_ptr<Client> client = next();
+	if (!client && timeout_ms > 0)
+	{
+		request_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+			return stopping || (client = next()) != nullptr;
+		});
+	}
+	if (!client)
+		return false;
+
+	request.client = client->id;
+	request.message.swap(client->request);
+	client->has_request = false;
+	last_polled = client->id;
+	return true;
+}
+
+void SplatIO::ViewerServer::reply(uint64_t client, const uint8_t* rgb, int width, int height, FrameEncoding encoding, const std::string& verify)
+{
+	auto frame = std::make_unique<Frame>();
+	frame->client = client;
+	frame->encoding = encoding;
+	frame->verify = verify;
+	if (rgb != nullptr)
+	{
+		frame->width = width;
+		frame->height = height;
+		frame->pixels.assign(rgb, rgb + (size_t)width * height * 3);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = clients.find(client);
+	if (stopping || it == clients.end() || it->second->closed)
+		return;
+	// A frame of the same client still waiting for the encoder is outdated
+	for (auto& waiting : to_encode)
+		if (waiting->client == client)
+		{
+			waiting = std::move(frame);
+			counters.frames_replaced++;
+			return;
+		}
+	to_encode.push_back(std::move(frame));
+	encode_cv.notify_one();
+}
+
+void SplatIO::ViewerServer::encodeLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		encode_cv.wait(lock, [this] { return stopping || !to_encode.empty(); });
+		if (stopping)
+			return;
+		std::unique_ptr<Frame> frame = std::move(to_encode.front());
+		to_encode.pop_front();
+		lock.unlock();
+
+		// The payload replaces the pixels
+		const auto start = std::chrono::steady_clock::now();
+		bool ok = true;
+		if (frame->encoding == FrameEncoding::JPEG && !frame->pixels.empty())
+		{
+			try
+			{
+				std::vector<uint8_t> jpeg = encodeJPEG(frame->pixels.data(), frame->width, frame->height, options.jpeg_quality);
+				frame->pixels.resize(4 + jpeg.size());
+				putLength(frame->pixels.data(), (uint32_t)jpeg.size());
+				std::memcpy(frame->pixels.data() + 4, jpeg.data(), jpeg.size());
+			}
+			catch (const std::exception&)
+			{
+				ok = false;
+			}
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		lock.lock();
+		counters.encode_ms += ms;
+		auto it = clients.find(frame->client);
+		if (it == clients.end() || it->second->closed)
+			continue;
+		// The client would wait for the reply forever
+		if (!ok)
+		{
+			close(*it->second);
+			continue;
+		}
+		if (it->second->encoded)
+			counters.frames_replaced++;
+		it->second->encoded = std::move(frame);
+		send_cv.notify_all();
+	}
+}
+
+void SplatIO::ViewerServer::sendLoop(std::shared_ptr<Client> client)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		send_cv.wait(lock, [&] { return client->closed || client->encoded != nullptr; });
+		if (client->closed)
+			return;
+		std::unique_ptr<Frame> frame = std::move(client->encoded);
+		lock.unlock();
+
+		uint8_t length[4];
+		putLength(length, (uint32_t)frame->verify.size());
+		const bool ok = sendAll(client->socket, frame->pixels.data(), frame->pixels.size())
+			&& sendAll(client->socket, length, 4)
+			&& sendAll(client->socket, frame->verify.data(), frame->verify.size());
+
+		lock.lock();
+		if (!ok)
+		{
+			close(*client);
+			return;
+		}
+		counters.frames++;
+		counters.bytes_sent += frame->pixels.size() + 4 + frame->verify.size();
+	}
+}
+
+SplatIO::ViewerServer::Stats SplatIO::ViewerServer::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
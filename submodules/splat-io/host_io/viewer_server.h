@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPLAT_IO_VIEWER_SERVER_H_INCLUDED
+#define SPLAT_IO_VIEWER_SERVER_H_INCLUDED
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Server of the network viewer protocol (gaussian_renderer/network_gui.py)
+// that runs beside training. Clients send camera requests as
+//
+//   [uint32 length][JSON message]
+//
+// and get one reply per request: the frame, then [uint32 length][verify
+// string]. Frames are raw RGB8 (width * height * 3 bytes, rows top to
+// bottom) as the original viewer expects, or [uint32 length][JPEG] for
+// clients that ask for it, see FrameEncoding. Integers are little endian.
+//
+// Every client has a reader and a sender thread, and one encoder thread
+// is shared. Requests wait per client, a newer request replacing the one
+// not yet taken (latest wins), so the trainer polls without blocking and
+// always renders the newest camera. Replies are copied and handed to the
+// encoder, then to the client's sender, so the trainer continues while
+// the previous frames are encoded and sent. Clients that pipeline several
+// requests only get a reply to the newest of those taken together.
+namespace SplatIO
+{
+	enum class FrameEncoding
+	{
+		Raw = 0,
+		JPEG = 1
+	};
+
+	class ViewerServer
+	{
+	public:
+		struct Options
+		{
+			std::string host = "127.0.0.1";
+			int port = 6009;				// 0: any free port, see port()
+			int max_clients = 4;			// further connections are closed
+			int jpeg_quality = 85;
+		};
+
+		struct Request
+		{
+			uint64_t client = 0;
+			std::string message;			// the JSON text
+		};
+
+		struct Stats
+		{
+			uint64_t requests = 0;			// received
+			uint64_t requests_replaced = 0;	// by a newer one before they were taken
+			uint64_t frames = 0;			// sent
+			uint64_t frames_replaced = 0;	// by a newer one before they were sent
+			uint64_t bytes_sent = 0;
+			double encode_ms = 0.0;			// spent encoding, in total
+			int clients = 0;
+		};
+
+		explicit ViewerServer(const Options& options);
+		~ViewerServer();
+
+		ViewerServer(const ViewerServer&) = delete;
+		ViewerServer& operator=(const ViewerServer&) = delete;
+
+		// Binds the listening socket and starts accepting clients
+		void start();
+		// Disconnects all clients and joins the threads
+		void stop();
+		// The bound port, once started
+		int port() const { return bound_port; }
+
+		// The newest request of the next client that has one, clients
+		// taking turns. Waits up to timeout_ms for one; returns false if
+		// there is none.
+		bool poll(Request& request, int timeout_ms);
+		// Replies to the request taken from client with an 8 bit RGB frame
+		// (rows top to bottom; null for requests without one) and the
+		// verify string. The frame is copied, encoding and sending happen
+		// on the server's threads. Replies to clients that disconnected are
+		// dropped.
+		void reply(uint64_t client, const uint8_t* rgb, int width, int height, FrameEncoding encoding, const std::string& verify);
+
+		Stats stats() const;
+
+	private:
+		struct Frame
+		{
+			uint64_t client = 0;
+			int width = 0, height = 0;
+			FrameEncoding encoding = FrameEncoding::Raw;
+			std::vector<uint8_t> pixels;	// RGB8 before encoding, the payload after
+			std::string verify;
+		};
+
+		struct Client
+		{
+			uint64_t id = 0;
+			int socket = -1;
+			bool closed = false;
+			bool has_request = false;
+			std::string request;
+			std::unique_ptr<Frame> encoded;	// waiting for the sender
+			std::thread reader, sender;
+		};
+
+		void acceptLoop();
+		void readLoop(std::shared_ptr<Client> client);
+		void encodeLoop();
+		void sendLoop(std::shared_ptr<Client> client);
+		// Marks the client closed and wakes its threads; needs the lock
+		void close(Client& client);
+		// Joins and removes the closed clients
+		void reap(bool all);
+
+		Options options;
+		int listener = -1;
+		int bound_port = 0;
+
+		mutable std::mutex mutex;
+		std::condition_variable request_cv, encode_cv, send_cv;
+		std::map<uint64_t, std::shared_ptr<Client>> clients;
+		std::deque<std::unique_ptr<Frame>> to_encode;
+		uint64_t next_id = 1;
+		uint64_t last_polled = 0;
+		bool stopping = false;
+		Stats counters;
+
+		std::thread acceptor, encoder;
+	};
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "image_tensors.h"
+
+std::unique_ptr<SplatIO::ImageLoader> createImageLoader(
+	const std::vector<std::string>& paths,
+	const std::string& cache_path,
+	const int resolution,
+	const std::vector<int>& factors,
+	const std::optional<std::vector<float>>& background,
+	const int threads,
+	const int capacity)
+{
+	SplatIO::ImageLoader::Options options;
+	options.resolution = resolution;
+	options.factors = factors;
+	options.threads = threads;
+	options.capacity = capacity;
+	if (background)
+	{
+		if (background->size() != 3) {
+			AT_ERROR("background must be an RGB triple");
+		}
+		options.composite = true;
+		for (int c = 0; c < 3; c++)
+			options.background[c] = (*background)[c];
+	}
+	return std::make_unique<SplatIO::ImageLoader>(paths, cache_path, options);
+}
+
+std::tuple<int, int, int> imageLevelSize(const SplatIO::ImageLoader& loader, const int image, const int level)
+{
+	const SplatIO::PyramidLevel& desc = loader.level(image, level);
+	return std::make_tuple((int)desc.width, (int)desc.height, (int)desc.channels);
+}
+
+torch::Tensor takeImage(SplatIO::ImageLoader& loader, const int image, const int level)
+{
+	auto* loaded = new SplatIO::LoadedImage(loader.take(image, level));
+	return torch::from_blob(
+		loaded->data.data(),
+		{ loaded->channels, loaded->height, loaded->width },
+		[loaded](void*) { delete loaded; },
+		torch::TensorOptions().dtype(torch::kFloat32));
+}
+
+std::unique_ptr<SplatIO::ImageWriter> createImageWriter(const int threads, const int capacity, const bool fast)
+{
+	SplatIO::ImageWriter::Options options;
+	options.threads = threads;
+	options.capacity = capacity;
+	options.fast = fast;
+	return std::make_unique<SplatIO::ImageWriter>(options);
+}
+
+void submitImage(SplatIO::ImageWriter& writer, const std::string& path, const torch::Tensor& image)
+{
+	if (image.ndimension() != 3 || image.size(0) != 3) {
+		AT_ERROR("image must have dimensions (3, height, width)");
+	}
+	torch::Tensor rgb = image.detach().mul(255.0).add_(0.5).clamp_(0.0, 255.0).to(torch::kUInt8).permute({ 1, 2, 0 }).contiguous().cpu();
+
+	SplatIO::Image8 frame;
+	frame.width = (int)rgb.size(1);
+	frame.height = (int)rgb.size(0);
+	frame.channels = 3;
+	frame.pixels.assign(rgb.data_ptr<uint8_t>(), rgb.data_ptr<uint8_t>() + rgb.numel());
+
+	py::gil_scoped_release release;
+	writer.submit(path, std::move(frame));
+}
+
+std::map<std::string, double> imageWriterStats(const SplatIO::ImageWriter& writer)
+{
+	const SplatIO::ImageWriter::Stats stats = writer.stats();
+	return {
+		{ "images", (double)stats.images },
+		{ "bytes", (double)stats.bytes },
+		{ "encode_ms", stats.encode_ms },
+		{ "wait_ms", stats.wait_ms },
+		{ "wall_ms", stats.wall_ms } };
+}
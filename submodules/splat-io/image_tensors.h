@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "host_io/image_loader.h"
+#include "host_io/image_writer.h"
+
+// Image loader over a pyramid cache, see host_io/image_loader.h. background
+// (RGB in [0, 1]) is blended under RGBA images if given; otherwise they
+// keep their alpha channel.
+std::unique_ptr<SplatIO::ImageLoader> createImageLoader(
+	const std::vector<std::string>& paths,
+	const std::string& cache_path,
+	const int resolution,
+	const std::vector<int>& factors,
+	const std::optional<std::vector<float>>& background,
+	const int threads,
+	const int capacity);
+
+// (width, height, channels) of a level
+std::tuple<int, int, int> imageLevelSize(const SplatIO::ImageLoader& loader, const int image, const int level);
+
+// A level as a (channels, height, width) float tensor in [0, 1]
+torch::Tensor takeImage(SplatIO::ImageLoader& loader, const int image, const int level);
+
+// PNG writer over a pool of encoder threads, see host_io/image_writer.h
+std::unique_ptr<SplatIO::ImageWriter> createImageWriter(const int threads, const int capacity, const bool fast);
+
+// Quantizes a (3, height, width) float image in [0, 1] on its device, as
+// torchvision.utils.save_image rounds it, and queues it for writing.
+// Blocks (without the GIL) while the queue is full.
+void submitImage(SplatIO::ImageWriter& writer, const std::string& path, const torch::Tensor& image);
+
+std::map<std::string, double> imageWriterStats(const SplatIO::ImageWriter& writer);
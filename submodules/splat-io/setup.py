@@ -0,0 +1,43 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use 
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+from setuptools import setup
+from torch.utils.cpp_extension import CppExtension, BuildExtension
+
+setup(
+    name="splat_io",
+    packages=['splat_io'],
+    ext_modules=[
+        CppExtension(
+            name="splat_io._C",
+            sources=[
+            "host_io/splat_file.cpp",
+            "host_io/colmap_reader.cpp",
+            "host_io/image_codec.cpp",
+            "host_io/image_pyramid.cpp",
+            "host_io/image_loader.cpp",
+            "host_io/image_writer.cpp",
+            "host_io/chunk_cache.cpp",
+            "host_io/viewer_server.cpp",
+            "splat_tensors.cpp",
+            "colmap_tensors.cpp",
+            "image_tensors.cpp",
+            "viewer_tensors.cpp",
+            "chunk_tensors.cpp",
+            "ext.cpp"],
+            extra_compile_args={"cxx": ["-O3", "-fopenmp"]},
+            libraries=["png", "jpeg"],
+            extra_link_args=["-fopenmp"])
+        ],
+    cmdclass={
+        'build_ext': BuildExtension
+    }
+)
@@ -0,0 +1,106 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use 
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+from ._C import SplatWriter, ImageLoader, ImageWriter, ViewerServer, ChunkCache, read_splat
+from ._C import read_colmap_cameras as read_colmap_cameras_native
+from ._C import read_colmap_images as read_colmap_images_native
+from ._C import read_colmap_points as read_colmap_points_native
+
+def load_splat(path, prefetch = False):
+    # Map a splat file. Returns (sh_degree, {name: tensor}); the tensors are
+    # CPU tensors backed directly by the file pages (copy-on-write).
+    count, sh_degree, tensors = read_splat(path, prefetch)
+    return sh_degree, tensors
+
+def save_splat(path, sh_degree, attributes, chunk_size = 1 << 20):
+    # Stream a list of (name, tensor) pairs with equal row counts to a splat
+    # file. Rows are transferred chunk_size at a time, so at most one chunk
+    # per attribute is staged in host memory.
+    count = attributes[0][1].shape[0] if attributes else 0
+    writer = SplatWriter(path, count, sh_degree)
+    for name, tensor in attributes:
+        assert tensor.shape[0] == count, "All attributes must have the same number of rows"
+        writer.add_attribute(name, list(tensor.shape[1:]), str(tensor.dtype).replace("torch.", ""))
+    for start in range(0, count, chunk_size):
+        for name, tensor in attributes:
+            writer.write(name, tensor[start:start + chunk_size])
+    writer.close()
+
+def read_colmap_cameras(path):
+    # cameras.bin as numpy arrays: (ids, model_ids, widths, heights, params),
+    # params being a list with the parameters of every camera
+    ids, model_ids, widths, heights, offsets, params = read_colmap_cameras_native(path)
+    params = params.numpy()
+    offsets = offsets.tolist()
+    return ids.numpy(), model_ids.numpy(), widths.numpy(), heights.numpy(), \
+        [params[offsets[i]:offsets[i + 1]] for i in range(len(offsets) - 1)]
+
+def read_colmap_images(path, points2D = False):
+    # images.bin as numpy arrays: (ids, qvecs, tvecs, camera_ids, names,
+    # xys, point3D_ids). The 2D points are only decoded if points2D is set,
+    # xys and point3D_ids are then lists of per-image arrays, else None.
+    ids, qvecs, tvecs, camera_ids, names, offsets, xys, point3D_ids = read_colmap_images_native(path, points2D)
+    if points2D:
+        offsets = offsets.tolist()
+        xys = xys.numpy()
+        point3D_ids = point3D_ids.numpy()
+        xys = [xys[offsets[i]:offsets[i + 1]] for i in range(len(names))]
+        point3D_ids = [point3D_ids[offsets[i]:offsets[i + 1]] for i in range(len(names))]
+    else:
+        xys = point3D_ids = None
+    return ids.numpy(), qvecs.numpy(), tvecs.numpy(), camera_ids.numpy(), names, xys, point3D_ids
+
+def read_colmap_points(path, tracks = False):
+    # points3D.bin as numpy arrays: (ids, xyz, rgb, errors, track_offsets,
+    # tracks); the track of point i is tracks[track_offsets[i]:track_offsets[i + 1]]
+    # as (image id, point2D index) rows. Tracks are only decoded if tracks
+    # is set, otherwise the last two are None.
+    ids, xyz, rgb, errors, track_offsets, track_data = read_colmap_points_native(path, tracks)
+    if tracks:
+        return ids.numpy(), xyz.numpy(), rgb.numpy(), errors.numpy(), track_offsets.numpy(), track_data.numpy()
+    return ids.numpy(), xyz.numpy(), rgb.numpy(), errors.numpy(), None, None
+
+class ImagePyramid:
+    # Images decoded on the loader's worker threads into a pyramid of
+    # downscale factors (1x/2x/4x/8x by default) kept in an on-disk cache,
+    # see host_io/image_loader.h. Levels are addressed by image path and
+    # factor and returned as (C, H, W) float CPU tensors in [0, 1].
+    def __init__(self, paths, cache_path, resolution = -1, factors = (1, 2, 4, 8), background = None, threads = 0, capacity = 8):
+        self.factors = [int(f) for f in factors]
+        self.index = {path: i for i, path in enumerate(paths)}
+        self.loader = ImageLoader(list(paths), cache_path, resolution, self.factors,
+                                  None if background is None else [float(c) for c in background], threads, capacity)
+
+    def prepare(self):
+        # Returns the number of images that had to be decoded
+        return self.loader.prepare()
+
+    def level(self, path, factor):
+        if factor not in self.factors:
+            raise ValueError("No pyramid level for downscale factor {}".format(factor))
+        return self.index[path], self.factors.index(factor)
+
+    def size(self, path, factor):
+        # (width, height, channels) of a level
+        return self.loader.level_size(*self.level(path, factor))
+
+    def submit(self, path, factor):
+        self.loader.submit(*self.level(path, factor))
+
+    def take(self, path, factor):
+        return self.loader.take(*self.level(path, factor))
+
+    def cancel(self, path, factor):
+        # For a submitted level that will not be taken
+        self.loader.cancel(*self.level(path, factor))
+
+    def clear(self):
+        self.loader.clear()
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "splat_tensors.h"
+#include <memory>
+
+torch::ScalarType scalarType(SplatIO::DataType type)
+{
+	switch (type)
+	{
+	case SplatIO::DataType::Float32: return torch::kFloat32;
+	case SplatIO::DataType::Float16: return torch::kFloat16;
+	case SplatIO::DataType::UInt8: return torch::kUInt8;
+	case SplatIO::DataType::Int32: return torch::kInt32;
+	}
+	AT_ERROR("Unknown splat attribute type");
+}
+
+static SplatIO::DataType dataType(const std::string& name)
+{
+	if (name == "float32") return SplatIO::DataType::Float32;
+	if (name == "float16") return SplatIO::DataType::Float16;
+	if (name == "uint8") return SplatIO::DataType::UInt8;
+	if (name == "int32") return SplatIO::DataType::Int32;
+	AT_ERROR("Unsupported splat attribute type ", name);
+}
+
+std::tuple<int64_t, int, std::map<std::string, torch::Tensor>>
+readSplat(const std::string& path, const bool prefetch)
+{
+	SplatIO::SplatReader reader(path);
+	std::shared_ptr<SplatIO::MappedFile> mapping = reader.mapping();
+	if (prefetch)
+		mapping->prefetch(0, mapping->size());
+
+	const int64_t count = reader.count();
+	std::map<std::string, torch::Tensor> tensors;
+	for (const std::string& name : reader.attributeNames())
+	{
+		const SplatIO::AttributeDesc& attribute = *reader.find(name);
+		std::vector<int64_t> sizes = { count };
+		for (uint32_t i = 0; i < attribute.ndim; i++)
+			sizes.push_back(attribute.dims[i]);
+
+		// Every tensor holds a reference to the mapping
+		tensors[name] = torch::from_blob(
+			reader.data(attribute),
+			sizes,
+			[mapping](void*) {},
+			torch::TensorOptions().dtype(scalarType((SplatIO::DataType)attribute.dtype)));
+	}
+	return std::make_tuple(count, (int)reader.shDegree(), tensors);
+}
+
+void addSplatAttribute(
+	SplatIO::SplatWriter& writer,
+	const std::string& name,
+	const std::vector<int64_t>& dims,
+	const std::string& dtype)
+{
+	std::vector<uint32_t> trailing(dims.begin(), dims.end());
+	writer.addAttribute(name, dataType(dtype), trailing);
+}
+
+void writeSplatRows(
+	SplatIO::SplatWriter& writer,
+	const std::string& name,
+	const torch::Tensor& rows)
+{
+	const SplatIO::AttributeDesc& attribute = writer.attribute(name);
+	if (rows.ndimension() != (int64_t)attribute.ndim + 1) {
+		AT_ERROR("Rows of attribute ", name, " must have ", attribute.ndim + 1, " dimensions");
+	}
+	for (uint32_t i = 0; i < attribute.ndim; i++) {
+		if (rows.size(i + 1) != attribute.dims[i]) {
+			AT_ERROR("Rows of attribute ", name, " do not match its declared shape");
+		}
+	}
+	if (rows.scalar_type() != scalarType((SplatIO::DataType)attribute.dtype)) {
+		AT_ERROR("Rows of attribute ", name, " do not match its declared type");
+	}
+
+	torch::Tensor host = rows.detach().to(torch::kCPU).contiguous();
+	writer.write(name, host.data_ptr(), host.size(0));
+}
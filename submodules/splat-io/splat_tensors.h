@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "host_io/splat_file.h"
+
+// Torch type of the columns of a splat attribute type
+torch::ScalarType scalarType(SplatIO::DataType type);
+
+// Maps a splat file and wraps every attribute as a CPU tensor that shares
+// the mapped pages (no copy). The mapping lives as long as any of the
+// returned tensors. Returns (count, sh_degree, tensors by attribute name).
+std::tuple<int64_t, int, std::map<std::string, torch::Tensor>>
+readSplat(const std::string& path, const bool prefetch);
+
+void addSplatAttribute(
+	SplatIO::SplatWriter& writer,
+	const std::string& name,
+	const std::vector<int64_t>& dims,
+	const std::string& dtype);
+
+// Append the rows of a (rows x dims...) tensor to an attribute. Device
+// tensors are copied to the host first, one chunk at a time.
+void writeSplatRows(
+	SplatIO::SplatWriter& writer,
+	const std::string& name,
+	const torch::Tensor& rows);
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+// Loopback client of the viewer server: connects real sockets to a server
+// on a free port and checks the protocol of viewer_server.h, including
+// latest-wins replacement, raw and JPEG frames, replies without a frame,
+// disconnects and stop. Exits with a nonzero status on the first failure.
+
+#include "viewer_server.h"
+#include "image_codec.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using SplatIO::FrameEncoding;
+using SplatIO::ViewerServer;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			std::exit(1); \
+		} \
+	} while (0)
+
+namespace
+{
+	// Blocking calls of the client give up after this, so that a broken
+	// server fails the test instead of hanging it
+	constexpr int TIMEOUT_MS = 5000;
+
+	int connectTo(int port)
+	{
+		const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+		CHECK(fd >= 0);
+		timeval timeout = { TIMEOUT_MS / 1000, 0 };
+		::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		sockaddr_in address;
+		std::memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons((uint16_t)port);
+		::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+		CHECK(::connect(fd, (sockaddr*)&address, sizeof(address)) == 0);
+		return fd;
+	}
+
+	void sendMessage(int fd, const std::string& message)
+	{
+		const uint32_t length = (uint32_t)message.size();
+		CHECK(::send(fd, &length, 4, 0) == 4);
+		CHECK(::send(fd, message.data(), length, 0) == (ssize_t)length);
+	}
+
+	void receive(int fd, void* data, size_t bytes)
+	{
+		char* cursor = (char*)data;
+		while (bytes > 0)
+		{
+			const ssize_t n = ::recv(fd, cursor, bytes, 0);
+			CHECK(n > 0);
+			cursor += n;
+			bytes -= n;
+		}
+	}
+
+	std::vector<uint8_t> receiveBlock(int fd)
+	{
+		uint32_t length = 0;
+		receive(fd, &length, 4);
+		std::vector<uint8_t> block(length);
+		receive(fd, block.data(), length);
+		return block;
+	}
+
+	std::string receiveString(int fd)
+	{
+		const std::vector<uint8_t> block = receiveBlock(fd);
+		return std::string(block.begin(), block.end());
+	}
+
+	// True once the peer closed the connection
+	bool closedByPeer(int fd)
+	{
+		char byte;
+		return ::recv(fd, &byte, 1, 0) == 0;
+	}
+
+	// Waits for the condition on the server's state, which its threads
+	// update asynchronously
+	void waitFor(const std::function<bool()>& condition)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+		while (!condition())
+		{
+			CHECK(std::chrono::steady_clock::now() < deadline);
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+
+	ViewerServer::Request pollOne(ViewerServer& server)
+	{
+		ViewerServer::Request request;
+		CHECK(server.poll(request, TIMEOUT_MS));
+		return request;
+	}
+
+	std::vector<uint8_t> testFrame(int width, int height)
+	{
+		std::vector<uint8_t> rgb((size_t)width * height * 3);
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+			{
+				uint8_t* pixel = rgb.data() + ((size_t)y * width + x) * 3;
+				pixel[0] = (uint8_t)(x * 4);
+				pixel[1] = (uint8_t)(y * 4);
+				pixel[2] = 128;
+			}
+		return rgb;
+	}
+}
+
+int main()
+{
+	ViewerServer::Options options;
+	options.port = 0;
+	ViewerServer server(options);
+	server.start();
+	CHECK(server.port() > 0);
+
+	// Nothing to poll without clients
+	ViewerServer::Request request;
+	CHECK(!server.poll(request, 10));
+
+	// Two clients; the first sends three requests before any is taken
+	const int first = connectTo(server.port());
+	const int second = connectTo(server.port());
+	waitFor([&] { return server.stats().clients == 2; });
+	sendMessage(first, "{\"frame\":1}");
+	sendMessage(first, "{\"frame\":2}");
+	sendMessage(first, "{\"frame\":3}");
+	sendMessage(second, "{\"frame\":4}");
+	waitFor([&] { return server.stats().requests == 4; });
+
+	// Latest wins: one request per client, the newest one
+	const ViewerServer::Request a = pollOne(server);
+	const ViewerServer::Request b = pollOne(server);
+	CHECK(a.client != b.client);
+	CHECK(!server.poll(request, 10));
+	const ViewerServer::Request& from_first = a.message == "{\"frame\":3}" ? a : b;
+	const ViewerServer::Request& from_second = a.message == "{\"frame\":3}" ? b : a;
+	CHECK(from_first.message == "{\"frame\":3}");
+	CHECK(from_second.message == "{\"frame\":4}");
+	CHECK(server.stats().requests_replaced == 2);
+
+	// Raw frames arrive byte for byte, followed by the verify string
+	const int width = 64, height = 48;
+	const std::vector<uint8_t> frame = testFrame(width, height);
+	server.reply(from_first.client, frame.data(), width, height, FrameEncoding::Raw, "raw-verify");
+	std::vector<uint8_t> raw(frame.size());
+	receive(first, raw.data(), raw.size());
+	CHECK(raw == frame);
+	CHECK(receiveString(first) == "raw-verify");
+
+	// JPEG frames are length prefixed and decode to the frame's size
+	server.reply(from_second.client, frame.data(), width, height, FrameEncoding::JPEG, "jpeg-verify");
+	const std::vector<uint8_t> jpeg = receiveBlock(second);
+	CHECK(receiveString(second) == "jpeg-verify");
+	CHECK(jpeg.size() > 2 && jpeg[0] == 0xFF && jpeg[1] == 0xD8);
+	const std::string jpeg_path = "viewer_server_test_" + std::to_string(::getpid()) + ".jpg";
+	FILE* file = std::fopen(jpeg_path.c_str(), "wb");
+	CHECK(file != nullptr);
+	CHECK(std::fwrite(jpeg.data(), 1, jpeg.size(), file) == jpeg.size());
+	std::fclose(file);
+	const SplatIO::Image8 decoded = SplatIO::decodeImage(jpeg_path);
+	std::remove(jpeg_path.c_str());
+	CHECK(decoded.width == width && decoded.height == height && decoded.channels == 3);
+	int worst = 0;
+	for (size_t i = 0; i < frame.size(); i++)
+		worst = std::max(worst, std::abs((int)decoded.pixels[i] - (int)frame[i]));
+	CHECK(worst < 32);
+
+	// A reply without a frame is only the verify string
+	sendMessage(first, "{\"resolution_x\":0}");
+	request = pollOne(server);
+	CHECK(request.client == from_first.client);
+	server.reply(request.client, nullptr, 0, 0, FrameEncoding::Raw, "no-frame");
+	CHECK(receiveString(first) == "no-frame");
+	waitFor([&] { return server.stats().frames == 3; });
+
+	// A disconnected client is removed, and replies to it are dropped
+	::close(second);
+	waitFor([&] { server.poll(request, 10); return server.stats().clients == 1; });
+	server.reply(from_second.client, frame.data(), width, height, FrameEncoding::Raw, "dropped");
+
+	// The remaining client still gets its replies
+	sendMessage(first, "{\"frame\":5}");
+	request = pollOne(server);
+	CHECK(request.message == "{\"frame\":5}");
+	server.reply(request.client, frame.data(), width, height, FrameEncoding::Raw, "after-disconnect");
+	receive(first, raw.data(), raw.size());
+	CHECK(raw == frame);
+	CHECK(receiveString(first) == "after-disconnect");
+	waitFor([&] { return server.stats().frames == 4; });
+
+	// Stop disconnects the clients and joins every thread; a second stop
+	// does nothing
+	server.stop();
+	CHECK(closedByPeer(first));
+	CHECK(server.stats().clients == 0);
+	server.stop();
+	::close(first);
+
+	std::printf("viewer_server_test passed\n");
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "viewer_tensors.h"
+
+std::unique_ptr<SplatIO::ViewerServer> createViewerServer(
+	const std::string& host,
+	const int port,
+	const int max_clients,
+	const int jpeg_quality)
+{
+	SplatIO::ViewerServer::Options options;
+	options.host = host;
+	options.port = port;
+	options.max_clients = max_clients;
+	options.jpeg_quality = jpeg_quality;
+	auto server = std::make_unique<SplatIO::ViewerServer>(options);
+	try
+	{
+		server->start();
+	}
+	catch (const std::runtime_error& e)
+	{
+		AT_ERROR(e.what());
+	}
+	return server;
+}
+
+std::optional<std::tuple<uint64_t, std::string>> pollViewer(SplatIO::ViewerServer& server, const int timeout_ms)
+{
+	SplatIO::ViewerServer::Request request;
+	if (!server.poll(request, timeout_ms))
+		return std::nullopt;
+	return std::make_tuple(request.client, std::move(request.message));
+}
+
+void replyViewer(
+	SplatIO::ViewerServer& server,
+	const uint64_t client,
+	const std::optional<torch::Tensor>& image,
+	const std::string& encoding,
+	const std::string& verify)
+{
+	SplatIO::FrameEncoding frame_encoding;
+	if (encoding == "raw")
+		frame_encoding = SplatIO::FrameEncoding::Raw;
+	else if (encoding == "jpeg")
+		frame_encoding = SplatIO::FrameEncoding::JPEG;
+	else
+		AT_ERROR("Unknown frame encoding ", encoding, " (expected raw or jpeg)");
+
+	if (!image)
+	{
+		server.reply(client, nullptr, 0, 0, frame_encoding, verify);
+		return;
+	}
+	if (image->ndimension() != 3 || image->size(0) != 3) {
+		AT_ERROR("image must have dimensions (3, height, width)");
+	}
+	// Quantized on the image's device, only the 8 bit frame is copied over
+	torch::Tensor rgb = (image->detach().clamp(0.0, 1.0) * 255.0).to(torch::kUInt8).permute({ 1, 2, 0 }).contiguous().cpu();
+	server.reply(client, rgb.data_ptr<uint8_t>(), (int)rgb.size(1), (int)rgb.size(0), frame_encoding, verify);
+}
+
+std::map<std::string, double> viewerStats(const SplatIO::ViewerServer& server)
+{
+	const SplatIO::ViewerServer::Stats stats = server.stats();
+	return {
+		{ "requests", (double)stats.requests },
+		{ "requests_replaced", (double)stats.requests_replaced },
+		{ "frames", (double)stats.frames },
+		{ "frames_replaced", (double)stats.frames_replaced },
+		{ "bytes_sent", (double)stats.bytes_sent },
+		{ "encode_ms", stats.encode_ms },
+		{ "clients", (double)stats.clients } };
+}
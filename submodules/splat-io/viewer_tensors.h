@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#pragma once
+#include <torch/extension.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include "host_io/viewer_server.h"
+
+// Started viewer server, see host_io/viewer_server.h
+std::unique_ptr<SplatIO::ViewerServer> createViewerServer(
+	const std::string& host,
+	const int port,
+	const int max_clients,
+	const int jpeg_quality);
+
+// The next (client, JSON message) request, or None after timeout_ms
+std::optional<std::tuple<uint64_t, std::string>> pollViewer(SplatIO::ViewerServer& server, const int timeout_ms);
+
+// Replies to a request with a rendered (3, height, width) float image in
+// [0, 1] on any device, or without an image if it is None. encoding is
+// "raw" or "jpeg".
+void replyViewer(
+	SplatIO::ViewerServer& server,
+	const uint64_t client,
+	const std::optional<torch::Tensor>& image,
+	const std::string& encoding,
+	const std::string& verify);
+
+std::map<std::string, double> viewerStats(const SplatIO::ViewerServer& server);
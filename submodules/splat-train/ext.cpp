@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <torch/extension.h>
+#include "loss.h"
+#include "store.h"
+#include "optimizer.h"
+
+// Fused (1 - lambda_dssim) L1 + lambda_dssim (1 - SSIM) loss of images
+// (C, H, W) or (N, C, H, W), on the device of the images. Returns the mean
+// L1 and SSIM of every image (N) and, if compute_grad, the gradient of the
+// loss (the mean over the batch) with respect to img1.
+std::tuple<torch::Tensor, torch::Tensor, torch::Tensor>
+FusedL1SSIM(const torch::Tensor& img1, const torch::Tensor& img2, const float lambda_dssim, const bool compute_grad)
+{
+  if ((img1.ndimension() != 3 && img1.ndimension() != 4) || img1.sizes() != img2.sizes()) {
+    AT_ERROR("images must have the same dimensions (C, H, W) or (N, C, H, W)");
+  }
+  if (img1.device() != img2.device()) {
+    AT_ERROR("images must be on the same device");
+  }
+  const torch::Tensor x = (img1.ndimension() == 3 ? img1.unsqueeze(0) : img1).to(torch::kFloat32).contiguous();
+  const torch::Tensor y = (img2.ndimension() == 3 ? img2.unsqueeze(0) : img2).to(torch::kFloat32).contiguous();
+  const int64_t N = x.size(0);
+  const double n = (double)x.numel();
+  const float l1_weight = (float)((1.0 - lambda_dssim) / n);
+  const float ssim_weight = (float)(lambda_dssim / n);
+
+  torch::Tensor partials, grad;
+  if (x.is_cuda())
+  {
+#ifdef WITH_CUDA
+    std::tie(partials, grad) = FusedL1SSIMCUDA(x, y, l1_weight, ssim_weight, compute_grad);
+#else
+    AT_ERROR("splat_train was built without CUDA support");
+#endif
+  }
+  else
+  {
+    std::tie(partials, grad) = FusedL1SSIMCPU(x, y, l1_weight, ssim_weight, compute_grad);
+  }
+
+  // Tiles are summed up in double, in the same order on every call
+  const torch::Tensor sums = partials.to(torch::kFloat64).sum(1).view({N, -1, 2}).sum(1) / (double)(n / N);
+  if (compute_grad)
+    grad = grad.view_as(img1);
+  return std::make_tuple(sums.select(1, 0).to(torch::kFloat32), sums.select(1, 1).to(torch::kFloat32), grad);
+}
+
+// Swap-compaction of the columns of a GaussianStore: removes the rows
+// where remove is set from the first remove.numel() rows of every column,
+// filling the holes below the new size with the kept rows above it.
+// Returns the new number of rows.
+int64_t CompactRows(const std::vector<torch::Tensor>& columns, const torch::Tensor& remove)
+{
+  if (remove.ndimension() != 1 || remove.scalar_type() != torch::kBool) {
+    AT_ERROR("remove must be a boolean mask (num_rows)");
+  }
+  const int64_t size = remove.numel();
+  for (const torch::Tensor& column : columns) {
+    if (!column.is_contiguous() || column.ndimension() == 0 || column.size(0) < size) {
+      AT_ERROR("columns must be contiguous with at least as many rows as remove");
+    }
+    if (column.device() != remove.device()) {
+      AT_ERROR("columns must be on the device of remove");
+    }
+  }
+
+  // Removed rows below the new size are the holes, kept rows above it
+  // are moved into them, in order
+  const torch::Tensor keep = remove.logical_not();
+  const int64_t new_size = keep.sum().item<int64_t>();
+  const torch::Tensor dst = remove.narrow(0, 0, new_size).nonzero().view({-1});
+  const torch::Tensor src = keep.narrow(0, new_size, size - new_size).nonzero().view({-1}) + new_size;
+
+  if (remove.is_cuda())
+  {
+#ifdef WITH_CUDA
+    MoveRowsCUDA(columns, dst, src);
+#else
+    AT_ERROR("splat_train was built without CUDA support");
+#endif
+  }
+  else
+  {
+    MoveRowsCPU(columns, dst, src);
+  }
+  return new_size;
+}
+
+// Sparse Adam step t of one parameter group: updates the given rows of
+// param (rows along the first dimension) and of its moments, see
+// sparse_adam.h. The moments of the rows are first decayed by the steps
+// since last_step, which is left for the caller to update.
+void SparseAdamStep(
+  torch::Tensor& param, const torch::Tensor& grad, torch::Tensor& exp_avg, torch::Tensor& exp_avg_sq,
+  const torch::Tensor& rows, const torch::Tensor& last_step,
+  const int step, const double lr, const double beta1, const double beta2, const double eps)
+{
+  for (const torch::Tensor* t : { &param, &grad, &exp_avg, &exp_avg_sq }) {
+    if (t->scalar_type() != torch::kFloat32 || !t->is_contiguous() || t->sizes() != param.sizes()) {
+      AT_ERROR("param, grad and moments must be contiguous float tensors of the same size");
+    }
+    if (t->device() != param.device()) {
+      AT_ERROR("param, grad and moments must be on the same device");
+    }
+  }
+  if (rows.ndimension() != 1 || rows.scalar_type() != torch::kInt64 || rows.device() != param.device()) {
+    AT_ERROR("rows must be a list (num_rows) of int64 indices on the device of param");
+  }
+  if (last_step.ndimension() != 1 || last_step.scalar_type() != torch::kInt32 || !last_step.is_contiguous()
+    || last_step.device() != param.device() || param.ndimension() == 0 || last_step.size(0) < param.size(0)) {
+    AT_ERROR("last_step must be an int32 tensor with an entry per row of param");
+  }
+  if (step < 1) {
+    AT_ERROR("step counts from 1");
+  }
+  if (param.numel() == 0 || rows.numel() == 0)
+    return;
+
+  AdamStep s;
+  s.step = step;
+  s.beta1 = (float)beta1;
+  s.beta2 = (float)beta2;
+  s.eps = (float)eps;
+  s.step_size = (float)(lr / (1.0 - std::pow(beta1, step)));
+  s.bias_correction2_sqrt = (float)std::sqrt(1.0 - std::pow(beta2, step));
+
+  const torch::Tensor r = rows.contiguous();
+  if (param.is_cuda())
+  {
+#ifdef WITH_CUDA
+    SparseAdamStepCUDA(param, grad, exp_avg, exp_avg_sq, r, last_step, s);
+#else
+    AT_ERROR("splat_train was built without CUDA support");
+#endif
+  }
+  else
+  {
+    SparseAdamStepCPU(param, grad, exp_avg, exp_avg_sq, r, last_step, s);
+  }
+}
+
+// Morton codes (int32) of points (P, 3) within their bounding box, for
+// reordering Gaussians by position
+torch::Tensor ComputeMortonCodes(const torch::Tensor& points)
+{
+  if (points.ndimension() != 2 || points.size(1) != 3) {
+    AT_ERROR("points must have dimensions (num_points, 3)");
+  }
+  const torch::Tensor p = points.to(torch::kFloat32).contiguous();
+  if (p.size(0) == 0)
+    return torch::empty({0}, p.options().dtype(torch::kInt32));
+
+  MortonBox box;
+  const torch::Tensor minn = std::get<0>(p.min(0)).cpu(), maxx = std::get<0>(p.max(0)).cpu();
+  for (int k = 0; k < 3; k++) {
+    box.minn[k] = minn[k].item<float>();
+    box.maxx[k] = maxx[k].item<float>();
+  }
+
+  if (p.is_cuda())
+  {
+#ifdef WITH_CUDA
+    return MortonCodesCUDA(p, box);
+#else
+    AT_ERROR("splat_train was built without CUDA support");
+#endif
+  }
+  return MortonCodesCPU(p, box);
+}
+
+PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
+  m.def("fused_l1_ssim", &FusedL1SSIM, pybind11::arg("img1"), pybind11::arg("img2"), pybind11::arg("lambda_dssim"), pybind11::arg("compute_grad"));
+  m.def("compact_rows", &CompactRows, pybind11::arg("columns"), pybind11::arg("remove"));
+  m.def("morton_codes", &ComputeMortonCodes, pybind11::arg("points"));
+  m.def("sparse_adam_step", &SparseAdamStep, pybind11::arg("param"), pybind11::arg("grad"), pybind11::arg("exp_avg"), pybind11::arg("exp_avg_sq"),
+    pybind11::arg("rows"), pybind11::arg("last_step"), pybind11::arg("step"), pybind11::arg("lr"), pybind11::arg("beta1"), pybind11::arg("beta2"), pybind11::arg("eps"));
+}
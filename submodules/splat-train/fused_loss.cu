@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "fused_loss.h"
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+// Every block handles a LOSS_BLOCK x LOSS_BLOCK tile of one plane. The
+// tile and its halo are staged in shared memory, blurred horizontally and
+// then vertically, so each input value is read from global memory once.
+#define LOSS_BLOCK 16
+#define LOSS_HALO (LOSS_BLOCK + 2 * SSIM_RADIUS)
+#define LOSS_THREADS (LOSS_BLOCK * LOSS_BLOCK)
+
+namespace
+{
+	// Sums values over the block into values[0]
+	__device__ void blockSum(float* values, int tid)
+	{
+		for (int stride = LOSS_THREADS / 2; stride > 0; stride >>= 1)
+		{
+			if (tid < stride)
+				values[tid] += values[tid + stride];
+			__syncthreads();
+		}
+	}
+
+	template<bool GRAD>
+	__global__ void l1ssimCUDA(
+		int H, int W,
+		const float* __restrict__ x,
+		const float* __restrict__ y,
+		const SSIMWindow window,
+		float* __restrict__ partials,
+		float* __restrict__ scratch)
+	{
+		__shared__ float s_x[LOSS_HALO][LOSS_HALO];
+		__shared__ float s_y[LOSS_HALO][LOSS_HALO];
+		__shared__ float s_rows[5][LOSS_HALO][LOSS_BLOCK];
+		__shared__ float s_sum[2][LOSS_THREADS];
+
+		const size_t HW = (size_t)H * W;
+		const int p = blockIdx.z;
+		const int tid = threadIdx.y * LOSS_BLOCK + threadIdx.x;
+		const int row0 = blockIdx.y * LOSS_BLOCK - SSIM_RADIUS;
+		const int col0 = blockIdx.x * LOSS_BLOCK - SSIM_RADIUS;
+		const float* xp = x + p * HW;
+		const float* yp = y + p * HW;
+
+		for (int i = tid; i < LOSS_HALO * LOSS_HALO; i += LOSS_THREADS)
+		{
+			const int r = i / LOSS_HALO, c = i % LOSS_HALO;
+			const int gr = row0 + r, gc = col0 + c;
+			const bool inside = gr >= 0 && gr < H && gc >= 0 && gc < W;
+			s_x[r][c] = inside ? xp[gr * (size_t)W + gc] : 0.0f;
+			s_y[r][c] = inside ? yp[gr * (size_t)W + gc] : 0.0f;
+		}
+		__syncthreads();
+
+		for (int i = tid; i < LOSS_HALO * LOSS_BLOCK; i += LOSS_THREADS)
+		{
+			const int r = i / LOSS_BLOCK, c = i % LOSS_BLOCK;
+			float m[5] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int k = 0; k < SSIM_WINDOW; k++)
+			{
+				const float w = window.w[k];
+				const float a = s_x[r][c + k], b = s_y[r][c + k];
+				m[0] += w * a;
+				m[1] += w * b;
+				m[2] += w * a * a;
+				m[3] += w * b * b;
+				m[4] += w * a * b;
+			}
+			for (int j = 0; j < 5; j++)
+				s_rows[j][r][c] = m[j];
+		}
+		__syncthreads();
+
+		const int r = threadIdx.y, c = threadIdx.x;
+		float m[5] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int k = 0; k < SSIM_WINDOW; k++)
+			for (int j = 0; j < 5; j++)
+				m[j] += window.w[k] * s_rows[j][r + k][c];
+
+		const int gr = row0 + SSIM_RADIUS + r, gc = col0 + SSIM_RADIUS + c;
+		float l1 = 0.0f, ssim = 0.0f;
+		if (gr < H && gc < W)
+		{
+			float d_mu, d_xx, d_xy;
+			ssim = ssimPixel(m[0], m[1], m[2], m[3], m[4], d_mu, d_xx, d_xy);
+			l1 = fabsf(s_x[r + SSIM_RADIUS][c + SSIM_RADIUS] - s_y[r + SSIM_RADIUS][c + SSIM_RADIUS]);
+			if (GRAD)
+			{
+				float* g = scratch + 3 * p * HW + gr * (size_t)W + gc;
+				g[0] = d_mu;
+				g[HW] = d_xx;
+				g[2 * HW] = d_xy;
+			}
+		}
+
+		s_sum[0][tid] = l1;
+		s_sum[1][tid] = ssim;
+		__syncthreads();
+		blockSum(s_sum[0], tid);
+		blockSum(s_sum[1], tid);
+		if (tid == 0)
+		{
+			const size_t tile = ((size_t)p * gridDim.y + blockIdx.y) * gridDim.x + blockIdx.x;
+			partials[2 * tile] = s_sum[0][0];
+			partials[2 * tile + 1] = s_sum[1][0];
+		}
+	}
+
+	// Blurs the partial derivatives of SSIM back onto the pixels
+	__global__ void l1ssimGradCUDA(
+		int H, int W,
+		const float* __restrict__ x,
+		const float* __restrict__ y,
+		const SSIMWindow window,
+		float l1_weight, float ssim_weight,
+		const float* __restrict__ scratch,
+		float* __restrict__ dx)
+	{
+		__shared__ float s_g[3][LOSS_HALO][LOSS_HALO];
+		__shared__ float s_rows[3][LOSS_HALO][LOSS_BLOCK];
+
+		const size_t HW = (size_t)H * W;
+		const int p = blockIdx.z;
+		const int tid = threadIdx.y * LOSS_BLOCK + threadIdx.x;
+		const int row0 = blockIdx.y * LOSS_BLOCK - SSIM_RADIUS;
+		const int col0 = blockIdx.x * LOSS_BLOCK - SSIM_RADIUS;
+		const float* g = scratch + 3 * p * HW;
+
+		for (int i = tid; i < LOSS_HALO * LOSS_HALO; i += LOSS_THREADS)
+		{
+			const int r = i / LOSS_HALO, c = i % LOSS_HALO;
+			const int gr = row0 + r, gc = col0 + c;
+			const bool inside = gr >= 0 && gr < H && gc >= 0 && gc < W;
+			for (int j = 0; j < 3; j++)
+				s_g[j][r][c] = inside ? g[j * HW + gr * (size_t)W + gc] : 0.0f;
+		}
+		__syncthreads();
+
+		for (int i = tid; i < LOSS_HALO * LOSS_BLOCK; i += LOSS_THREADS)
+		{
+			const int r = i / LOSS_BLOCK, c = i % LOSS_BLOCK;
+			for (int j = 0; j < 3; j++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < SSIM_WINDOW; k++)
+					sum += window.w[k] * s_g[j][r][c + k];
+				s_rows[j][r][c] = sum;
+			}
+		}
+		__syncthreads();
+
+		const int r = threadIdx.y, c = threadIdx.x;
+		const int gr = row0 + SSIM_RADIUS + r, gc = col0 + SSIM_RADIUS + c;
+		if (gr >= H || gc >= W)
+			return;
+
+		float b[3] = { 0.0f, 0.0f, 0.0f };
+		for (int k = 0; k < SSIM_WINDOW; k++)
+			for (int j = 0; j < 3; j++)
+				b[j] += window.w[k] * s_rows[j][r + k][c];
+
+		const size_t idx = p * HW + gr * (size_t)W + gc;
+		const float xv = x[idx], yv = y[idx];
+		const float sign = (float)(xv > yv) - (float)(xv < yv);
+		dx[idx] = l1_weight * sign - ssim_weight * (b[0] + 2.0f * xv * b[1] + yv * b[2]);
+	}
+}
+
+int FusedLoss::numTiles(int H, int W)
+{
+	return ((H + LOSS_BLOCK - 1) / LOSS_BLOCK) * ((W + LOSS_BLOCK - 1) / LOSS_BLOCK);
+}
+
+void FusedLoss::l1ssim(
+	int planes, int H, int W,
+	const float* x,
+	const float* y,
+	float l1_weight, float ssim_weight,
+	float* partials,
+	float* dx,
+	float* scratch)
+{
+	if (planes == 0 || H == 0 || W == 0)
+		return;
+
+	const SSIMWindow window = SSIMWindow::gaussian();
+	const dim3 grid((W + LOSS_BLOCK - 1) / LOSS_BLOCK, (H + LOSS_BLOCK - 1) / LOSS_BLOCK, planes);
+	const dim3 block(LOSS_BLOCK, LOSS_BLOCK, 1);
+	if (dx)
+	{
+		l1ssimCUDA<true> << <grid, block >> > (H, W, x, y, window, partials, scratch);
+		l1ssimGradCUDA << <grid, block >> > (H, W, x, y, window, l1_weight, ssim_weight, scratch, dx);
+	}
+	else
+	{
+		l1ssimCUDA<false> << <grid, block >> > (H, W, x, y, window, partials, nullptr);
+	}
+}
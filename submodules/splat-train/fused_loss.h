@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef FUSED_LOSS_H_INCLUDED
+#define FUSED_LOSS_H_INCLUDED
+
+#include <cmath>
+
+#ifdef __CUDACC__
+#define LOSS_FUNC __host__ __device__
+#else
+#define LOSS_FUNC
+#endif
+
+// SSIM of utils/loss_utils.py: 11 x 11 Gaussian window with sigma 1.5,
+// zero padding, constants for images in [0, 1]
+#define SSIM_WINDOW 11
+#define SSIM_RADIUS 5
+#define SSIM_SIGMA 1.5
+#define SSIM_C1 (0.01f * 0.01f)
+#define SSIM_C2 (0.03f * 0.03f)
+
+// Normalized 1D window, the 2D window is its outer product
+struct SSIMWindow
+{
+	float w[SSIM_WINDOW];
+
+	static SSIMWindow gaussian()
+	{
+		SSIMWindow window;
+		double g[SSIM_WINDOW], sum = 0.0;
+		for (int k = 0; k < SSIM_WINDOW; k++)
+		{
+			const double x = k - SSIM_RADIUS;
+			g[k] = std::exp(-x * x / (2.0 * SSIM_SIGMA * SSIM_SIGMA));
+			sum += g[k];
+		}
+		for (int k = 0; k < SSIM_WINDOW; k++)
+			window.w[k] = (float)(g[k] / sum);
+		return window;
+	}
+};
+
+// SSIM of one pixel from the blurred x, y, x^2, y^2 and x*y. Also returns
+// its partial derivatives with respect to the blurred x, x^2 and x*y,
+// from which the gradient with respect to x is
+//   blur(d_mu) + 2 x blur(d_xx) + y blur(d_xy).
+LOSS_FUNC inline float ssimPixel(
+	float mu_x, float mu_y, float e_xx, float e_yy, float e_xy,
+	float& d_mu, float& d_xx, float& d_xy)
+{
+	const float sigma_xx = e_xx - mu_x * mu_x;
+	const float sigma_yy = e_yy - mu_y * mu_y;
+	const float sigma_xy = e_xy - mu_x * mu_y;
+
+	const float a1 = 2.0f * mu_x * mu_y + SSIM_C1;
+	const float a2 = 2.0f * sigma_xy + SSIM_C2;
+	const float b1 = mu_x * mu_x + mu_y * mu_y + SSIM_C1;
+	const float b2 = sigma_xx + sigma_yy + SSIM_C2;
+	const float inv_b = 1.0f / (b1 * b2);
+	const float s = a1 * a2 * inv_b;
+
+	d_xx = -s / b2;
+	d_xy = 2.0f * a1 * inv_b;
+	d_mu = 2.0f * mu_y * (a2 - a1) * inv_b + 2.0f * mu_x * (s / b2 - s / b1);
+	return s;
+}
+
+// Combined (1 - lambda) L1 + lambda (1 - SSIM) loss of images x and y in
+// one pass. Both hold planes (images times channels) of H x W floats.
+// Per tile of every plane, partials receives the sum of |x - y| and the
+// sum of SSIM (planes x numTiles(H, W) x 2). If dx is not null, it
+// receives
+//   l1_weight * sign(x - y) - ssim_weight * d(sum of SSIM)/dx
+// and scratch must hold 3 x planes x H x W floats. For the mean loss over
+// n values, l1_weight = (1 - lambda) / n and ssim_weight = lambda / n.
+// FusedLoss works on device memory, FusedLossCpu on host memory.
+class FusedLoss
+{
+public:
+	static int numTiles(int H, int W);
+
+	static void l1ssim(
+		int planes, int H, int W,
+		const float* x,
+		const float* y,
+		float l1_weight, float ssim_weight,
+		float* partials,
+		float* dx,
+		float* scratch);
+};
+
+class FusedLossCpu
+{
+public:
+	static int numTiles(int H, int W);
+
+	static void l1ssim(
+		int planes, int H, int W,
+		const float* x,
+		const float* y,
+		float l1_weight, float ssim_weight,
+		float* partials,
+		float* dx,
+		float* scratch);
+};
+
+#endif
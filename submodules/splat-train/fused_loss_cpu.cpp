@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "fused_loss.h"
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+namespace
+{
+	// Rows of a plane handled by one task. The separable filter blurs the
+	// BAND_ROWS + 2 * SSIM_RADIUS rows it needs horizontally into a band
+	// buffer, which then stays in cache for the vertical pass.
+	constexpr int BAND_ROWS = 32;
+
+	// Band buffers of one thread. Rows hold W values, padded rows have
+	// SSIM_RADIUS zeros on either side.
+	struct Band
+	{
+		int W;
+		std::vector<float> padded;	// 5 padded rows
+		std::vector<float> rows;	// 5 maps x (BAND_ROWS + 2 SSIM_RADIUS) rows
+		std::vector<float> blurred;	// 5 rows
+
+		explicit Band(int W_) : W(W_),
+			padded(5 * (size_t)(W_ + 2 * SSIM_RADIUS), 0.0f),
+			rows(5 * (size_t)(BAND_ROWS + 2 * SSIM_RADIUS) * W_),
+			blurred(5 * (size_t)W_)
+		{}
+
+		float* pad(int m) { return padded.data() + m * (size_t)(W + 2 * SSIM_RADIUS) + SSIM_RADIUS; }
+		float* row(int m, int r) { return rows.data() + ((size_t)m * (BAND_ROWS + 2 * SSIM_RADIUS) + r) * W; }
+		float* blur(int m) { return blurred.data() + (size_t)m * W; }
+
+		// Horizontal pass of padded row m into band row r
+		void blurRow(int m, int r, const SSIMWindow& window)
+		{
+			const float* in = pad(m) - SSIM_RADIUS;
+			float* out = row(m, r);
+			for (int c = 0; c < W; c++)
+				out[c] = 0.0f;
+			for (int k = 0; k < SSIM_WINDOW; k++)
+			{
+				const float w = window.w[k];
+				for (int c = 0; c < W; c++)
+					out[c] += w * in[c + k];
+			}
+		}
+
+		// Vertical pass over the band rows r, ..., r + SSIM_WINDOW - 1
+		void blurColumns(int maps, int r, const SSIMWindow& window)
+		{
+			for (int m = 0; m < maps; m++)
+			{
+				float* out = blur(m);
+				for (int c = 0; c < W; c++)
+					out[c] = 0.0f;
+				for (int k = 0; k < SSIM_WINDOW; k++)
+				{
+					const float w = window.w[k];
+					const float* in = row(m, r + k);
+					for (int c = 0; c < W; c++)
+						out[c] += w * in[c];
+				}
+			}
+		}
+	};
+
+	// Horizontally blurs maps rows of the band starting at row r0 - SSIM_RADIUS,
+	// load(i, Band&) fills the padded rows with the maps of image row i
+	template<typename Load>
+	void blurBand(Band& band, int maps, int r0, int r1, int H, const SSIMWindow& window, Load load)
+	{
+		for (int i = r0 - SSIM_RADIUS; i < r1 + SSIM_RADIUS; i++)
+		{
+			const int r = i - (r0 - SSIM_RADIUS);
+			if (i < 0 || i >= H)
+			{
+				for (int m = 0; m < maps; m++)
+					std::fill(band.row(m, r), band.row(m, r) + band.W, 0.0f);
+				continue;
+			}
+			load(i, band);
+			for (int m = 0; m < maps; m++)
+				band.blurRow(m, r, window);
+		}
+	}
+}
+
+int FusedLossCpu::numTiles(int H, int)
+{
+	return (H + BAND_ROWS - 1) / BAND_ROWS;
+}
+
+void FusedLossCpu::l1ssim(
+	int planes, int H, int W,
+	const float* x,
+	const float* y,
+	float l1_weight, float ssim_weight,
+	float* partials,
+	float* dx,
+	float* scratch)
+{
+	const int bands = numTiles(H, W);
+	const int tasks = planes * bands;
+	const size_t HW = (size_t)H * W;
+	const SSIMWindow window = SSIMWindow::gaussian();
+
+	#pragma omp parallel
+	{
+		Band band(W);
+
+		// Blur x, y, x^2, y^2 and x*y, sum up both losses and keep the
+		// partial derivatives of SSIM for the gradient
+		#pragma omp for schedule(dynamic)
+		for (int t = 0; t < tasks; t++)
+		{
+			const int p = t / bands;
+			const int r0 = (t % bands) * BAND_ROWS;
+			const int r1 = std::min(r0 + BAND_ROWS, H);
+			const float* xp = x + p * HW;
+			const float* yp = y + p * HW;
+
+			blurBand(band, 5, r0, r1, H, window, [&](int i, Band& b) {
+				const float* xr = xp + i * (size_t)W;
+				const float* yr = yp + i * (size_t)W;
+				float* px = b.pad(0);
+				float* py = b.pad(1);
+				float* pxx = b.pad(2);
+				float* pyy = b.pad(3);
+				float* pxy = b.pad(4);
+				for (int c = 0; c < W; c++)
+				{
+					px[c] = xr[c];
+					py[c] = yr[c];
+					pxx[c] = xr[c] * xr[c];
+					pyy[c] = yr[c] * yr[c];
+					pxy[c] = xr[c] * yr[c];
+				}
+			});
+
+			double l1_sum = 0.0, ssim_sum = 0.0;
+			for (int r = r0; r < r1; r++)
+			{
+				band.blurColumns(5, r - r0, window);
+				const float* mu_x = band.blur(0);
+				const float* mu_y = band.blur(1);
+				const float* e_xx = band.blur(2);
+				const float* e_yy = band.blur(3);
+				const float* e_xy = band.blur(4);
+				const size_t row = r * (size_t)W;
+				float* d_mu = dx ? scratch + 3 * p * HW + row : nullptr;
+
+				float l1_row = 0.0f, ssim_row = 0.0f;
+				for (int c = 0; c < W; c++)
+				{
+					float g_mu, g_xx, g_xy;
+					ssim_row += ssimPixel(mu_x[c], mu_y[c], e_xx[c], e_yy[c], e_xy[c], g_mu, g_xx, g_xy);
+					l1_row += std::abs(xp[row + c] - yp[row + c]);
+					if (dx)
+					{
+						d_mu[c] = g_mu;
+						d_mu[HW + c] = g_xx;
+						d_mu[2 * HW + c] = g_xy;
+					}
+				}
+				l1_sum += l1_row;
+				ssim_sum += ssim_row;
+			}
+			partials[2 * (size_t)t] = (float)l1_sum;
+			partials[2 * (size_t)t + 1] = (float)ssim_sum;
+		}
+
+		if (dx)
+		{
+			// Gradient: blur the partial derivatives back onto the pixels
+			#pragma omp for schedule(dynamic)
+			for (int t = 0; t < tasks; t++)
+			{
+				const int p = t / bands;
+				const int r0 = (t % bands) * BAND_ROWS;
+				const int r1 = std::min(r0 + BAND_ROWS, H);
+				const float* xp = x + p * HW;
+				const float* yp = y + p * HW;
+				const float* g = scratch + 3 * p * HW;
+
+				blurBand(band, 3, r0, r1, H, window, [&](int i, Band& b) {
+					for (int m = 0; m < 3; m++)
+						std::copy(g + m * HW + i * (size_t)W, g + m * HW + (i + 1) * (size_t)W, b.pad(m));
+				});
+
+				for (int r = r0; r < r1; r++)
+				{
+					band.blurColumns(3, r - r0, window);
+					const float* b_mu = band.blur(0);
+					const float* b_xx = band.blur(1);
+					const float* b_xy = band.blur(2);
+					const size_t row = r * (size_t)W;
+					float* out = dx + p * HW + row;
+					for (int c = 0; c < W; c++)
+					{
+						const float xv = xp[row + c], yv = yp[row + c];
+						const float sign = (float)(xv > yv) - (float)(xv < yv);
+						const float d_ssim = b_mu[c] + 2.0f * xv * b_xx[c] + yv * b_xy[c];
+						out[c] = l1_weight * sign - ssim_weight * d_ssim;
+					}
+				}
+			}
+		}
+	}
+}
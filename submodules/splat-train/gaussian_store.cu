@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "gaussian_store.h"
+#include <algorithm>
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#define STORE_THREADS 256
+#define STORE_MAX_BLOCKS 4096
+
+namespace
+{
+	template<typename T>
+	__device__ void moveUnits(T* data, int64_t row_units, int64_t count, const int64_t* dst, const int64_t* src)
+	{
+		const int64_t total = count * row_units;
+		for (int64_t i = blockIdx.x * (int64_t)blockDim.x + threadIdx.x; i < total; i += (int64_t)gridDim.x * blockDim.x)
+		{
+			const int64_t row = i / row_units;
+			const int64_t k = i - row * row_units;
+			data[dst[row] * row_units + k] = data[src[row] * row_units + k];
+		}
+	}
+
+	// One column per blockIdx.y, consecutive threads move consecutive
+	// words of a row
+	__global__ void moveRowsCUDA(
+		const StoreColumn* __restrict__ columns,
+		int64_t count,
+		const int64_t* __restrict__ dst,
+		const int64_t* __restrict__ src)
+	{
+		const StoreColumn column = columns[blockIdx.y];
+		if (column.row_bytes % 4 == 0)
+			moveUnits((uint32_t*)column.data, column.row_bytes / 4, count, dst, src);
+		else
+			moveUnits((uint8_t*)column.data, column.row_bytes, count, dst, src);
+	}
+}
+
+void StoreCompaction::moveRows(
+	int num_columns,
+	const StoreColumn* columns,
+	int64_t count,
+	const int64_t* dst,
+	const int64_t* src,
+	StoreColumn* scratch)
+{
+	if (num_columns == 0 || count == 0)
+		return;
+
+	int64_t max_row_bytes = 0;
+	for (int c = 0; c < num_columns; c++)
+		max_row_bytes = std::max(max_row_bytes, columns[c].row_bytes);
+
+	cudaMemcpy(scratch, columns, num_columns * sizeof(StoreColumn), cudaMemcpyHostToDevice);
+	const int64_t blocks = std::min<int64_t>((count * max_row_bytes / 4 + STORE_THREADS - 1) / STORE_THREADS + 1, STORE_MAX_BLOCKS);
+	moveRowsCUDA << <dim3((unsigned)blocks, num_columns, 1), STORE_THREADS >> > (scratch, count, dst, src);
+}
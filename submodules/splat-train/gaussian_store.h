@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef GAUSSIAN_STORE_H_INCLUDED
+#define GAUSSIAN_STORE_H_INCLUDED
+
+#include <cstdint>
+
+// One column of splat_train.GaussianStore: rows of row_bytes bytes each,
+// stored back to back.
+struct StoreColumn
+{
+	char* data;
+	int64_t row_bytes;
+};
+
+// Row moves of the swap-compaction: row src[i] of every column is copied
+// to row dst[i], for i < count. Destinations are removed rows below the
+// new size and sources kept rows above it, so no row is both and all
+// moves are independent. columns is always in host memory.
+// StoreCompaction works on device memory and needs a device scratch of
+// num_columns StoreColumns, StoreCompactionCpu works on host memory.
+class StoreCompaction
+{
+public:
+	static void moveRows(
+		int num_columns,
+		const StoreColumn* columns,
+		int64_t count,
+		const int64_t* dst,
+		const int64_t* src,
+		StoreColumn* scratch);
+};
+
+class StoreCompactionCpu
+{
+public:
+	static void moveRows(
+		int num_columns,
+		const StoreColumn* columns,
+		int64_t count,
+		const int64_t* dst,
+		const int64_t* src);
+};
+
+#endif
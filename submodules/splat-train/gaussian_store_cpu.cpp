@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "gaussian_store.h"
+#include <cstring>
+#include <omp.h>
+
+void StoreCompactionCpu::moveRows(
+	int num_columns,
+	const StoreColumn* columns,
+	int64_t count,
+	const int64_t* dst,
+	const int64_t* src)
+{
+	// All columns of a row are moved by the same thread
+	#pragma omp parallel for schedule(static, 64)
+	for (int64_t i = 0; i < count; i++)
+	{
+		for (int c = 0; c < num_columns; c++)
+		{
+			const int64_t row_bytes = columns[c].row_bytes;
+			std::memcpy(columns[c].data + dst[i] * row_bytes, columns[c].data + src[i] * row_bytes, row_bytes);
+		}
+	}
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <torch/extension.h>
+
+// Fused (1 - lambda) L1 + lambda (1 - SSIM) loss of contiguous float
+// images x and y (N, C, H, W), see fused_loss.h. Returns the partial sums
+// (N * C, tiles, 2) of |x - y| and SSIM and, if compute_grad, the gradient
+// of the loss with respect to x (otherwise an empty tensor).
+std::tuple<torch::Tensor, torch::Tensor>
+FusedL1SSIMCUDA(const torch::Tensor& x, const torch::Tensor& y, const float l1_weight, const float ssim_weight, const bool compute_grad);
+
+std::tuple<torch::Tensor, torch::Tensor>
+FusedL1SSIMCPU(const torch::Tensor& x, const torch::Tensor& y, const float l1_weight, const float ssim_weight, const bool compute_grad);
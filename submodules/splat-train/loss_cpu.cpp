@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "loss.h"
+#include "fused_loss.h"
+
+std::tuple<torch::Tensor, torch::Tensor>
+FusedL1SSIMCPU(const torch::Tensor& x, const torch::Tensor& y, const float l1_weight, const float ssim_weight, const bool compute_grad)
+{
+  const int planes = x.size(0) * x.size(1);
+  const int H = x.size(2);
+  const int W = x.size(3);
+
+  auto float_opts = x.options().dtype(torch::kFloat32);
+  torch::Tensor partials = torch::zeros({planes, FusedLossCpu::numTiles(H, W), 2}, float_opts);
+  torch::Tensor grad = torch::empty({compute_grad ? x.numel() : 0}, float_opts);
+  torch::Tensor scratch = torch::empty({compute_grad ? 3 * x.numel() : 0}, float_opts);
+
+  FusedLossCpu::l1ssim(planes, H, W, x.data_ptr<float>(), y.data_ptr<float>(),
+    l1_weight, ssim_weight, partials.data_ptr<float>(),
+    compute_grad ? grad.data_ptr<float>() : nullptr,
+    compute_grad ? scratch.data_ptr<float>() : nullptr);
+
+  if (compute_grad)
+    grad = grad.view_as(x);
+  return std::make_tuple(partials, grad);
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "morton.h"
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+namespace
+{
+	__global__ void mortonCodesCUDA(int64_t P, const float* __restrict__ points, const MortonBox box, int32_t* __restrict__ codes)
+	{
+		const int64_t i = blockIdx.x * (int64_t)blockDim.x + threadIdx.x;
+		if (i >= P)
+			return;
+		codes[i] = (int32_t)coord2Morton(points + 3 * i, box);
+	}
+}
+
+void MortonCodes::compute(int64_t P, const float* points, const MortonBox& box, int32_t* codes)
+{
+	if (P == 0)
+		return;
+	mortonCodesCUDA << <(unsigned)((P + 255) / 256), 256 >> > (P, points, box, codes);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef MORTON_H_INCLUDED
+#define MORTON_H_INCLUDED
+
+#include <cstdint>
+
+#ifdef __CUDACC__
+#define MORTON_FUNC __host__ __device__
+#else
+#define MORTON_FUNC
+#endif
+
+// Morton (Z-order) codes of 3D points, as simple_knn's coord2Morton
+// computed them: 10 bits per axis of the position within the bounding
+// box, interleaved into 30 bits. Sorting by code puts points that are
+// close in space close in memory.
+struct MortonBox
+{
+	float minn[3];
+	float maxx[3];
+};
+
+MORTON_FUNC inline uint32_t prepMorton(uint32_t x)
+{
+	x = (x | (x << 16)) & 0x030000FF;
+	x = (x | (x << 8)) & 0x0300F00F;
+	x = (x | (x << 4)) & 0x030C30C3;
+	x = (x | (x << 2)) & 0x09249249;
+	return x;
+}
+
+MORTON_FUNC inline uint32_t coord2Morton(const float* coord, const MortonBox& box)
+{
+	uint32_t bits[3];
+	for (int k = 0; k < 3; k++)
+	{
+		// Flat extents map to cell 0, positions are clamped to the box
+		const float extent = box.maxx[k] - box.minn[k];
+		float t = extent > 0.0f ? (coord[k] - box.minn[k]) / extent : 0.0f;
+		t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+		bits[k] = prepMorton((uint32_t)(t * ((1 << 10) - 1)));
+	}
+	return bits[0] | (bits[1] << 1) | (bits[2] << 2);
+}
+
+// Codes of P points (x, y, z). MortonCodes works on device memory,
+// MortonCodesCpu on host memory.
+class MortonCodes
+{
+public:
+	static void compute(int64_t P, const float* points, const MortonBox& box, int32_t* codes);
+};
+
+class MortonCodesCpu
+{
+public:
+	static void compute(int64_t P, const float* points, const MortonBox& box, int32_t* codes);
+};
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "morton.h"
+#include <omp.h>
+
+void MortonCodesCpu::compute(int64_t P, const float* points, const MortonBox& box, int32_t* codes)
+{
+	#pragma omp parallel for schedule(static, 1024)
+	for (int64_t i = 0; i < P; i++)
+		codes[i] = (int32_t)coord2Morton(points + 3 * i, box);
+}
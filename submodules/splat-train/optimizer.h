@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <torch/extension.h>
+#include "sparse_adam.h"
+
+// Adam step s over the rows (int64) of a contiguous float parameter with
+// its gradient and moments, see sparse_adam.h. last_step (int32) holds
+// the step of the last update of every row.
+void SparseAdamStepCUDA(torch::Tensor& param, const torch::Tensor& grad, torch::Tensor& exp_avg, torch::Tensor& exp_avg_sq,
+  const torch::Tensor& rows, const torch::Tensor& last_step, const AdamStep& s);
+
+void SparseAdamStepCPU(torch::Tensor& param, const torch::Tensor& grad, torch::Tensor& exp_avg, torch::Tensor& exp_avg_sq,
+  const torch::Tensor& rows, const torch::Tensor& last_step, const AdamStep& s);
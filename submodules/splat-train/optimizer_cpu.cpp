@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "optimizer.h"
+
+void SparseAdamStepCPU(torch::Tensor& param, const torch::Tensor& grad, torch::Tensor& exp_avg, torch::Tensor& exp_avg_sq,
+  const torch::Tensor& rows, const torch::Tensor& last_step, const AdamStep& s)
+{
+  SparseAdamCpu::step(rows.numel(), rows.data_ptr<int64_t>(), param.numel() / param.size(0),
+    param.data_ptr<float>(), grad.data_ptr<float>(), exp_avg.data_ptr<float>(), exp_avg_sq.data_ptr<float>(),
+    last_step.data_ptr<int32_t>(), s);
+}
@@ -0,0 +1,69 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use 
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+from setuptools import setup
+from torch.utils.cpp_extension import CUDAExtension, CppExtension, BuildExtension, CUDA_HOME
+import os
+
+# The host implementation is always built. Set SPLAT_TRAIN_CPU_ONLY=1 to
+# skip the CUDA sources.
+cpu_only = os.environ.get("SPLAT_TRAIN_CPU_ONLY", "0") == "1" or CUDA_HOME is None
+
+cxx_compiler_flags = []
+
+if os.name == 'nt':
+    cxx_compiler_flags.append("/openmp")
+    link_flags = []
+else:
+    cxx_compiler_flags.append("-O3")
+    cxx_compiler_flags.append("-fopenmp")
+    link_flags = ["-fopenmp"]
+
+cpu_sources = [
+    "fused_loss_cpu.cpp",
+    "loss_cpu.cpp",
+    "gaussian_store_cpu.cpp",
+    "morton_cpu.cpp",
+    "store_cpu.cpp",
+    "sparse_adam_cpu.cpp",
+    "optimizer_cpu.cpp",
+    "ext.cpp"]
+cuda_sources = [
+    "fused_loss.cu",
+    "loss.cu",
+    "gaussian_store.cu",
+    "morton.cu",
+    "store.cu",
+    "sparse_adam.cu",
+    "optimizer.cu"]
+
+if cpu_only:
+    extension = CppExtension(
+        name="splat_train._C",
+        sources=cpu_sources,
+        extra_compile_args={"cxx": cxx_compiler_flags},
+        extra_link_args=link_flags)
+else:
+    extension = CUDAExtension(
+        name="splat_train._C",
+        sources=cuda_sources + cpu_sources,
+        define_macros=[("WITH_CUDA", None)],
+        extra_compile_args={"nvcc": [], "cxx": cxx_compiler_flags},
+        extra_link_args=link_flags)
+
+setup(
+    name="splat_train",
+    packages=['splat_train'],
+    ext_modules=[extension],
+    cmdclass={
+        'build_ext': BuildExtension
+    }
+)
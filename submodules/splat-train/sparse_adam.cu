@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "sparse_adam.h"
+#include <algorithm>
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#define ADAM_THREADS 256
+#define ADAM_MAX_BLOCKS 4096
+
+namespace
+{
+	// Consecutive threads update consecutive values of the visible rows
+	__global__ void sparseAdamCUDA(
+		int64_t count,
+		const int64_t* __restrict__ rows,
+		int64_t row_size,
+		float* __restrict__ param,
+		const float* __restrict__ grad,
+		float* __restrict__ exp_avg,
+		float* __restrict__ exp_avg_sq,
+		const int32_t* __restrict__ last_step,
+		const AdamStep s)
+	{
+		const int64_t total = count * row_size;
+		for (int64_t i = blockIdx.x * (int64_t)blockDim.x + threadIdx.x; i < total; i += (int64_t)gridDim.x * blockDim.x)
+		{
+			const int64_t n = i / row_size;
+			const int64_t row = rows[n];
+			const int64_t k = row * row_size + (i - n * row_size);
+			const int skipped = s.step - last_step[row];
+			const float decay1 = skipped == 1 ? s.beta1 : powf(s.beta1, (float)skipped);
+			const float decay2 = skipped == 1 ? s.beta2 : powf(s.beta2, (float)skipped);
+			adamUpdate(s, decay1, decay2, param[k], grad[k], exp_avg[k], exp_avg_sq[k]);
+		}
+	}
+}
+
+void SparseAdam::step(
+	int64_t count,
+	const int64_t* rows,
+	int64_t row_size,
+	float* param,
+	const float* grad,
+	float* exp_avg,
+	float* exp_avg_sq,
+	const int32_t* last_step,
+	const AdamStep& s)
+{
+	if (count == 0 || row_size == 0)
+		return;
+
+	const int64_t blocks = std::min<int64_t>((count * row_size + ADAM_THREADS - 1) / ADAM_THREADS, ADAM_MAX_BLOCKS);
+	sparseAdamCUDA << <(unsigned)blocks, ADAM_THREADS >> > (count, rows, row_size, param, grad, exp_avg, exp_avg_sq, last_step, s);
+}
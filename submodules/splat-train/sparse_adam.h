@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#ifndef SPARSE_ADAM_H_INCLUDED
+#define SPARSE_ADAM_H_INCLUDED
+
+#include <cmath>
+#include <cstdint>
+
+#ifdef __CUDACC__
+#define ADAM_FUNC __host__ __device__
+#else
+#define ADAM_FUNC
+#endif
+
+// Per-step constants of an Adam update at step t (counting from 1), as
+// torch.optim.Adam computes them: the step size lr / (1 - beta1^t) and
+// sqrt(1 - beta2^t), in double.
+struct AdamStep
+{
+	int32_t step;
+	float beta1, beta2, eps;
+	float step_size;
+	float bias_correction2_sqrt;
+};
+
+// Update of one value whose row was last updated at step last_step. The
+// moments are first decayed by the steps the row was skipped in (with a
+// zero gradient), then updated with grad as in dense Adam. The parameter
+// does not move in the skipped steps.
+ADAM_FUNC inline void adamUpdate(
+	const AdamStep& s, float decay1, float decay2,
+	float& param, float grad, float& exp_avg, float& exp_avg_sq)
+{
+	exp_avg = exp_avg * decay1 + (1.0f - s.beta1) * grad;
+	exp_avg_sq = exp_avg_sq * decay2 + (1.0f - s.beta2) * grad * grad;
+	param -= s.step_size * exp_avg / (sqrtf(exp_avg_sq) / s.bias_correction2_sqrt + s.eps);
+}
+
+// Adam step over the rows rows[i], i < count, of a parameter of row_size
+// floats per row (Gaussian), with its gradient and moments laid out the
+// same way. last_step holds the step of the last update of every row, 0
+// if it never was; decay1 and decay2 of adamUpdate are beta^(t - last).
+// Rows must be distinct. last_step is not written, the caller sets it to
+// t for the rows once every parameter of the step is updated.
+// SparseAdam works on device memory, SparseAdamCpu on host memory.
+class SparseAdam
+{
+public:
+	static void step(
+		int64_t count,
+		const int64_t* rows,
+		int64_t row_size,
+		float* param,
+		const float* grad,
+		float* exp_avg,
+		float* exp_avg_sq,
+		const int32_t* last_step,
+		const AdamStep& s);
+};
+
+class SparseAdamCpu
+{
+public:
+	static void step(
+		int64_t count,
+		const int64_t* rows,
+		int64_t row_size,
+		float* param,
+		const float* grad,
+		float* exp_avg,
+		float* exp_avg_sq,
+		const int32_t* last_step,
+		const AdamStep& s);
+};
+
+#endif
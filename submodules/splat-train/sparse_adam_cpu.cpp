@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "sparse_adam.h"
+#include <omp.h>
+
+void SparseAdamCpu::step(
+	int64_t count,
+	const int64_t* rows,
+	int64_t row_size,
+	float* param,
+	const float* grad,
+	float* exp_avg,
+	float* exp_avg_sq,
+	const int32_t* last_step,
+	const AdamStep& s)
+{
+	// One row per iteration, the decay is computed once per row
+	#pragma omp parallel for schedule(static, 64)
+	for (int64_t i = 0; i < count; i++)
+	{
+		const int64_t row = rows[i];
+		const int skipped = s.step - last_step[row];
+		const float decay1 = skipped == 1 ? s.beta1 : powf(s.beta1, (float)skipped);
+		const float decay2 = skipped == 1 ? s.beta2 : powf(s.beta2, (float)skipped);
+		const int64_t begin = row * row_size;
+		for (int64_t k = begin; k < begin + row_size; k++)
+			adamUpdate(s, decay1, decay2, param[k], grad[k], exp_avg[k], exp_avg_sq[k]);
+	}
+}
@@ -0,0 +1,44 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use 
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import torch
+from . import _C
+from .store import GaussianStore
+from .optimizer import SparseAdam
+
+class _FusedL1SSIM(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, img1, img2, lambda_dssim):
+        # The gradient is computed along with the loss and kept for backward
+        l1, ssim, grad = _C.fused_l1_ssim(img1, img2, lambda_dssim, ctx.needs_input_grad[0])
+        l1, ssim = l1.mean(), ssim.mean()
+        loss = (1.0 - lambda_dssim) * l1 + lambda_dssim * (1.0 - ssim)
+        ctx.mark_non_differentiable(l1, ssim)
+        ctx.save_for_backward(grad)
+        return loss, l1, ssim
+
+    @staticmethod
+    def backward(ctx, grad_loss, _, __):
+        grad, = ctx.saved_tensors
+        return grad * grad_loss, None, None
+
+def fused_l1_ssim(img1, img2, lambda_dssim=0.2):
+    # (1 - lambda_dssim) * l1_loss + lambda_dssim * (1 - ssim) of
+    # utils/loss_utils.py for images (C, H, W) or (N, C, H, W), in one
+    # pass instead of five convolutions. Returns (loss, l1, ssim); only
+    # loss is differentiable, and only with respect to img1.
+    return _FusedL1SSIM.apply(img1, img2, lambda_dssim)
+
+def fused_ssim(img1, img2):
+    # SSIM of every image of a batch (N, C, H, W), as ssim(..., size_average=False)
+    with torch.no_grad():
+        _, ssim, _ = _C.fused_l1_ssim(img1, img2, 0.0, False)
+    return ssim
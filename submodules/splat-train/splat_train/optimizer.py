@@ -0,0 +1,49 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import torch
+from . import _C
+
+class SparseAdam(torch.optim.Adam):
+    # Adam that only updates the rows (Gaussians) that were visible in the
+    # iteration, with one native pass over them per parameter group. A row
+    # skipped for k steps gets the decay of its moments over those steps
+    # when it is next updated (lazy correction), but unlike in dense Adam
+    # its parameters do not keep moving on the momentum in between.
+    # last_step (P, int32) holds the step of the last update of every row,
+    # 0 for new rows. Moments and steps are the state of torch.optim.Adam,
+    # so learning rate schedules and state_dict work as before.
+
+    def __init__(self, params, lr=1e-3, betas=(0.9, 0.999), eps=1e-8):
+        super().__init__(params, lr=lr, betas=betas, eps=eps)
+
+    @torch.no_grad()
+    def step(self, visible, last_step):
+        # visible is a boolean mask (P), e.g. radii > 0, or a list of rows
+        rows = None
+        step = None
+        for group in self.param_groups:
+            beta1, beta2 = group["betas"]
+            for param in group["params"]:
+                if param.grad is None:
+                    continue
+                if rows is None:
+                    rows = visible.nonzero().view(-1) if visible.dtype == torch.bool else visible.long()
+                state = self.state[param]
+                if "exp_avg" not in state:
+                    state["exp_avg"] = torch.zeros_like(param, memory_format=torch.contiguous_format)
+                    state["exp_avg_sq"] = torch.zeros_like(param, memory_format=torch.contiguous_format)
+                state["step"] = state.get("step", torch.tensor(0.0)) + 1
+                step = int(state["step"].item())
+                _C.sparse_adam_step(param, param.grad.contiguous(), state["exp_avg"], state["exp_avg_sq"],
+                                    rows, last_step, step, group["lr"], beta1, beta2, group["eps"])
+        if step is not None:
+            last_step.index_fill_(0, rows, step)
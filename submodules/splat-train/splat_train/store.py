@@ -0,0 +1,142 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import torch
+from torch import nn
+from . import _C
+
+class GaussianStore:
+    # Structure-of-arrays storage of per-Gaussian tensors ("columns") with
+    # reserved capacity. Every column is a buffer of capacity rows, the
+    # first size rows are in use and store[name] is a view of them.
+    # Appending writes into the reserved rows and removing moves the last
+    # kept rows into the holes (swap-compaction), so both take time in the
+    # number of changed Gaussians. Only growing beyond the capacity
+    # reallocates, geometrically. Removing does not keep the order of the
+    # Gaussians.
+    #
+    # Parameters of an Adam optimizer bound with bind_optimizer are views
+    # of their columns as well, and so are their moments. After every
+    # change of the size they are swapped for new views of the same
+    # buffers, see parameters.
+
+    def __init__(self, growth=1.5):
+        self.size = 0
+        self.capacity = 0
+        self.growth = growth
+        self.buffers = {}
+        self.optimizer = None
+        self.parameters = {}
+
+    def __contains__(self, name):
+        return name in self.buffers
+
+    def __getitem__(self, name):
+        return self.buffers[name][:self.size]
+
+    @torch.no_grad()
+    def set_column(self, name, tensor):
+        # Adds the column or overwrites its rows. The first column sets the size.
+        if not self.buffers:
+            self.size = tensor.shape[0]
+            self.capacity = max(self.capacity, self.size)
+        assert tensor.shape[0] == self.size, "Column {} has {} rows, expected {}".format(name, tensor.shape[0], self.size)
+        if name not in self.buffers:
+            self.buffers[name] = tensor.new_zeros((self.capacity,) + tuple(tensor.shape[1:]))
+        self[name].copy_(tensor)
+        return self[name]
+
+    @torch.no_grad()
+    def reserve(self, capacity):
+        if capacity <= self.capacity:
+            return
+        for name, buffer in self.buffers.items():
+            grown = buffer.new_zeros((capacity,) + tuple(buffer.shape[1:]))
+            grown[:self.size] = buffer[:self.size]
+            self.buffers[name] = grown
+        self.capacity = capacity
+        self._rebind()
+
+    @torch.no_grad()
+    def append(self, tensors):
+        # Appends rows (name -> tensor), columns that are not given get zeros
+        n = next(iter(tensors.values())).shape[0]
+        if self.size + n > self.capacity:
+            self.reserve(max(self.size + n, int(self.capacity * self.growth)))
+        for name, buffer in self.buffers.items():
+            rows = buffer[self.size:self.size + n]
+            if name in tensors:
+                rows.copy_(tensors[name])
+            else:
+                rows.zero_()
+        self.size += n
+        self._rebind()
+
+    @torch.no_grad()
+    def remove(self, mask):
+        # Removes the rows where mask (size) is set
+        self.size = _C.compact_rows(list(self.buffers.values()), mask.contiguous())
+        self._rebind()
+
+    @torch.no_grad()
+    def reorder(self, order):
+        # Permutes the rows of all columns, row i gets the former row
+        # order[i]. Views stay valid; pending gradients would not match
+        # the rows anymore and are dropped.
+        for buffer in self.buffers.values():
+            rows = buffer[:self.size]
+            rows.copy_(rows.index_select(0, order))
+        for param in self.parameters.values():
+            param.grad = None
+
+    @torch.no_grad()
+    def morton_order(self, name):
+        # Order of the rows along the Morton curve through the positions in
+        # column name, for reorder. Rows in the same cell keep their order.
+        codes = _C.morton_codes(self[name])
+        return torch.sort(codes, stable=True)[1]
+
+    @torch.no_grad()
+    def bind_optimizer(self, optimizer):
+        # Binds the parameter groups named after columns. Their moments live
+        # in the columns "<name>.exp_avg" and "<name>.exp_avg_sq"; moments
+        # the optimizer already has, e.g. from a checkpoint, are kept.
+        self.optimizer = optimizer
+        for group in optimizer.param_groups:
+            name = group["name"]
+            if name not in self.buffers:
+                continue
+            param = group["params"][0]
+            state = optimizer.state.pop(param, {})
+            for moment in ("exp_avg", "exp_avg_sq"):
+                key = name + "." + moment
+                if key not in self.buffers:
+                    self.set_column(key, torch.zeros_like(self[name]))
+                if moment in state:
+                    self[key].copy_(state[moment])
+            optimizer.state[param] = {"step": state.get("step", torch.tensor(0.0))}
+        self._rebind()
+
+    def _rebind(self):
+        if self.optimizer is None:
+            return
+        for group in self.optimizer.param_groups:
+            name = group["name"]
+            if name not in self.buffers:
+                continue
+            state = self.optimizer.state.pop(group["params"][0], {})
+            param = nn.Parameter(self[name])
+            group["params"][0] = param
+            self.optimizer.state[param] = {
+                "step": state.get("step", torch.tensor(0.0)),
+                "exp_avg": self[name + ".exp_avg"],
+                "exp_avg_sq": self[name + ".exp_avg_sq"]}
+            self.parameters[name] = param
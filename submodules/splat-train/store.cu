@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include "store.h"
+#include "gaussian_store.h"
+
+void MoveRowsCUDA(const std::vector<torch::Tensor>& columns, const torch::Tensor& dst, const torch::Tensor& src)
+{
+  std::vector<StoreColumn> host_columns;
+  for (const torch::Tensor& column : columns)
+    host_columns.push_back({ (char*)column.data_ptr(), (int64_t)(column.numel() / column.size(0)) * (int64_t)column.element_size() });
+
+  torch::Tensor scratch = torch::empty({(int64_t)(host_columns.size() * sizeof(StoreColumn))}, dst.options().dtype(torch::kUInt8));
+  StoreCompaction::moveRows((int)host_columns.size(), host_columns.data(), dst.numel(),
+    dst.data_ptr<int64_t>(), src.data_ptr<int64_t>(), (StoreColumn*)scratch.data_ptr());
+}
+
+torch::Tensor MortonCodesCUDA(const torch::Tensor& points, const MortonBox& box)
+{
+  torch::Tensor codes = torch::empty({points.size(0)}, points.options().dtype(torch::kInt32));
+  MortonCodes::compute(points.size(0), points.data_ptr<float>(), box, codes.data_ptr<int32_t>());
+  return codes;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2023, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact  george.drettakis@inria.fr
+ */
+
+#include <torch/extension.h>
+#include "morton.h"
+
+// Copies row src[i] to row dst[i] of every column (contiguous tensors
+// with rows along the first dimension), see gaussian_store.h.
+void MoveRowsCUDA(const std::vector<torch::Tensor>& columns, const torch::Tensor& dst, const torch::Tensor& src);
+
+void MoveRowsCPU(const std::vector<torch::Tensor>& columns, const torch::Tensor& dst, const torch::Tensor& src);
+
+// Morton codes (int32) of contiguous float points (P, 3) within box, see
+// morton.h.
+torch::Tensor MortonCodesCUDA(const torch::Tensor& points, const MortonBox& box);
+
+torch::Tensor MortonCodesCPU(const torch::Tensor& points, const MortonBox& box);
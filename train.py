@@ -17,7 +17,9 @@ import torch
 import random
 from random import randint
 from utils.loss_utils import l1_loss, ssim
-from gaussian_renderer import render, network_gui
+from splat_train import fused_l1_ssim
+from gaussian_renderer import render, gaussian_contributions, network_gui
+from diff_gaussian_rasterization import RasterizerContext
 import sys
 from scene import Scene, GaussianModel
 from utils.general_utils import safe_state
@@ -49,6 +51,11 @@ def create_offset_gt(image, offset):
 
 def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoint_iterations, checkpoint, debug_from):
     first_iter = 0
+    if pipe.bvh_culling:
+        # The means move every iteration, and refitting the host BVH to
+        # them costs more than the preprocessing the cull saves
+        print("BVH culling is for rendering trained models, training without it")
+        pipe.bvh_culling = False
     tb_writer = prepare_output_and_logger(dataset)
     gaussians = GaussianModel(dataset.sh_degree)
     scene = Scene(dataset, gaussians)
@@ -75,25 +82,25 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
 
     gaussians.compute_3D_filter(cameras=trainCameras)
 
+    # Reuse the rasterizer's auxiliary buffers across iterations
+    raster_context = RasterizerContext() if pipe.persistent_buffers else None
+    # Frames of the viewer follow one camera, keep their depth order
+    viewer_context = None
+    if pipe.coherent_sort:
+        viewer_context = RasterizerContext()
+        viewer_context.set_coherent_sort(True)
+
+    def render_viewer_frame(custom_cam, do_shs_python, do_rot_scale_python, scaling_modifer):
+        pipe.convert_SHs_python, pipe.compute_cov3D_python = do_shs_python, do_rot_scale_python
+        with torch.no_grad():
+            return render(custom_cam, gaussians, pipe, background, scaling_modifer, raster_context=viewer_context)["render"]
+
     viewpoint_stack = None
     ema_loss_for_log = 0.0
     progress_bar = tqdm(range(first_iter, opt.iterations), desc="Training progress")
     first_iter += 1
     for iteration in range(first_iter, opt.iterations + 1):        
-        if network_gui.conn == None:
-            network_gui.try_connect()
-        while network_gui.conn != None:
-            try:
-                net_image_bytes = None
-                custom_cam, do_training, pipe.convert_SHs_python, pipe.compute_cov3D_python, keep_alive, scaling_modifer = network_gui.receive()
-                if custom_cam != None:
-                    net_image = render(custom_cam, gaussians, pipe, background, scaling_modifer)["render"]
-                    net_image_bytes = memoryview((torch.clamp(net_image, min=0, max=1.0) * 255).byte().permute(1, 2, 0).contiguous().cpu().numpy())
-                network_gui.send(net_image_bytes, dataset.source_path)
-                if do_training and ((iteration < int(opt.iterations)) or not keep_alive):
-                    break
-            except Exception as e:
-                network_gui.conn = None
+        network_gui.serve(render_viewer_frame, dataset.source_path, iteration >= int(opt.iterations))
 
         iter_start.record()
 
@@ -106,10 +113,20 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
         # Pick a random Camera
         if not viewpoint_stack:
             viewpoint_stack = scene.getTrainCameras().copy()
-        viewpoint_cam = viewpoint_stack.pop(randint(0, len(viewpoint_stack)-1))
+            if scene.image_pyramid is not None:
+                # Fix the order of the pass up front so its images can be prefetched
+                random.shuffle(viewpoint_stack)
+                for camera in reversed(viewpoint_stack):
+                    camera.prefetch()
+        if scene.image_pyramid is not None:
+            viewpoint_cam = viewpoint_stack.pop()
+        else:
+            viewpoint_cam = viewpoint_stack.pop(randint(0, len(viewpoint_stack)-1))
         
         # Pick a random high resolution camera
         if random.random() < 0.3 and dataset.sample_more_highres:
+            if scene.image_pyramid is not None:
+                viewpoint_cam.cancel_prefetch()
             viewpoint_cam = trainCameras[highresolution_index[randint(0, len(highresolution_index)-1)]]
             
         # Render
@@ -122,7 +139,7 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
             # subpixel_offset *= 0.0
         else:
             subpixel_offset = None
-        render_pkg = render(viewpoint_cam, gaussians, pipe, background, kernel_size=dataset.kernel_size, subpixel_offset=subpixel_offset)
+        render_pkg = render(viewpoint_cam, gaussians, pipe, background, kernel_size=dataset.kernel_size, subpixel_offset=subpixel_offset, raster_context=raster_context)
         image, viewspace_point_tensor, visibility_filter, radii = render_pkg["render"], render_pkg["viewspace_points"], render_pkg["visibility_filter"], render_pkg["radii"]
 
         # Loss
@@ -131,8 +148,11 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
         if dataset.resample_gt_image:
             gt_image = create_offset_gt(gt_image, subpixel_offset)
 
-        Ll1 = l1_loss(image, gt_image)
-        loss = (1.0 - opt.lambda_dssim) * Ll1 + opt.lambda_dssim * (1.0 - ssim(image, gt_image))
+        if opt.fused_loss:
+            loss, Ll1, _ = fused_l1_ssim(image, gt_image, opt.lambda_dssim)
+        else:
+            Ll1 = l1_loss(image, gt_image)
+            loss = (1.0 - opt.lambda_dssim) * Ll1 + opt.lambda_dssim * (1.0 - ssim(image, gt_image))
         loss.backward()
 
         iter_end.record()
@@ -145,6 +165,8 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
                 progress_bar.update(10)
             if iteration == opt.iterations:
                 progress_bar.close()
+                if raster_context is not None:
+                    print("\nRasterizer buffers: {}".format(raster_context.stats()))
 
             # Log and save
             training_report(tb_writer, iteration, Ll1, loss, l1_loss, iter_start.elapsed_time(iter_end), testing_iterations, scene, render, (pipe, background, dataset.kernel_size))
@@ -161,11 +183,22 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
                 if iteration > opt.densify_from_iter and iteration % opt.densification_interval == 0:
                     size_threshold = 20 if iteration > opt.opacity_reset_interval else None
                     gaussians.densify_and_prune(opt.densify_grad_threshold, 0.005, scene.cameras_extent, size_threshold)
-                    gaussians.compute_3D_filter(cameras=trainCameras)
+                    if opt.morton_reorder:
+                        gaussians.reorder_morton()
+                    # Incrementally, only the new Gaussians are evaluated
+                    gaussians.compute_3D_filter(cameras=trainCameras, incremental=opt.incremental_3D_filter)
 
                 if iteration % opt.opacity_reset_interval == 0 or (dataset.white_background and iteration == opt.densify_from_iter):
                     gaussians.reset_opacity()
 
+            # Once densification is over, drop the Gaussians that never
+            # visibly contribute to any training view
+            if iteration == opt.densify_until_iter and opt.min_contribution > 0:
+                contributions = gaussian_contributions(trainCameras, gaussians, pipe, background, dataset.kernel_size, raster_context=raster_context)
+                gaussians.prune_by_contribution(contributions, opt.min_contribution)
+                # The filter rows are not compacted with the parameters
+                gaussians.compute_3D_filter(cameras=trainCameras, incremental=opt.incremental_3D_filter)
+
             if iteration % 100 == 0 and iteration > opt.densify_until_iter:
                 if iteration < opt.iterations - 100:
                     # don't update in the end of training
@@ -173,7 +206,7 @@ def training(dataset, opt, pipe, testing_iterations, saving_iterations, checkpoi
         
             # Optimizer step
             if iteration < opt.iterations:
-                gaussians.optimizer.step()
+                gaussians.optimizer_step(visibility_filter)
                 gaussians.optimizer.zero_grad(set_to_none = True)
 
             if (iteration in checkpoint_iterations):
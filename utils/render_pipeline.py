@@ -0,0 +1,95 @@
+#
+# Copyright (C) 2023, Inria
+# GRAPHDECO research group, https://team.inria.fr/graphdeco
+# All rights reserved.
+#
+# This software is free for non-commercial, research and evaluation use
+# under the terms of the LICENSE.md file.
+#
+# For inquiries contact  george.drettakis@inria.fr
+#
+
+import json
+import os
+import time
+import torch
+from splat_io import ImageWriter
+from utils.loss_utils import ssim
+from utils.image_utils import psnr
+
+def quantize(image):
+    # The image as read back from the 8 bit PNG that save_image writes
+    return image.mul(255).add_(0.5).clamp_(0, 255).floor_().div_(255)
+
+class RenderPipeline:
+    # Stages behind the renderer of render.py. Renderings and ground truth
+    # are quantized on the GPU and handed to a native PNG writer, whose
+    # encoder threads work through a bounded queue while the next views are
+    # rendered. With metrics, SSIM/PSNR/LPIPS are computed from the same
+    # quantized tensors as metrics.py would from the PNGs, without reading
+    # them back. finish() waits for the writes and reports every stage.
+
+    def __init__(self, metrics=False, threads=0, capacity=16):
+        self.writer = ImageWriter(threads, capacity)
+        self.lpips_fn = None
+        if metrics:
+            import lpips
+            self.lpips_fn = lpips.LPIPS(net='vgg').cuda()
+        self.scores = {}
+        self.timings = {"render": 0.0, "submit": 0.0, "metrics": 0.0}
+        self.views = 0
+        self.start = time.perf_counter()
+
+    def rendered(self, elapsed):
+        # Time spent rendering one view, synchronized by the caller
+        self.timings["render"] += elapsed
+        self.views += 1
+
+    def add(self, rendering, gt, render_file, gt_file, method=None):
+        # Queues the view for writing; with metrics and a method (the
+        # directory name metrics.py reports under), scores it as well
+        start = time.perf_counter()
+        self.writer.submit(render_file, rendering)
+        self.writer.submit(gt_file, gt)
+        self.timings["submit"] += time.perf_counter() - start
+
+        if self.lpips_fn is None or method is None:
+            return
+        start = time.perf_counter()
+        rendering = quantize(rendering.unsqueeze(0))
+        gt = quantize(gt.unsqueeze(0))
+        scores = self.scores.setdefault(method, {"SSIM": {}, "PSNR": {}, "LPIPS": {}})
+        name = os.path.basename(render_file)
+        scores["SSIM"][name] = ssim(rendering, gt).item()
+        scores["PSNR"][name] = psnr(rendering, gt).item()
+        scores["LPIPS"][name] = self.lpips_fn(rendering, gt).item()
+        self.timings["metrics"] += time.perf_counter() - start
+
+    def finish(self, model_path):
+        self.writer.flush()
+        wall = time.perf_counter() - self.start
+        stats = self.writer.stats()
+
+        if self.scores:
+            # The files metrics.py writes
+            full = {}
+            for method, scores in self.scores.items():
+                full[method] = {metric: torch.tensor(list(values.values())).mean().item() for metric, values in scores.items()}
+                print("Method:", method)
+                for metric in ("SSIM", "PSNR", "LPIPS"):
+                    print("  {:<5}: {:>12.7f}".format(metric, full[method][metric]))
+            with open(os.path.join(model_path, "results.json"), 'w') as fp:
+                json.dump(full, fp, indent=True)
+            with open(os.path.join(model_path, "per_view.json"), 'w') as fp:
+                json.dump(self.scores, fp, indent=True)
+
+        def rate(count, seconds):
+            return count / seconds if seconds > 0 else float("inf")
+        print("\nPipeline ({:.2f} s for {} views):".format(wall, self.views))
+        print("  render : {:8.2f} s {:8.1f} views/s".format(self.timings["render"], rate(self.views, self.timings["render"])))
+        print("  submit : {:8.2f} s {:8.1f} images/s (quantize, copy, {:.2f} s waiting for the queue)".format(
+            self.timings["submit"], rate(2 * self.views, self.timings["submit"]), stats["wait_ms"] / 1000))
+        print("  encode : {:8.2f} s {:8.1f} images/s per thread, {:.1f} images/s overall".format(
+            stats["encode_ms"] / 1000, rate(stats["images"], stats["encode_ms"] / 1000), rate(stats["images"], stats["wall_ms"] / 1000)))
+        if self.lpips_fn is not None:
+            print("  metrics: {:8.2f} s {:8.1f} views/s".format(self.timings["metrics"], rate(sum(len(s["PSNR"]) for s in self.scores.values()), self.timings["metrics"])))